@@ -0,0 +1,299 @@
+#ifndef _EXPRESSION_H_
+#define _EXPRESSION_H_
+
+/*  -   -   -   -   -   -   -   -   -   -   -   */
+template<class _T>
+class Vector;
+template<class _T>
+class Matrix2D;
+template<class _E>
+class VectorExpr;
+template<class _E>
+class Matrix2DExpr;
+template<class _T>
+class Matrix2DView;
+/*  -   -   -   -   -   -   -   -   -   -   -   */
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+using namespace std;
+
+// The arithmetic operators on Vector and Matrix2D do not compute anything, they build a tree of
+// the nodes below. The tree is walked once, element by element, when it is assigned to a Vector or
+// Matrix2D or reduced with Mean/STD/Min/Max, so a chain of operators costs a single pass and a
+// single allocation.
+//
+// Operands passed as lvalues are held by reference, temporaries are moved into the node, so an
+// expression kept in an `auto` stays valid as long as the named containers it reads from.
+
+template<class _E>
+constexpr bool is_vector_expr_v = is_base_of_v<VectorExpr<decay_t<_E>>, decay_t<_E>>;
+
+template<class _E>
+constexpr bool is_matrix2d_expr_v = is_base_of_v<Matrix2DExpr<decay_t<_E>>, decay_t<_E>>;
+
+template<class _E>
+using expr_storage_t = conditional_t<is_lvalue_reference_v<_E>, const remove_reference_t<_E>&, decay_t<_E>>;
+
+// operands the matrix product reads in place through Begin(), RowStride() and ColStride()
+template<class _E>
+constexpr bool is_strided_matrix_v = false;
+
+template<class _T>
+constexpr bool is_strided_matrix_v<Matrix2D<_T>> = true;
+
+template<class _T>
+constexpr bool is_strided_matrix_v<Matrix2DView<_T>> = true;
+
+template<class _L, class _R>
+Matrix2D<typename _L::value_type> gemm_product(const _L&, const _R&) noexcept;
+
+// broadcast operands are read once per row, so anything that is not already a Vector is evaluated up front
+template<class _E, class _T>
+using broadcast_storage_t = conditional_t<is_same_v<decay_t<_E>, Vector<_T>> && is_lvalue_reference_v<_E>, const Vector<_T>&, Vector<_T>>;
+
+
+// Vector nodes ----------------------------------------------------------------
+template<class _Op, class _L, class _R>
+class VectorBinaryExpr : public VectorExpr<VectorBinaryExpr<_Op, _L, _R>> {
+    public:
+        typedef typename decay_t<_L>::value_type value_type;
+        typedef size_t size_type;
+
+    private:
+        _L _x;
+        _R _y;
+
+    public:
+        template<class _A, class _B>
+        constexpr VectorBinaryExpr(_A &&x, _B &&y) noexcept : _x(forward<_A>(x)), _y(forward<_B>(y)) {}
+
+        constexpr size_type Size() const noexcept { return this->_y.Size(); }
+        constexpr value_type operator [] (size_type i) const noexcept { return _Op()(this->_x[i], this->_y[i]); }
+};
+
+
+template<class _Op, class _L>
+class VectorScalarExpr : public VectorExpr<VectorScalarExpr<_Op, _L>> {
+    public:
+        typedef typename decay_t<_L>::value_type value_type;
+        typedef size_t size_type;
+
+    private:
+        _L _x;
+        value_type _y;
+
+    public:
+        template<class _A>
+        constexpr VectorScalarExpr(_A &&x, const value_type &y) noexcept : _x(forward<_A>(x)), _y(y) {}
+
+        constexpr size_type Size() const noexcept { return this->_x.Size(); }
+        constexpr value_type operator [] (size_type i) const noexcept { return _Op()(this->_x[i], this->_y); }
+};
+
+
+// Matrix2D nodes ----------------------------------------------------------------
+template<class _Op, class _L, class _R>
+class Matrix2DBinaryExpr : public Matrix2DExpr<Matrix2DBinaryExpr<_Op, _L, _R>> {
+    public:
+        typedef typename decay_t<_L>::value_type value_type;
+        typedef size_t size_type;
+
+    private:
+        _L _x;
+        _R _y;
+
+    public:
+        template<class _A, class _B>
+        constexpr Matrix2DBinaryExpr(_A &&x, _B &&y) noexcept : _x(forward<_A>(x)), _y(forward<_B>(y)) {}
+
+        constexpr size_type Row() const noexcept { return this->_x.Row(); }
+        constexpr size_type Col() const noexcept { return this->_x.Col(); }
+        constexpr value_type operator () (size_type i, size_type j) const noexcept { return _Op()(this->_x(i, j), this->_y(i, j)); }
+};
+
+
+// applies y[j] to every element of column j, a one element Vector is applied to every element
+template<class _Op, class _L, class _R>
+class Matrix2DBroadcastExpr : public Matrix2DExpr<Matrix2DBroadcastExpr<_Op, _L, _R>> {
+    public:
+        typedef typename decay_t<_L>::value_type value_type;
+        typedef size_t size_type;
+
+    private:
+        _L _x;
+        _R _y;
+        size_type _step;
+
+    public:
+        template<class _A, class _B>
+        constexpr Matrix2DBroadcastExpr(_A &&x, _B &&y) noexcept : _x(forward<_A>(x)), _y(forward<_B>(y)) {
+            this->_step = this->_y.Size() == 1 ? 0 : 1;
+        }
+
+        constexpr size_type Row() const noexcept { return this->_x.Row(); }
+        constexpr size_type Col() const noexcept { return this->_x.Col(); }
+        constexpr value_type operator () (size_type i, size_type j) const noexcept { return _Op()(this->_x(i, j), this->_y[j * this->_step]); }
+};
+
+
+template<class _Op, class _L>
+class Matrix2DScalarExpr : public Matrix2DExpr<Matrix2DScalarExpr<_Op, _L>> {
+    public:
+        typedef typename decay_t<_L>::value_type value_type;
+        typedef size_t size_type;
+
+    private:
+        _L _x;
+        value_type _y;
+
+    public:
+        template<class _A>
+        constexpr Matrix2DScalarExpr(_A &&x, const value_type &y) noexcept : _x(forward<_A>(x)), _y(y) {}
+
+        constexpr size_type Row() const noexcept { return this->_x.Row(); }
+        constexpr size_type Col() const noexcept { return this->_x.Col(); }
+        constexpr value_type operator () (size_type i, size_type j) const noexcept { return _Op()(this->_x(i, j), this->_y); }
+};
+
+
+// Vector operators ----------------------------------------------------------------
+template<class _L, class _R, enable_if_t<is_vector_expr_v<_L> && is_vector_expr_v<_R>, int> = 0>
+constexpr auto operator + (_L &&x, _R &&y) noexcept {
+    return VectorBinaryExpr<plus<>, expr_storage_t<_L>, expr_storage_t<_R>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, enable_if_t<is_vector_expr_v<_L>, int> = 0>
+constexpr auto operator + (_L &&x, const typename decay_t<_L>::value_type &y) noexcept {
+    return VectorScalarExpr<plus<>, expr_storage_t<_L>>(forward<_L>(x), y);
+}
+
+
+template<class _L, class _R, enable_if_t<is_vector_expr_v<_L> && is_vector_expr_v<_R>, int> = 0>
+constexpr auto operator - (_L &&x, _R &&y) noexcept {
+    return VectorBinaryExpr<minus<>, expr_storage_t<_L>, expr_storage_t<_R>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, enable_if_t<is_vector_expr_v<_L>, int> = 0>
+constexpr auto operator - (_L &&x, const typename decay_t<_L>::value_type &y) noexcept {
+    return VectorScalarExpr<minus<>, expr_storage_t<_L>>(forward<_L>(x), y);
+}
+
+
+template<class _L, class _R, enable_if_t<is_vector_expr_v<_L> && is_vector_expr_v<_R>, int> = 0>
+constexpr auto operator * (_L &&x, _R &&y) noexcept {
+    return VectorBinaryExpr<multiplies<>, expr_storage_t<_L>, expr_storage_t<_R>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, enable_if_t<is_vector_expr_v<_L>, int> = 0>
+constexpr auto operator * (_L &&x, const typename decay_t<_L>::value_type &y) noexcept {
+    return VectorScalarExpr<multiplies<>, expr_storage_t<_L>>(forward<_L>(x), y);
+}
+
+
+template<class _L, class _R, enable_if_t<is_vector_expr_v<_L> && is_vector_expr_v<_R>, int> = 0>
+constexpr auto operator / (_L &&x, _R &&y) noexcept {
+    return VectorBinaryExpr<divides<>, expr_storage_t<_L>, expr_storage_t<_R>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, enable_if_t<is_vector_expr_v<_L>, int> = 0>
+constexpr auto operator / (_L &&x, const typename decay_t<_L>::value_type &y) noexcept {
+    return VectorScalarExpr<divides<>, expr_storage_t<_L>>(forward<_L>(x), y);
+}
+
+
+// Matrix2D operators ----------------------------------------------------------------
+template<class _L, class _R, enable_if_t<is_matrix2d_expr_v<_L> && is_matrix2d_expr_v<_R>, int> = 0>
+constexpr auto operator + (_L &&x, _R &&y) noexcept {
+    return Matrix2DBinaryExpr<plus<>, expr_storage_t<_L>, expr_storage_t<_R>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, class _R, enable_if_t<is_matrix2d_expr_v<_L> && is_vector_expr_v<_R>, int> = 0>
+constexpr auto operator + (_L &&x, _R &&y) noexcept {
+    typedef typename decay_t<_L>::value_type _T;
+    return Matrix2DBroadcastExpr<plus<>, expr_storage_t<_L>, broadcast_storage_t<_R, _T>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, enable_if_t<is_matrix2d_expr_v<_L>, int> = 0>
+constexpr auto operator + (_L &&x, const typename decay_t<_L>::value_type &y) noexcept {
+    return Matrix2DScalarExpr<plus<>, expr_storage_t<_L>>(forward<_L>(x), y);
+}
+
+
+template<class _L, class _R, enable_if_t<is_matrix2d_expr_v<_L> && is_matrix2d_expr_v<_R>, int> = 0>
+constexpr auto operator - (_L &&x, _R &&y) noexcept {
+    return Matrix2DBinaryExpr<minus<>, expr_storage_t<_L>, expr_storage_t<_R>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, class _R, enable_if_t<is_matrix2d_expr_v<_L> && is_vector_expr_v<_R>, int> = 0>
+constexpr auto operator - (_L &&x, _R &&y) noexcept {
+    typedef typename decay_t<_L>::value_type _T;
+    return Matrix2DBroadcastExpr<minus<>, expr_storage_t<_L>, broadcast_storage_t<_R, _T>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, enable_if_t<is_matrix2d_expr_v<_L>, int> = 0>
+constexpr auto operator - (_L &&x, const typename decay_t<_L>::value_type &y) noexcept {
+    return Matrix2DScalarExpr<minus<>, expr_storage_t<_L>>(forward<_L>(x), y);
+}
+
+
+template<class _L, class _R, enable_if_t<is_matrix2d_expr_v<_L> && is_vector_expr_v<_R>, int> = 0>
+constexpr auto operator * (_L &&x, _R &&y) noexcept {
+    typedef typename decay_t<_L>::value_type _T;
+    return Matrix2DBroadcastExpr<multiplies<>, expr_storage_t<_L>, broadcast_storage_t<_R, _T>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, enable_if_t<is_matrix2d_expr_v<_L>, int> = 0>
+constexpr auto operator * (_L &&x, const typename decay_t<_L>::value_type &y) noexcept {
+    return Matrix2DScalarExpr<multiplies<>, expr_storage_t<_L>>(forward<_L>(x), y);
+}
+
+
+template<class _L, class _R, enable_if_t<is_matrix2d_expr_v<_L> && is_matrix2d_expr_v<_R>, int> = 0>
+constexpr auto operator / (_L &&x, _R &&y) noexcept {
+    return Matrix2DBinaryExpr<divides<>, expr_storage_t<_L>, expr_storage_t<_R>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, class _R, enable_if_t<is_matrix2d_expr_v<_L> && is_vector_expr_v<_R>, int> = 0>
+constexpr auto operator / (_L &&x, _R &&y) noexcept {
+    typedef typename decay_t<_L>::value_type _T;
+    return Matrix2DBroadcastExpr<divides<>, expr_storage_t<_L>, broadcast_storage_t<_R, _T>>(forward<_L>(x), forward<_R>(y));
+}
+
+
+template<class _L, enable_if_t<is_matrix2d_expr_v<_L>, int> = 0>
+constexpr auto operator / (_L &&x, const typename decay_t<_L>::value_type &y) noexcept {
+    return Matrix2DScalarExpr<divides<>, expr_storage_t<_L>>(forward<_L>(x), y);
+}
+
+
+// the matrix product is not element-wise, Matrix2D and views (transposes included) are read in place
+// through their strides, any other expression is evaluated first
+template<class _L, class _R, enable_if_t<is_matrix2d_expr_v<_L> && is_matrix2d_expr_v<_R>, int> = 0>
+auto operator * (const _L &x, const _R &y) noexcept {
+    typedef typename _L::value_type _T;
+    if constexpr (is_strided_matrix_v<_L> && is_strided_matrix_v<_R>) {
+        return gemm_product(x, y);
+    } else if constexpr (is_strided_matrix_v<_L>) {
+        return gemm_product(x, Matrix2D<_T>(y));
+    } else if constexpr (is_strided_matrix_v<_R>) {
+        return gemm_product(Matrix2D<_T>(x), y);
+    } else {
+        return gemm_product(Matrix2D<_T>(x), Matrix2D<_T>(y));
+    }
+}
+
+#endif // !_EXPRESSION_H_
@@ -0,0 +1,478 @@
+#ifndef _FIXED_H_
+#define _FIXED_H_
+
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <type_traits>
+#include <ostream>
+
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+
+using namespace std;
+
+// Vectors and matrices whose extents are template arguments, for the 2 .. 4 element geometry that
+// Vector and Matrix2D would send through the allocator and the pool. The elements live inside the
+// object, every loop is unrolled over an index_sequence and every member is constexpr, so they can be
+// computed at compile time. Operators are eager: at these sizes an expression tree would cost more
+// than the arithmetic. Vector<_T>(x.Begin(), x.Size()) and Matrix2D<_T>(m.Begin(), m.Row(), m.Col())
+// convert them to the dynamic containers.
+
+template<class _T, size_t _N>
+class FixedVector;
+template<class _T, size_t _R, size_t _C>
+class FixedMatrix2D;
+
+
+// f(0), f(1), ... f(N - 1), expanded at compile time
+template<class _F, size_t... _I>
+constexpr void fixed_unroll(_F &&f, index_sequence<_I...>) noexcept { (f(_I), ...); }
+
+template<size_t _N, class _F>
+constexpr void fixed_for(_F &&f) noexcept { fixed_unroll(f, make_index_sequence<_N>()); }
+
+
+// Newton's iteration inside constant expressions, where sqrt is not available, the library at run time
+template<class _T>
+constexpr _T fixed_sqrt(_T __x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    if (__builtin_is_constant_evaluated()) {
+        if (!(__x > _T(0)) || __x == numeric_limits<_T>::infinity()) {
+            return __x == _T(0) || __x == numeric_limits<_T>::infinity() ? __x : numeric_limits<_T>::quiet_NaN();
+        }
+        long double __r = __x > _T(1) ? __x : _T(1), __next = (__r + __x / __r) / 2;
+        while (__next < __r) {
+            __r = __next;
+            __next = (__r + __x / __r) / 2;
+        }
+        return _T(__r);
+    }
+#endif
+    return sqrt(__x);
+}
+
+
+// Vector ----------------------------------------------------------------
+template<class _T, size_t _N>
+class FixedVector {
+    static_assert(_N > 0, "a FixedVector holds at least one element");
+
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        typedef _T* iterator;
+        typedef const _T* const_iterator;
+        typedef typename Description<_T>::stat_type stat_type;
+
+    private:
+        _T _vec[_N] {};
+
+        template<class _Op> constexpr FixedVector<_T, _N>& update(const FixedVector<_T, _N>&) noexcept;
+        template<class _Op> constexpr FixedVector<_T, _N>& update(const _T&) noexcept;
+
+    public:
+        constexpr FixedVector() noexcept = default;
+        template<class... _A, enable_if_t<sizeof...(_A) == _N && (is_convertible_v<_A, _T> && ...), int> = 0>
+        constexpr FixedVector(_A... __x) noexcept : _vec{_T(__x)...} {}
+
+        static constexpr FixedVector<_T, _N> ZeroInit() noexcept { return FixedVector<_T, _N>(); }
+        static constexpr FixedVector<_T, _N> OneInit() noexcept;
+
+        static constexpr size_type Size() noexcept { return _N; }
+        constexpr const_iterator Begin() const noexcept { return this->_vec; }
+        constexpr iterator Begin() noexcept { return this->_vec; }
+        constexpr const_iterator End() const noexcept { return this->_vec + _N; }
+        constexpr iterator End() noexcept { return this->_vec + _N; }
+
+        constexpr _T Mean() const noexcept;
+        constexpr stat_type STD() const noexcept;
+        constexpr _T Max() const noexcept;
+        constexpr _T Min() const noexcept;
+        constexpr size_type Argmax() const noexcept;
+
+        constexpr const _T& operator [] (size_type i) const noexcept { return this->_vec[i]; }
+        constexpr _T& operator [] (size_type i) noexcept { return this->_vec[i]; }
+
+        constexpr FixedVector<_T, _N>& operator += (const FixedVector<_T, _N> &y) noexcept { return this->template update<plus<>>(y); }
+        constexpr FixedVector<_T, _N>& operator -= (const FixedVector<_T, _N> &y) noexcept { return this->template update<minus<>>(y); }
+        constexpr FixedVector<_T, _N>& operator *= (const FixedVector<_T, _N> &y) noexcept { return this->template update<multiplies<>>(y); }
+        constexpr FixedVector<_T, _N>& operator /= (const FixedVector<_T, _N> &y) noexcept { return this->template update<divides<>>(y); }
+        constexpr FixedVector<_T, _N>& operator += (const _T &y) noexcept { return this->template update<plus<>>(y); }
+        constexpr FixedVector<_T, _N>& operator -= (const _T &y) noexcept { return this->template update<minus<>>(y); }
+        constexpr FixedVector<_T, _N>& operator *= (const _T &y) noexcept { return this->template update<multiplies<>>(y); }
+        constexpr FixedVector<_T, _N>& operator /= (const _T &y) noexcept { return this->template update<divides<>>(y); }
+
+        friend ostream& operator << (ostream &str, const FixedVector<_T, _N> &x) noexcept {
+            text_print_vector(str, x);
+            return str;
+        }
+};
+
+
+template<class _T, size_t _N>
+constexpr FixedVector<_T, _N> FixedVector<_T, _N>::OneInit() noexcept {
+    FixedVector<_T, _N> v;
+    fixed_for<_N>([&v](size_t i) { v._vec[i] = _T(1); });
+    return v;
+}
+
+
+// accumulated in double like Vector::Mean
+template<class _T, size_t _N>
+constexpr _T FixedVector<_T, _N>::Mean() const noexcept {
+    double __sum = 0;
+    fixed_for<_N>([&](size_t i) { __sum += double(this->_vec[i]); });
+    return _T(__sum / _N);
+}
+
+
+// population standard deviation, two passes over the elements
+template<class _T, size_t _N>
+constexpr auto FixedVector<_T, _N>::STD() const noexcept -> stat_type {
+    stat_type __mean = 0, __m2 = 0;
+    fixed_for<_N>([&](size_t i) { __mean += stat_type(this->_vec[i]); });
+    __mean /= _N;
+    fixed_for<_N>([&](size_t i) { __m2 += (stat_type(this->_vec[i]) - __mean) * (stat_type(this->_vec[i]) - __mean); });
+    return fixed_sqrt(__m2 / _N);
+}
+
+
+template<class _T, size_t _N>
+constexpr _T FixedVector<_T, _N>::Max() const noexcept { return this->_vec[this->Argmax()]; }
+
+
+template<class _T, size_t _N>
+constexpr _T FixedVector<_T, _N>::Min() const noexcept {
+    _T __min = this->_vec[0];
+    fixed_for<_N>([&](size_t i) { __min = this->_vec[i] < __min ? this->_vec[i] : __min; });
+    return __min;
+}
+
+
+// first index of the largest element
+template<class _T, size_t _N>
+constexpr size_t FixedVector<_T, _N>::Argmax() const noexcept {
+    size_t __arg = 0;
+    fixed_for<_N>([&](size_t i) { __arg = this->_vec[i] > this->_vec[__arg] ? i : __arg; });
+    return __arg;
+}
+
+
+template<class _T, size_t _N>
+template<class _Op>
+constexpr FixedVector<_T, _N>& FixedVector<_T, _N>::update(const FixedVector<_T, _N> &y) noexcept {
+    fixed_for<_N>([&](size_t i) { this->_vec[i] = _Op()(this->_vec[i], y[i]); });
+    return *this;
+}
+
+
+template<class _T, size_t _N>
+template<class _Op>
+constexpr FixedVector<_T, _N>& FixedVector<_T, _N>::update(const _T &y) noexcept {
+    fixed_for<_N>([&](size_t i) { this->_vec[i] = _Op()(this->_vec[i], y); });
+    return *this;
+}
+
+
+template<class _T, size_t _N>
+constexpr FixedVector<_T, _N> operator + (FixedVector<_T, _N> x, const FixedVector<_T, _N> &y) noexcept { return x += y; }
+template<class _T, size_t _N>
+constexpr FixedVector<_T, _N> operator - (FixedVector<_T, _N> x, const FixedVector<_T, _N> &y) noexcept { return x -= y; }
+template<class _T, size_t _N>
+constexpr FixedVector<_T, _N> operator * (FixedVector<_T, _N> x, const FixedVector<_T, _N> &y) noexcept { return x *= y; }
+template<class _T, size_t _N>
+constexpr FixedVector<_T, _N> operator / (FixedVector<_T, _N> x, const FixedVector<_T, _N> &y) noexcept { return x /= y; }
+template<class _T, size_t _N>
+constexpr FixedVector<_T, _N> operator + (FixedVector<_T, _N> x, const typename FixedVector<_T, _N>::value_type &y) noexcept { return x += y; }
+template<class _T, size_t _N>
+constexpr FixedVector<_T, _N> operator - (FixedVector<_T, _N> x, const typename FixedVector<_T, _N>::value_type &y) noexcept { return x -= y; }
+template<class _T, size_t _N>
+constexpr FixedVector<_T, _N> operator * (FixedVector<_T, _N> x, const typename FixedVector<_T, _N>::value_type &y) noexcept { return x *= y; }
+template<class _T, size_t _N>
+constexpr FixedVector<_T, _N> operator / (FixedVector<_T, _N> x, const typename FixedVector<_T, _N>::value_type &y) noexcept { return x /= y; }
+
+
+template<class _T, size_t _N>
+constexpr bool operator == (const FixedVector<_T, _N> &x, const FixedVector<_T, _N> &y) noexcept {
+    bool __eq = true;
+    fixed_for<_N>([&](size_t i) { __eq &= x[i] == y[i]; });
+    return __eq;
+}
+
+
+template<class _T, size_t _N>
+constexpr bool operator != (const FixedVector<_T, _N> &x, const FixedVector<_T, _N> &y) noexcept { return !(x == y); }
+
+
+// Matrix ----------------------------------------------------------------
+// row-major, element (i, j) lives at _mat[i * _C + j]
+template<class _T, size_t _R, size_t _C>
+class FixedMatrix2D {
+    static_assert(_R > 0 && _C > 0, "a FixedMatrix2D holds at least one element");
+
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        typedef _T* _iterator;
+        typedef const _T* const_iterator;
+        typedef typename Description<_T>::stat_type stat_type;
+
+    private:
+        _T _mat[_R * _C] {};
+
+        constexpr FixedVector<_T, _R * _C> flat() const noexcept;
+
+        template<class _Op> constexpr FixedMatrix2D<_T, _R, _C>& update(const FixedMatrix2D<_T, _R, _C>&) noexcept;
+        template<class _Op> constexpr FixedMatrix2D<_T, _R, _C>& update(const FixedVector<_T, _C>&) noexcept;
+        template<class _Op> constexpr FixedMatrix2D<_T, _R, _C>& update(const _T&) noexcept;
+
+    public:
+        constexpr FixedMatrix2D() noexcept = default;
+        // the elements row by row
+        template<class... _A, enable_if_t<sizeof...(_A) == _R * _C && (is_convertible_v<_A, _T> && ...), int> = 0>
+        constexpr FixedMatrix2D(_A... __x) noexcept : _mat{_T(__x)...} {}
+
+        static constexpr FixedMatrix2D<_T, _R, _C> ZeroInit() noexcept { return FixedMatrix2D<_T, _R, _C>(); }
+        static constexpr FixedMatrix2D<_T, _R, _C> OneInit() noexcept;
+        static constexpr FixedMatrix2D<_T, _R, _C> Identity() noexcept;
+
+        constexpr const_iterator Begin() const noexcept { return this->_mat; }
+        constexpr _iterator Begin() noexcept { return this->_mat; }
+        static constexpr size_type Row() noexcept { return _R; }
+        static constexpr size_type Col() noexcept { return _C; }
+        static constexpr size_type Stride() noexcept { return _C; }
+        static constexpr size_type RowStride() noexcept { return _C; }
+        static constexpr size_type ColStride() noexcept { return 1; }
+
+        // copies, they are as small as the matrix
+        constexpr FixedVector<_T, _C> Row(size_type) const noexcept;
+        constexpr FixedVector<_T, _R> Column(size_type) const noexcept;
+        constexpr FixedMatrix2D<_T, _C, _R> T() const noexcept;
+
+        // whole matrix, or one value per column (COL) or per row (ROW) with m.Mean<Axis2D::COL>()
+        constexpr _T Mean() const noexcept { return this->flat().Mean(); }
+        constexpr stat_type STD() const noexcept { return this->flat().STD(); }
+        constexpr _T Max() const noexcept { return this->flat().Max(); }
+        constexpr _T Min() const noexcept { return this->flat().Min(); }
+        constexpr size_type Argmax() const noexcept { return this->flat().Argmax(); }
+        template<Axis2D _A> constexpr auto Mean() const noexcept;
+        template<Axis2D _A> constexpr auto STD() const noexcept;
+        template<Axis2D _A> constexpr auto Max() const noexcept;
+        template<Axis2D _A> constexpr auto Min() const noexcept;
+
+        constexpr const _T& operator () (size_type i, size_type j) const noexcept { return this->_mat[i * _C + j]; }
+        constexpr _T& operator () (size_type i, size_type j) noexcept { return this->_mat[i * _C + j]; }
+
+        // element-wise like Matrix2D: a FixedVector is applied to every row, *= with a square matrix is the product
+        constexpr FixedMatrix2D<_T, _R, _C>& operator += (const FixedMatrix2D<_T, _R, _C> &y) noexcept { return this->template update<plus<>>(y); }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator -= (const FixedMatrix2D<_T, _R, _C> &y) noexcept { return this->template update<minus<>>(y); }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator /= (const FixedMatrix2D<_T, _R, _C> &y) noexcept { return this->template update<divides<>>(y); }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator *= (const FixedMatrix2D<_T, _C, _C> &y) noexcept { return *this = *this * y; }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator += (const FixedVector<_T, _C> &y) noexcept { return this->template update<plus<>>(y); }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator -= (const FixedVector<_T, _C> &y) noexcept { return this->template update<minus<>>(y); }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator *= (const FixedVector<_T, _C> &y) noexcept { return this->template update<multiplies<>>(y); }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator /= (const FixedVector<_T, _C> &y) noexcept { return this->template update<divides<>>(y); }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator += (const _T &y) noexcept { return this->template update<plus<>>(y); }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator -= (const _T &y) noexcept { return this->template update<minus<>>(y); }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator *= (const _T &y) noexcept { return this->template update<multiplies<>>(y); }
+        constexpr FixedMatrix2D<_T, _R, _C>& operator /= (const _T &y) noexcept { return this->template update<divides<>>(y); }
+
+        friend ostream& operator << (ostream &stream, const FixedMatrix2D<_T, _R, _C> &m) noexcept {
+            text_print_matrix(stream, m);
+            return stream;
+        }
+};
+
+
+template<class _T, size_t _R, size_t _C>
+constexpr FixedVector<_T, _R * _C> FixedMatrix2D<_T, _R, _C>::flat() const noexcept {
+    FixedVector<_T, _R * _C> v;
+    fixed_for<_R * _C>([&](size_t k) { v[k] = this->_mat[k]; });
+    return v;
+}
+
+
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> FixedMatrix2D<_T, _R, _C>::OneInit() noexcept {
+    FixedMatrix2D<_T, _R, _C> m;
+    fixed_for<_R * _C>([&m](size_t k) { m._mat[k] = _T(1); });
+    return m;
+}
+
+
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> FixedMatrix2D<_T, _R, _C>::Identity() noexcept {
+    static_assert(_R == _C, "the identity is square");
+    FixedMatrix2D<_T, _R, _C> m;
+    fixed_for<_R>([&m](size_t i) { m._mat[i * _C + i] = _T(1); });
+    return m;
+}
+
+
+template<class _T, size_t _R, size_t _C>
+constexpr FixedVector<_T, _C> FixedMatrix2D<_T, _R, _C>::Row(size_type i) const noexcept {
+    FixedVector<_T, _C> v;
+    fixed_for<_C>([&](size_t j) { v[j] = this->_mat[i * _C + j]; });
+    return v;
+}
+
+
+template<class _T, size_t _R, size_t _C>
+constexpr FixedVector<_T, _R> FixedMatrix2D<_T, _R, _C>::Column(size_type j) const noexcept {
+    FixedVector<_T, _R> v;
+    fixed_for<_R>([&](size_t i) { v[i] = this->_mat[i * _C + j]; });
+    return v;
+}
+
+
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _C, _R> FixedMatrix2D<_T, _R, _C>::T() const noexcept {
+    FixedMatrix2D<_T, _C, _R> m;
+    fixed_for<_R * _C>([&](size_t k) { m(k % _C, k / _C) = this->_mat[k]; });
+    return m;
+}
+
+
+// Statistics ----------------------------------------------------------------
+// COL: one value per column, ROW: one value per row
+template<class _T, size_t _R, size_t _C>
+template<Axis2D _A>
+constexpr auto FixedMatrix2D<_T, _R, _C>::Mean() const noexcept {
+    static_assert(_A == Axis2D::COL || _A == Axis2D::ROW, "Mean() without an axis covers the whole matrix");
+    if constexpr (_A == Axis2D::COL) {
+        FixedVector<_T, _C> v;
+        fixed_for<_C>([&](size_t j) { v[j] = this->Column(j).Mean(); });
+        return v;
+    } else {
+        FixedVector<_T, _R> v;
+        fixed_for<_R>([&](size_t i) { v[i] = this->Row(i).Mean(); });
+        return v;
+    }
+}
+
+
+template<class _T, size_t _R, size_t _C>
+template<Axis2D _A>
+constexpr auto FixedMatrix2D<_T, _R, _C>::STD() const noexcept {
+    static_assert(_A == Axis2D::COL || _A == Axis2D::ROW, "STD() without an axis covers the whole matrix");
+    if constexpr (_A == Axis2D::COL) {
+        FixedVector<stat_type, _C> v;
+        fixed_for<_C>([&](size_t j) { v[j] = this->Column(j).STD(); });
+        return v;
+    } else {
+        FixedVector<stat_type, _R> v;
+        fixed_for<_R>([&](size_t i) { v[i] = this->Row(i).STD(); });
+        return v;
+    }
+}
+
+
+template<class _T, size_t _R, size_t _C>
+template<Axis2D _A>
+constexpr auto FixedMatrix2D<_T, _R, _C>::Max() const noexcept {
+    static_assert(_A == Axis2D::COL || _A == Axis2D::ROW, "Max() without an axis covers the whole matrix");
+    if constexpr (_A == Axis2D::COL) {
+        FixedVector<_T, _C> v;
+        fixed_for<_C>([&](size_t j) { v[j] = this->Column(j).Max(); });
+        return v;
+    } else {
+        FixedVector<_T, _R> v;
+        fixed_for<_R>([&](size_t i) { v[i] = this->Row(i).Max(); });
+        return v;
+    }
+}
+
+
+template<class _T, size_t _R, size_t _C>
+template<Axis2D _A>
+constexpr auto FixedMatrix2D<_T, _R, _C>::Min() const noexcept {
+    static_assert(_A == Axis2D::COL || _A == Axis2D::ROW, "Min() without an axis covers the whole matrix");
+    if constexpr (_A == Axis2D::COL) {
+        FixedVector<_T, _C> v;
+        fixed_for<_C>([&](size_t j) { v[j] = this->Column(j).Min(); });
+        return v;
+    } else {
+        FixedVector<_T, _R> v;
+        fixed_for<_R>([&](size_t i) { v[i] = this->Row(i).Min(); });
+        return v;
+    }
+}
+
+
+// Operators ----------------------------------------------------------------
+template<class _T, size_t _R, size_t _C>
+template<class _Op>
+constexpr FixedMatrix2D<_T, _R, _C>& FixedMatrix2D<_T, _R, _C>::update(const FixedMatrix2D<_T, _R, _C> &y) noexcept {
+    fixed_for<_R * _C>([&](size_t k) { this->_mat[k] = _Op()(this->_mat[k], y._mat[k]); });
+    return *this;
+}
+
+
+template<class _T, size_t _R, size_t _C>
+template<class _Op>
+constexpr FixedMatrix2D<_T, _R, _C>& FixedMatrix2D<_T, _R, _C>::update(const FixedVector<_T, _C> &y) noexcept {
+    fixed_for<_R * _C>([&](size_t k) { this->_mat[k] = _Op()(this->_mat[k], y[k % _C]); });
+    return *this;
+}
+
+
+template<class _T, size_t _R, size_t _C>
+template<class _Op>
+constexpr FixedMatrix2D<_T, _R, _C>& FixedMatrix2D<_T, _R, _C>::update(const _T &y) noexcept {
+    fixed_for<_R * _C>([&](size_t k) { this->_mat[k] = _Op()(this->_mat[k], y); });
+    return *this;
+}
+
+
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator + (FixedMatrix2D<_T, _R, _C> x, const FixedMatrix2D<_T, _R, _C> &y) noexcept { return x += y; }
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator - (FixedMatrix2D<_T, _R, _C> x, const FixedMatrix2D<_T, _R, _C> &y) noexcept { return x -= y; }
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator / (FixedMatrix2D<_T, _R, _C> x, const FixedMatrix2D<_T, _R, _C> &y) noexcept { return x /= y; }
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator + (FixedMatrix2D<_T, _R, _C> x, const FixedVector<_T, _C> &y) noexcept { return x += y; }
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator - (FixedMatrix2D<_T, _R, _C> x, const FixedVector<_T, _C> &y) noexcept { return x -= y; }
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator * (FixedMatrix2D<_T, _R, _C> x, const FixedVector<_T, _C> &y) noexcept { return x *= y; }
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator / (FixedMatrix2D<_T, _R, _C> x, const FixedVector<_T, _C> &y) noexcept { return x /= y; }
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator + (FixedMatrix2D<_T, _R, _C> x, const typename FixedMatrix2D<_T, _R, _C>::value_type &y) noexcept { return x += y; }
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator - (FixedMatrix2D<_T, _R, _C> x, const typename FixedMatrix2D<_T, _R, _C>::value_type &y) noexcept { return x -= y; }
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator * (FixedMatrix2D<_T, _R, _C> x, const typename FixedMatrix2D<_T, _R, _C>::value_type &y) noexcept { return x *= y; }
+template<class _T, size_t _R, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator / (FixedMatrix2D<_T, _R, _C> x, const typename FixedMatrix2D<_T, _R, _C>::value_type &y) noexcept { return x /= y; }
+
+
+// the matrix product, every multiply-add spelled out
+template<class _T, size_t _R, size_t _K, size_t _C>
+constexpr FixedMatrix2D<_T, _R, _C> operator * (const FixedMatrix2D<_T, _R, _K> &x, const FixedMatrix2D<_T, _K, _C> &y) noexcept {
+    FixedMatrix2D<_T, _R, _C> m;
+    fixed_for<_R * _C>([&](size_t __rc) {
+        size_t i = __rc / _C, j = __rc % _C;
+        _T __sum = _T(0);
+        fixed_for<_K>([&](size_t k) { __sum += x(i, k) * y(k, j); });
+        m(i, j) = __sum;
+    });
+    return m;
+}
+
+
+template<class _T, size_t _R, size_t _C>
+constexpr bool operator == (const FixedMatrix2D<_T, _R, _C> &x, const FixedMatrix2D<_T, _R, _C> &y) noexcept {
+    bool __eq = true;
+    fixed_for<_R * _C>([&](size_t k) { __eq &= x.Begin()[k] == y.Begin()[k]; });
+    return __eq;
+}
+
+
+template<class _T, size_t _R, size_t _C>
+constexpr bool operator != (const FixedMatrix2D<_T, _R, _C> &x, const FixedMatrix2D<_T, _R, _C> &y) noexcept { return !(x == y); }
+
+#endif // !_FIXED_H_
@@ -0,0 +1,311 @@
+#ifndef _GEMM_H_
+#define _GEMM_H_
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#include "Memory.hpp"
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+// C = alpha * A * B + beta * C, Goto/BLIS style:
+//   the k x n block of B is packed into nr wide panels that stay in L3/L2,
+//   the m x k block of A is packed into mr tall panels that stay in L2/L1,
+//   an mr x nr micro-kernel keeps its tile of C in registers for the whole k loop.
+// A and B are read through (row stride, col stride) pairs so transposed operands need no copy.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define _GEMM_VECTOR_EXT 1
+#endif
+
+#if defined(_GEMM_VECTOR_EXT) && (defined(__x86_64__) || defined(__i386__))
+#define _GEMM_X86_DISPATCH 1
+#endif
+
+constexpr size_t GEMM_KC = 256;
+constexpr size_t GEMM_MC_PANELS = 16;
+constexpr size_t GEMM_NC_PANELS = 128;
+constexpr size_t GEMM_MAX_TILE = 6 * 32;
+
+template<class _T>
+struct GemmKernel {
+    size_t mr;
+    size_t nr;
+    void (*run)(size_t, const _T*, const _T*, _T*, size_t) noexcept;
+};
+
+// Micro-kernels ----------------------------------------------------------------
+template<class _T, size_t _MR, size_t _NR>
+void gemm_scalar_kernel(size_t __kc, const _T *a, const _T *b, _T *c, size_t __rsc) noexcept {
+    _T acc[_MR][_NR] = {};
+
+    for (size_t p = 0; p < __kc; p++) {
+        for (size_t i = 0; i < _MR; i++) {
+            for (size_t j = 0; j < _NR; j++) {
+                acc[i][j] += a[i] * b[j];
+            }
+        }
+        a += _MR;
+        b += _NR;
+    }
+    for (size_t i = 0; i < _MR; i++) {
+        for (size_t j = 0; j < _NR; j++) {
+            c[i * __rsc + j] += acc[i][j];
+        }
+    }
+}
+
+
+#ifdef _GEMM_VECTOR_EXT
+// _V is a compiler vector type, each row of the tile is _NV vectors wide; the ISA is the one of the caller
+template<class _V, class _T, size_t _MR, size_t _NV>
+__attribute__((always_inline)) inline void gemm_vector_kernel(size_t __kc, const _T *a, const _T *b, _T *c, size_t __rsc) noexcept {
+    constexpr size_t __w = sizeof(_V) / sizeof(_T);
+    _V acc[_MR][_NV] = {};
+
+    for (size_t p = 0; p < __kc; p++) {
+        _V bv[_NV];
+        #pragma GCC unroll 8
+        for (size_t v = 0; v < _NV; v++) {
+            memcpy(&bv[v], b + v * __w, sizeof(_V));
+        }
+        #pragma GCC unroll 8
+        for (size_t i = 0; i < _MR; i++) {
+            _V ai = _V{} + a[i];
+            #pragma GCC unroll 8
+            for (size_t v = 0; v < _NV; v++) {
+                acc[i][v] += ai * bv[v];
+            }
+        }
+        a += _MR;
+        b += _NV * __w;
+    }
+    #pragma GCC unroll 8
+    for (size_t i = 0; i < _MR; i++) {
+        #pragma GCC unroll 8
+        for (size_t v = 0; v < _NV; v++) {
+            _V t;
+            memcpy(&t, c + i * __rsc + v * __w, sizeof(_V));
+            t += acc[i][v];
+            memcpy(c + i * __rsc + v * __w, &t, sizeof(_V));
+        }
+    }
+}
+
+typedef float gemm_f32x4 __attribute__((vector_size(16)));
+typedef float gemm_f32x8 __attribute__((vector_size(32)));
+typedef float gemm_f32x16 __attribute__((vector_size(64)));
+typedef double gemm_f64x2 __attribute__((vector_size(16)));
+typedef double gemm_f64x4 __attribute__((vector_size(32)));
+typedef double gemm_f64x8 __attribute__((vector_size(64)));
+
+// 128-bit vectors are baseline on x86-64 (SSE2) and AArch64 (NEON)
+inline void gemm_kernel_base_f32(size_t __kc, const float *a, const float *b, float *c, size_t __rsc) noexcept {
+    gemm_vector_kernel<gemm_f32x4, float, 6, 2>(__kc, a, b, c, __rsc);
+}
+
+inline void gemm_kernel_base_f64(size_t __kc, const double *a, const double *b, double *c, size_t __rsc) noexcept {
+    gemm_vector_kernel<gemm_f64x2, double, 6, 2>(__kc, a, b, c, __rsc);
+}
+#endif
+
+
+#ifdef _GEMM_X86_DISPATCH
+__attribute__((target("avx2,fma"))) inline void gemm_kernel_avx2_f32(size_t __kc, const float *a, const float *b, float *c, size_t __rsc) noexcept {
+    gemm_vector_kernel<gemm_f32x8, float, 6, 2>(__kc, a, b, c, __rsc);
+}
+
+__attribute__((target("avx2,fma"))) inline void gemm_kernel_avx2_f64(size_t __kc, const double *a, const double *b, double *c, size_t __rsc) noexcept {
+    gemm_vector_kernel<gemm_f64x4, double, 6, 2>(__kc, a, b, c, __rsc);
+}
+
+__attribute__((target("avx512f"))) inline void gemm_kernel_avx512_f32(size_t __kc, const float *a, const float *b, float *c, size_t __rsc) noexcept {
+    gemm_vector_kernel<gemm_f32x16, float, 6, 2>(__kc, a, b, c, __rsc);
+}
+
+__attribute__((target("avx512f"))) inline void gemm_kernel_avx512_f64(size_t __kc, const double *a, const double *b, double *c, size_t __rsc) noexcept {
+    gemm_vector_kernel<gemm_f64x8, double, 6, 2>(__kc, a, b, c, __rsc);
+}
+#endif
+
+// Kernel selection ----------------------------------------------------------------
+template<class _T>
+GemmKernel<_T> gemm_select_kernel() noexcept {
+    return { 4, 4, gemm_scalar_kernel<_T, 4, 4> };
+}
+
+
+template<>
+inline GemmKernel<float> gemm_select_kernel<float>() noexcept {
+#ifdef _GEMM_X86_DISPATCH
+    if (__builtin_cpu_supports("avx512f")) {
+        return { 6, 32, gemm_kernel_avx512_f32 };
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return { 6, 16, gemm_kernel_avx2_f32 };
+    }
+#endif
+#ifdef _GEMM_VECTOR_EXT
+    return { 6, 8, gemm_kernel_base_f32 };
+#else
+    return { 4, 4, gemm_scalar_kernel<float, 4, 4> };
+#endif
+}
+
+
+template<>
+inline GemmKernel<double> gemm_select_kernel<double>() noexcept {
+#ifdef _GEMM_X86_DISPATCH
+    if (__builtin_cpu_supports("avx512f")) {
+        return { 6, 16, gemm_kernel_avx512_f64 };
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return { 6, 8, gemm_kernel_avx2_f64 };
+    }
+#endif
+#ifdef _GEMM_VECTOR_EXT
+    return { 6, 4, gemm_kernel_base_f64 };
+#else
+    return { 4, 4, gemm_scalar_kernel<double, 4, 4> };
+#endif
+}
+
+
+template<class _T>
+const GemmKernel<_T>& gemm_kernel() noexcept {
+    static const GemmKernel<_T> kernel = gemm_select_kernel<_T>();
+    return kernel;
+}
+
+// Packing ----------------------------------------------------------------
+// mr tall panels of A, scaled by alpha, zero padded at the bottom edge
+template<class _T>
+void gemm_pack_a(size_t __mc, size_t __kc, size_t __mr, _T alpha, const _T *a, size_t __rsa, size_t __csa, _T *pa) noexcept {
+    for (size_t ir = 0; ir < __mc; ir += __mr) {
+        size_t __rows = min(__mr, __mc - ir);
+        for (size_t p = 0; p < __kc; p++) {
+            for (size_t i = 0; i < __rows; i++) {
+                pa[i] = alpha * a[(ir + i) * __rsa + p * __csa];
+            }
+            for (size_t i = __rows; i < __mr; i++) {
+                pa[i] = _T(0);
+            }
+            pa += __mr;
+        }
+    }
+}
+
+
+// nr wide panels of B, zero padded at the right edge
+template<class _T>
+void gemm_pack_b(size_t __kc, size_t __nc, size_t __nr, const _T *b, size_t __rsb, size_t __csb, _T *pb) noexcept {
+    for (size_t jr = 0; jr < __nc; jr += __nr) {
+        size_t __cols = min(__nr, __nc - jr);
+        for (size_t p = 0; p < __kc; p++) {
+            const _T *row = b + p * __rsb + jr * __csb;
+            if (__csb == 1) {
+                memcpy(pb, row, __cols * sizeof(_T));
+            } else {
+                for (size_t j = 0; j < __cols; j++) {
+                    pb[j] = row[j * __csb];
+                }
+            }
+            for (size_t j = __cols; j < __nr; j++) {
+                pb[j] = _T(0);
+            }
+            pb += __nr;
+        }
+    }
+}
+
+// Driver ----------------------------------------------------------------
+// runs the micro-kernel over every tile of one packed mc x nc block of C
+template<class _T>
+void gemm_macro_kernel(const GemmKernel<_T> &kernel, size_t __mc, size_t __nc, size_t __kc, const _T *pa, const _T *pb, _T *c, size_t __rsc) noexcept {
+    size_t __mr = kernel.mr, __nr = kernel.nr;
+    alignas(MEMORY_ALIGNMENT) _T tile[GEMM_MAX_TILE];
+
+    for (size_t jr = 0; jr < __nc; jr += __nr) {
+        size_t __cols = min(__nr, __nc - jr);
+        for (size_t ir = 0; ir < __mc; ir += __mr) {
+            size_t __rows = min(__mr, __mc - ir);
+            _T *ref_c = c + ir * __rsc + jr;
+
+            if (__rows == __mr && __cols == __nr) {
+                kernel.run(__kc, pa + ir * __kc, pb + jr * __kc, ref_c, __rsc);
+                continue;
+            }
+            // edge tiles go through a full size scratch tile so the kernel never writes out of bounds
+            fill(tile, tile + __mr * __nr, _T(0));
+            kernel.run(__kc, pa + ir * __kc, pb + jr * __kc, tile, __nr);
+            for (size_t i = 0; i < __rows; i++) {
+                for (size_t j = 0; j < __cols; j++) {
+                    ref_c[i * __rsc + j] += tile[i * __nr + j];
+                }
+            }
+        }
+    }
+}
+
+
+template<class _T>
+void gemm_scale(size_t __m, size_t __n, _T beta, _T *c, size_t __rsc) noexcept {
+    if (beta == _T(1)) {
+        return;
+    }
+    for (size_t i = 0; i < __m; i++) {
+        _T *row = c + i * __rsc;
+        for (size_t j = 0; j < __n; j++) {
+            row[j] = beta == _T(0) ? _T(0) : beta * row[j];
+        }
+    }
+}
+
+
+// C (m x n, row stride rsc) = alpha * A (m x k) * B (k x n) + beta * C
+template<class _T>
+void gemm(size_t __m, size_t __n, size_t __k, _T alpha,
+          const _T *a, size_t __rsa, size_t __csa,
+          const _T *b, size_t __rsb, size_t __csb,
+          _T beta, _T *c, size_t __rsc) noexcept {
+    gemm_scale(__m, __n, beta, c, __rsc);
+    if (__m == 0 || __n == 0 || __k == 0 || alpha == _T(0)) {
+        return;
+    }
+
+    const GemmKernel<_T> &kernel = gemm_kernel<_T>();
+    size_t __mr = kernel.mr, __nr = kernel.nr;
+    size_t __mc_max = min(GEMM_MC_PANELS * __mr, (__m + __mr - 1) / __mr * __mr);
+    size_t __nc_max = min(GEMM_NC_PANELS * __nr, (__n + __nr - 1) / __nr * __nr);
+    size_t __kc_max = min(GEMM_KC, __k);
+
+    size_t __blocks = (__m + __mc_max - 1) / __mc_max;
+    _T *pb = aligned_new<_T>(__kc_max * __nc_max);
+
+    for (size_t jc = 0; jc < __n; jc += __nc_max) {
+        size_t __nc = min(__nc_max, __n - jc);
+        for (size_t pc = 0; pc < __k; pc += __kc_max) {
+            size_t __kc = min(__kc_max, __k - pc);
+            gemm_pack_b(__kc, __nc, __nr, b + pc * __rsb + jc * __csb, __rsb, __csb, pb);
+
+            // every mc block of rows writes its own rows of C, so blocks run on the pool without
+            // synchronisation and each element is accumulated in the same order whatever the thread count
+            ThreadPool::Global().ParallelFor(0, __blocks, __mc_max * __nc * __kc, [&](size_t lo, size_t hi) {
+                _T *pa = aligned_new<_T>(__mc_max * __kc_max);
+                for (size_t blk = lo; blk < hi; blk++) {
+                    size_t ic = blk * __mc_max;
+                    size_t __mc = min(__mc_max, __m - ic);
+                    gemm_pack_a(__mc, __kc, __mr, alpha, a + ic * __rsa + pc * __csa, __rsa, __csa, pa);
+                    gemm_macro_kernel(kernel, __mc, __nc, __kc, pa, pb, c + ic * __rsc + jc, __rsc);
+                }
+                aligned_delete(pa);
+            });
+        }
+    }
+
+    aligned_delete(pb);
+}
+
+#endif // !_GEMM_H_
@@ -0,0 +1,102 @@
+#ifndef _GEMV_H_
+#define _GEMV_H_
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+// Matrix-vector products over a matrix whose rows are contiguous and rsa elements apart:
+//   gemv (y = A x) scores x against four rows at a time with the dot4 kernel of Simd.hpp, tasks own
+//   groups of rows, so tall matrices spread over the pool;
+//   gemv_t (y = A^T x) adds x[i] times row i into y, four rows per pass over a GEMV_COLS wide block of
+//   y that stays in L1. Rows are cut into at most GEMV_PANELS panels summed separately and the panel
+//   sums added in order afterwards, so both tall and wide matrices run on the pool.
+// Panels and groups only depend on the shape, results are the same whatever the thread count.
+
+constexpr size_t GEMV_COLS = 2048;
+constexpr size_t GEMV_PANELS = 64;
+constexpr size_t GEMV_PANEL_ROWS = 256;
+
+
+// y (m) = A (m x n) x
+template<class _T>
+void gemv(size_t __m, size_t __n, const _T *a, size_t __rsa, const _T *x, _T *y) noexcept {
+    const SimdKernels<_T> &k = simd_kernels<_T>();
+
+    ThreadPool::Global().ParallelFor(0, (__m + 3) / 4, 4 * __n, [&k, __m, __n, a, __rsa, x, y](size_t lo, size_t hi) {
+        for (size_t g = lo; g < hi; g++) {
+            size_t i = 4 * g;
+            if (i + 4 <= __m) {
+                double d[4];
+                k.dot4(a + i * __rsa, __rsa, x, __n, d);
+                for (size_t r = 0; r < 4; r++) {
+                    y[i + r] = _T(d[r]);
+                }
+                continue;
+            }
+            for (; i < __m; i++) {
+                y[i] = _T(k.dot(a + i * __rsa, x, __n));
+            }
+        }
+    });
+}
+
+
+// y[j] = sum of x[i] * A(i, j) over rows [lo, hi), for columns [j0, j1)
+template<class _T>
+void gemv_t_panel(size_t __lo, size_t __hi, size_t __j0, size_t __j1, const _T *a, size_t __rsa, const _T *x, _T *y) noexcept {
+    fill(y + __j0, y + __j1, _T(0));
+    size_t i = __lo;
+
+    for (; i + 4 <= __hi; i += 4) {
+        const _T *r0 = a + i * __rsa, *r1 = r0 + __rsa, *r2 = r1 + __rsa, *r3 = r2 + __rsa;
+        _T x0 = x[i], x1 = x[i + 1], x2 = x[i + 2], x3 = x[i + 3];
+        simd_for(__j0, __j1, [=](size_t j) { y[j] += x0 * r0[j] + x1 * r1[j] + x2 * r2[j] + x3 * r3[j]; });
+    }
+    for (; i < __hi; i++) {
+        const _T *r0 = a + i * __rsa;
+        _T x0 = x[i];
+        simd_for(__j0, __j1, [=](size_t j) { y[j] += x0 * r0[j]; });
+    }
+}
+
+
+// y (n) = A^T x, A is m x n
+template<class _T>
+void gemv_t(size_t __m, size_t __n, const _T *a, size_t __rsa, const _T *x, _T *y) noexcept {
+    if (__m == 0) {
+        fill(y, y + __n, _T(0));
+        return;
+    }
+    size_t __h = (max(GEMV_PANEL_ROWS, (__m + GEMV_PANELS - 1) / GEMV_PANELS) + 3) / 4 * 4;
+    size_t __panels = (__m + __h - 1) / __h;
+    size_t __blocks = (__n + GEMV_COLS - 1) / GEMV_COLS;
+    vector<_T> part(__panels > 1 ? __panels * __n : 0);
+    _T *ref_p = part.data();
+
+    ThreadPool::Global().ParallelFor(0, __panels * __blocks, __h * min(__n, GEMV_COLS), [&](size_t lo, size_t hi) {
+        for (size_t t = lo; t < hi; t++) {
+            size_t p = t / __blocks, j0 = t % __blocks * GEMV_COLS;
+            _T *out = __panels > 1 ? ref_p + p * __n : y;
+            gemv_t_panel(p * __h, min(__m, (p + 1) * __h), j0, min(__n, j0 + GEMV_COLS), a, __rsa, x, out);
+        }
+    });
+    if (__panels == 1) {
+        return;
+    }
+    ThreadPool::Global().ParallelFor(0, __blocks, __panels * GEMV_COLS, [&](size_t lo, size_t hi) {
+        size_t j0 = lo * GEMV_COLS, j1 = min(__n, hi * GEMV_COLS);
+        copy(ref_p + j0, ref_p + j1, y + j0);
+        for (size_t p = 1; p < __panels; p++) {
+            const _T *src = ref_p + p * __n;
+            simd_for(j0, j1, [=](size_t j) { y[j] += src[j]; });
+        }
+    });
+}
+
+#endif // !_GEMV_H_
@@ -0,0 +1,728 @@
+#ifndef _LINALG_H_
+#define _LINALG_H_
+
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "Memory.hpp"
+#include "Profile.hpp"
+#include "ThreadPool.hpp"
+#include "Simd.hpp"
+#include "Gemm.hpp"
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+
+using namespace std;
+
+// Dense factorizations of a Matrix2D, each kept as an object that solves against any number of
+// right-hand sides:
+//   LU: P A = L U with partial pivoting, recursive on halves of the columns (Toledo), so nearly all
+//   the work is one gemm per level and only LINALG_LEAF wide column strips are eliminated one column
+//   at a time;
+//   Cholesky: A = L L^T for symmetric positive definite A, right-looking in LINALG_BLOCK wide
+//   panels, the trailing lower triangle updated one block column at a time through gemm;
+//   QR: A = Q R with Householder reflectors, LINALG_BLOCK of them at a time applied as one block
+//   reflector I - V T V^T (compact WY), three gemm per block.
+// Triangular solves against a matrix are blocked the same way. Every parallel step either writes
+// disjoint rows or adds panel partials in order, so results do not depend on the thread count.
+// A factorization that fails (singular, not positive definite, rank deficient or the wrong shape)
+// reports it through Ok(), and the solves then give an empty Vector / Matrix2D.
+
+constexpr size_t LINALG_BLOCK = 128;
+constexpr size_t LINALG_LEAF = 16;
+constexpr size_t LINALG_PANELS = 64;
+constexpr size_t LINALG_PANEL_ROWS = 256;
+// columns of B a task of the blocked triangular solve takes, wide enough to vectorize
+constexpr size_t LINALG_STRIP = 64;
+
+
+// Triangular solves ----------------------------------------------------------------
+// rows [lo, hi) of the n x n triangular A against columns [c0, c1) of B, unblocked
+template<class _T>
+void linalg_trsm_block(bool __lower, bool __unit, size_t __lo, size_t __hi, const _T *a, size_t __rsa, size_t __csa,
+                       _T *b, size_t __rsb, size_t __c0, size_t __c1) noexcept {
+    for (size_t __k = __lo; __k < __hi; __k++) {
+        size_t i = __lower ? __k : __lo + __hi - 1 - __k;
+        _T *bi = b + i * __rsb;
+        size_t __p0 = __lower ? __lo : i + 1, __p1 = __lower ? i : __hi;
+        for (size_t p = __p0; p < __p1; p++) {
+            _T __aip = a[i * __rsa + p * __csa];
+            const _T *bp = b + p * __rsb;
+            simd_for(__c0, __c1, [=](size_t c) { bi[c] -= __aip * bp[c]; });
+        }
+        if (!__unit) {
+            _T __d = a[i * __rsa + i * __csa];
+            simd_for(__c0, __c1, [=](size_t c) { bi[c] /= __d; });
+        }
+    }
+}
+
+
+// one right-hand side with contiguous rows of A (dot products) or contiguous columns (axpy)
+template<class _T>
+void linalg_trsv(bool __lower, bool __unit, size_t __n, const _T *a, size_t __rsa, size_t __csa, _T *x) noexcept {
+    const SimdKernels<_T> &k = simd_kernels<_T>();
+
+    if (__csa == 1) {
+        for (size_t __s = 0; __s < __n; __s++) {
+            size_t i = __lower ? __s : __n - 1 - __s;
+            const _T *row = a + i * __rsa;
+            double __dot = __lower ? k.dot(row, x, i) : k.dot(row + i + 1, x + i + 1, __n - i - 1);
+            x[i] = _T(double(x[i]) - __dot);
+            if (!__unit) {
+                x[i] /= row[i];
+            }
+        }
+        return;
+    }
+    for (size_t __s = 0; __s < __n; __s++) {
+        size_t j = __lower ? __s : __n - 1 - __s;
+        const _T *col = a + j * __csa;
+        if (!__unit) {
+            x[j] /= col[j];
+        }
+        _T __xj = x[j];
+        if (__lower) {
+            simd_for(j + 1, __n, [=](size_t i) { x[i] -= __xj * col[i]; });
+        } else {
+            simd_for(0, j, [=](size_t i) { x[i] -= __xj * col[i]; });
+        }
+    }
+}
+
+
+// B (n x m, row stride rsb) = op(A)^-1 B in place, A n x n lower or upper triangular read through
+// (rsa, csa), with an implied unit diagonal when __unit. Blocks of LINALG_BLOCK rows are solved in
+// place, split over LINALG_STRIP wide strips of B, and the rest of B updated with gemm
+template<class _T>
+void linalg_trsm(bool __lower, bool __unit, size_t __n, size_t __m, const _T *a, size_t __rsa, size_t __csa, _T *b, size_t __rsb) noexcept {
+    if (__n == 0 || __m == 0) {
+        return;
+    }
+    if (__m == 1 && __rsb == 1 && (__csa == 1 || __rsa == 1)) {
+        linalg_trsv(__lower, __unit, __n, a, __rsa, __csa, b);
+        return;
+    }
+    size_t __blocks = (__n + LINALG_BLOCK - 1) / LINALG_BLOCK;
+    for (size_t __s = 0; __s < __blocks; __s++) {
+        size_t __blk = __lower ? __s : __blocks - 1 - __s;
+        size_t __lo = __blk * LINALG_BLOCK, __hi = min(__n, __lo + LINALG_BLOCK);
+
+        size_t __strips = (__m + LINALG_STRIP - 1) / LINALG_STRIP;
+        ThreadPool::Global().ParallelFor(0, __strips, LINALG_STRIP * (__hi - __lo) * (__hi - __lo), [&](size_t lo, size_t hi) {
+            linalg_trsm_block(__lower, __unit, __lo, __hi, a, __rsa, __csa, b, __rsb, lo * LINALG_STRIP, min(__m, hi * LINALG_STRIP));
+        });
+        if (__lower && __hi < __n) {
+            gemm(__n - __hi, __m, __hi - __lo, _T(-1), a + __hi * __rsa + __lo * __csa, __rsa, __csa,
+                 b + __lo * __rsb, __rsb, size_t(1), _T(1), b + __hi * __rsb, __rsb);
+        } else if (!__lower && __lo > 0) {
+            gemm(__lo, __m, __hi - __lo, _T(-1), a + __lo * __csa, __rsa, __csa,
+                 b + __lo * __rsb, __rsb, size_t(1), _T(1), b, __rsb);
+        }
+    }
+}
+
+
+// n x n identity, the right-hand side of Inverse
+template<class _T>
+Matrix2D<_T> linalg_identity(size_t __n) noexcept {
+    auto e = Matrix2D<_T>::ZeroInit(__n, __n);
+    for (size_t i = 0; i < __n; i++) {
+        e.RowBegin(i)[i] = _T(1);
+    }
+    return e;
+}
+
+
+// LU ----------------------------------------------------------------
+template<class _T>
+class LU {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+
+    private:
+        Matrix2D<_T> _lu;
+        // row i was swapped with row _pivots[i] >= i, in order
+        vector<size_type> _pivots;
+        int _sign = 1;
+        bool _ok = false;
+
+        void factor(size_type, size_type) noexcept;
+        void leaf(size_type, size_type) noexcept;
+        void permute(_T*, size_type, size_type) const noexcept;
+
+    public:
+        LU() noexcept = default;
+        template<class _E> explicit LU(const Matrix2DExpr<_E>&) noexcept;
+
+        // square and no zero pivot
+        constexpr bool Ok() const noexcept { return this->_ok; }
+        // L below the diagonal (its unit diagonal implied) and U on and above it
+        constexpr const Matrix2D<_T>& Factors() const noexcept { return this->_lu; }
+        const vector<size_type>& Pivots() const noexcept { return this->_pivots; }
+
+        _T Determinant() const noexcept;
+        template<class _E> Vector<_T> Solve(const VectorExpr<_E>&) const noexcept;
+        template<class _E> Matrix2D<_T> Solve(const Matrix2DExpr<_E>&) const noexcept;
+        Matrix2D<_T> Inverse() const noexcept;
+};
+
+
+template<class _T>
+template<class _E>
+LU<_T>::LU(const Matrix2DExpr<_E> &e) noexcept : _lu(e) {
+    size_type __n = this->_lu.Row();
+    _PROFILE_SCOPE("LU::LU", 2.0 * double(__n) * double(__n) * double(__n) / 3.0);
+    if (__n != this->_lu.Col()) {
+        this->_lu = Matrix2D<_T>();
+        return;
+    }
+    this->_ok = true;
+    this->_pivots.resize(__n);
+    this->factor(0, __n);
+}
+
+
+// columns [j0, j0 + w) over rows [j0, n): the left half, then the right half updated with a unit lower
+// solve and a gemm, then the right half
+template<class _T>
+void LU<_T>::factor(size_type __j0, size_type __w) noexcept {
+    if (__w <= LINALG_LEAF) {
+        this->leaf(__j0, __w);
+        return;
+    }
+    size_type __n = this->_lu.Row(), __lda = this->_lu.Stride(), __h = __w / 2;
+    _T *a = this->_lu.Begin();
+
+    this->factor(__j0, __h);
+    linalg_trsm(true, true, __h, __w - __h, a + __j0 * __lda + __j0, __lda, size_t(1), a + __j0 * __lda + __j0 + __h, __lda);
+    gemm(__n - __j0 - __h, __w - __h, __h, _T(-1), a + (__j0 + __h) * __lda + __j0, __lda, size_t(1),
+         a + __j0 * __lda + __j0 + __h, __lda, size_t(1), _T(1), a + (__j0 + __h) * __lda + __j0 + __h, __lda);
+    this->factor(__j0 + __h, __w - __h);
+}
+
+
+// one column at a time; whole rows are swapped, so the columns left and right of the strip see the
+// same permutation. The pivot of the next column is found while the rows are updated
+template<class _T>
+void LU<_T>::leaf(size_type __j0, size_type __w) noexcept {
+    size_type __n = this->_lu.Row(), __lda = this->_lu.Stride(), __end = __j0 + __w;
+    _T *a = this->_lu.Begin();
+    typedef pair<_T, size_type> candidate;
+    auto larger = [](const candidate &x, const candidate &y) { return y.first > x.first ? y : x; };
+
+    candidate __best{_T(-1), __j0};
+    for (size_type i = __j0; i < __n; i++) {
+        __best = larger(__best, {abs(a[i * __lda + __j0]), i});
+    }
+    for (size_type j = __j0; j < __end; j++) {
+        size_type p = __best.second;
+        this->_pivots[j] = p;
+        if (p != j) {
+            swap_ranges(a + j * __lda, a + j * __lda + __n, a + p * __lda);
+            this->_sign = -this->_sign;
+        }
+        const _T *u = a + j * __lda;
+        _T __piv = u[j];
+        if (__piv == _T(0)) {
+            this->_ok = false;
+        }
+        bool __next = j + 1 < __end;
+        __best = ThreadPool::Global().ParallelReduce(j + 1, __n, __end - j, candidate{_T(-1), j + 1},
+            [=](size_type lo, size_type hi) {
+                candidate __c{_T(-1), j + 1};
+                for (size_type i = lo; i < hi; i++) {
+                    _T *r = a + i * __lda;
+                    if (__piv != _T(0)) {
+                        _T __l = r[j] /= __piv;
+                        simd_for(j + 1, __end, [=](size_t c) { r[c] -= __l * u[c]; });
+                    }
+                    if (__next) {
+                        __c = larger(__c, {abs(r[j + 1]), i});
+                    }
+                }
+                return __c;
+            }, larger);
+    }
+}
+
+
+// rows swapped in the order of the pivots
+template<class _T>
+void LU<_T>::permute(_T *b, size_type __m, size_type __rsb) const noexcept {
+    for (size_type i = 0; i < this->_pivots.size(); i++) {
+        if (this->_pivots[i] != i) {
+            swap_ranges(b + i * __rsb, b + i * __rsb + __m, b + this->_pivots[i] * __rsb);
+        }
+    }
+}
+
+
+template<class _T>
+_T LU<_T>::Determinant() const noexcept {
+    size_type __n = this->_lu.Row();
+    if (!this->_ok && __n == 0) {
+        return _T(0);
+    }
+    double __det = this->_sign;
+    for (size_type i = 0; i < __n; i++) {
+        __det *= double(this->_lu.RowBegin(i)[i]);
+    }
+    return _T(__det);
+}
+
+
+template<class _T>
+template<class _E>
+Vector<_T> LU<_T>::Solve(const VectorExpr<_E> &e) const noexcept {
+    _PROFILE_SCOPE("LU::Solve", 2.0 * double(this->_lu.Row()) * double(this->_lu.Row()));
+    Vector<_T> x(e);
+    size_type __n = this->_lu.Row(), __lda = this->_lu.Stride();
+    if (!this->_ok || x.Size() != __n) {
+        return Vector<_T>();
+    }
+    this->permute(x.Begin(), 1, 1);
+    linalg_trsm(true, true, __n, size_t(1), this->_lu.Begin(), __lda, size_t(1), x.Begin(), size_t(1));
+    linalg_trsm(false, false, __n, size_t(1), this->_lu.Begin(), __lda, size_t(1), x.Begin(), size_t(1));
+    return x;
+}
+
+
+template<class _T>
+template<class _E>
+Matrix2D<_T> LU<_T>::Solve(const Matrix2DExpr<_E> &e) const noexcept {
+    Matrix2D<_T> x(e);
+    size_type __n = this->_lu.Row(), __lda = this->_lu.Stride(), __m = x.Col();
+    _PROFILE_SCOPE("LU::Solve", 2.0 * double(__n) * double(__n) * double(__m));
+    if (!this->_ok || x.Row() != __n) {
+        return Matrix2D<_T>();
+    }
+    this->permute(x.Begin(), __m, x.Stride());
+    linalg_trsm(true, true, __n, __m, this->_lu.Begin(), __lda, size_t(1), x.Begin(), x.Stride());
+    linalg_trsm(false, false, __n, __m, this->_lu.Begin(), __lda, size_t(1), x.Begin(), x.Stride());
+    return x;
+}
+
+
+template<class _T>
+Matrix2D<_T> LU<_T>::Inverse() const noexcept {
+    return this->_ok ? this->Solve(linalg_identity<_T>(this->_lu.Row())) : Matrix2D<_T>();
+}
+
+
+// Cholesky ----------------------------------------------------------------
+// only the lower triangle of the matrix is read
+template<class _T>
+class Cholesky {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+
+    private:
+        Matrix2D<_T> _l;
+        bool _ok = false;
+
+        bool factor() noexcept;
+
+    public:
+        Cholesky() noexcept = default;
+        template<class _E> explicit Cholesky(const Matrix2DExpr<_E>&) noexcept;
+
+        // square and positive definite
+        constexpr bool Ok() const noexcept { return this->_ok; }
+        // lower triangular, zeros above the diagonal
+        constexpr const Matrix2D<_T>& L() const noexcept { return this->_l; }
+
+        _T Determinant() const noexcept;
+        template<class _E> Vector<_T> Solve(const VectorExpr<_E>&) const noexcept;
+        template<class _E> Matrix2D<_T> Solve(const Matrix2DExpr<_E>&) const noexcept;
+        Matrix2D<_T> Inverse() const noexcept;
+};
+
+
+template<class _T>
+template<class _E>
+Cholesky<_T>::Cholesky(const Matrix2DExpr<_E> &e) noexcept : _l(e) {
+    size_type __n = this->_l.Row();
+    _PROFILE_SCOPE("Cholesky::Cholesky", double(__n) * double(__n) * double(__n) / 3.0);
+    if (__n != this->_l.Col()) {
+        this->_l = Matrix2D<_T>();
+        return;
+    }
+    this->_ok = this->factor();
+    for (size_type i = 0; i < __n; i++) {
+        fill(this->_l.RowBegin(i) + i + 1, this->_l.RowBegin(i) + __n, _T(0));
+    }
+}
+
+
+// the diagonal block of a panel, then the rows under it (x L11^T = a, row by row), then the block
+// columns of the trailing lower triangle; false at the first pivot that is not positive
+template<class _T>
+bool Cholesky<_T>::factor() noexcept {
+    size_type __n = this->_l.Row(), __lda = this->_l.Stride();
+    _T *a = this->_l.Begin();
+    const SimdKernels<_T> &k = simd_kernels<_T>();
+
+    for (size_type __k0 = 0; __k0 < __n; __k0 += LINALG_BLOCK) {
+        size_type __k1 = min(__n, __k0 + LINALG_BLOCK);
+        for (size_type j = __k0; j < __k1; j++) {
+            _T *rj = a + j * __lda;
+            double __d = double(rj[j]) - k.dot(rj + __k0, rj + __k0, j - __k0);
+            if (!(__d > 0)) {
+                return false;
+            }
+            rj[j] = _T(sqrt(__d));
+            for (size_type i = j + 1; i < __k1; i++) {
+                _T *ri = a + i * __lda;
+                ri[j] = _T((double(ri[j]) - k.dot(ri + __k0, rj + __k0, j - __k0)) / double(rj[j]));
+            }
+        }
+        if (__k1 == __n) {
+            break;
+        }
+        ThreadPool::Global().ParallelFor(__k1, __n, (__k1 - __k0) * (__k1 - __k0), [=, &k](size_type lo, size_type hi) {
+            for (size_type i = lo; i < hi; i++) {
+                _T *ri = a + i * __lda;
+                for (size_type j = __k0; j < __k1; j++) {
+                    const _T *rj = a + j * __lda;
+                    ri[j] = _T((double(ri[j]) - k.dot(ri + __k0, rj + __k0, j - __k0)) / double(rj[j]));
+                }
+            }
+        });
+        for (size_type __c0 = __k1; __c0 < __n; __c0 += LINALG_BLOCK) {
+            size_type __cw = min(LINALG_BLOCK, __n - __c0);
+            gemm(__n - __c0, __cw, __k1 - __k0, _T(-1), a + __c0 * __lda + __k0, __lda, size_t(1),
+                 a + __c0 * __lda + __k0, size_t(1), __lda, _T(1), a + __c0 * __lda + __c0, __lda);
+        }
+    }
+    return true;
+}
+
+
+template<class _T>
+_T Cholesky<_T>::Determinant() const noexcept {
+    double __det = 1;
+    for (size_type i = 0; i < this->_l.Row(); i++) {
+        __det *= double(this->_l.RowBegin(i)[i]);
+    }
+    return this->_ok ? _T(__det * __det) : _T(0);
+}
+
+
+template<class _T>
+template<class _E>
+Vector<_T> Cholesky<_T>::Solve(const VectorExpr<_E> &e) const noexcept {
+    _PROFILE_SCOPE("Cholesky::Solve", 2.0 * double(this->_l.Row()) * double(this->_l.Row()));
+    Vector<_T> x(e);
+    size_type __n = this->_l.Row(), __lda = this->_l.Stride();
+    if (!this->_ok || x.Size() != __n) {
+        return Vector<_T>();
+    }
+    linalg_trsm(true, false, __n, size_t(1), this->_l.Begin(), __lda, size_t(1), x.Begin(), size_t(1));
+    linalg_trsm(false, false, __n, size_t(1), this->_l.Begin(), size_t(1), __lda, x.Begin(), size_t(1));
+    return x;
+}
+
+
+template<class _T>
+template<class _E>
+Matrix2D<_T> Cholesky<_T>::Solve(const Matrix2DExpr<_E> &e) const noexcept {
+    Matrix2D<_T> x(e);
+    size_type __n = this->_l.Row(), __lda = this->_l.Stride(), __m = x.Col();
+    _PROFILE_SCOPE("Cholesky::Solve", 2.0 * double(__n) * double(__n) * double(__m));
+    if (!this->_ok || x.Row() != __n) {
+        return Matrix2D<_T>();
+    }
+    linalg_trsm(true, false, __n, __m, this->_l.Begin(), __lda, size_t(1), x.Begin(), x.Stride());
+    linalg_trsm(false, false, __n, __m, this->_l.Begin(), size_t(1), __lda, x.Begin(), x.Stride());
+    return x;
+}
+
+
+template<class _T>
+Matrix2D<_T> Cholesky<_T>::Inverse() const noexcept {
+    return this->_ok ? this->Solve(linalg_identity<_T>(this->_l.Row())) : Matrix2D<_T>();
+}
+
+
+// QR ----------------------------------------------------------------
+template<class _T>
+class QR {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+
+    private:
+        // R on and above the diagonal, the reflectors v below it (their leading 1 implied)
+        Matrix2D<_T> _qr;
+        vector<_T> _tau;
+        bool _ok = false;
+
+        void panel(size_type, size_type) noexcept;
+        void reflector(size_type, size_type, _T*, _T*) const noexcept;
+        void apply(size_type, size_type, bool, _T*, size_type, size_type) const noexcept;
+
+    public:
+        QR() noexcept = default;
+        template<class _E> explicit QR(const Matrix2DExpr<_E>&) noexcept;
+
+        // at least as many rows as columns and full rank: no diagonal entry of R below max(m, n) * epsilon
+        // times the largest one
+        constexpr bool Ok() const noexcept { return this->_ok; }
+        // the first min(rows, cols) columns of Q, and R (min(rows, cols) x cols)
+        Matrix2D<_T> Q() const noexcept;
+        Matrix2D<_T> R() const noexcept;
+
+        // least squares, x minimising |A x - b|
+        template<class _E> Vector<_T> Solve(const VectorExpr<_E>&) const noexcept;
+        template<class _E> Matrix2D<_T> Solve(const Matrix2DExpr<_E>&) const noexcept;
+};
+
+
+template<class _T>
+template<class _E>
+QR<_T>::QR(const Matrix2DExpr<_E> &e) noexcept : _qr(e) {
+    size_type __m = this->_qr.Row(), __n = this->_qr.Col(), __kmax = min(__m, __n), __lda = this->_qr.Stride();
+    _PROFILE_SCOPE("QR::QR", 2.0 * double(__m) * double(__n) * double(__kmax) - 2.0 * double(__kmax) * double(__kmax) * double(__kmax) / 3.0);
+    _T *a = this->_qr.Begin();
+    this->_tau.assign(__kmax, _T(0));
+
+    for (size_type __k = 0; __k < __kmax; __k += LINALG_BLOCK) {
+        size_type __nb = min(LINALG_BLOCK, __kmax - __k);
+        this->panel(__k, __nb);
+        if (__k + __nb < __n) {
+            this->apply(__k, __nb, true, a + __k + __nb, __n - __k - __nb, __lda);
+        }
+    }
+    // rounding leaves a rank-deficient A with tiny diagonal entries rather than zeros, so the rank is
+    // judged relative to the largest one
+    _T __scale = _T(0);
+    for (size_type j = 0; j < __kmax; j++) {
+        __scale = max(__scale, _T(fabs(a[j * __lda + j])));
+    }
+    _T __tol = __scale * _T(max(__m, __n)) * numeric_limits<_T>::epsilon();
+    this->_ok = __m >= __n && __scale > _T(0);
+    for (size_type j = 0; j < __kmax; j++) {
+        this->_ok = this->_ok && fabs(a[j * __lda + j]) > __tol;
+    }
+}
+
+
+// reflectors of columns [k, k + nb), each applied to the columns after it within the panel. The
+// products v^T A are summed over at most LINALG_PANELS row panels and the partials added in order
+template<class _T>
+void QR<_T>::panel(size_type __k, size_type __nb) noexcept {
+    size_type __m = this->_qr.Row(), __lda = this->_qr.Stride(), __end = __k + __nb;
+    _T *a = this->_qr.Begin();
+    vector<double> part;
+
+    for (size_type j = __k; j < __end; j++) {
+        _T *rj = a + j * __lda;
+        double __alpha = rj[j], __sigma = 0;
+        for (size_type i = j + 1; i < __m; i++) {
+            __sigma += double(a[i * __lda + j]) * double(a[i * __lda + j]);
+        }
+        if (__sigma == 0) {
+            this->_tau[j] = _T(0);
+            continue;
+        }
+        double __beta = -copysign(sqrt(__alpha * __alpha + __sigma), __alpha);
+        _T __tau = _T((__beta - __alpha) / __beta), __scale = _T(1.0 / (__alpha - __beta));
+        this->_tau[j] = __tau;
+        rj[j] = _T(__beta);
+        for (size_type i = j + 1; i < __m; i++) {
+            a[i * __lda + j] *= __scale;
+        }
+
+        size_type __w = __end - j - 1;
+        if (__w == 0) {
+            continue;
+        }
+        size_type __rows = __m - j - 1;
+        size_type __panels = min(LINALG_PANELS, max<size_type>(1, __rows / LINALG_PANEL_ROWS));
+        part.assign(__panels * __w, 0.0);
+        double *ref_p = part.data();
+        ThreadPool::Global().ParallelFor(0, __panels, __rows / __panels * __w, [=](size_type lo, size_type hi) {
+            for (size_type p = lo; p < hi; p++) {
+                double *w = ref_p + p * __w;
+                for (size_type i = j + 1 + p * __rows / __panels; i < j + 1 + (p + 1) * __rows / __panels; i++) {
+                    const _T *ri = a + i * __lda;
+                    double __v = ri[j];
+                    for (size_type c = 0; c < __w; c++) {
+                        w[c] += __v * double(ri[j + 1 + c]);
+                    }
+                }
+            }
+        });
+        for (size_type c = 0; c < __w; c++) {
+            double __s = rj[j + 1 + c];
+            for (size_type p = 0; p < __panels; p++) {
+                __s += ref_p[p * __w + c];
+            }
+            ref_p[c] = double(__tau) * __s;
+            rj[j + 1 + c] -= _T(ref_p[c]);
+        }
+        ThreadPool::Global().ParallelFor(j + 1, __m, __w, [=](size_type lo, size_type hi) {
+            for (size_type i = lo; i < hi; i++) {
+                _T *ri = a + i * __lda;
+                double __v = ri[j];
+                for (size_type c = 0; c < __w; c++) {
+                    ri[j + 1 + c] -= _T(__v * ref_p[c]);
+                }
+            }
+        });
+    }
+}
+
+
+// V ((m - k) x nb, unit lower trapezoidal) of the reflectors [k, k + nb) and the upper triangular
+// T (nb x nb) with H_k ... H_k+nb-1 = I - V T V^T: T(:j, j) = -tau_j T(:j, :j) V(:, :j)^T v_j
+template<class _T>
+void QR<_T>::reflector(size_type __k, size_type __nb, _T *v, _T *t) const noexcept {
+    size_type __m = this->_qr.Row(), __lda = this->_qr.Stride(), __rows = __m - __k;
+    const _T *a = this->_qr.Begin();
+
+    for (size_type i = 0; i < __rows; i++) {
+        const _T *ri = a + (__k + i) * __lda + __k;
+        for (size_type c = 0; c < __nb; c++) {
+            v[i * __nb + c] = c < i ? ri[c] : c == i ? _T(1) : _T(0);
+        }
+    }
+    _T *s = aligned_new<_T>(__nb * __nb);
+    gemm(__nb, __nb, __rows, _T(1), v, size_t(1), __nb, v, __nb, size_t(1), _T(0), s, __nb);
+    fill(t, t + __nb * __nb, _T(0));
+    for (size_type j = 0; j < __nb; j++) {
+        _T __tau = this->_tau[__k + j];
+        t[j * __nb + j] = __tau;
+        for (size_type i = 0; i < j; i++) {
+            double __acc = 0;
+            for (size_type p = i; p < j; p++) {
+                __acc += double(t[i * __nb + p]) * double(s[p * __nb + j]);
+            }
+            t[i * __nb + j] = _T(-double(__tau) * __acc);
+        }
+    }
+    aligned_delete(s);
+}
+
+
+// C (rows [k, m), nc columns, row stride ldc) = H C, or H^T C when __trans, H the block reflector of
+// [k, k + nb): C -= V op(T) (V^T C)
+template<class _T>
+void QR<_T>::apply(size_type __k, size_type __nb, bool __trans, _T *c, size_type __nc, size_type __ldc) const noexcept {
+    size_type __rows = this->_qr.Row() - __k;
+    _T *v = aligned_new<_T>(__rows * __nb), *t = aligned_new<_T>(__nb * __nb);
+    _T *w = aligned_new<_T>(__nb * __nc), *tw = aligned_new<_T>(__nb * __nc);
+    c += __k * __ldc;
+
+    this->reflector(__k, __nb, v, t);
+    gemm(__nb, __nc, __rows, _T(1), v, size_t(1), __nb, c, __ldc, size_t(1), _T(0), w, __nc);
+    gemm(__nb, __nc, __nb, _T(1), t, __trans ? size_t(1) : __nb, __trans ? __nb : size_t(1), w, __nc, size_t(1), _T(0), tw, __nc);
+    gemm(__rows, __nc, __nb, _T(-1), v, __nb, size_t(1), tw, __nc, size_t(1), _T(1), c, __ldc);
+
+    aligned_delete(v);
+    aligned_delete(t);
+    aligned_delete(w);
+    aligned_delete(tw);
+}
+
+
+// H_1 ... H_k applied to the first k columns of the identity, last block first
+template<class _T>
+Matrix2D<_T> QR<_T>::Q() const noexcept {
+    _PROFILE_SCOPE("QR::Q", 0);
+    size_type __m = this->_qr.Row(), __kmax = this->_tau.size();
+    auto q = Matrix2D<_T>::ZeroInit(__m, __kmax);
+    for (size_type i = 0; i < __kmax; i++) {
+        q.RowBegin(i)[i] = _T(1);
+    }
+    for (size_type __k = (__kmax + LINALG_BLOCK - 1) / LINALG_BLOCK * LINALG_BLOCK; __k > 0;) {
+        __k -= LINALG_BLOCK;
+        this->apply(__k, min(LINALG_BLOCK, __kmax - __k), false, q.Begin(), __kmax, q.Stride());
+    }
+    return q;
+}
+
+
+template<class _T>
+Matrix2D<_T> QR<_T>::R() const noexcept {
+    size_type __kmax = this->_tau.size(), __n = this->_qr.Col();
+    auto r = Matrix2D<_T>::ZeroInit(__kmax, __n);
+    for (size_type i = 0; i < __kmax; i++) {
+        copy(this->_qr.RowBegin(i) + i, this->_qr.RowBegin(i) + __n, r.RowBegin(i) + i);
+    }
+    return r;
+}
+
+
+// Q^T b one reflector at a time, then R x = (Q^T b)[:n]
+template<class _T>
+template<class _E>
+Vector<_T> QR<_T>::Solve(const VectorExpr<_E> &e) const noexcept {
+    size_type __m = this->_qr.Row(), __n = this->_qr.Col(), __lda = this->_qr.Stride();
+    _PROFILE_SCOPE("QR::Solve", 4.0 * double(__m) * double(__n));
+    Vector<_T> y(e);
+    if (!this->_ok || y.Size() != __m) {
+        return Vector<_T>();
+    }
+    const _T *a = this->_qr.Begin();
+    _T *ref_y = y.Begin();
+    for (size_type j = 0; j < __n; j++) {
+        double __s = ref_y[j];
+        for (size_type i = j + 1; i < __m; i++) {
+            __s += double(a[i * __lda + j]) * double(ref_y[i]);
+        }
+        _T __ts = _T(double(this->_tau[j]) * __s);
+        ref_y[j] -= __ts;
+        for (size_type i = j + 1; i < __m; i++) {
+            ref_y[i] -= __ts * a[i * __lda + j];
+        }
+    }
+    linalg_trsm(false, false, __n, size_t(1), a, __lda, size_t(1), ref_y, size_t(1));
+    return Vector<_T>(y.Begin(), __n);
+}
+
+
+template<class _T>
+template<class _E>
+Matrix2D<_T> QR<_T>::Solve(const Matrix2DExpr<_E> &e) const noexcept {
+    Matrix2D<_T> y(e);
+    size_type __m = this->_qr.Row(), __n = this->_qr.Col(), __p = y.Col();
+    _PROFILE_SCOPE("QR::Solve", 4.0 * double(__m) * double(__n) * double(__p));
+    if (!this->_ok || y.Row() != __m) {
+        return Matrix2D<_T>();
+    }
+    for (size_type __k = 0; __k < __n; __k += LINALG_BLOCK) {
+        this->apply(__k, min(LINALG_BLOCK, __n - __k), true, y.Begin(), __p, y.Stride());
+    }
+    linalg_trsm(false, false, __n, __p, this->_qr.Begin(), this->_qr.Stride(), size_t(1), y.Begin(), y.Stride());
+    return Matrix2D<_T>(y.Begin(), __n, __p, y.Stride());
+}
+
+
+// Entry points ----------------------------------------------------------------
+// A x = b for square A through LU, b a Vector or a Matrix2D of right-hand sides
+template<class _E, class _B>
+auto solve(const Matrix2DExpr<_E> &a, const _B &b) noexcept { return LU<typename _E::value_type>(a).Solve(b); }
+
+
+template<class _E>
+auto inverse(const Matrix2DExpr<_E> &a) noexcept { return LU<typename _E::value_type>(a).Inverse(); }
+
+
+template<class _E>
+auto determinant(const Matrix2DExpr<_E> &a) noexcept { return LU<typename _E::value_type>(a).Determinant(); }
+
+
+// x minimising |A x - b| through QR, A with at least as many rows as columns and full column rank
+template<class _E, class _B>
+auto least_squares(const Matrix2DExpr<_E> &a, const _B &b) noexcept { return QR<typename _E::value_type>(a).Solve(b); }
+
+#endif // !_LINALG_H_
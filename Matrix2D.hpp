@@ -9,562 +9,1185 @@ class Vector;
 #include <iostream>
 #include <random>
 #include <chrono>
+#include <cstring>
+#include <utility>
+
+#include "Memory.hpp"
+#include "Profile.hpp"
+#include "Expression.hpp"
+#include "Gemm.hpp"
+#include "Gemv.hpp"
+#include "Transpose.hpp"
+#include "View.hpp"
+#include "ThreadPool.hpp"
+#include "Statistics.hpp"
+#include "Random.hpp"
+#include "Serialize.hpp"
+#include "Text.hpp"
+#include "Vector.hpp"
+#include "Sort.hpp"
 
 using namespace std;
 using namespace chrono;
 
 enum Axis2D {
     ALL,
-    COL
+    COL,
+    ROW
 };
 
-template<class _T>
-class Matrix2D {
-    public:
-        typedef size_t size_type;
-        typedef _T** _iterator;
-
+// any matrix-shaped operand: a Matrix2D or a lazy expression over Matrix2Ds, see Expression.hpp
+template<class _E>
+class Matrix2DExpr {
     private:
-        _iterator _mat;
-        size_type _row;
-        size_type _col;
-        
-        // mutable _iterator _mat;
-        // mutable size_type _row;
-        // mutable size_type _col;
+        template<class _Update> auto sweep_columns(_Update) const noexcept;
+        template<class _Reduce> auto sweep_rows(_Reduce) const noexcept;
+        template<class _R> auto mat_vec(const VectorExpr<_R>&, bool) const noexcept;
+        template<class _R, class _F> auto sort_lines(Axis2D, size_t, bool, _F) const noexcept;
 
         auto calc_mean_for_whole_matrix() const noexcept;
         auto calc_mean_for_each_col() const noexcept;
+        auto calc_mean_for_each_row() const noexcept;
         auto calc_std_for_whole_matrix() const noexcept;
         auto calc_std_for_each_col() const noexcept;
+        auto calc_std_for_each_row() const noexcept;
         auto find_min_whole_matrix() const noexcept;
         auto find_min_for_each_col() const noexcept;
+        auto find_min_for_each_row() const noexcept;
         auto find_max_whole_matrix() const noexcept;
         auto find_max_for_each_col() const noexcept;
+        auto find_max_for_each_row() const noexcept;
+
+    public:
+        constexpr const _E& self() const noexcept { return static_cast<const _E&>(*this); }
+
+        constexpr auto Mean(Axis2D) const noexcept;
+        constexpr auto STD(Axis2D) const noexcept;
+        constexpr auto Min(Axis2D) const noexcept;
+        constexpr auto Max(Axis2D) const noexcept;
+        auto Argmax(Axis2D) const noexcept;
+
+        auto Describe(Axis2D) const noexcept;
+
+        // sorting and selection of the whole matrix (indices are row-major offsets), of each column
+        // (indices are rows) or of each row (indices are columns), see Sort.hpp. Sort and Argsort keep
+        // the shape, TopK gives a k x c (COL), r x k (ROW) or 1 x k (ALL) matrix of indices
+        auto Sort(Axis2D, bool __descending = false) const noexcept;
+        auto Argsort(Axis2D, bool __descending = false) const noexcept;
+        auto TopK(size_t, Axis2D, bool __largest = true) const noexcept;
+        auto Quantile(double, Axis2D) const noexcept;
+        auto Median(Axis2D axis) const noexcept { return this->Quantile(0.5, axis); }
+
+        // the matrix-vector products y = A x and y = A^T x, see Gemv.hpp; MatVec scores x against every
+        // row in one pass. Both give an empty vector when the size of x does not match
+        template<class _R> auto MatVec(const VectorExpr<_R> &e) const noexcept { return this->mat_vec(e, false); }
+        template<class _R> auto MatVecT(const VectorExpr<_R> &e) const noexcept { return this->mat_vec(e, true); }
+
+        // buffered, with the stream's precision and TextFormat::Global() summarizing large matrices
+        friend ostream& operator << (ostream &stream, const Matrix2DExpr<_E> &e) noexcept {
+            text_print_matrix(stream, e.self());
+            return stream;
+        }
+};
+
+
+template<class _T>
+class Matrix2D : public Matrix2DExpr<Matrix2D<_T>> {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        typedef _T* _iterator;
+        typedef const _T* const_iterator;
+
+    private:
+        // row-major storage in one contiguous buffer, element (i, j) lives at _mat[i * _stride + j]
+        // the matrix owns the buffer, allocated with aligned_new and released in the destructor
+        _iterator _mat = nullptr;
+        size_type _row = 0;
+        size_type _col = 0;
+        size_type _stride = 0;
+
+        static auto allocate(size_type, size_type) noexcept;
+
+        template<class _Op, class _E> Matrix2D<_T>& update(const Matrix2DExpr<_E>&) noexcept;
+        template<class _Op, class _E> Matrix2D<_T>& update(const VectorExpr<_E>&) noexcept;
+        template<class _Op> Matrix2D<_T>& update(const _T&) noexcept;
+
+        template<class _L, class _R> friend Matrix2D<typename _L::value_type> gemm_product(const _L&, const _R&) noexcept;
 
 
     public:
         constexpr Matrix2D() noexcept = default;
-        constexpr Matrix2D(_iterator, size_type, size_type) noexcept;
+        Matrix2D(const_iterator, size_type, size_type) noexcept;
+        Matrix2D(const_iterator, size_type, size_type, size_type) noexcept;
+        Matrix2D(const Matrix2D<_T>&) noexcept;
+        Matrix2D(Matrix2D<_T>&&) noexcept;
+        template<class _E> Matrix2D(const Matrix2DExpr<_E>&) noexcept;
+        ~Matrix2D() noexcept;
 
         static auto ZeroInit(size_type, size_type) noexcept;
         static auto OneInit(size_type, size_type) noexcept;
-        static auto RandomInit(size_type, size_type) noexcept;
-
-        constexpr _iterator Begin() const noexcept { return this->_mat; }
+        // random factories take a seed, the same seed gives the same matrix whatever the thread count;
+        // for a weight matrix applied as x * W, fan-in is Row() and fan-out is Col()
+        static auto RandomInit(size_type, size_type, uint64_t __seed = random_seed()) noexcept;
+        static auto NormalInit(size_type, size_type, _T __mean = _T(0), _T __std = _T(1), uint64_t __seed = random_seed()) noexcept;
+        static auto XavierInit(size_type, size_type, uint64_t __seed = random_seed()) noexcept;
+        static auto HeInit(size_type, size_type, uint64_t __seed = random_seed()) noexcept;
+
+        // binary files, see Serialize.hpp; Load and Map give an empty matrix when the file cannot be
+        // read, Map shares the file's pages instead of copying them and keeps the file's row stride
+        bool Save(ostream&) const noexcept;
+        bool Save(const string&) const noexcept;
+        static auto Load(istream&) noexcept;
+        static auto Load(const string&) noexcept;
+        static auto Map(const string&, bool __verify = false) noexcept;
+
+        // CSV text, see Text.hpp; precision < 0 writes every value so that it reads back exactly.
+        // ReadCSV detects the delimiter when it is 0 and gives an empty matrix when the file cannot be
+        // read; info receives the delimiter, the column names of a header line and the column types
+        bool WriteCSV(ostream&, const vector<string> &__names = {}, char __delimiter = ',', int __precision = -1) const noexcept;
+        bool WriteCSV(const string&, const vector<string> &__names = {}, char __delimiter = ',', int __precision = -1) const noexcept;
+        static auto ReadCSV(istream&, CSVInfo *__info = nullptr, char __delimiter = 0) noexcept;
+        static auto ReadCSV(const string&, CSVInfo *__info = nullptr, char __delimiter = 0) noexcept;
+
+        constexpr const_iterator Begin() const noexcept { return this->_mat; }
+        constexpr _iterator Begin() noexcept { return this->_mat; }
+        constexpr const_iterator RowBegin(size_type i) const noexcept { return this->_mat + i * this->_stride; }
+        constexpr _iterator RowBegin(size_type i) noexcept { return this->_mat + i * this->_stride; }
         constexpr size_type Row() const noexcept { return this->_row; }
         constexpr size_type Col() const noexcept { return this->_col; }
+        constexpr size_type Stride() const noexcept { return this->_stride; }
+        constexpr size_type RowStride() const noexcept { return this->_stride; }
+        constexpr size_type ColStride() const noexcept { return 1; }
+
+        // views over this matrix's buffer, see View.hpp
+        constexpr auto Row(size_type i) const & noexcept { return VectorView<_T>(this->RowBegin(i), this->_col, 1); }
+        auto Row(size_type) && noexcept = delete;
+        constexpr auto Column(size_type j) const & noexcept { return VectorView<_T>(this->_mat + j, this->_row, this->_stride); }
+        auto Column(size_type) && noexcept = delete;
+        constexpr auto Block(size_type, size_type, size_type, size_type) const & noexcept;
+        auto Block(size_type, size_type, size_type, size_type) && noexcept = delete;
+
+        constexpr auto T() const & noexcept;
+        auto T() && noexcept;
+        Matrix2D<_T>& Transpose() noexcept;
+
+        Matrix2D<_T>& operator = (const Matrix2D<_T>&) noexcept;
+        Matrix2D<_T>& operator = (Matrix2D<_T>&&) noexcept;
+        template<class _E> Matrix2D<_T>& operator = (const Matrix2DExpr<_E>&) noexcept;
+        _T operator () (const int, const int) const noexcept;
+        _T& operator () (const int, const int) noexcept;
+
+        // in place, element by element, no allocation; a Vector is applied to every row like in operator+
+        template<class _E> Matrix2D<_T>& operator += (const Matrix2DExpr<_E> &e) noexcept { return this->template update<plus<>>(e); }
+        template<class _E> Matrix2D<_T>& operator -= (const Matrix2DExpr<_E> &e) noexcept { return this->template update<minus<>>(e); }
+        template<class _E> Matrix2D<_T>& operator /= (const Matrix2DExpr<_E> &e) noexcept { return this->template update<divides<>>(e); }
+        template<class _E> Matrix2D<_T>& operator += (const VectorExpr<_E> &e) noexcept { return this->template update<plus<>>(e); }
+        template<class _E> Matrix2D<_T>& operator -= (const VectorExpr<_E> &e) noexcept { return this->template update<minus<>>(e); }
+        template<class _E> Matrix2D<_T>& operator *= (const VectorExpr<_E> &e) noexcept { return this->template update<multiplies<>>(e); }
+        template<class _E> Matrix2D<_T>& operator /= (const VectorExpr<_E> &e) noexcept { return this->template update<divides<>>(e); }
+        Matrix2D<_T>& operator += (const _T &y) noexcept { return this->template update<plus<>>(y); }
+        Matrix2D<_T>& operator -= (const _T &y) noexcept { return this->template update<minus<>>(y); }
+        Matrix2D<_T>& operator *= (const _T &y) noexcept { return this->template update<multiplies<>>(y); }
+        Matrix2D<_T>& operator /= (const _T &y) noexcept { return this->template update<divides<>>(y); }
+        // matrix * matrix is the matrix product, its result needs a buffer of its own
+        template<class _E> Matrix2D<_T>& operator *= (const Matrix2DExpr<_E> &e) noexcept { return *this = *this * e.self(); }
+
+        Matrix2D<_T> operator * (const Matrix2D<_T>&) const noexcept;
+};
 
-        constexpr auto Mean(Axis2D) const noexcept;
-        constexpr auto STD(Axis2D) const noexcept;
-        constexpr auto Min(Axis2D) const noexcept;
-        constexpr auto Max(Axis2D) const noexcept;
 
-        constexpr auto T() const noexcept;
+template<class _E>
+Matrix2D(const Matrix2DExpr<_E>&) -> Matrix2D<typename _E::value_type>;
 
-        void operator = (const Matrix2D<_T>&) const noexcept;
-        _T operator () (const int, const int) const noexcept;
-        auto operator - (const Matrix2D<_T>&) const noexcept;
-        auto operator - (const Vector<_T>&) const noexcept;
-        auto operator - (const _T&) const noexcept;
-        auto operator + (const Matrix2D<_T>&) const noexcept;
-        auto operator + (const Vector<_T>&) const noexcept;
-        auto operator + (const _T&) const noexcept;
-        auto operator * (const Matrix2D<_T>&) const noexcept;
-        auto operator * (const Vector<_T>&) const noexcept;
-        auto operator * (const _T&) const noexcept;
-        auto operator / (const Matrix2D<_T>&) const noexcept;
-        auto operator / (const Vector<_T>&) const noexcept;
-        auto operator / (const _T&) const noexcept;
-
-        friend auto operator << (const ostream& stream, const Matrix2D<_T>& mat) noexcept {
-            for (int i = 0; i < mat.Row(); i++) {
-                for (int j = 0; j < mat.Col(); j++) {
-                    cout<<mat(i, j)<<"  ";
-                }
-                cout<<endl;
-            }
-        }
-};
+
+template<class _T>
+Matrix2D<_T>::Matrix2D(const_iterator _mat, size_type __r, size_type __c) noexcept : Matrix2D(_mat, __r, __c, __c) {}
 
 
 template<class _T>
-constexpr Matrix2D<_T>::Matrix2D(_iterator _mat, size_type __r, size_type __c) noexcept {
-    this->_mat = _mat;
+Matrix2D<_T>::Matrix2D(const_iterator _mat, size_type __r, size_type __c, size_type __s) noexcept {
+    _PROFILE_SCOPE("Matrix2D::Matrix2D(copy)", 0);
+    this->_mat = aligned_new<_T>(__r * __c);
     this->_row = __r;
     this->_col = __c;
+    this->_stride = __c;
+
+    // the source may be padded between rows, the copy is always packed
+    for (size_type i = 0; i < __r; i++) {
+        memcpy(this->RowBegin(i), _mat + i * __s, __c * sizeof(_T));
+    }
+}
+
+
+template<class _T>
+Matrix2D<_T>::Matrix2D(const Matrix2D<_T> &y) noexcept : Matrix2D(y.Begin(), y.Row(), y.Col(), y.Stride()) {}
+
+
+template<class _T>
+Matrix2D<_T>::Matrix2D(Matrix2D<_T> &&y) noexcept {
+    this->_mat = y._mat;
+    this->_row = y._row;
+    this->_col = y._col;
+    this->_stride = y._stride;
+    y._mat = nullptr;
+    y._row = y._col = y._stride = 0;
+}
+
+
+// evaluates the whole expression tree in a single pass into one new buffer
+template<class _T>
+template<class _E>
+Matrix2D<_T>::Matrix2D(const Matrix2DExpr<_E> &e) noexcept {
+    _PROFILE_SCOPE("Matrix2D::Matrix2D(expression)", 0);
+    const _E &x = e.self();
+    this->_row = x.Row();
+    this->_col = x.Col();
+    this->_stride = x.Col();
+    this->_mat = aligned_new<_T>(this->_row * this->_col);
+
+    _T *ref_v = this->_mat;
+    size_type __c = this->_col;
+    // views copy contiguous rows as they are, a transposed view is copied tile by tile rather than
+    // read down its columns
+    if constexpr (is_same_v<_E, Matrix2DView<_T>>) {
+        if (x.ColStride() == 1) {
+            for (size_type i = 0; i < this->_row; i++) {
+                memcpy(ref_v + i * __c, x.Begin() + i * x.RowStride(), __c * sizeof(_T));
+            }
+            return;
+        }
+        if (x.RowStride() == 1) {
+            transpose(__c, this->_row, x.Begin(), x.ColStride(), ref_v, __c);
+            return;
+        }
+    }
+    ThreadPool::Global().ParallelFor(0, this->_row, __c, [&x, ref_v, __c](size_type lo, size_type hi) {
+        for (size_type i = lo; i < hi; i++) {
+            _T *v = ref_v + i * __c;
+            for (size_type j = 0; j < __c; j++) {
+                v[j] = x(i, j);
+            }
+        }
+    });
+}
+
+
+template<class _T>
+Matrix2D<_T>::~Matrix2D() noexcept { aligned_delete(this->_mat); }
+
+
+template<class _T>
+auto Matrix2D<_T>::allocate(size_type __r, size_type __c) noexcept {
+    Matrix2D<_T> m;
+    m._mat = aligned_new<_T>(__r * __c);
+    m._row = __r;
+    m._col = __c;
+    m._stride = __c;
+    return m;
 }
 
 
 // Initializers ----------------------------------------------------------------
 template<class _T>
 auto Matrix2D<_T>::ZeroInit(size_type __r, size_type __c) noexcept {
-    _T **v = new _T*[__r];
+    _PROFILE_SCOPE("Matrix2D::ZeroInit", 0);
+    auto m = Matrix2D::allocate(__r, __c);
+    _T *v = m.Begin();
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new _T[__c];
-        for (int j = 0; j < __c; j++) {
-            v[i][j] = _T(0);
-        }
+    for (size_type i = 0; i < __r * __c; i++) {
+        v[i] = _T(0);
     }
-    return Matrix2D(v, __r, __c);
+    return m;
 }
 
 
 template<class _T>
 auto Matrix2D<_T>::OneInit(size_type __r, size_type __c) noexcept {
-    _T **v = new _T*[__r];
+    _PROFILE_SCOPE("Matrix2D::OneInit", 0);
+    auto m = Matrix2D::allocate(__r, __c);
+    _T *v = m.Begin();
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new _T[__c];
-        for (int j = 0; j < __c; j++) {
-            v[i][j] = _T(1);
-        }
+    for (size_type i = 0; i < __r * __c; i++) {
+        v[i] = _T(1);
     }
-    return Matrix2D(v, __r, __c);
+    return m;
 }
 
 
+// uniform on [-1, 1), see Random.hpp
 template<class _T>
-auto Matrix2D<_T>::RandomInit(size_type __r, size_type __c) noexcept {
-    auto seed = system_clock::now().time_since_epoch().count();
-    default_random_engine engine(seed);
-    uniform_real_distribution<_T> distribution(-1., 1.);
-    _T **v = new _T*[__r];
+auto Matrix2D<_T>::RandomInit(size_type __r, size_type __c, uint64_t __seed) noexcept {
+    _PROFILE_SCOPE("Matrix2D::RandomInit", 0);
+    auto m = Matrix2D::allocate(__r, __c);
+    random_uniform(m.Begin(), __r * __c, __seed, _T(-1), _T(1));
+    return m;
+}
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new _T[__c];
-        for (int j = 0; j < __c; j++) {
-            v[i][j] = distribution(engine);
-        }
-    }
-    return Matrix2D(v, __r, __c);
+
+template<class _T>
+auto Matrix2D<_T>::NormalInit(size_type __r, size_type __c, _T __mean, _T __std, uint64_t __seed) noexcept {
+    _PROFILE_SCOPE("Matrix2D::NormalInit", 0);
+    auto m = Matrix2D::allocate(__r, __c);
+    random_normal(m.Begin(), __r * __c, __seed, __mean, __std);
+    return m;
 }
 
-// Statistics ----------------------------------------------------------------
+
+// Glorot / Xavier: uniform on [-a, a) with a = sqrt(6 / (fan_in + fan_out))
 template<class _T>
-auto Matrix2D<_T>::calc_mean_for_whole_matrix() const noexcept {
-    _T *sum = new _T[1];
+auto Matrix2D<_T>::XavierInit(size_type __r, size_type __c, uint64_t __seed) noexcept {
+    _PROFILE_SCOPE("Matrix2D::XavierInit", 0);
+    _T __a = sqrt(_T(6) / _T(__r + __c));
+    auto m = Matrix2D::allocate(__r, __c);
+    random_uniform(m.Begin(), __r * __c, __seed, -__a, __a);
+    return m;
+}
 
-    sum[0] = 0;
-    for (int i = 0; i < this->_row; i++) {
-        for (int j = 0; j < this->_col; j++) {
-            sum[0] += this->_mat[i][j];
-        }
+
+// He / Kaiming: normal with mean 0 and std sqrt(2 / fan_in)
+template<class _T>
+auto Matrix2D<_T>::HeInit(size_type __r, size_type __c, uint64_t __seed) noexcept {
+    _PROFILE_SCOPE("Matrix2D::HeInit", 0);
+    auto m = Matrix2D::allocate(__r, __c);
+    random_normal(m.Begin(), __r * __c, __seed, _T(0), sqrt(_T(2) / _T(__r)));
+    return m;
+}
+
+// Statistics ----------------------------------------------------------------
+// whole-matrix and per-column reductions are chunked over rows and combined in row order, per-row
+// reductions give each task a range of rows; either way the result is independent of the thread count.
+// Every kernel reads the matrix row by row, the per-column ones keep one accumulator per column and
+// update all of them from each row, so the inner loop runs over contiguous memory and vectorizes.
+template<class _E>
+template<class _Update>
+auto Matrix2DExpr<_E>::sweep_columns(_Update update) const noexcept {
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    size_t __c = x.Col();
+
+    // no row to start the accumulators from, every column gives 0
+    if (x.Row() == 0 || __c == 0) {
+        return Vector<_T>::ZeroInit(__c);
     }
-    sum[0] /= (this->_row * this->_col);
-    return Vector(sum, 1);
+    auto acc = ThreadPool::Global().ParallelReduce(0, x.Row(), __c, vector<_T>(), [&x, __c, update](size_t lo, size_t hi) {
+        vector<_T> part(__c);
+        for (size_t j = 0; j < __c; j++) {
+            part[j] = x(lo, j);
+        }
+        for (size_t i = lo + 1; i < hi; i++) {
+            _T *ref_p = part.data();
+            for (size_t j = 0; j < __c; j++) {
+                update(ref_p[j], x(i, j));
+            }
+        }
+        return part;
+    }, [__c, update](vector<_T> acc, const vector<_T> &part) {
+        if (acc.empty()) {
+            return part;
+        }
+        for (size_t j = 0; j < __c; j++) {
+            update(acc[j], part[j]);
+        }
+        return acc;
+    });
+
+    auto vec = Vector<_T>::allocate(__c);
+    memcpy(vec.Begin(), acc.data(), __c * sizeof(_T));
+    return vec;
 }
 
 
-template<class _T>
-auto Matrix2D<_T>::calc_mean_for_each_col() const noexcept {
-    _T *sum = new _T[this->_col];
+template<class _E>
+template<class _Reduce>
+auto Matrix2DExpr<_E>::sweep_rows(_Reduce reduce) const noexcept {
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    auto vec = Vector<_T>::allocate(x.Row());
+    _T *out = vec.Begin();
+
+    ThreadPool::Global().ParallelFor(0, x.Row(), x.Col(), [out, reduce](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            out[i] = reduce(i);
+        }
+    });
+    return vec;
+}
+
 
-    for (int i = 0; i < this->_col; i++) {
-        sum[i] = 0;
-        for (int j = 0; j < this->_row; j++) {
-            sum[i] += this->_mat[j][i];
+template<class _E>
+auto Matrix2DExpr<_E>::calc_mean_for_whole_matrix() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::calc_mean_for_whole_matrix", this->self().Row() * this->self().Col());
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    auto vec = Vector<_T>::allocate(1);
+
+    // summed in double like Vector::Mean, so a float matrix keeps its precision
+    double __sum = ThreadPool::Global().ParallelReduce(0, x.Row(), x.Col(), 0.0, [&x](size_t lo, size_t hi) {
+        double s = 0;
+        for (size_t i = lo; i < hi; i++) {
+            for (size_t j = 0; j < x.Col(); j++) {
+                s += double(x(i, j));
+            }
         }
-        sum[i] /= this->_row;
+        return s;
+    }, plus<double>());
+    if (x.Row() * x.Col() != 0) {
+        __sum /= double(x.Row() * x.Col());
     }
-    return Vector<_T>(sum, this->_col);
+    vec[0] = _T(__sum);
+    return vec;
 }
 
 
-template<class _T>
-constexpr auto Matrix2D<_T>::Mean(Axis2D axis) const noexcept {
+template<class _E>
+auto Matrix2DExpr<_E>::calc_mean_for_each_col() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::calc_mean_for_each_col", this->self().Row() * this->self().Col());
+    typedef typename _E::value_type _T;
+    auto vec = this->sweep_columns([](_T &acc, _T v) { acc += v; });
+    _T __r = _T(this->self().Row());
+
+    for (size_t j = 0; __r != _T(0) && j < vec.Size(); j++) {
+        vec[j] /= __r;
+    }
+    return vec;
+}
+
+
+template<class _E>
+auto Matrix2DExpr<_E>::calc_mean_for_each_row() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::calc_mean_for_each_row", this->self().Row() * this->self().Col());
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+
+    return this->sweep_rows([&x](size_t i) {
+        _T s = 0;
+        for (size_t j = 0; j < x.Col(); j++) {
+            s += x(i, j);
+        }
+        return x.Col() ? s / _T(x.Col()) : s;
+    });
+}
+
+
+template<class _E>
+constexpr auto Matrix2DExpr<_E>::Mean(Axis2D axis) const noexcept {
     switch (axis) {
         case Axis2D::ALL : return this->calc_mean_for_whole_matrix();
         case Axis2D::COL : return this->calc_mean_for_each_col();
-        default : return Vector<_T>();
+        case Axis2D::ROW : return this->calc_mean_for_each_row();
+        default : return Vector<typename _E::value_type>();
     }
 }
 
 
-template<class _T>
-auto Matrix2D<_T>::calc_std_for_whole_matrix() const noexcept {
-    auto mean = this->Mean(Axis2D::ALL)[0];
-    _T *sum = new _T[1];
+template<class _E>
+auto Matrix2DExpr<_E>::calc_std_for_whole_matrix() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::calc_std_for_whole_matrix", 3 * this->self().Row() * this->self().Col());
+    typedef typename _E::value_type _T;
+    auto vec = Vector<_T>::allocate(1);
 
-    sum[0] = 0;
-    for (int i = 0; i < this->_row; i++) {
-        for (int j = 0; j < this->_col; j++) {
-            sum[0] += pow(this->_mat[i][j] - mean, 2);
-        }
-    }
-    sum[0] = sqrt(sum[0] / (this->_row * this->_col));
-    return Vector(sum, 1);
+    vec[0] = this->Describe(Axis2D::ALL)[0].STD();
+    return vec;
 }
 
 
-template<class _T>
-auto Matrix2D<_T>::calc_std_for_each_col() const noexcept {
-    auto mean = this->Mean(Axis2D::COL);
-    size_type __l = mean.Size();
-    _T *sum = new _T[__l];
+template<class _E>
+auto Matrix2DExpr<_E>::calc_std_for_each_col() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::calc_std_for_each_col", 3 * this->self().Row() * this->self().Col());
+    typedef typename _E::value_type _T;
+    auto d = this->Describe(Axis2D::COL);
+    size_t __l = d.size();
+    auto vec = Vector<_T>::allocate(__l);
 
-    for (int i = 0; i < this->_col; i++) {
-        sum[i] = 0;
-        for (int j = 0; j < this->_row; j++) {
-            sum[i] += pow(this->_mat[j][i] - mean[i], 2);
-        }
-        sum[i] = sqrt(sum[i] / this->_row);
+    for (size_t i = 0; i < __l; i++) {
+        vec[i] = d[i].STD();
     }
-    return Vector(sum, __l);
+    return vec;
 }
 
 
-template<class _T>
-constexpr auto Matrix2D<_T>::STD(Axis2D axis) const noexcept {
+template<class _E>
+auto Matrix2DExpr<_E>::calc_std_for_each_row() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::calc_std_for_each_row", 3 * this->self().Row() * this->self().Col());
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+
+    return this->sweep_rows([&x](size_t i) {
+        return _T(describe_range<_T>(0, x.Col(), [&x, i](size_t j) { return x(i, j); }).STD());
+    });
+}
+
+
+template<class _E>
+constexpr auto Matrix2DExpr<_E>::STD(Axis2D axis) const noexcept {
     switch (axis) {
         case Axis2D::ALL : return this->calc_std_for_whole_matrix();
         case Axis2D::COL : return this->calc_std_for_each_col();
-        default : return Vector<_T>();
+        case Axis2D::ROW : return this->calc_std_for_each_row();
+        default : return Vector<typename _E::value_type>();
     }
 }
 
 
-template<class _T>
-auto Matrix2D<_T>::find_max_whole_matrix() const noexcept {
-    _T *max = new _T[1];
+template<class _E>
+auto Matrix2DExpr<_E>::find_max_whole_matrix() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::find_max_whole_matrix", 0);
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    auto vec = Vector<_T>::allocate(1);
+    _T *max = vec.Begin();
 
-    max[0] = this->_mat[0][0];
-    for (int i = 0; i < this->_row; i++) {
-        for (int j = 0; j < this->_col; j++) {
-            if (this->_mat[i][j] > max[0]) {
-                max[0] = this->_mat[i][j];
+    if (x.Row() * x.Col() == 0) {
+        max[0] = _T(0);
+        return vec;
+    }
+    max[0] = ThreadPool::Global().ParallelReduce(0, x.Row(), x.Col(), x(0, 0), [&x](size_t lo, size_t hi) {
+        _T m = x(lo, 0);
+        for (size_t i = lo; i < hi; i++) {
+            for (size_t j = 0; j < x.Col(); j++) {
+                if (x(i, j) > m) {
+                    m = x(i, j);
+                }
             }
         }
-    }
-    return Vector(max, 1);
+        return m;
+    }, [](_T a, _T b) { return b > a ? b : a; });
+    return vec;
 }
 
 
-template<class _T>
-auto Matrix2D<_T>::find_max_for_each_col() const noexcept {
-    size_type __l = this->_col;
-    _T *max = new _T[__l];
+template<class _E>
+auto Matrix2DExpr<_E>::find_max_for_each_col() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::find_max_for_each_col", 0);
+    typedef typename _E::value_type _T;
+    return this->sweep_columns([](_T &acc, _T v) { acc = v > acc ? v : acc; });
+}
 
-    for (int i = 0; i < this->_col; i++) {
-        max[i] = this->_mat[0][i];
-        for (int j = 0; j < this->_row; j++) {
-            if (this->_mat[j][i] > max[i]) {
-                max[i] = this->_mat[j][i];
-            }
+
+template<class _E>
+auto Matrix2DExpr<_E>::find_max_for_each_row() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::find_max_for_each_row", 0);
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+
+    return this->sweep_rows([&x](size_t i) {
+        if (x.Col() == 0) {
+            return _T(0);
         }
-    }
-    return Vector(max, __l);
+        _T m = x(i, 0);
+        for (size_t j = 1; j < x.Col(); j++) {
+            _T v = x(i, j);
+            m = v > m ? v : m;
+        }
+        return m;
+    });
 }
 
 
-template<class _T>
-constexpr auto Matrix2D<_T>::Max(Axis2D axis) const noexcept {
+template<class _E>
+constexpr auto Matrix2DExpr<_E>::Max(Axis2D axis) const noexcept {
     switch (axis) {
         case Axis2D::ALL : return this->find_max_whole_matrix();
         case Axis2D::COL : return this->find_max_for_each_col();
-        default : return Vector<_T>();
+        case Axis2D::ROW : return this->find_max_for_each_row();
+        default : return Vector<typename _E::value_type>();
     }
 }
 
 
-template<class _T>
-auto Matrix2D<_T>::find_min_whole_matrix() const noexcept {
-    _T *min = new _T[1];
+template<class _E>
+auto Matrix2DExpr<_E>::find_min_whole_matrix() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::find_min_whole_matrix", 0);
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    auto vec = Vector<_T>::allocate(1);
+    _T *min = vec.Begin();
 
-    min[0] = this->_mat[0][0];
-    for (int i = 0; i < this->_row; i++) {
-        for (int j = 0; j < this->_col; j++) {
-            if (this->_mat[i][j] < min[0]) {
-                min[0] = this->_mat[i][j];
+    if (x.Row() * x.Col() == 0) {
+        min[0] = _T(0);
+        return vec;
+    }
+    min[0] = ThreadPool::Global().ParallelReduce(0, x.Row(), x.Col(), x(0, 0), [&x](size_t lo, size_t hi) {
+        _T m = x(lo, 0);
+        for (size_t i = lo; i < hi; i++) {
+            for (size_t j = 0; j < x.Col(); j++) {
+                if (x(i, j) < m) {
+                    m = x(i, j);
+                }
             }
         }
-    }
-    return Vector(min, 1);
+        return m;
+    }, [](_T a, _T b) { return b < a ? b : a; });
+    return vec;
 }
 
 
-template<class _T>
-auto Matrix2D<_T>::find_min_for_each_col() const noexcept {
-    size_type __l = this->_col;
-    _T *min = new _T[__l];
+template<class _E>
+auto Matrix2DExpr<_E>::find_min_for_each_col() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::find_min_for_each_col", 0);
+    typedef typename _E::value_type _T;
+    return this->sweep_columns([](_T &acc, _T v) { acc = v < acc ? v : acc; });
+}
 
-    for (int i = 0; i < this->_col; i++) {
-        min[i] = this->_mat[0][i];
-        for (int j = 0; j < this->_row; j++) {
-            if (this->_mat[j][i] < min[i]) {
-                min[i] = this->_mat[j][i];
-            }
+
+template<class _E>
+auto Matrix2DExpr<_E>::find_min_for_each_row() const noexcept {
+    _PROFILE_SCOPE("Matrix2D::find_min_for_each_row", 0);
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+
+    return this->sweep_rows([&x](size_t i) {
+        if (x.Col() == 0) {
+            return _T(0);
         }
-    }
-    return Vector(min, __l);
+        _T m = x(i, 0);
+        for (size_t j = 1; j < x.Col(); j++) {
+            _T v = x(i, j);
+            m = v < m ? v : m;
+        }
+        return m;
+    });
 }
 
 
-template<class _T>
-constexpr auto Matrix2D<_T>::Min(Axis2D axis) const noexcept {
+template<class _E>
+constexpr auto Matrix2DExpr<_E>::Min(Axis2D axis) const noexcept {
     switch (axis) {
         case Axis2D::ALL : return this->find_min_whole_matrix();
         case Axis2D::COL : return this->find_min_for_each_col();
-        default : return Vector<_T>();
+        case Axis2D::ROW : return this->find_min_for_each_row();
+        default : return Vector<typename _E::value_type>();
     }
 }
 
-// Transpose ----------------------------------------------------------------
-template<class _T>
-constexpr auto Matrix2D<_T>::T() const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    _T **v = new _T*[__c];
 
-    for (int i = 0; i < __c; i++) {
-        v[i] = new _T[__r];
-        for (int j = 0; j < __r; j++) {
-            v[i][j] = this->_mat[j][i];
-        }
+// ALL: row-major offset of the max, COL: row of the max of each column, ROW: column of the max of each row
+template<class _E>
+auto Matrix2DExpr<_E>::Argmax(Axis2D axis) const noexcept {
+    _PROFILE_SCOPE("Matrix2D::Argmax", 0);
+    auto d = this->Describe(axis);
+    auto vec = Vector<size_t>::allocate(d.size());
+
+    for (size_t i = 0; i < d.size(); i++) {
+        vec[i] = d[i].Argmax();
     }
-    return Matrix2D(v, this->_col, this->_row);
+    return vec;
 }
 
-// Operators ----------------------------------------------------------------
-template<class _T>
-void Matrix2D<_T>::operator = (const Matrix2D<_T> &y) const noexcept {
-    this->_mat = y.Begin();
-    this->_row = y.Row();
-    this->_col = y.Col();
-}
 
+// one Description for the whole matrix (indices are row-major offsets), one per column (indices are
+// rows) or one per row (indices are columns)
+template<class _E>
+auto Matrix2DExpr<_E>::Describe(Axis2D axis) const noexcept {
+    _PROFILE_SCOPE("Matrix2D::Describe", 3 * this->self().Row() * this->self().Col());
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    size_t __c = x.Col();
+    auto &pool = ThreadPool::Global();
+
+    if (axis == Axis2D::COL) {
+        vector<Description<_T>> init(__c);
+        return pool.ParallelReduce(0, x.Row(), __c, init, [&x](size_t lo, size_t hi) {
+            return describe_columns<_T>(x, lo, hi);
+        }, [__c](vector<Description<_T>> acc, const vector<Description<_T>> &y) {
+            for (size_t j = 0; j < __c; j++) {
+                acc[j].Merge(y[j]);
+            }
+            return acc;
+        });
+    }
 
-template<class _T>
-_T Matrix2D<_T>::operator () (const int i, const int j) const noexcept {
-    return this->_mat[i][j];
+    if (axis == Axis2D::ROW) {
+        vector<Description<_T>> rows(x.Row());
+        pool.ParallelFor(0, x.Row(), __c, [&x, &rows](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                rows[i] = describe_range<_T>(0, x.Col(), [&x, i](size_t j) { return x(i, j); });
+            }
+        });
+        return rows;
+    }
+
+    auto all = pool.ParallelReduce(0, x.Row(), __c, Description<_T>(), [&x, __c](size_t lo, size_t hi) {
+        Description<_T> d;
+        for (size_t i = lo; i < hi; i++) {
+            d.Merge(describe_range<_T>(i * __c, (i + 1) * __c, [&x, i, __c](size_t k) { return x(i, k - i * __c); }));
+        }
+        return d;
+    }, [](Description<_T> acc, const Description<_T> &y) { return acc.Merge(y); });
+    return vector<Description<_T>>(1, all);
 }
 
+// Sorting and selection ----------------------------------------------------------------
+// f(line, n, out) on each column, each row or the whole matrix in row-major order, writing __len
+// results per line: the results of column j fill column j of a __len x c matrix, those of row i row i
+// of an r x __len matrix, those of the whole matrix an r x c (__keep) or 1 x __len one. Columns are
+// gathered SORT_COLUMNS at a time, reading the rows of the block in order, instead of transposing
+template<class _E>
+template<class _R, class _F>
+auto Matrix2DExpr<_E>::sort_lines(Axis2D axis, size_t __len, bool __keep, _F f) const noexcept {
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    size_t __r = x.Row(), __c = x.Col();
+    auto &pool = ThreadPool::Global();
+
+    if (axis == Axis2D::COL) {
+        auto m = Matrix2D<_R>::ZeroInit(__len, __c);
+        size_t __blocks = (__c + SORT_COLUMNS - 1) / SORT_COLUMNS;
+        pool.ParallelFor(0, __blocks, __r * SORT_COLUMNS, [&](size_t lo, size_t hi) {
+            vector<_T> lines(__r * SORT_COLUMNS);
+            vector<_R> out(__len * SORT_COLUMNS);
+            for (size_t b = lo; b < hi; b++) {
+                size_t __j0 = b * SORT_COLUMNS, __w = min(SORT_COLUMNS, __c - __j0);
+                for (size_t i = 0; i < __r; i++) {
+                    for (size_t t = 0; t < __w; t++) {
+                        lines[t * __r + i] = x(i, __j0 + t);
+                    }
+                }
+                for (size_t t = 0; t < __w; t++) {
+                    f(lines.data() + t * __r, __r, out.data() + t * __len);
+                }
+                for (size_t i = 0; i < __len; i++) {
+                    _R *mi = m.RowBegin(i) + __j0;
+                    for (size_t t = 0; t < __w; t++) {
+                        mi[t] = out[t * __len + i];
+                    }
+                }
+            }
+        });
+        return m;
+    }
 
-template<class _T>
-auto Matrix2D<_T>::operator - (const Matrix2D<_T> &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    _T **v = new _T*[__r];
+    if (axis == Axis2D::ROW) {
+        auto m = Matrix2D<_R>::ZeroInit(__r, __len);
+        pool.ParallelFor(0, __r, __c, [&](size_t lo, size_t hi) {
+            vector<_T> line;
+            for (size_t i = lo; i < hi; i++) {
+                if constexpr (is_same_v<_E, Matrix2D<_T>>) {
+                    f(x.RowBegin(i), __c, m.RowBegin(i));
+                } else {
+                    line.resize(__c);
+                    for (size_t j = 0; j < __c; j++) {
+                        line[j] = x(i, j);
+                    }
+                    f(line.data(), __c, m.RowBegin(i));
+                }
+            }
+        });
+        return m;
+    }
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
-        for (int j = 0; j < __c; j++) {
-            v[i][j] = this->_mat[i][j] - y(i, j);
+    vector<_T> all(__r * __c);
+    pool.ParallelFor(0, __r, __c, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            for (size_t j = 0; j < __c; j++) {
+                all[i * __c + j] = x(i, j);
+            }
         }
-    }
-    return Matrix2D(v, __r, __c);
+    });
+    auto m = __keep ? Matrix2D<_R>::ZeroInit(__r, __c) : Matrix2D<_R>::ZeroInit(1, __len);
+    f(all.data(), __r * __c, m.Begin());
+    return m;
 }
 
 
-template<class _T>
-auto Matrix2D<_T>::operator - (const Vector<_T> &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    size_type __l = y.Size();
+template<class _E>
+auto Matrix2DExpr<_E>::Sort(Axis2D axis, bool __descending) const noexcept {
+    _PROFILE_SCOPE("Matrix2D::Sort", 0);
+    typedef typename _E::value_type _T;
+    size_t __len = axis == Axis2D::COL ? this->self().Row() : this->self().Col();
 
+    return this->template sort_lines<_T>(axis, __len, true, [__descending](const _T *p, size_t __n, _T *out) {
+        sort_values(p, __n, __descending, out);
+    });
+}
 
-    if (__l == 1) {
-        return this->operator-(y[0]);
-    }
 
-    _T **v = new _T*[__r];
+template<class _E>
+auto Matrix2DExpr<_E>::Argsort(Axis2D axis, bool __descending) const noexcept {
+    _PROFILE_SCOPE("Matrix2D::Argsort", 0);
+    typedef typename _E::value_type _T;
+    size_t __len = axis == Axis2D::COL ? this->self().Row() : this->self().Col();
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
-    }
+    return this->template sort_lines<size_t>(axis, __len, true, [__descending](const _T *p, size_t __n, size_t *out) {
+        sort_indices(p, __n, __descending, out);
+    });
+}
 
-    for (int i = 0; i < __c; i++) {
-        for (int j = 0; j < __r; j++) {
-            v[j][i] = this->_mat[j][i] - y[i];
-        }
-    }
-    return Matrix2D(v, __r, __c);
+
+template<class _E>
+auto Matrix2DExpr<_E>::TopK(size_t __k, Axis2D axis, bool __largest) const noexcept {
+    _PROFILE_SCOPE("Matrix2D::TopK", 0);
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    size_t __n = axis == Axis2D::COL ? x.Row() : (axis == Axis2D::ROW ? x.Col() : x.Row() * x.Col());
+
+    return this->template sort_lines<size_t>(axis, min(__k, __n), false, [__k, __largest](const _T *p, size_t __m, size_t *out) {
+        sort_top_k(p, __m, __k, __largest, out);
+    });
 }
 
 
-template<class _T>
-auto Matrix2D<_T>::operator - (const _T &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    _T **v = new _T*[__r];
+// one quantile for the whole matrix, per column or per row, like Mean
+template<class _E>
+auto Matrix2DExpr<_E>::Quantile(double __q, Axis2D axis) const noexcept {
+    _PROFILE_SCOPE("Matrix2D::Quantile", 0);
+    typedef typename _E::value_type _T;
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
-        for (int j = 0; j < __c; j++) {
-            v[i][j] = this->_mat[i][j] - y;
-        }
-    }
-    return Matrix2D(v, __r, __c);
+    auto m = this->template sort_lines<_T>(axis, 1, false, [__q](const _T *p, size_t __n, _T *out) {
+        out[0] = sort_quantile(p, __n, __q);
+    });
+    return Vector<_T>(m.Begin(), m.Row() * m.Col());
 }
 
 
+// Views ----------------------------------------------------------------
+// the r x c block whose top-left element is (r0, c0), rows keep the stride of the matrix; the block is
+// clamped to the matrix, so it may have fewer rows or columns, or none
 template<class _T>
-auto Matrix2D<_T>::operator + (const Matrix2D<_T> &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    _T **v = new _T*[__r];
+constexpr auto Matrix2D<_T>::Block(size_type __r0, size_type __c0, size_type __r, size_type __c) const & noexcept {
+    __r0 = min(__r0, this->_row);
+    __c0 = min(__c0, this->_col);
+    __r = min(__r, this->_row - __r0);
+    __c = min(__c, this->_col - __c0);
+    return Matrix2DView<_T>(this->RowBegin(__r0) + __c0, __r, __c, this->_stride, 1);
+}
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
-        for (int j = 0; j < __c; j++) {
-            v[i][j] = this->_mat[i][j] + y(i, j);
-        }
-    }
-    return Matrix2D(v, __r, __c);
+// Transpose ----------------------------------------------------------------
+// a view of the same buffer with the strides swapped, nothing is copied
+template<class _T>
+constexpr auto Matrix2D<_T>::T() const & noexcept {
+    return Matrix2DView<_T>(this->_mat, this->_col, this->_row, 1, this->_stride);
 }
 
 
+// a temporary has no buffer left to view, it is transposed for real
 template<class _T>
-auto Matrix2D<_T>::operator + (const Vector<_T> &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    size_type __l = y.Size();
-
+auto Matrix2D<_T>::T() && noexcept {
+    this->Transpose();
+    return move(*this);
+}
 
-    if (__l == 1) {
-        return this->operator+(y[0]);
-    }
 
-    _T **v = new _T*[__r];
+// square matrices swap their elements in place, other shapes go through a tiled copy
+template<class _T>
+Matrix2D<_T>& Matrix2D<_T>::Transpose() noexcept {
+    _PROFILE_SCOPE("Matrix2D::Transpose", 0);
+    size_type __r = this->_row, __c = this->_col;
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
+    if (__r == __c) {
+        transpose_in_place(__r, this->_mat, this->_stride);
+        return *this;
     }
+    auto m = Matrix2D::allocate(__c, __r);
+    transpose(__r, __c, this->Begin(), this->_stride, m.Begin(), m.Stride());
+    return *this = move(m);
+}
 
-    for (int i = 0; i < __c; i++) {
-        for (int j = 0; j < __r; j++) {
-            v[j][i] = this->_mat[j][i] + y[i];
+// Operators ----------------------------------------------------------------
+template<class _T>
+Matrix2D<_T>& Matrix2D<_T>::operator = (const Matrix2D<_T> &y) noexcept {
+    if (this != &y) {
+        if (this->_row * this->_col != y.Row() * y.Col()) {
+            _T *__p = aligned_new_like<_T>(y.Row() * y.Col(), this->_mat);
+            aligned_delete(this->_mat);
+            this->_mat = __p;
+        }
+        this->_row = y.Row();
+        this->_col = y.Col();
+        this->_stride = y.Col();
+        for (size_type i = 0; i < this->_row; i++) {
+            memcpy(this->RowBegin(i), y.RowBegin(i), this->_col * sizeof(_T));
         }
     }
-    return Matrix2D(v, __r, __c);
+    return *this;
 }
 
 
+// like Vector, an arena buffer only moves into a matrix whose buffer is from the same arena
 template<class _T>
-auto Matrix2D<_T>::operator + (const _T &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    _T **v = new _T*[__r];
-
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
-        for (int j = 0; j < __c; j++) {
-            v[i][j] = this->_mat[i][j] + y;
-        }
+Matrix2D<_T>& Matrix2D<_T>::operator = (Matrix2D<_T> &&y) noexcept {
+    MemoryArena *arena = memory_arena_of(y._mat);
+    if (arena != nullptr && arena != memory_arena_of(this->_mat)) {
+        return *this = static_cast<const Matrix2D<_T>&>(y);
     }
-    return Matrix2D(v, __r, __c);
+    if (this != &y) {
+        aligned_delete(this->_mat);
+        this->_mat = y._mat;
+        this->_row = y._row;
+        this->_col = y._col;
+        this->_stride = y._stride;
+        y._mat = nullptr;
+        y._row = y._col = y._stride = 0;
+    }
+    return *this;
 }
 
 
 template<class _T>
-auto Matrix2D<_T>::operator / (const Matrix2D<_T> &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    _T **v = new _T*[__r];
-
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
-        for (int j = 0; j < __c; j++) {
-            v[i][j] = this->_mat[i][j] / y(i, j);
-        }
-    }
-    return Matrix2D(v, __r, __c);
+_T Matrix2D<_T>::operator () (const int i, const int j) const noexcept {
+    return this->_mat[i * this->_stride + j];
 }
 
 
 template<class _T>
-auto Matrix2D<_T>::operator / (const Vector<_T> &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    size_type __l = y.Size();
+_T& Matrix2D<_T>::operator () (const int i, const int j) noexcept {
+    return this->_mat[i * this->_stride + j];
+}
 
 
-    if (__l == 1) {
-        return this->operator/(y[0]);
-    }
+template<class _T>
+template<class _E>
+Matrix2D<_T>& Matrix2D<_T>::operator = (const Matrix2DExpr<_E> &e) noexcept {
+    // evaluate into a fresh buffer first, the expression may still be reading this matrix
+    return *this = Matrix2D<_T>(e);
+}
 
-    _T **v = new _T*[__r];
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
-    }
+template<class _T>
+Matrix2D<_T> Matrix2D<_T>::operator * (const Matrix2D<_T> &y) const noexcept { return gemm_product(*this, y); }
 
-    for (int i = 0; i < __c; i++) {
-        for (int j = 0; j < __r; j++) {
-            v[j][i] = this->_mat[j][i] / y[i];
+// Compound assignment ----------------------------------------------------------------
+// m(i, j) = op(m(i, j), x(i, j)) straight into the buffer, row by row; like Vector::update, x may read
+// this matrix at the same position but not at other ones (m += m.T() needs a copy of the transpose)
+template<class _T>
+template<class _Op, class _E>
+Matrix2D<_T>& Matrix2D<_T>::update(const Matrix2DExpr<_E> &e) noexcept {
+    _PROFILE_SCOPE("Matrix2D::update", this->_row * this->_col);
+    const _E &x = e.self();
+    _T *ref_v = this->_mat;
+    size_type __c = this->_col, __s = this->_stride;
+
+    ThreadPool::Global().ParallelFor(0, this->_row, __c, [&x, ref_v, __c, __s](size_type lo, size_type hi) {
+        _Op op;
+        for (size_type i = lo; i < hi; i++) {
+            _T *v = ref_v + i * __s;
+            for (size_type j = 0; j < __c; j++) {
+                v[j] = op(v[j], x(i, j));
+            }
         }
-    }
-    return Matrix2D(v, __r, __c);
+    });
+    return *this;
 }
 
 
+// y[j] applied to column j, a one element vector to every element; anything but a Vector is evaluated once first
 template<class _T>
-auto Matrix2D<_T>::operator / (const _T &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    _T **v = new _T*[__r];
-
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
-        for (int j = 0; j < __c; j++) {
-            v[i][j] = this->_mat[i][j] / y;
-        }
+template<class _Op, class _E>
+Matrix2D<_T>& Matrix2D<_T>::update(const VectorExpr<_E> &e) noexcept {
+    if constexpr (!is_same_v<_E, Vector<_T>>) {
+        return this->template update<_Op>(Vector<_T>(e));
+    } else {
+        _PROFILE_SCOPE("Matrix2D::update", this->_row * this->_col);
+        const _T *y = e.self().Begin();
+        size_type __step = e.self().Size() == 1 ? 0 : 1;
+        _T *ref_v = this->_mat;
+        size_type __c = this->_col, __s = this->_stride;
+
+        ThreadPool::Global().ParallelFor(0, this->_row, __c, [y, __step, ref_v, __c, __s](size_type lo, size_type hi) {
+            _Op op;
+            for (size_type i = lo; i < hi; i++) {
+                _T *v = ref_v + i * __s;
+                for (size_type j = 0; j < __c; j++) {
+                    v[j] = op(v[j], y[j * __step]);
+                }
+            }
+        });
+        return *this;
     }
-    return Matrix2D(v, __r, __c);
 }
 
 
 template<class _T>
-auto Matrix2D<_T>::operator * (const Matrix2D<_T> &y) const noexcept {
-    size_type _x_r = this->_row, _x_c = this->_col;
-    size_type _y_r = y.Row(), _y_c = y.Col();
+template<class _Op>
+Matrix2D<_T>& Matrix2D<_T>::update(const _T &y) noexcept {
+    _PROFILE_SCOPE("Matrix2D::update", this->_row * this->_col);
+    _T *ref_v = this->_mat;
+    size_type __c = this->_col, __s = this->_stride;
+
+    ThreadPool::Global().ParallelFor(0, this->_row, __c, [y, ref_v, __c, __s](size_type lo, size_type hi) {
+        _Op op;
+        for (size_type i = lo; i < hi; i++) {
+            _T *v = ref_v + i * __s;
+            for (size_type j = 0; j < __c; j++) {
+                v[j] = op(v[j], y);
+            }
+        }
+    });
+    return *this;
+}
+
+
+// x and y are Matrix2D or Matrix2DView, gemm reads both through their (row, col) strides
+template<class _L, class _R>
+Matrix2D<typename _L::value_type> gemm_product(const _L &x, const _R &y) noexcept {
+    _PROFILE_SCOPE("Matrix2D::operator*", 2.0 * x.Row() * x.Col() * y.Col());
+    typedef typename _L::value_type _T;
+    size_t _x_r = x.Row(), _x_c = x.Col();
+    size_t _y_c = y.Col();
+
+    auto m = Matrix2D<_T>::allocate(_x_r, _y_c);
+
+    gemm<_T>(_x_r, _y_c, _x_c, _T(1),
+             x.Begin(), x.RowStride(), x.ColStride(),
+             y.Begin(), y.RowStride(), y.ColStride(),
+             _T(0), m.Begin(), m.Stride());
+    return m;
+}
+
 
-    _T **v = new _T*[_x_r];
 
-    for (int i = 0; i < _x_r; i++) {
-        v[i] = new float[_y_c];
-        for (int j = 0; j < _y_c; j++) {
-            v[i][j] = 0;
-            for (int k = 0; k < _y_r; k++) {
-                v[i][j] += (this->_mat[i][k] * y(k, j));
+// Matrix-vector products ----------------------------------------------------------------
+// a Matrix2D or a view with unit column stride runs the product on its rows, a view with unit row
+// stride (a transposed matrix) runs the other product on the rows underneath; anything else, and any
+// vector that is not stored contiguously, is evaluated first
+template<class _E>
+template<class _R>
+auto Matrix2DExpr<_E>::mat_vec(const VectorExpr<_R> &e, bool __trans) const noexcept {
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    const _T *v = vector_data(e.self());
+
+    if constexpr (!is_strided_matrix_v<_E>) {
+        Matrix2D<_T> m(x);
+        return __trans ? m.MatVecT(e) : m.MatVec(e);
+    } else {
+        if (e.self().Size() != (__trans ? x.Row() : x.Col())) {
+            return Vector<_T>();
+        }
+        if constexpr (!is_same_v<_R, Vector<_T>>) {
+            if (v == nullptr) {
+                return this->mat_vec(Vector<_T>(e), __trans);
             }
         }
+        _PROFILE_SCOPE(__trans ? "Matrix2D::MatVecT" : "Matrix2D::MatVec", 2 * x.Row() * x.Col());
+        size_t __r = x.Row(), __c = x.Col(), __rs = x.RowStride(), __cs = x.ColStride();
+        auto y = Vector<_T>::allocate(__trans ? __c : __r);
+
+        if (__cs == 1) {
+            __trans ? gemv_t(__r, __c, x.Begin(), __rs, v, y.Begin()) : gemv(__r, __c, x.Begin(), __rs, v, y.Begin());
+        } else if (__rs == 1) {
+            __trans ? gemv(__c, __r, x.Begin(), __cs, v, y.Begin()) : gemv_t(__c, __r, x.Begin(), __cs, v, y.Begin());
+        } else if constexpr (!is_same_v<_E, Matrix2D<_T>>) {
+            Matrix2D<_T> m(x);
+            return __trans ? m.MatVecT(e) : m.MatVec(e);
+        }
+        return y;
     }
-    return Matrix2D(v, _x_r, _y_c);
 }
 
 
+// Serialization ----------------------------------------------------------------
 template<class _T>
-auto Matrix2D<_T>::operator * (const Vector<_T> &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    size_type __l = y.Size();
+bool Matrix2D<_T>::Save(ostream &out) const noexcept {
+    _PROFILE_SCOPE("Matrix2D::Save", 0);
+    return serial_save(out, 2, this->_row, this->_col, this->_stride, this->_mat);
+}
 
 
-    if (__l == 1) {
-        return this->operator*(y[0]);
-    }
+template<class _T>
+bool Matrix2D<_T>::Save(const string &__path) const noexcept {
+    ofstream out(__path, ios::binary | ios::trunc);
+    return this->Save(out);
+}
 
-    _T **v = new _T*[__r];
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
-    }
+template<class _T>
+auto Matrix2D<_T>::Load(istream &in) noexcept {
+    _PROFILE_SCOPE("Matrix2D::Load", 0);
+    Matrix2D<_T> m;
+    bool ok = serial_load<_T>(in, 2, [&m](size_type __r, size_type __c) {
+        m = Matrix2D::allocate(__r, __c);
+        return m.Begin();
+    });
+    return ok ? move(m) : Matrix2D<_T>();
+}
 
-    for (int i = 0; i < __c; i++) {
-        for (int j = 0; j < __r; j++) {
-            v[j][i] = this->_mat[j][i] * y[i];
-        }
+
+template<class _T>
+auto Matrix2D<_T>::Load(const string &__path) noexcept {
+    ifstream in(__path, ios::binary);
+    return Matrix2D::Load(in);
+}
+
+
+template<class _T>
+auto Matrix2D<_T>::Map(const string &__path, bool __verify) noexcept {
+    _PROFILE_SCOPE("Matrix2D::Map", 0);
+    Matrix2D<_T> m;
+    SerialHeader h;
+    if (_T *p = serial_map<_T>(__path, 2, h, __verify)) {
+        m._mat = p;
+        m._row = size_type(h.row);
+        m._col = size_type(h.col);
+        m._stride = size_type(h.stride);
     }
-    return Matrix2D(v, __r, __c);
+    return m;
 }
 
 
+// CSV ----------------------------------------------------------------
 template<class _T>
-auto Matrix2D<_T>::operator * (const _T &y) const noexcept {
-    size_type __r = this->_row, __c = this->_col;
-    _T **v = new _T*[__r];
+bool Matrix2D<_T>::WriteCSV(ostream &out, const vector<string> &__names, char __delimiter, int __precision) const noexcept {
+    _PROFILE_SCOPE("Matrix2D::WriteCSV", 0);
+    return text_write_csv(out, *this, __names, __delimiter, __precision);
+}
 
-    for (int i = 0; i < __r; i++) {
-        v[i] = new float[__c];
-        for (int j = 0; j < __c; j++) {
-            v[i][j] = this->_mat[i][j] * y;
-        }
-    }
-    return Matrix2D(v, __r, __c);
+
+template<class _T>
+bool Matrix2D<_T>::WriteCSV(const string &__path, const vector<string> &__names, char __delimiter, int __precision) const noexcept {
+    ofstream out(__path, ios::binary | ios::trunc);
+    return this->WriteCSV(out, __names, __delimiter, __precision);
 }
 
 
+template<class _T>
+auto Matrix2D<_T>::ReadCSV(istream &in, CSVInfo *__info, char __delimiter) noexcept {
+    _PROFILE_SCOPE("Matrix2D::ReadCSV", 0);
+    string text;
+    char chunk[TEXT_BUFFER];
+    while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0) {
+        text.append(chunk, size_t(in.gcount()));
+    }
+    Matrix2D<_T> m;
+    CSVInfo info;
+    csv_parse<_T>(text.data(), text.data() + text.size(), __delimiter, info, [&m](size_type __r, size_type __c) {
+        m = Matrix2D::allocate(__r, __c);
+        return m.Begin();
+    });
+    if (__info != nullptr) {
+        *__info = move(info);
+    }
+    return m;
+}
+
 
+// the file is mapped rather than read when the platform allows it
+template<class _T>
+auto Matrix2D<_T>::ReadCSV(const string &__path, CSVInfo *__info, char __delimiter) noexcept {
+    _PROFILE_SCOPE("Matrix2D::ReadCSV", 0);
+#ifdef _MEMORY_MMAP
+    size_t __bytes = 0;
+    char *text = memory_map(__path, __bytes);
+    if (text == nullptr) {
+        ifstream in(__path, ios::binary);
+        return in ? Matrix2D::ReadCSV(in, __info, __delimiter) : Matrix2D<_T>();
+    }
+    Matrix2D<_T> m;
+    CSVInfo info;
+    csv_parse<_T>(text, text + __bytes, __delimiter, info, [&m](size_type __r, size_type __c) {
+        m = Matrix2D::allocate(__r, __c);
+        return m.Begin();
+    });
+    memory_unmap(text, __bytes);
+    if (__info != nullptr) {
+        *__info = move(info);
+    }
+    return m;
+#else
+    ifstream in(__path, ios::binary);
+    return Matrix2D::ReadCSV(in, __info, __delimiter);
+#endif
+}
 
-#endif // !_MATRIX2D_H_
\ No newline at end of file
+#endif // !_MATRIX2D_H_
@@ -0,0 +1,403 @@
+#ifndef _MEMORY_H_
+#define _MEMORY_H_
+
+#include <new>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include <string>
+
+#include "Profile.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define _MEMORY_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+// every buffer is aligned to a cache line so rows can be streamed with SIMD loads
+constexpr size_t MEMORY_ALIGNMENT = 64;
+
+// Vector and Matrix2D buffers come from one of three places, picked by aligned_new:
+//   an ArenaScope active on the calling thread: bumped out of the scope's arena, freed all at once
+//     when the scope ends (aligned_delete does nothing for them). Assigning to a container keeps the
+//     kind of buffer it had (aligned_new_like), so one created outside the scope, or empty, never
+//     receives an arena buffer;
+//   otherwise, up to MEMORY_POOL_MAX bytes: a power of two size class of the thread's pool, handed
+//     back to the pool of whichever thread frees it and reused by the next allocation of that class;
+//   larger buffers: the global aligned operator new.
+// A one cache line header in front of every buffer records where it came from, so a buffer can be
+// released from any thread and by code that does not know about arenas. Buffers opened with Map (see
+// Serialize.hpp) live inside a private file mapping that has room for the header, and are unmapped.
+constexpr size_t MEMORY_POOL_MIN = 64;
+constexpr size_t MEMORY_POOL_MAX = size_t(1) << 20;
+constexpr size_t MEMORY_POOL_CLASSES = 15;          // 64 B .. 1 MB
+constexpr size_t MEMORY_POOL_CACHE = size_t(4) << 20; // bytes kept per size class and thread
+constexpr size_t MEMORY_ARENA_BLOCK = size_t(1) << 20;
+
+enum class MemorySource : uint32_t {
+    HEAP,
+    POOL,
+    ARENA,
+    MAPPED
+};
+
+class MemoryArena;
+
+struct alignas(MEMORY_ALIGNMENT) MemoryHeader {
+    MemorySource source;
+    uint32_t size_class;
+    size_t bytes;
+    size_t offset;      // MAPPED: from the start of the mapping to the header
+    MemoryArena *arena; // ARENA: the arena it was bumped out of
+};
+
+
+inline void* memory_heap_new(size_t __bytes) noexcept {
+    return ::operator new[](__bytes, align_val_t(MEMORY_ALIGNMENT), nothrow);
+}
+
+
+inline void memory_heap_delete(void *__p) noexcept {
+    ::operator delete[](__p, align_val_t(MEMORY_ALIGNMENT));
+}
+
+
+#ifdef _MEMORY_MMAP
+// the whole file, private and copy on write: pages are read on first touch and writes never reach
+// the file; nullptr when it cannot be opened
+inline char* memory_map(const string &__path, size_t &__bytes) noexcept {
+    int fd = open(__path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        __bytes = size_t(st.st_size);
+        p = mmap(nullptr, __bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    return p == MAP_FAILED ? nullptr : static_cast<char*>(p);
+}
+
+
+inline void memory_unmap(void *__p, size_t __bytes) noexcept { munmap(__p, __bytes); }
+#endif
+
+
+// Pool ----------------------------------------------------------------
+// per-thread free lists of blocks, one list per power of two size class; no locks, a block freed on
+// another thread simply joins that thread's lists
+class MemoryPool {
+    private:
+        vector<void*> free_blocks[MEMORY_POOL_CLASSES];
+
+        static bool& destroyed() noexcept;
+
+    public:
+        MemoryPool() noexcept = default;
+        MemoryPool(const MemoryPool&) = delete;
+        MemoryPool& operator = (const MemoryPool&) = delete;
+        ~MemoryPool() noexcept;
+
+        // the calling thread's pool, nullptr once it has been destroyed at thread exit
+        static MemoryPool* Local() noexcept;
+        static constexpr size_t SizeClass(size_t) noexcept;
+        static constexpr size_t ClassBytes(size_t __k) noexcept { return MEMORY_POOL_MIN << __k; }
+
+        void* Allocate(size_t __k) noexcept;
+        void Release(void*, size_t __k) noexcept;
+        void Trim() noexcept;
+};
+
+
+inline MemoryPool::~MemoryPool() noexcept {
+    this->Trim();
+    MemoryPool::destroyed() = true;
+}
+
+
+// buffers released by static objects after the thread's pool is gone go back to the heap
+inline bool& MemoryPool::destroyed() noexcept {
+    static thread_local bool flag = false;
+    return flag;
+}
+
+
+inline MemoryPool* MemoryPool::Local() noexcept {
+    if (MemoryPool::destroyed()) {
+        return nullptr;
+    }
+    static thread_local MemoryPool pool;
+    return &pool;
+}
+
+
+// smallest class whose blocks hold __bytes, MEMORY_POOL_CLASSES when it is too large for the pool
+constexpr size_t MemoryPool::SizeClass(size_t __bytes) noexcept {
+    size_t __k = 0;
+    while (__k < MEMORY_POOL_CLASSES && MemoryPool::ClassBytes(__k) < __bytes) {
+        __k++;
+    }
+    return __k;
+}
+
+
+inline void* MemoryPool::Allocate(size_t __k) noexcept {
+    auto &blocks = this->free_blocks[__k];
+    if (blocks.empty()) {
+        return memory_heap_new(MemoryPool::ClassBytes(__k));
+    }
+    void *p = blocks.back();
+    blocks.pop_back();
+    return p;
+}
+
+
+inline void MemoryPool::Release(void *__p, size_t __k) noexcept {
+    auto &blocks = this->free_blocks[__k];
+    if ((blocks.size() + 1) * MemoryPool::ClassBytes(__k) > MEMORY_POOL_CACHE) {
+        memory_heap_delete(__p);
+        return;
+    }
+    blocks.push_back(__p);
+}
+
+
+// gives every cached block back to the heap
+inline void MemoryPool::Trim() noexcept {
+    for (auto &blocks : this->free_blocks) {
+        for (void *p : blocks) {
+            memory_heap_delete(p);
+        }
+        blocks.clear();
+        blocks.shrink_to_fit();
+    }
+}
+
+
+// Arena ----------------------------------------------------------------
+// bump allocator over a chain of blocks, nothing is freed until Reset or destruction
+class MemoryArena {
+    private:
+        struct block_type {
+            char *data;
+            size_t size;
+        };
+
+        vector<block_type> blocks;
+        size_t current = 0;
+        size_t offset = 0;
+        size_t block_size;
+        // buffers handed out and not yet released by aligned_delete, which may run on any thread
+        atomic<size_t> live{0};
+
+    public:
+        explicit MemoryArena(size_t __block_size = MEMORY_ARENA_BLOCK) noexcept : block_size(__block_size) {}
+        MemoryArena(const MemoryArena&) = delete;
+        MemoryArena& operator = (const MemoryArena&) = delete;
+        ~MemoryArena() noexcept;
+
+        void* Allocate(size_t) noexcept;
+        void Reset() noexcept;
+        size_t Capacity() const noexcept;
+        size_t Live() const noexcept { return this->live.load(memory_order_relaxed); }
+
+        void Acquire() noexcept { this->live.fetch_add(1, memory_order_relaxed); }
+        void Release() noexcept { this->live.fetch_sub(1, memory_order_relaxed); }
+};
+
+
+inline MemoryArena::~MemoryArena() noexcept {
+    for (auto &b : this->blocks) {
+        memory_heap_delete(b.data);
+    }
+}
+
+
+inline void* MemoryArena::Allocate(size_t __bytes) noexcept {
+    __bytes = (__bytes + MEMORY_ALIGNMENT - 1) / MEMORY_ALIGNMENT * MEMORY_ALIGNMENT;
+
+    // blocks kept by Reset are reused in order before a new one is added
+    while (this->current < this->blocks.size()) {
+        auto &b = this->blocks[this->current];
+        if (this->offset + __bytes <= b.size) {
+            void *p = b.data + this->offset;
+            this->offset += __bytes;
+            return p;
+        }
+        this->current++;
+        this->offset = 0;
+    }
+
+    size_t __size = max(this->block_size, __bytes);
+    char *data = static_cast<char*>(memory_heap_new(__size));
+    if (data == nullptr) {
+        return nullptr;
+    }
+    this->blocks.push_back({data, __size});
+    this->current = this->blocks.size() - 1;
+    this->offset = __bytes;
+    return data;
+}
+
+
+// every allocation is dropped at once, the blocks are kept for the next round
+inline void MemoryArena::Reset() noexcept {
+    this->current = 0;
+    this->offset = 0;
+}
+
+
+inline size_t MemoryArena::Capacity() const noexcept {
+    size_t __c = 0;
+    for (auto &b : this->blocks) {
+        __c += b.size;
+    }
+    return __c;
+}
+
+
+// while alive, every Vector / Matrix2D buffer allocated by this thread comes from the arena and is
+// released when the scope ends: containers created inside must not be used after it, debug builds
+// assert that none is still alive when the scope ends. Scopes nest, the innermost one is used.
+class ArenaScope {
+    private:
+        MemoryArena own;
+        MemoryArena *arena;
+        MemoryArena *previous;
+
+        static MemoryArena*& active() noexcept;
+
+    public:
+        explicit ArenaScope(size_t __block_size = MEMORY_ARENA_BLOCK) noexcept;
+        explicit ArenaScope(MemoryArena&) noexcept;
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator = (const ArenaScope&) = delete;
+        ~ArenaScope() noexcept;
+
+        static MemoryArena* Active() noexcept { return ArenaScope::active(); }
+        MemoryArena& Arena() noexcept { return *this->arena; }
+};
+
+
+inline MemoryArena*& ArenaScope::active() noexcept {
+    static thread_local MemoryArena *arena = nullptr;
+    return arena;
+}
+
+
+inline ArenaScope::ArenaScope(size_t __block_size) noexcept : own(__block_size) {
+    this->arena = &this->own;
+    this->previous = ArenaScope::active();
+    ArenaScope::active() = this->arena;
+}
+
+
+// a caller provided arena is reset, not freed, at the end of the scope so its blocks serve the next one
+inline ArenaScope::ArenaScope(MemoryArena &__arena) noexcept {
+    this->arena = &__arena;
+    this->previous = ArenaScope::active();
+    ArenaScope::active() = this->arena;
+}
+
+
+inline ArenaScope::~ArenaScope() noexcept {
+    assert(this->arena->Live() == 0 && "a container allocated inside an ArenaScope outlives it");
+    ArenaScope::active() = this->previous;
+    if (this->arena != &this->own) {
+        this->arena->Reset();
+    }
+}
+
+
+// Allocation ----------------------------------------------------------------
+// from the arena when it is not null, otherwise from the pool or the heap
+template<class _T>
+_T* memory_new(size_t __l, MemoryArena *arena) noexcept {
+    if (__l > (SIZE_MAX - sizeof(MemoryHeader)) / sizeof(_T)) {
+        return nullptr;
+    }
+    size_t __bytes = __l * sizeof(_T) + sizeof(MemoryHeader);
+    MemoryHeader header{MemorySource::HEAP, 0, __bytes, 0, nullptr};
+    void *p;
+
+    MemoryPool *pool = arena == nullptr && __bytes <= MEMORY_POOL_MAX ? MemoryPool::Local() : nullptr;
+
+    if (arena != nullptr) {
+        header.source = MemorySource::ARENA;
+        header.arena = arena;
+        p = arena->Allocate(__bytes);
+    } else if (pool != nullptr) {
+        header.source = MemorySource::POOL;
+        header.size_class = uint32_t(MemoryPool::SizeClass(__bytes));
+        p = pool->Allocate(header.size_class);
+    } else {
+        p = memory_heap_new(__bytes);
+    }
+    if (p == nullptr) {
+        return nullptr;
+    }
+    if (arena != nullptr) {
+        arena->Acquire();
+    }
+    *static_cast<MemoryHeader*>(p) = header;
+    _PROFILE_ALLOCATE(__bytes, header.source != MemorySource::ARENA);
+    return reinterpret_cast<_T*>(static_cast<MemoryHeader*>(p) + 1);
+}
+
+
+// the arena __p was bumped out of, nullptr for any other buffer
+template<class _T>
+MemoryArena* memory_arena_of(const _T *__p) noexcept {
+    if (__p == nullptr) {
+        return nullptr;
+    }
+    const MemoryHeader *header = reinterpret_cast<const MemoryHeader*>(__p) - 1;
+    return header->source == MemorySource::ARENA ? header->arena : nullptr;
+}
+
+
+// from the innermost ArenaScope of this thread, if any
+template<class _T>
+_T* aligned_new(size_t __l) noexcept { return memory_new<_T>(__l, ArenaScope::Active()); }
+
+
+// from the same place as __like: its arena when it is an arena buffer, otherwise the pool or the heap
+// whatever scope is active. Containers assigned to take their new buffer this way
+template<class _T>
+_T* aligned_new_like(size_t __l, const _T *__like) noexcept { return memory_new<_T>(__l, memory_arena_of(__like)); }
+
+
+template<class _T>
+void aligned_delete(_T *__p) noexcept {
+    if (__p == nullptr) {
+        return;
+    }
+    MemoryHeader *header = reinterpret_cast<MemoryHeader*>(const_cast<remove_cv_t<_T>*>(__p)) - 1;
+
+    MemoryPool *pool = MemoryPool::Local();
+
+    if (header->source == MemorySource::HEAP || header->source == MemorySource::POOL) {
+        _PROFILE_RELEASE(header->bytes);
+    }
+    switch (header->source) {
+        case MemorySource::ARENA : return header->arena->Release();
+#ifdef _MEMORY_MMAP
+        case MemorySource::MAPPED : return memory_unmap(reinterpret_cast<char*>(header) - header->offset, header->bytes);
+#endif
+        case MemorySource::POOL : return pool != nullptr ? pool->Release(header, header->size_class) : memory_heap_delete(header);
+        default : return memory_heap_delete(header);
+    }
+}
+
+#endif // !_MEMORY_H_
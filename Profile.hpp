@@ -0,0 +1,266 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+// Opt-in instrumentation of Vector and Matrix2D operations, compiled in when CVM_PROFILE is defined
+// (the CVM_PROFILE CMake option) and expanding to nothing otherwise:
+//   every instrumented operation counts its calls, wall time, floating point operations and the bytes
+//   it allocated (inclusive of the operations it calls, and of anything other threads allocated
+//   meanwhile); aligned_new and aligned_delete keep the live and peak bytes of all buffers.
+//   Profiler::Global().WriteSummary prints a table sorted by total time, WriteTrace writes the
+//   recorded calls as Chrome trace-event JSON (chrome://tracing, Perfetto) once SetTrace(true) is on.
+
+#ifdef CVM_PROFILE
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <ostream>
+#include <fstream>
+
+using namespace std;
+
+// trace events kept at most, later calls are only counted
+constexpr size_t PROFILE_TRACE_LIMIT = size_t(1) << 20;
+
+struct ProfileStats {
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+    uint64_t min_nanoseconds = UINT64_MAX;
+    uint64_t max_nanoseconds = 0;
+    double flops = 0;
+    uint64_t bytes = 0;
+};
+
+struct ProfileEvent {
+    const char *name;
+    uint64_t start;         // nanoseconds since the profiler was created
+    uint64_t duration;
+    uint32_t thread;
+    double flops;
+    uint64_t bytes;
+    int64_t live;           // live bytes when the call returned
+};
+
+
+class Profiler {
+    private:
+        mutable mutex lock;
+        // keyed by the address of the name, Stats merges equal names from different translation units
+        unordered_map<const char*, ProfileStats> stats;
+        vector<ProfileEvent> events;
+        atomic<bool> trace{false};
+        chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+        atomic<int64_t> live{0};
+        atomic<int64_t> peak{0};
+        atomic<uint64_t> allocated{0};
+        atomic<uint64_t> allocations{0};
+
+    public:
+        static Profiler& Global() noexcept;
+
+        uint64_t Now() const noexcept;
+        static uint32_t ThreadIndex() noexcept;
+
+        void Allocate(size_t, bool __live) noexcept;
+        void Release(size_t) noexcept;
+        void Record(const char*, uint64_t __start, uint64_t __duration, double __flops, uint64_t __bytes) noexcept;
+
+        uint64_t Allocated() const noexcept { return this->allocated; }
+        int64_t Live() const noexcept { return this->live; }
+        int64_t Peak() const noexcept { return this->peak; }
+        unordered_map<string, ProfileStats> Stats() const noexcept;
+
+        // tracing keeps one event per call, off by default
+        void SetTrace(bool __on) noexcept { this->trace = __on; }
+        // drops the counters and events, the peak restarts from the bytes live now
+        void Reset() noexcept;
+
+        void WriteSummary(ostream&) const noexcept;
+        bool WriteTrace(ostream&) const noexcept;
+        bool WriteTrace(const string&) const noexcept;
+};
+
+
+// never destroyed, so buffers released by static objects at exit can still be counted
+inline Profiler& Profiler::Global() noexcept {
+    static Profiler *profiler = new Profiler();
+    return *profiler;
+}
+
+
+inline uint64_t Profiler::Now() const noexcept {
+    return uint64_t(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - this->epoch).count());
+}
+
+
+// small per-thread ids for the trace, in order of first use
+inline uint32_t Profiler::ThreadIndex() noexcept {
+    static atomic<uint32_t> next{0};
+    static thread_local uint32_t index = next++;
+    return index;
+}
+
+
+// arena buffers are never released one by one, they count as allocated but not as live (__live false)
+inline void Profiler::Allocate(size_t __bytes, bool __live) noexcept {
+    this->allocated += __bytes;
+    this->allocations++;
+    if (!__live) {
+        return;
+    }
+    int64_t __now = this->live += int64_t(__bytes);
+    int64_t __peak = this->peak;
+    while (__now > __peak && !this->peak.compare_exchange_weak(__peak, __now)) {}
+}
+
+
+inline void Profiler::Release(size_t __bytes) noexcept { this->live -= int64_t(__bytes); }
+
+
+inline void Profiler::Record(const char *__name, uint64_t __start, uint64_t __duration, double __flops, uint64_t __bytes) noexcept {
+    lock_guard<mutex> guard(this->lock);
+    ProfileStats &s = this->stats[__name];
+    s.calls++;
+    s.nanoseconds += __duration;
+    s.min_nanoseconds = min(s.min_nanoseconds, __duration);
+    s.max_nanoseconds = max(s.max_nanoseconds, __duration);
+    s.flops += __flops;
+    s.bytes += __bytes;
+    if (this->trace && this->events.size() < PROFILE_TRACE_LIMIT) {
+        this->events.push_back({__name, __start, __duration, Profiler::ThreadIndex(), __flops, __bytes, this->live});
+    }
+}
+
+
+inline unordered_map<string, ProfileStats> Profiler::Stats() const noexcept {
+    lock_guard<mutex> guard(this->lock);
+    unordered_map<string, ProfileStats> all;
+    for (auto &[name, s] : this->stats) {
+        ProfileStats &t = all[name];
+        t.calls += s.calls;
+        t.nanoseconds += s.nanoseconds;
+        t.min_nanoseconds = min(t.min_nanoseconds, s.min_nanoseconds);
+        t.max_nanoseconds = max(t.max_nanoseconds, s.max_nanoseconds);
+        t.flops += s.flops;
+        t.bytes += s.bytes;
+    }
+    return all;
+}
+
+
+inline void Profiler::Reset() noexcept {
+    lock_guard<mutex> guard(this->lock);
+    this->stats.clear();
+    this->events.clear();
+    this->allocated = 0;
+    this->allocations = 0;
+    this->peak = int64_t(this->live);
+}
+
+
+// Export ----------------------------------------------------------------
+inline void Profiler::WriteSummary(ostream &out) const noexcept {
+    auto all = this->Stats();
+    vector<pair<string, ProfileStats>> rows(all.begin(), all.end());
+    sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) { return a.second.nanoseconds > b.second.nanoseconds; });
+
+    size_t __width = 9;
+    for (auto &r : rows) {
+        __width = max(__width, r.first.size());
+    }
+    char line[512];
+    snprintf(line, sizeof(line), "%-*s %10s %12s %12s %12s %10s %12s\n", int(__width), "operation",
+             "calls", "total ms", "mean us", "max us", "GFLOP/s", "MB alloc");
+    out << line;
+    for (auto &[name, s] : rows) {
+        double __seconds = double(s.nanoseconds) * 1e-9;
+        snprintf(line, sizeof(line), "%-*s %10llu %12.3f %12.3f %12.3f %10.3f %12.3f\n", int(__width), name.c_str(),
+                 (unsigned long long)s.calls, double(s.nanoseconds) * 1e-6, double(s.nanoseconds) * 1e-3 / double(s.calls),
+                 double(s.max_nanoseconds) * 1e-3, __seconds > 0 ? s.flops * 1e-9 / __seconds : 0.0, double(s.bytes) / 1e6);
+        out << line;
+    }
+    snprintf(line, sizeof(line), "allocated %.3f MB in %llu buffers, live %.3f MB, peak live %.3f MB\n",
+             double(this->allocated) / 1e6, (unsigned long long)this->allocations.load(),
+             double(this->live) / 1e6, double(this->peak) / 1e6);
+    out << line;
+}
+
+
+// complete ("X") events with their FLOPs and bytes as arguments, and a "live bytes" counter track
+inline bool Profiler::WriteTrace(ostream &out) const noexcept {
+    lock_guard<mutex> guard(this->lock);
+    char line[512];
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t k = 0; k < this->events.size(); k++) {
+        const ProfileEvent &e = this->events[k];
+        string name;
+        for (const char *p = e.name; *p; p++) {
+            if (*p == '"' || *p == '\\') {
+                name += '\\';
+            }
+            name += *p;
+        }
+        snprintf(line, sizeof(line),
+                 "%s\n{\"name\":\"%s\",\"cat\":\"cvm\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                 "\"args\":{\"flops\":%.0f,\"bytes\":%llu}},"
+                 "\n{\"name\":\"live bytes\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"live\":%lld}}",
+                 k ? "," : "", name.c_str(), e.thread, double(e.start) * 1e-3, double(e.duration) * 1e-3, e.flops,
+                 (unsigned long long)e.bytes, double(e.start + e.duration) * 1e-3, (long long)e.live);
+        out << line;
+    }
+    out << "\n]}\n";
+    return bool(out.flush());
+}
+
+
+inline bool Profiler::WriteTrace(const string &__path) const noexcept {
+    ofstream out(__path, ios::trunc);
+    return this->WriteTrace(out);
+}
+
+
+// times the enclosing block and records it under name when it ends
+class ProfileScope {
+    private:
+        const char *name;
+        double flops;
+        uint64_t start;
+        uint64_t allocated;
+
+    public:
+        ProfileScope(const char *__name, double __flops) noexcept
+            : name(__name), flops(__flops), start(Profiler::Global().Now()), allocated(Profiler::Global().Allocated()) {}
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator = (const ProfileScope&) = delete;
+
+        ~ProfileScope() noexcept {
+            Profiler &p = Profiler::Global();
+            p.Record(this->name, this->start, p.Now() - this->start, this->flops, p.Allocated() - this->allocated);
+        }
+};
+
+#define _PROFILE_CONCAT_(a, b) a##b
+#define _PROFILE_CONCAT(a, b) _PROFILE_CONCAT_(a, b)
+#define _PROFILE_SCOPE(name, flops) ProfileScope _PROFILE_CONCAT(__profile_scope_, __LINE__)(name, double(flops))
+#define _PROFILE_ALLOCATE(bytes, live) Profiler::Global().Allocate(bytes, live)
+#define _PROFILE_RELEASE(bytes) Profiler::Global().Release(bytes)
+
+#else
+
+// disabled: no code, the arguments are not even evaluated
+#define _PROFILE_SCOPE(name, flops) ((void)0)
+#define _PROFILE_ALLOCATE(bytes, live) ((void)0)
+#define _PROFILE_RELEASE(bytes) ((void)0)
+
+#endif
+
+#endif // !_PROFILE_H_
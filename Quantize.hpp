@@ -0,0 +1,763 @@
+#ifndef _QUANTIZE_H_
+#define _QUANTIZE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+#include "Memory.hpp"
+#include "Profile.hpp"
+#include "ThreadPool.hpp"
+#include "Simd.hpp"
+#include "Transpose.hpp"
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+
+using namespace std;
+
+// Reduced precision storage:
+//   Half (IEEE binary16) and BFloat16 keep the upper bits of a float, converted with round to nearest
+//   even; F16C / AVX-512 convert 8 / 16 halves per instruction, AVX-512 BF16 16 bfloat16s, the
+//   integer bit tricks of the scalar code are vectorized by the compiler elsewhere.
+//   int8 codes are affine: value = scale * (code - zero), with one (scale, zero) for the whole matrix
+//   (Axis2D::ALL), per row (ROW) or per column (COL); zero is always representable exactly.
+//   The int8 product accumulates code products in int32 lanes over QUANT_BLOCK elements and the block
+//   sums in int64 (AVX-512 VNNI multiplies 64 byte pairs per instruction), then applies the scales
+//   and zero-points once per element of the result. Other products dequantize and accumulate in float.
+
+constexpr size_t QUANT_BLOCK = size_t(1) << 16;
+constexpr size_t QUANT_PANEL_BYTES = size_t(1) << 18;
+constexpr size_t QUANT_ROWS = 16;
+
+struct Half {
+    uint16_t bits = 0;
+};
+
+struct BFloat16 {
+    uint16_t bits = 0;
+};
+
+
+// Scalar conversions ----------------------------------------------------------------
+inline uint16_t half_from_float(float __f) noexcept {
+    uint32_t x;
+    memcpy(&x, &__f, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000, a = x & 0x7fffffff;
+
+    if (a >= 0x7f800000) {
+        return uint16_t(sign | 0x7c00 | (a > 0x7f800000 ? 0x200 : 0));
+    }
+    // 65520 and above round to infinity
+    if (a >= 0x477ff000) {
+        return uint16_t(sign | 0x7c00);
+    }
+    // below 2^-14 the half is subnormal, adding 0.5 lines the float mantissa up with it and rounds
+    if (a < 0x38800000) {
+        float f;
+        memcpy(&f, &a, sizeof(f));
+        f += 0.5f;
+        memcpy(&a, &f, sizeof(a));
+        return uint16_t(sign | (a - 0x3f000000));
+    }
+    // rebias the exponent, 0xfff plus the lowest kept bit rounds to nearest even
+    a += 0xc8000fff + ((a >> 13) & 1);
+    return uint16_t(sign | (a >> 13));
+}
+
+
+inline float float_from_half(uint16_t __h) noexcept {
+    uint32_t sign = uint32_t(__h & 0x8000) << 16, e = __h & 0x7fff, x;
+
+    // NaNs come out quiet, like vcvtph2ps
+    if (e >= 0x7c00) {
+        x = sign | 0x7f800000 | ((e & 0x3ff) << 13) | (e > 0x7c00 ? 0x400000 : 0);
+    } else if (e >= 0x400) {
+        x = sign | ((e << 13) + 0x38000000);
+    } else {
+        float f = float(e) * 5.9604644775390625e-8f;
+        memcpy(&x, &f, sizeof(x));
+        x |= sign;
+    }
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+
+// subnormal floats flush to a signed zero like vcvtneps2bf16, so every kernel gives the same codes
+inline uint16_t bfloat16_from_float(float __f) noexcept {
+    uint32_t x;
+    memcpy(&x, &__f, sizeof(x));
+    if ((x & 0x7fffffff) > 0x7f800000) {
+        return uint16_t((x >> 16) | 0x40);
+    }
+    if ((x & 0x7f800000) == 0) {
+        return uint16_t((x >> 16) & 0x8000);
+    }
+    return uint16_t((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+}
+
+
+inline float float_from_bfloat16(uint16_t __b) noexcept {
+    uint32_t x = uint32_t(__b) << 16;
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+
+// Conversion kernels ----------------------------------------------------------------
+inline void quant_to_half_scalar(const float *src, uint16_t *dst, size_t __n) noexcept {
+    for (size_t i = 0; i < __n; i++) {
+        dst[i] = half_from_float(src[i]);
+    }
+}
+
+
+inline void quant_from_half_scalar(const uint16_t *src, float *dst, size_t __n) noexcept {
+    for (size_t i = 0; i < __n; i++) {
+        dst[i] = float_from_half(src[i]);
+    }
+}
+
+
+inline void quant_to_bfloat16_base(const float *src, uint16_t *dst, size_t __n) noexcept {
+    simd_for(0, __n, [=](size_t i) { dst[i] = bfloat16_from_float(src[i]); });
+}
+
+
+inline void quant_from_bfloat16_base(const uint16_t *src, float *dst, size_t __n) noexcept {
+    simd_for(0, __n, [=](size_t i) { dst[i] = float_from_bfloat16(src[i]); });
+}
+
+
+// out[r] = sum of x[i] * y[i] for the four rows y = y0 + r * rs, in int32 lanes per block and int64
+// across blocks; left to the vectorizer of each ISA
+__attribute__((always_inline)) inline void quant_dot4_kernel(const int8_t *x, const int8_t *y, size_t __rs, size_t __n, int64_t *out) noexcept {
+    const int8_t *y0 = y, *y1 = y + __rs, *y2 = y + 2 * __rs, *y3 = y + 3 * __rs;
+    int64_t total[4] = {};
+
+    for (size_t b = 0; b < __n; b += QUANT_BLOCK) {
+        size_t e = min(b + QUANT_BLOCK, __n);
+        int32_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+        for (size_t i = b; i < e; i++) {
+            int32_t __x = x[i];
+            acc0 += __x * int32_t(y0[i]);
+            acc1 += __x * int32_t(y1[i]);
+            acc2 += __x * int32_t(y2[i]);
+            acc3 += __x * int32_t(y3[i]);
+        }
+        total[0] += acc0;
+        total[1] += acc1;
+        total[2] += acc2;
+        total[3] += acc3;
+    }
+    for (size_t r = 0; r < 4; r++) {
+        out[r] = total[r];
+    }
+}
+
+
+_SIMD_VECTORIZE inline void quant_dot4_base(const int8_t *x, const int8_t *y, size_t __rs, size_t __n, int64_t *out) noexcept {
+    quant_dot4_kernel(x, y, __rs, __n, out);
+}
+
+// q = clamp(v * inv + zero) rounded to nearest even, with one (inv, zero) for the row or one per element
+// when __cols; adding and taking back 1.5 * 2^23 rounds, vectorizes everywhere unlike nearbyint. The
+// kernel owns the loop so that the int8 stores, which may alias anything, do not reload the pointers
+__attribute__((always_inline)) inline void quant_to_int8_kernel(const float *__restrict v, int8_t *__restrict q, size_t __n,
+                                                               const float *__restrict inv, const float *__restrict zero, bool __cols) noexcept {
+    constexpr float __magic = 12582912.0f;
+    if (__cols) {
+        for (size_t j = 0; j < __n; j++) {
+            float t = clamp(v[j] * inv[j] + zero[j], -128.0f, 127.0f);
+            q[j] = int8_t(int32_t((t + __magic) - __magic));
+        }
+        return;
+    }
+    float __inv = inv[0], __z = zero[0];
+    for (size_t j = 0; j < __n; j++) {
+        float t = clamp(v[j] * __inv + __z, -128.0f, 127.0f);
+        q[j] = int8_t(int32_t((t + __magic) - __magic));
+    }
+}
+
+
+_SIMD_VECTORIZE inline void quant_to_int8_base(const float *v, int8_t *q, size_t __n, const float *inv, const float *zero, bool __cols) noexcept {
+    quant_to_int8_kernel(v, q, __n, inv, zero, __cols);
+}
+
+#ifdef _SIMD_X86_DISPATCH
+__attribute__((target("avx2,fma,f16c"))) inline void quant_to_half_f16c(const float *src, uint16_t *dst, size_t __n) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= __n; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    quant_to_half_scalar(src + i, dst + i, __n - i);
+}
+
+
+__attribute__((target("avx2,fma,f16c"))) inline void quant_from_half_f16c(const uint16_t *src, float *dst, size_t __n) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= __n; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    quant_from_half_scalar(src + i, dst + i, __n - i);
+}
+
+
+__attribute__((target("avx512f"))) inline void quant_to_half_avx512(const float *src, uint16_t *dst, size_t __n) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= __n; i += 16) {
+        __m256i h = _mm512_maskz_cvtps_ph(0xffff, _mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), h);
+    }
+    quant_to_half_scalar(src + i, dst + i, __n - i);
+}
+
+
+__attribute__((target("avx512f"))) inline void quant_from_half_avx512(const uint16_t *src, float *dst, size_t __n) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= __n; i += 16) {
+        __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm512_storeu_ps(dst + i, _mm512_maskz_cvtph_ps(0xffff, h));
+    }
+    quant_from_half_scalar(src + i, dst + i, __n - i);
+}
+
+
+// the instruction flushes subnormal floats to zero, like bfloat16_from_float
+__attribute__((target("avx512f,avx512bf16"))) inline void quant_to_bfloat16_avx512(const float *src, uint16_t *dst, size_t __n) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= __n; i += 16) {
+        __m256bh b = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+        memcpy(dst + i, &b, sizeof(b));
+    }
+    for (; i < __n; i++) {
+        dst[i] = bfloat16_from_float(src[i]);
+    }
+}
+
+
+_SIMD_VECTORIZE __attribute__((target("avx2,fma"))) inline void quant_to_int8_avx2(const float *v, int8_t *q, size_t __n, const float *inv, const float *zero, bool __cols) noexcept {
+    quant_to_int8_kernel(v, q, __n, inv, zero, __cols);
+}
+
+
+_SIMD_VECTORIZE __attribute__((target("avx512f,avx512bw"))) inline void quant_to_int8_avx512(const float *v, int8_t *q, size_t __n, const float *inv, const float *zero, bool __cols) noexcept {
+    quant_to_int8_kernel(v, q, __n, inv, zero, __cols);
+}
+
+
+_SIMD_VECTORIZE __attribute__((target("avx2,fma"))) inline void quant_dot4_avx2(const int8_t *x, const int8_t *y, size_t __rs, size_t __n, int64_t *out) noexcept {
+    quant_dot4_kernel(x, y, __rs, __n, out);
+}
+
+
+// sum of the 16 lanes, halving the vector; the masked extracts keep GCC from warning on undefined lanes
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) inline int32_t quant_reduce_vnni(__m512i v) noexcept {
+    __m256i h = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xff, v, 0), _mm512_maskz_extracti64x4_epi64(0xff, v, 1));
+    __m128i q = _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+    q = _mm_add_epi32(q, _mm_shuffle_epi32(q, 0x4e));
+    q = _mm_add_epi32(q, _mm_shuffle_epi32(q, 0xb1));
+    return _mm_cvtsi128_si32(q);
+}
+
+
+// vpdpbusd multiplies unsigned by signed bytes: the rows are biased to y + 128, unsigned, and 128 * sum(x)
+// is taken back per block, one more vpdpbusd of x against ones shared by the four rows
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) inline void quant_dot4_vnni(const int8_t *x, const int8_t *y, size_t __rs, size_t __n, int64_t *out) noexcept {
+    const __m512i flip = _mm512_set1_epi8(char(0x80)), ones = _mm512_set1_epi8(1);
+    const int8_t *row[4] = {y, y + __rs, y + 2 * __rs, y + 3 * __rs};
+    int64_t total[4] = {};
+    size_t i = 0;
+
+    for (size_t b = 0; b + 64 <= __n; b = i) {
+        size_t e = b + min(QUANT_BLOCK, __n - b) / 64 * 64;
+        __m512i acc[4] = {}, sum = _mm512_setzero_si512();
+        for (i = b; i < e; i += 64) {
+            __m512i v = _mm512_loadu_si512(x + i);
+            sum = _mm512_dpbusd_epi32(sum, ones, v);
+            for (size_t r = 0; r < 4; r++) {
+                __m512i u = _mm512_xor_si512(_mm512_loadu_si512(row[r] + i), flip);
+                acc[r] = _mm512_dpbusd_epi32(acc[r], u, v);
+            }
+        }
+        int64_t __bias = 128 * int64_t(quant_reduce_vnni(sum));
+        for (size_t r = 0; r < 4; r++) {
+            total[r] += int64_t(quant_reduce_vnni(acc[r])) - __bias;
+        }
+    }
+    for (size_t r = 0; r < 4; r++) {
+        for (size_t t = i; t < __n; t++) {
+            total[r] += int32_t(x[t]) * int32_t(row[r][t]);
+        }
+        out[r] = total[r];
+    }
+}
+#endif
+
+
+// Kernel selection ----------------------------------------------------------------
+struct QuantKernels {
+    void (*to_half)(const float*, uint16_t*, size_t) noexcept;
+    void (*from_half)(const uint16_t*, float*, size_t) noexcept;
+    void (*to_bfloat16)(const float*, uint16_t*, size_t) noexcept;
+    void (*from_bfloat16)(const uint16_t*, float*, size_t) noexcept;
+    void (*to_int8)(const float*, int8_t*, size_t, const float*, const float*, bool) noexcept;
+    void (*dot4)(const int8_t*, const int8_t*, size_t, size_t, int64_t*) noexcept;
+};
+
+
+// the extensions are checked one by one on top of simd_level, a CPU may have AVX-512 without BF16
+inline QuantKernels quant_select_kernels() noexcept {
+    QuantKernels k = { quant_to_half_scalar, quant_from_half_scalar, quant_to_bfloat16_base, quant_from_bfloat16_base, quant_to_int8_base,
+                       quant_dot4_base };
+#ifdef _SIMD_X86_DISPATCH
+    SimdLevel level = simd_level();
+    if (level >= SimdLevel::AVX2) {
+        k.to_int8 = quant_to_int8_avx2;
+        k.dot4 = quant_dot4_avx2;
+        if (__builtin_cpu_supports("f16c")) {
+            k.to_half = quant_to_half_f16c;
+            k.from_half = quant_from_half_f16c;
+        }
+    }
+    if (level == SimdLevel::AVX512) {
+        k.to_half = quant_to_half_avx512;
+        k.from_half = quant_from_half_avx512;
+        if (__builtin_cpu_supports("avx512bf16")) {
+            k.to_bfloat16 = quant_to_bfloat16_avx512;
+        }
+        if (__builtin_cpu_supports("avx512bw")) {
+            k.to_int8 = quant_to_int8_avx512;
+        }
+        if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni")) {
+            k.dot4 = quant_dot4_vnni;
+        }
+    }
+#endif
+    return k;
+}
+
+
+inline const QuantKernels& quant_kernels() noexcept {
+    static const QuantKernels kernels = quant_select_kernels();
+    return kernels;
+}
+
+
+// Quantized matrix ----------------------------------------------------------------
+// _Q is Half, BFloat16 or int8_t; only int8 codes carry scales and zero-points
+template<class _Q>
+class QuantizedMatrix {
+    static_assert(is_same_v<_Q, Half> || is_same_v<_Q, BFloat16> || is_same_v<_Q, int8_t>, "codes are Half, BFloat16 or int8_t");
+
+    public:
+        typedef _Q code_type;
+        typedef float value_type;
+        typedef size_t size_type;
+
+    private:
+        _Q *_codes = nullptr;
+        float *_scale = nullptr;
+        int32_t *_zero = nullptr;
+        size_type _row = 0;
+        size_type _col = 0;
+        Axis2D _axis = Axis2D::ALL;
+
+        static auto allocate(size_type, size_type, Axis2D) noexcept;
+        size_type groups() const noexcept;
+        void encode_row(size_type, const float*, const float*, const float*) noexcept;
+        void decode_row(size_type, float*) const noexcept;
+        Matrix2D<float> int_product(const QuantizedMatrix<_Q>&) const noexcept;
+
+    public:
+        constexpr QuantizedMatrix() noexcept = default;
+        // int8 scales are fitted on the range of every group, Half and BFloat16 ignore the axis
+        template<class _E> explicit QuantizedMatrix(const Matrix2DExpr<_E>&, Axis2D = Axis2D::ROW) noexcept;
+        QuantizedMatrix(const QuantizedMatrix<_Q>&) noexcept;
+        QuantizedMatrix(QuantizedMatrix<_Q>&&) noexcept;
+        ~QuantizedMatrix() noexcept;
+
+        constexpr size_type Row() const noexcept { return this->_row; }
+        constexpr size_type Col() const noexcept { return this->_col; }
+        constexpr Axis2D Axis() const noexcept { return this->_axis; }
+        constexpr const _Q* Codes() const noexcept { return this->_codes; }
+        // one per group along Axis(), nullptr for Half and BFloat16
+        constexpr const float* Scales() const noexcept { return this->_scale; }
+        constexpr const int32_t* ZeroPoints() const noexcept { return this->_zero; }
+        size_type Bytes() const noexcept;
+
+        template<class _T = float> Matrix2D<_T> Dequantize() const noexcept;
+        Vector<float> Row(size_type) const noexcept;
+        template<class _R> Vector<float> MatVec(const VectorExpr<_R>&) const noexcept;
+        // int8 x int8 accumulates in integers when the scales are constant along the shared dimension
+        // (rows or ALL on the left, columns or ALL on the right), everything else in float
+        Matrix2D<float> operator * (const QuantizedMatrix<_Q>&) const noexcept;
+
+        QuantizedMatrix<_Q>& operator = (const QuantizedMatrix<_Q>&) noexcept;
+        QuantizedMatrix<_Q>& operator = (QuantizedMatrix<_Q>&&) noexcept;
+};
+
+
+template<class _Q>
+auto QuantizedMatrix<_Q>::allocate(size_type __r, size_type __c, Axis2D axis) noexcept {
+    QuantizedMatrix<_Q> q;
+    q._row = __r;
+    q._col = __c;
+    q._axis = axis;
+    q._codes = aligned_new<_Q>(__r * __c);
+    if constexpr (is_same_v<_Q, int8_t>) {
+        q._scale = aligned_new<float>(q.groups());
+        q._zero = aligned_new<int32_t>(q.groups());
+    }
+    return q;
+}
+
+
+template<class _Q>
+typename QuantizedMatrix<_Q>::size_type QuantizedMatrix<_Q>::groups() const noexcept {
+    switch (this->_axis) {
+        case Axis2D::ALL : return 1;
+        case Axis2D::ROW : return this->_row;
+        default : return this->_col;
+    }
+}
+
+
+template<class _Q>
+typename QuantizedMatrix<_Q>::size_type QuantizedMatrix<_Q>::Bytes() const noexcept {
+    size_type __b = this->_row * this->_col * sizeof(_Q);
+    if constexpr (is_same_v<_Q, int8_t>) {
+        __b += this->groups() * (sizeof(float) + sizeof(int32_t));
+    }
+    return __b;
+}
+
+
+// codes of row i from its float values; int8 takes the inverse scales and zero-points of its groups
+template<class _Q>
+void QuantizedMatrix<_Q>::encode_row(size_type i, const float *v, const float *inv, const float *zero) noexcept {
+    size_type __c = this->_col;
+    _Q *q = this->_codes + i * __c;
+
+    if constexpr (is_same_v<_Q, Half>) {
+        quant_kernels().to_half(v, reinterpret_cast<uint16_t*>(q), __c);
+    } else if constexpr (is_same_v<_Q, BFloat16>) {
+        quant_kernels().to_bfloat16(v, reinterpret_cast<uint16_t*>(q), __c);
+    } else {
+        size_type g = this->_axis == Axis2D::ROW ? i : 0;
+        quant_kernels().to_int8(v, q, __c, inv + g, zero + g, this->_axis == Axis2D::COL);
+    }
+}
+
+
+template<class _Q>
+void QuantizedMatrix<_Q>::decode_row(size_type i, float *v) const noexcept {
+    size_type __c = this->_col;
+    const _Q *q = this->_codes + i * __c;
+
+    if constexpr (is_same_v<_Q, Half>) {
+        quant_kernels().from_half(reinterpret_cast<const uint16_t*>(q), v, __c);
+    } else if constexpr (is_same_v<_Q, BFloat16>) {
+        quant_kernels().from_bfloat16(reinterpret_cast<const uint16_t*>(q), v, __c);
+    } else if (this->_axis == Axis2D::COL) {
+        const float *s = this->_scale;
+        const int32_t *z = this->_zero;
+        simd_for(0, __c, [=](size_t j) { v[j] = s[j] * float(int32_t(q[j]) - z[j]); });
+    } else {
+        size_type g = this->_axis == Axis2D::ROW ? i : 0;
+        float __s = this->_scale[g];
+        int32_t __z = this->_zero[g];
+        simd_for(0, __c, [=](size_t j) { v[j] = __s * float(int32_t(q[j]) - __z); });
+    }
+}
+
+
+// int8 groups take the range [min(lo, 0), max(hi, 0)] over 256 codes, so 0 has an exact code; the
+// column ranges are gathered per panel of rows and merged in order
+template<class _Q>
+template<class _E>
+QuantizedMatrix<_Q>::QuantizedMatrix(const Matrix2DExpr<_E> &e, Axis2D axis) noexcept {
+    _PROFILE_SCOPE("QuantizedMatrix::QuantizedMatrix", 0);
+    const _E &x = e.self();
+    size_type __r = x.Row(), __c = x.Col();
+    *this = QuantizedMatrix::allocate(__r, __c, is_same_v<_Q, int8_t> ? axis : Axis2D::ALL);
+    auto fetch = [&x, __c](size_type i, float *v) {
+        for (size_type j = 0; j < __c; j++) {
+            v[j] = float(x(i, j));
+        }
+    };
+
+    vector<float> inv, zero;
+
+    if constexpr (is_same_v<_Q, int8_t>) {
+        size_type __g = this->groups();
+        vector<float> lo(__g, 0.0f), hi(__g, 0.0f);
+
+        if (axis == Axis2D::COL) {
+            size_type __panels = min<size_type>(64, max<size_type>(1, __r / 256));
+            vector<float> part_lo(__panels * __c, 0.0f), part_hi(__panels * __c, 0.0f);
+            float *ref_pl = part_lo.data(), *ref_ph = part_hi.data();
+            ThreadPool::Global().ParallelFor(0, __panels, __r / __panels * __c, [&](size_type b, size_type e) {
+                vector<float> v(__c);
+                for (size_type p = b; p < e; p++) {
+                    float *pl = ref_pl + p * __c, *ph = ref_ph + p * __c;
+                    for (size_type i = p * __r / __panels; i < (p + 1) * __r / __panels; i++) {
+                        fetch(i, v.data());
+                        for (size_type j = 0; j < __c; j++) {
+                            pl[j] = v[j] < pl[j] ? v[j] : pl[j];
+                            ph[j] = v[j] > ph[j] ? v[j] : ph[j];
+                        }
+                    }
+                }
+            });
+            for (size_type p = 0; p < __panels; p++) {
+                for (size_type j = 0; j < __c; j++) {
+                    lo[j] = min(lo[j], ref_pl[p * __c + j]);
+                    hi[j] = max(hi[j], ref_ph[p * __c + j]);
+                }
+            }
+        } else {
+            // ALL takes the extremes of the rows
+            vector<float> row_lo(__r, 0.0f), row_hi(__r, 0.0f);
+            float *ref_lo = row_lo.data(), *ref_hi = row_hi.data();
+            const SimdKernels<float> &k = simd_kernels<float>();
+            ThreadPool::Global().ParallelFor(0, __r, __c, [&fetch, &k, ref_lo, ref_hi, __c](size_type b, size_type e) {
+                vector<float> v(__c);
+                for (size_type i = b; i < e && __c > 0; i++) {
+                    fetch(i, v.data());
+                    ref_lo[i] = min(0.0f, k.min(v.data(), __c));
+                    ref_hi[i] = max(0.0f, k.max(v.data(), __c));
+                }
+            });
+            if (axis == Axis2D::ROW) {
+                lo = move(row_lo);
+                hi = move(row_hi);
+            } else {
+                for (size_type i = 0; i < __r; i++) {
+                    lo[0] = min(lo[0], row_lo[i]);
+                    hi[0] = max(hi[0], row_hi[i]);
+                }
+            }
+        }
+        inv.resize(__g);
+        zero.resize(__g);
+        for (size_type g = 0; g < __g; g++) {
+            float __s = (hi[g] - lo[g]) / 255.0f;
+            __s = __s > 0 && isfinite(__s) ? __s : 1.0f;
+            this->_scale[g] = __s;
+            this->_zero[g] = int32_t(clamp(nearbyintf(-128.0f - lo[g] / __s), -128.0f, 127.0f));
+            inv[g] = 1.0f / __s;
+            zero[g] = float(this->_zero[g]);
+        }
+    }
+    const float *ref_inv = inv.data(), *ref_zero = zero.data();
+    ThreadPool::Global().ParallelFor(0, __r, __c, [this, &fetch, ref_inv, ref_zero, __c](size_type b, size_type e) {
+        vector<float> v(__c);
+        for (size_type i = b; i < e; i++) {
+            fetch(i, v.data());
+            this->encode_row(i, v.data(), ref_inv, ref_zero);
+        }
+    });
+}
+
+
+template<class _Q>
+QuantizedMatrix<_Q>::QuantizedMatrix(const QuantizedMatrix<_Q> &y) noexcept {
+    *this = QuantizedMatrix::allocate(y._row, y._col, y._axis);
+    memcpy(this->_codes, y._codes, y._row * y._col * sizeof(_Q));
+    if constexpr (is_same_v<_Q, int8_t>) {
+        memcpy(this->_scale, y._scale, y.groups() * sizeof(float));
+        memcpy(this->_zero, y._zero, y.groups() * sizeof(int32_t));
+    }
+}
+
+
+template<class _Q>
+QuantizedMatrix<_Q>::QuantizedMatrix(QuantizedMatrix<_Q> &&y) noexcept { *this = move(y); }
+
+
+template<class _Q>
+QuantizedMatrix<_Q>::~QuantizedMatrix() noexcept {
+    aligned_delete(this->_codes);
+    aligned_delete(this->_scale);
+    aligned_delete(this->_zero);
+}
+
+
+template<class _Q>
+QuantizedMatrix<_Q>& QuantizedMatrix<_Q>::operator = (const QuantizedMatrix<_Q> &y) noexcept {
+    if (this != &y) {
+        *this = QuantizedMatrix<_Q>(y);
+    }
+    return *this;
+}
+
+
+template<class _Q>
+QuantizedMatrix<_Q>& QuantizedMatrix<_Q>::operator = (QuantizedMatrix<_Q> &&y) noexcept {
+    if (this != &y) {
+        swap(this->_codes, y._codes);
+        swap(this->_scale, y._scale);
+        swap(this->_zero, y._zero);
+        this->_row = exchange(y._row, 0);
+        this->_col = exchange(y._col, 0);
+        this->_axis = y._axis;
+    }
+    return *this;
+}
+
+
+// Dequantization ----------------------------------------------------------------
+template<class _Q>
+template<class _T>
+Matrix2D<_T> QuantizedMatrix<_Q>::Dequantize() const noexcept {
+    _PROFILE_SCOPE("QuantizedMatrix::Dequantize", 0);
+    auto m = Matrix2D<_T>::ZeroInit(this->_row, this->_col);
+    size_type __c = this->_col;
+
+    ThreadPool::Global().ParallelFor(0, this->_row, __c, [this, &m, __c](size_type b, size_type e) {
+        vector<float> v(is_same_v<_T, float> ? 0 : __c);
+        for (size_type i = b; i < e; i++) {
+            if constexpr (is_same_v<_T, float>) {
+                this->decode_row(i, m.RowBegin(i));
+            } else {
+                this->decode_row(i, v.data());
+                copy(v.begin(), v.end(), m.RowBegin(i));
+            }
+        }
+    });
+    return m;
+}
+
+
+template<class _Q>
+Vector<float> QuantizedMatrix<_Q>::Row(size_type i) const noexcept {
+    if (i >= this->_row) {
+        return Vector<float>();
+    }
+    auto vec = Vector<float>::ZeroInit(this->_col);
+    this->decode_row(i, vec.Begin());
+    return vec;
+}
+
+
+// Products ----------------------------------------------------------------
+// rows are decoded into a float buffer one at a time and scored with the float dot kernel
+template<class _Q>
+template<class _R>
+Vector<float> QuantizedMatrix<_Q>::MatVec(const VectorExpr<_R> &e) const noexcept {
+    const _R &x = e.self();
+    size_type __c = this->_col;
+    if (x.Size() != __c) {
+        return Vector<float>();
+    }
+    _PROFILE_SCOPE("QuantizedMatrix::MatVec", 2 * this->_row * __c);
+    vector<float> tmp;
+    const float *p = nullptr;
+    if constexpr (is_same_v<typename _R::value_type, float>) {
+        p = vector_data(x);
+    }
+    if (p == nullptr) {
+        tmp.resize(__c);
+        for (size_type j = 0; j < __c; j++) {
+            tmp[j] = float(x[j]);
+        }
+        p = tmp.data();
+    }
+
+    auto vec = Vector<float>::ZeroInit(this->_row);
+    float *ref_y = vec.Begin();
+    const SimdKernels<float> &k = simd_kernels<float>();
+    ThreadPool::Global().ParallelFor(0, this->_row, __c, [this, &k, p, ref_y, __c](size_type b, size_type e) {
+        vector<float> v(__c);
+        for (size_type i = b; i < e; i++) {
+            this->decode_row(i, v.data());
+            ref_y[i] = float(k.dot(v.data(), p, __c));
+        }
+    });
+    return vec;
+}
+
+
+// C(i, j) = sa_i sb_j (sum of qa qb - zb ra_i - za cb_j + k za zb) with ra_i, cb_j the code sums of row
+// i of A and column j of B. B is transposed once so its columns are contiguous, padded with zero columns
+// to a multiple of four for dot4; tasks own QUANT_ROWS rows of C and sweep the columns in panels of B
+// that fit in QUANT_PANEL_BYTES
+template<class _Q>
+Matrix2D<float> QuantizedMatrix<_Q>::int_product(const QuantizedMatrix<_Q> &y) const noexcept {
+    size_type __m = this->_row, __k = this->_col, __n = y._col;
+    vector<int8_t> bt((__n + 3) / 4 * 4 * __k, 0);
+    transpose(__k, __n, y._codes, __n, bt.data(), __k);
+    vector<int64_t> ra(__m), cb(__n);
+    auto code_sums = [__k](const int8_t *p, size_type __rows, int64_t *out) {
+        ThreadPool::Global().ParallelFor(0, __rows, __k, [p, out, __k](size_type b, size_type e) {
+            for (size_type i = b; i < e; i++) {
+                int64_t s = 0;
+                for (size_type t = 0; t < __k; t++) {
+                    s += p[i * __k + t];
+                }
+                out[i] = s;
+            }
+        });
+    };
+    code_sums(this->_codes, __m, ra.data());
+    code_sums(bt.data(), __n, cb.data());
+
+    auto m = Matrix2D<float>::ZeroInit(__m, __n);
+    size_type __w = max<size_type>(4, QUANT_PANEL_BYTES / max<size_type>(__k, 1) / 4 * 4);
+    const QuantKernels &qk = quant_kernels();
+    ThreadPool::Global().ParallelFor(0, (__m + QUANT_ROWS - 1) / QUANT_ROWS, QUANT_ROWS * __n * __k, [&](size_type lo, size_type hi) {
+        for (size_type j0 = 0; j0 < __n; j0 += __w) {
+            size_type j1 = min(__n, j0 + __w);
+            for (size_type i = lo * QUANT_ROWS; i < min(__m, hi * QUANT_ROWS); i++) {
+                const int8_t *a = this->_codes + i * __k;
+                size_type ga = this->_axis == Axis2D::ROW ? i : 0;
+                double __sa = this->_scale[ga];
+                int64_t __za = this->_zero[ga];
+                float *row = m.RowBegin(i);
+                for (size_type j = j0; j < j1; j += 4) {
+                    int64_t d[4];
+                    qk.dot4(a, bt.data() + j * __k, __k, __k, d);
+                    for (size_type t = j; t < min(j1, j + 4); t++) {
+                        size_type gb = y._axis == Axis2D::COL ? t : 0;
+                        int64_t __zb = y._zero[gb];
+                        int64_t v = d[t - j] - __zb * ra[i] - __za * cb[t] + int64_t(__k) * __za * __zb;
+                        row[t] = float(__sa * double(y._scale[gb]) * double(v));
+                    }
+                }
+            }
+        }
+    });
+    return m;
+}
+
+
+template<class _Q>
+Matrix2D<float> QuantizedMatrix<_Q>::operator * (const QuantizedMatrix<_Q> &y) const noexcept {
+    if (this->_col != y._row) {
+        return Matrix2D<float>();
+    }
+    _PROFILE_SCOPE("QuantizedMatrix::operator*", 2.0 * this->_row * this->_col * y._col);
+    if constexpr (is_same_v<_Q, int8_t>) {
+        if (this->_axis != Axis2D::COL && y._axis != Axis2D::ROW) {
+            return this->int_product(y);
+        }
+    }
+    return Matrix2D<float>(this->Dequantize() * y.Dequantize());
+}
+
+#endif // !_QUANTIZE_H_
@@ -0,0 +1,171 @@
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+
+#include "ThreadPool.hpp"
+#include "Simd.hpp"
+
+using namespace std;
+using namespace chrono;
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"): a counter-based
+// generator, the 4 words of block g are a keyed bijection of g, so element k of a buffer only depends
+// on (seed, k). Blocks are produced RANDOM_BATCH at a time in lane arrays the compiler vectorizes, the
+// distributions are applied a whole batch at a time, and the buffer is split over the pool: the output
+// is the same bits whatever the thread count or chunking.
+// float elements take one 32-bit word, double elements two (53-bit mantissa).
+
+constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+constexpr uint32_t PHILOX_W0 = 0x9E3779B9;
+constexpr uint32_t PHILOX_W1 = 0xBB67AE85;
+constexpr size_t PHILOX_ROUNDS = 10;
+constexpr size_t RANDOM_BATCH = 64;
+
+// a fresh seed per call, for callers that do not ask for a reproducible stream
+inline uint64_t random_seed() noexcept {
+    return uint64_t(system_clock::now().time_since_epoch().count());
+}
+
+
+// w[0..3][l] = Philox(counter = first + l, key = seed) for the RANDOM_BATCH blocks of the batch
+__attribute__((always_inline)) inline void philox_batch(uint64_t __first, uint64_t __seed, uint32_t w[4][RANDOM_BATCH]) noexcept {
+    uint32_t k0 = uint32_t(__seed), k1 = uint32_t(__seed >> 32);
+
+    for (size_t l = 0; l < RANDOM_BATCH; l++) {
+        uint64_t c = __first + l;
+        w[0][l] = uint32_t(c);
+        w[1][l] = uint32_t(c >> 32);
+        w[2][l] = 0;
+        w[3][l] = 0;
+    }
+    for (size_t r = 0; r < PHILOX_ROUNDS; r++) {
+        for (size_t l = 0; l < RANDOM_BATCH; l++) {
+            uint64_t p0 = uint64_t(PHILOX_M0) * w[0][l];
+            uint64_t p1 = uint64_t(PHILOX_M1) * w[2][l];
+            uint32_t c1 = w[1][l], c3 = w[3][l];
+            w[0][l] = uint32_t(p1 >> 32) ^ c1 ^ k0;
+            w[1][l] = uint32_t(p1);
+            w[2][l] = uint32_t(p0 >> 32) ^ c3 ^ k1;
+            w[3][l] = uint32_t(p0);
+        }
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+
+// [0, 1) from one word (float) or two words (double)
+template<class _T>
+inline _T random_unit(uint32_t __a, uint32_t __b) noexcept {
+    if constexpr (is_same_v<_T, float>) {
+        return float(__a >> 8) * (1.f / 16777216.f);
+    } else {
+        uint64_t __m = (uint64_t(__a) << 21) | (__b >> 11);
+        return _T(double(__m) * (1. / 9007199254740992.));
+    }
+}
+
+
+// every block of 4 words gives random_per_block<_T> elements: 4 floats or 2 doubles
+template<class _T>
+constexpr size_t random_per_block() noexcept { return is_same_v<_T, float> ? 4 : 2; }
+
+
+// u[e * RANDOM_BATCH + l] = element e of block l, so every lane loop runs over contiguous words
+template<class _T>
+__attribute__((always_inline)) inline void random_units(const uint32_t w[4][RANDOM_BATCH], _T *u) noexcept {
+    constexpr size_t __per = random_per_block<_T>();
+    for (size_t e = 0; e < __per; e++) {
+        for (size_t l = 0; l < RANDOM_BATCH; l++) {
+            u[e * RANDOM_BATCH + l] = __per == 4 ? random_unit<_T>(w[e][l], 0) : random_unit<_T>(w[2 * e][l], w[2 * e + 1][l]);
+        }
+    }
+}
+
+
+// u = the RANDOM_BATCH * random_per_block uniforms of batch bt, the lane loops are built once per ISA
+template<class _T>
+__attribute__((always_inline)) inline void random_batch_kernel(uint64_t __bt, uint64_t __seed, _T *u) noexcept {
+    uint32_t w[4][RANDOM_BATCH];
+    philox_batch(__bt * RANDOM_BATCH, __seed, w);
+    random_units(w, u);
+}
+
+template<class _T> _SIMD_VECTORIZE void random_batch_base(uint64_t __bt, uint64_t __seed, _T *u) noexcept { random_batch_kernel(__bt, __seed, u); }
+#ifdef _SIMD_X86_DISPATCH
+template<class _T> _SIMD_VECTORIZE __attribute__((target("avx2,fma"))) void random_batch_avx2(uint64_t __bt, uint64_t __seed, _T *u) noexcept { random_batch_kernel(__bt, __seed, u); }
+template<class _T> _SIMD_VECTORIZE __attribute__((target("avx512f"))) void random_batch_avx512(uint64_t __bt, uint64_t __seed, _T *u) noexcept { random_batch_kernel(__bt, __seed, u); }
+#endif
+
+
+template<class _T>
+inline void random_batch(uint64_t __bt, uint64_t __seed, _T *u) noexcept {
+    switch (simd_level()) {
+#ifdef _SIMD_X86_DISPATCH
+        case SimdLevel::AVX512 : return random_batch_avx512(__bt, __seed, u);
+        case SimdLevel::AVX2 : return random_batch_avx2(__bt, __seed, u);
+#endif
+        default : return random_batch_base(__bt, __seed, u);
+    }
+}
+
+
+// f(u, dst, count): u holds the batch's RANDOM_BATCH * random_per_block uniforms in [0, 1), f writes
+// the first count <= that many elements at dst
+template<class _T, class _F>
+void random_fill(_T *out, size_t __n, uint64_t __seed, _F f) noexcept {
+    constexpr size_t __per = random_per_block<_T>();
+    constexpr size_t __len = RANDOM_BATCH * __per;
+    size_t __batches = (__n + __len - 1) / __len;
+
+    ThreadPool::Global().ParallelFor(0, __batches, __len * 16, [=](size_t lo, size_t hi) {
+        _T u[__len];
+        for (size_t bt = lo; bt < hi; bt++) {
+            random_batch(bt, __seed, u);
+            f(u, out + bt * __len, min(__len, __n - bt * __len));
+        }
+    });
+}
+
+
+// Distributions ----------------------------------------------------------------
+// uniform on [lo, hi)
+template<class _T>
+void random_uniform(_T *out, size_t __n, uint64_t __seed, _T __lo, _T __hi) noexcept {
+    static_assert(is_floating_point_v<_T>, "random values are generated for floating point types");
+    _T __scale = __hi - __lo;
+
+    random_fill(out, __n, __seed, [__lo, __scale](const _T *u, _T *dst, size_t __c) _SIMD_VECTORIZE {
+        for (size_t e = 0; e < __c; e++) {
+            dst[e] = __lo + __scale * u[e];
+        }
+    });
+}
+
+
+// normal with the given mean and standard deviation, Box-Muller on consecutive pairs of uniforms
+template<class _T>
+void random_normal(_T *out, size_t __n, uint64_t __seed, _T __mean, _T __std) noexcept {
+    static_assert(is_floating_point_v<_T>, "random values are generated for floating point types");
+    constexpr _T __two_pi = _T(6.283185307179586);
+
+    random_fill(out, __n, __seed, [__mean, __std](const _T *u, _T *dst, size_t __c) {
+        for (size_t e = 0; e < __c; e += 2) {
+            _T r = sqrt(_T(-2) * log(_T(1) - u[e]));
+            _T t = __two_pi * u[e + 1];
+            dst[e] = __mean + __std * r * cos(t);
+            if (e + 1 < __c) {
+                dst[e + 1] = __mean + __std * r * sin(t);
+            }
+        }
+    });
+}
+
+#endif // !_RANDOM_H_
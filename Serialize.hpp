@@ -0,0 +1,293 @@
+#ifndef _SERIALIZE_H_
+#define _SERIALIZE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <fstream>
+#include <type_traits>
+#include <algorithm>
+
+#include "Memory.hpp"
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+// Binary files of Vector and Matrix2D:
+//   [0, 128)                 SerialHeader: dtype, shape, stride, data offset and alignment, checksum
+//   [128, offset)            zeroes, the last 64 bytes hold the MemoryHeader of a mapped buffer
+//   [offset, offset + size)  row * stride elements, row-major, rows stride elements apart
+// The data starts on a MEMORY_ALIGNMENT boundary, so Map hands out a mapping of the file as an
+// aligned buffer without copying anything and pages are only read when touched. Numbers are stored
+// in the byte order of the writer, a file is only read back on a machine with the same order.
+// The checksum covers the data bytes: SERIAL_CHUNK byte chunks are hashed independently, on the pool
+// when the data is in memory, and their hashes hashed together.
+
+constexpr char SERIAL_MAGIC[8] = {'C', 'V', 'M', 'C', 'X', 'X', '\0', '\n'};
+constexpr uint32_t SERIAL_VERSION = 1;
+constexpr uint32_t SERIAL_BYTE_ORDER = 0x01020304;
+constexpr size_t SERIAL_CHUNK = size_t(1) << 20;
+
+enum class SerialType : uint32_t {
+    INT8 = 1,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    INT64,
+    UINT64,
+    FLOAT32,
+    FLOAT64
+};
+
+struct alignas(MEMORY_ALIGNMENT) SerialHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    SerialType dtype;
+    uint32_t elem_size;
+    uint32_t rank;          // 1 for a Vector, 2 for a Matrix2D
+    uint32_t alignment;
+    uint64_t row;           // 1 for a Vector
+    uint64_t col;
+    uint64_t stride;
+    uint64_t offset;
+    uint64_t checksum;
+};
+
+constexpr size_t SERIAL_DATA_OFFSET = sizeof(SerialHeader) + sizeof(MemoryHeader);
+
+
+template<class _T>
+constexpr SerialType serial_type() noexcept {
+    static_assert(is_arithmetic_v<_T>, "only arithmetic element types can be saved");
+    if constexpr (is_floating_point_v<_T>) {
+        static_assert(sizeof(_T) == 4 || sizeof(_T) == 8, "only float and double can be saved");
+        return sizeof(_T) == 4 ? SerialType::FLOAT32 : SerialType::FLOAT64;
+    } else {
+        constexpr uint32_t __log = sizeof(_T) == 1 ? 0 : sizeof(_T) == 2 ? 1 : sizeof(_T) == 4 ? 2 : 3;
+        return SerialType(uint32_t(SerialType::INT8) + 2 * __log + (is_unsigned_v<_T> ? 1 : 0));
+    }
+}
+
+
+// Checksum ----------------------------------------------------------------
+// 4 lane multiply-rotate hash in the style of xxHash64 (not compatible with it), meant to catch
+// truncated and corrupted files, not tampering
+constexpr uint64_t SERIAL_P1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t SERIAL_P2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t SERIAL_P3 = 0x165667B19E3779F9ull;
+
+constexpr uint64_t serial_rotl(uint64_t __x, int __r) noexcept { return (__x << __r) | (__x >> (64 - __r)); }
+
+
+inline uint64_t serial_hash(const char *p, size_t __n, uint64_t __seed) noexcept {
+    uint64_t h[4] = {__seed + SERIAL_P1 + SERIAL_P2, __seed + SERIAL_P2, __seed, __seed - SERIAL_P1};
+    size_t i = 0;
+
+    for (; i + 32 <= __n; i += 32) {
+        uint64_t w[4];
+        memcpy(w, p + i, 32);
+        for (size_t l = 0; l < 4; l++) {
+            h[l] = serial_rotl(h[l] + w[l] * SERIAL_P2, 31) * SERIAL_P1;
+        }
+    }
+    uint64_t __x = serial_rotl(h[0], 1) + serial_rotl(h[1], 7) + serial_rotl(h[2], 12) + serial_rotl(h[3], 18);
+    for (; i < __n; i += 8) {
+        uint64_t w = 0;
+        memcpy(&w, p + i, min<size_t>(8, __n - i));
+        __x = serial_rotl(__x ^ (serial_rotl(w * SERIAL_P2, 31) * SERIAL_P1), 27) * SERIAL_P1 + SERIAL_P3;
+    }
+    __x ^= __n;
+    __x = (__x ^ (__x >> 33)) * SERIAL_P2;
+    __x = (__x ^ (__x >> 29)) * SERIAL_P3;
+    return __x ^ (__x >> 32);
+}
+
+
+// combines the chunk hashes in order
+inline uint64_t serial_combine(const vector<uint64_t> &__chunks, size_t __bytes) noexcept {
+    return serial_hash(reinterpret_cast<const char*>(__chunks.data()), __chunks.size() * sizeof(uint64_t), __bytes);
+}
+
+
+// checksum of the n bytes at p, chunks are hashed on the pool
+inline uint64_t serial_checksum(const char *p, size_t __n) noexcept {
+    vector<uint64_t> chunks((__n + SERIAL_CHUNK - 1) / SERIAL_CHUNK);
+    uint64_t *out = chunks.data();
+
+    ThreadPool::Global().ParallelFor(0, chunks.size(), SERIAL_CHUNK, [p, __n, out](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; k++) {
+            out[k] = serial_hash(p + k * SERIAL_CHUNK, min(SERIAL_CHUNK, __n - k * SERIAL_CHUNK), k);
+        }
+    });
+    return serial_combine(chunks, __n);
+}
+
+
+// Header ----------------------------------------------------------------
+template<class _T>
+SerialHeader serial_header(uint32_t __rank, uint64_t __r, uint64_t __c, uint64_t __s) noexcept {
+    SerialHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SERIAL_MAGIC, sizeof(SERIAL_MAGIC));
+    h.version = SERIAL_VERSION;
+    h.byte_order = SERIAL_BYTE_ORDER;
+    h.dtype = serial_type<_T>();
+    h.elem_size = sizeof(_T);
+    h.rank = __rank;
+    h.alignment = MEMORY_ALIGNMENT;
+    h.row = __r;
+    h.col = __c;
+    h.stride = __s;
+    h.offset = SERIAL_DATA_OFFSET;
+    return h;
+}
+
+
+// bytes of data that follow the header
+constexpr size_t serial_data_bytes(const SerialHeader &h) noexcept { return size_t(h.row * h.stride * h.elem_size); }
+
+
+// whether h describes a container of rank __rank with elements of type _T, whose data fits in one
+// buffer of aligned_new
+template<class _T>
+bool serial_valid(const SerialHeader &h, uint32_t __rank) noexcept {
+    return memcmp(h.magic, SERIAL_MAGIC, sizeof(SERIAL_MAGIC)) == 0 && h.version == SERIAL_VERSION &&
+           h.byte_order == SERIAL_BYTE_ORDER && h.dtype == serial_type<_T>() && h.elem_size == sizeof(_T) &&
+           h.rank == __rank && (__rank == 2 || h.row == 1) && h.stride >= h.col &&
+           h.alignment != 0 && h.offset % h.alignment == 0 && h.offset >= SERIAL_DATA_OFFSET &&
+           h.row <= (SIZE_MAX - sizeof(MemoryHeader)) / sizeof(_T) / max<uint64_t>(h.stride, 1);
+}
+
+
+// Streams ----------------------------------------------------------------
+// writes the header and the row * stride elements at data, false when the stream failed
+template<class _T>
+bool serial_save(ostream &out, uint32_t __rank, size_t __r, size_t __c, size_t __s, const _T *data) noexcept {
+    SerialHeader h = serial_header<_T>(__rank, __r, __c, __s);
+    const char *p = reinterpret_cast<const char*>(data);
+    size_t __bytes = serial_data_bytes(h);
+    h.checksum = serial_checksum(p, __bytes);
+
+    char pad[SERIAL_DATA_OFFSET - sizeof(SerialHeader)] = {};
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(pad, sizeof(pad));
+    for (size_t i = 0; i < __bytes && out; i += SERIAL_CHUNK) {
+        out.write(p + i, streamsize(min(SERIAL_CHUNK, __bytes - i)));
+    }
+    return bool(out.flush());
+}
+
+
+// bytes left in a stream that can seek, SIZE_MAX for one that cannot
+inline size_t serial_remaining(istream &in) noexcept {
+    streampos __at = in.tellg();
+    if (__at == streampos(-1) || !in.seekg(0, ios::end)) {
+        in.clear();
+        return SIZE_MAX;
+    }
+    streampos __end = in.tellg();
+    in.seekg(__at);
+    return __end == streampos(-1) || __end < __at ? SIZE_MAX : size_t(__end - __at);
+}
+
+
+// reads a file of rank __rank into the packed buffer returned by allocate(row, col), chunk by chunk;
+// padding between rows is dropped. False when the stream failed or is shorter than the header says,
+// the header does not match _T, the buffer could not be allocated or the checksum does not match
+template<class _T, class _Allocate>
+bool serial_load(istream &in, uint32_t __rank, _Allocate allocate) noexcept {
+    SerialHeader h;
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)) || !serial_valid<_T>(h, __rank)) {
+        return false;
+    }
+    size_t __bytes = serial_data_bytes(h), __row = h.col * sizeof(_T), __stride = h.stride * sizeof(_T);
+    size_t __left = serial_remaining(in);
+    if (__left != SIZE_MAX && (__left < h.offset - sizeof(h) || __left - (h.offset - sizeof(h)) < __bytes)) {
+        return false;
+    }
+    if (!in.ignore(streamsize(h.offset - sizeof(h)))) {
+        return false;
+    }
+    char *dst = reinterpret_cast<char*>(allocate(size_t(h.row), size_t(h.col)));
+    if (dst == nullptr) {
+        return false;
+    }
+    vector<char> scratch(__row == __stride ? 0 : min(SERIAL_CHUNK, __bytes));
+    vector<uint64_t> chunks;
+
+    // chunks of a packed file are read straight into the buffer, otherwise through scratch and then
+    // copied out without the padding
+    for (size_t i = 0; i < __bytes; i += SERIAL_CHUNK) {
+        size_t __n = min(SERIAL_CHUNK, __bytes - i);
+        char *p = scratch.empty() ? dst + i : scratch.data();
+        if (!in.read(p, streamsize(__n))) {
+            return false;
+        }
+        chunks.push_back(serial_hash(p, __n, chunks.size()));
+        for (size_t k = 0; !scratch.empty() && k < __n;) {
+            size_t __pos = i + k, __in_row = __pos % __stride;
+            size_t __take = min(__n - k, __stride - __in_row);
+            if (__in_row < __row) {
+                size_t __copy = min(__take, __row - __in_row);
+                memcpy(dst + __pos / __stride * __row + __in_row, p + k, __copy);
+            }
+            k += __take;
+        }
+    }
+    return serial_combine(chunks, __bytes) == h.checksum;
+}
+
+
+// Mapping ----------------------------------------------------------------
+// the data of the file at path as a buffer that aligned_delete releases, with the header in h;
+// nullptr when the file cannot be read, does not hold a container of rank __rank and type _T, or
+// (when verify is set, which reads every page) the checksum does not match. Without mmap the file is
+// read into an ordinary buffer.
+template<class _T>
+_T* serial_map(const string &__path, uint32_t __rank, SerialHeader &h, bool __verify) noexcept {
+#ifdef _MEMORY_MMAP
+    size_t __bytes = 0;
+    char *base = memory_map(__path, __bytes);
+    if (base == nullptr) {
+        return nullptr;
+    }
+    if (__bytes < sizeof(h)) {
+        memory_unmap(base, __bytes);
+        return nullptr;
+    }
+    memcpy(&h, base, sizeof(h));
+    if (!serial_valid<_T>(h, __rank) || h.offset % MEMORY_ALIGNMENT != 0 || h.offset > __bytes ||
+        __bytes - h.offset < serial_data_bytes(h) ||
+        (__verify && serial_checksum(base + h.offset, serial_data_bytes(h)) != h.checksum)) {
+        memory_unmap(base, __bytes);
+        return nullptr;
+    }
+    // the header slot lies in the private mapping, writing it never reaches the file
+    MemoryHeader *header = reinterpret_cast<MemoryHeader*>(base + h.offset) - 1;
+    *header = MemoryHeader{MemorySource::MAPPED, 0, __bytes, size_t(h.offset) - sizeof(MemoryHeader), nullptr};
+    return reinterpret_cast<_T*>(header + 1);
+#else
+    (void)__verify;
+    ifstream in(__path, ios::binary);
+    _T *data = nullptr;
+    bool ok = serial_load<_T>(in, __rank, [&data, &h](size_t __r, size_t __c) {
+        h.row = __r;
+        h.col = h.stride = __c;
+        return data = aligned_new<_T>(__r * __c);
+    });
+    if (!ok) {
+        aligned_delete(data);
+        return nullptr;
+    }
+    return data;
+#endif
+}
+
+#endif // !_SERIALIZE_H_
@@ -0,0 +1,449 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+using namespace std;
+
+// Vector kernels compiled once per instruction set and picked at run time, like the gemm micro-kernels:
+//   reductions (sum, min, max, argmax) over a contiguous buffer use explicit compiler vectors with
+//   SIMD_ACCUMULATORS independent accumulators, so consecutive additions do not wait on each other;
+//   float sums are accumulated in float lanes over SIMD_BLOCK elements, the block sums in double;
+//   dot products multiply-add into the same accumulators (fused on AVX2 and AVX-512), dot4 scores
+//   four rows against one vector so each load of the vector is shared by four rows;
+//   element-wise loops over an expression tree (simd_for) are compiled for every ISA and left to the
+//   compiler's vectorizer, the tree itself is inlined into each copy.
+// Integer types take the scalar kernels, with sums accumulated in double.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define _SIMD_VECTOR_EXT 1
+#endif
+
+#if defined(_SIMD_VECTOR_EXT) && (defined(__x86_64__) || defined(__i386__))
+#define _SIMD_X86_DISPATCH 1
+#endif
+
+// GCC only vectorizes loops that need an epilogue with the dynamic cost model, the -O3 default
+#if defined(__GNUC__) && !defined(__clang__)
+#define _SIMD_VECTORIZE __attribute__((optimize("tree-vectorize", "vect-cost-model=dynamic")))
+#else
+#define _SIMD_VECTORIZE
+#endif
+
+constexpr size_t SIMD_BLOCK = 4096;
+constexpr size_t SIMD_ACCUMULATORS = 4;
+
+// BASE is 128-bit vectors, baseline on x86-64 (SSE2) and AArch64 (NEON)
+enum class SimdLevel {
+    SCALAR,
+    BASE,
+    AVX2,
+    AVX512
+};
+
+
+inline SimdLevel simd_select_level() noexcept {
+#ifdef _SIMD_X86_DISPATCH
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SimdLevel::AVX2;
+    }
+#endif
+#ifdef _SIMD_VECTOR_EXT
+    return SimdLevel::BASE;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+
+inline SimdLevel simd_level() noexcept {
+    static const SimdLevel level = simd_select_level();
+    return level;
+}
+
+
+// Reduction kernels ----------------------------------------------------------------
+// _A is either a compiler vector of _T or a plain scalar accumulator, in which case __w is 1
+template<class _A, class _T>
+constexpr size_t simd_width() noexcept { return is_arithmetic_v<_A> ? 1 : sizeof(_A) / sizeof(_T); }
+
+
+// vectors are passed by reference, returning one wider than the default ISA would change the ABI
+template<class _A, class _T>
+__attribute__((always_inline)) inline void simd_load(_A &v, const _T *p) noexcept {
+    if constexpr (is_arithmetic_v<_A>) {
+        v = _A(*p);
+    } else {
+        memcpy(&v, p, sizeof(_A));
+    }
+}
+
+
+template<class _A>
+__attribute__((always_inline)) inline auto simd_lane(const _A &v, size_t __l) noexcept {
+    if constexpr (is_arithmetic_v<_A>) {
+        return v;
+    } else {
+        return v[__l];
+    }
+}
+
+
+template<class _A, class _T>
+__attribute__((always_inline)) inline double simd_sum_kernel(const _T *p, size_t __n) noexcept {
+    constexpr size_t __w = simd_width<_A, _T>();
+    constexpr size_t __step = __w * SIMD_ACCUMULATORS;
+    double total = 0;
+
+    for (size_t b = 0; b < __n; b += SIMD_BLOCK) {
+        size_t e = min(b + SIMD_BLOCK, __n);
+        _A acc[SIMD_ACCUMULATORS] = {};
+        size_t i = b;
+
+        for (; i + __step <= e; i += __step) {
+            for (size_t a = 0; a < SIMD_ACCUMULATORS; a++) {
+                _A t;
+                simd_load(t, p + i + a * __w);
+                acc[a] += t;
+            }
+        }
+        for (; i + __w <= e; i += __w) {
+            _A t;
+            simd_load(t, p + i);
+            acc[0] += t;
+        }
+        for (size_t a = 1; a < SIMD_ACCUMULATORS; a++) {
+            acc[0] += acc[a];
+        }
+        double block = 0;
+        for (size_t l = 0; l < __w; l++) {
+            block += simd_lane(acc[0], l);
+        }
+        for (; i < e; i++) {
+            block += p[i];
+        }
+        total += block;
+    }
+    return total;
+}
+
+
+// the largest element when _Max, the smallest otherwise; __n > 0
+template<class _A, class _T, bool _Max>
+__attribute__((always_inline)) inline _T simd_extreme_kernel(const _T *p, size_t __n) noexcept {
+    constexpr size_t __w = simd_width<_A, _T>();
+    constexpr size_t __step = __w * SIMD_ACCUMULATORS;
+    _T best = p[0];
+    size_t i = 0;
+
+    if (__n >= __step) {
+        _A acc[SIMD_ACCUMULATORS];
+        for (size_t a = 0; a < SIMD_ACCUMULATORS; a++) {
+            simd_load(acc[a], p + a * __w);
+        }
+        for (i = __step; i + __step <= __n; i += __step) {
+            for (size_t a = 0; a < SIMD_ACCUMULATORS; a++) {
+                _A t;
+                simd_load(t, p + i + a * __w);
+                acc[a] = (_Max ? t > acc[a] : t < acc[a]) ? t : acc[a];
+            }
+        }
+        for (size_t a = 1; a < SIMD_ACCUMULATORS; a++) {
+            acc[0] = (_Max ? acc[a] > acc[0] : acc[a] < acc[0]) ? acc[a] : acc[0];
+        }
+        best = simd_lane(acc[0], 0);
+        for (size_t l = 1; l < __w; l++) {
+            _T v = simd_lane(acc[0], l);
+            best = (_Max ? v > best : v < best) ? v : best;
+        }
+    }
+    for (; i < __n; i++) {
+        best = (_Max ? p[i] > best : p[i] < best) ? p[i] : best;
+    }
+    return best;
+}
+
+
+// one pass, every lane keeps its best value and the index it was first seen at (strict >), two
+// interleaved sets of lanes break the dependency chain; lanes are merged on (value, lowest index)
+// so the result is the first index of the maximum, like the scalar loop. __n > 0
+template<class _A, class _T>
+__attribute__((always_inline)) inline size_t simd_argmax_kernel(const _T *p, size_t __n) noexcept {
+    constexpr size_t __w = simd_width<_A, _T>();
+    size_t indx = 0, i = 0;
+    _T best = p[0];
+
+    if constexpr (__w > 1) {
+        typedef conditional_t<sizeof(_T) == 4, int32_t, int64_t> _L;
+        typedef _L _I __attribute__((vector_size(sizeof(_A))));
+        // lane indices are relative to the start of a block small enough for 32-bit lanes
+        constexpr size_t __block = size_t(1) << 30;
+
+        for (size_t b = 0; b + 2 * __w <= __n; b = i) {
+            size_t e = b + min(__block, __n - b) / (2 * __w) * (2 * __w);
+            _A best0, best1;
+            simd_load(best0, p + b);
+            simd_load(best1, p + b + __w);
+            _I idx0, idx1;
+            for (size_t l = 0; l < __w; l++) {
+                idx0[l] = _L(l);
+                idx1[l] = _L(l + __w);
+            }
+            _I cur0 = idx0, cur1 = idx1;
+
+            for (i = b + 2 * __w; i < e; i += 2 * __w) {
+                cur0 += _L(2 * __w);
+                cur1 += _L(2 * __w);
+                _A t0, t1;
+                simd_load(t0, p + i);
+                simd_load(t1, p + i + __w);
+                auto m0 = t0 > best0;
+                auto m1 = t1 > best1;
+                best0 = m0 ? t0 : best0;
+                idx0 = m0 ? cur0 : idx0;
+                best1 = m1 ? t1 : best1;
+                idx1 = m1 ? cur1 : idx1;
+            }
+            for (size_t l = 0; l < __w; l++) {
+                _T v[2] = {best0[l], best1[l]};
+                size_t k[2] = {b + size_t(idx0[l]), b + size_t(idx1[l])};
+                for (size_t s = 0; s < 2; s++) {
+                    if (v[s] > best || (v[s] == best && k[s] < indx)) {
+                        best = v[s];
+                        indx = k[s];
+                    }
+                }
+            }
+        }
+    }
+    for (; i < __n; i++) {
+        if (p[i] > best) {
+            best = p[i];
+            indx = i;
+        }
+    }
+    return indx;
+}
+
+
+// sum of x[i] * y[i], blocked and accumulated like simd_sum_kernel
+template<class _A, class _T>
+__attribute__((always_inline)) inline double simd_dot_kernel(const _T *x, const _T *y, size_t __n) noexcept {
+    constexpr size_t __w = simd_width<_A, _T>();
+    constexpr size_t __step = __w * SIMD_ACCUMULATORS;
+    double total = 0;
+
+    for (size_t b = 0; b < __n; b += SIMD_BLOCK) {
+        size_t e = min(b + SIMD_BLOCK, __n);
+        _A acc[SIMD_ACCUMULATORS] = {};
+        size_t i = b;
+
+        for (; i + __step <= e; i += __step) {
+            for (size_t a = 0; a < SIMD_ACCUMULATORS; a++) {
+                _A s, t;
+                simd_load(s, x + i + a * __w);
+                simd_load(t, y + i + a * __w);
+                acc[a] += s * t;
+            }
+        }
+        for (; i + __w <= e; i += __w) {
+            _A s, t;
+            simd_load(s, x + i);
+            simd_load(t, y + i);
+            acc[0] += s * t;
+        }
+        for (size_t a = 1; a < SIMD_ACCUMULATORS; a++) {
+            acc[0] += acc[a];
+        }
+        double block = 0;
+        for (size_t l = 0; l < __w; l++) {
+            block += simd_lane(acc[0], l);
+        }
+        for (; i < e; i++) {
+            block += double(x[i]) * double(y[i]);
+        }
+        total += block;
+    }
+    return total;
+}
+
+
+// out[r] = dot(a + r * rs, x) for the four rows r < 4 that start __rs elements apart; every row keeps
+// two accumulators, eight independent chains in all, and x is loaded once for the four of them
+template<class _A, class _T>
+__attribute__((always_inline)) inline void simd_dot4_kernel(const _T *a, size_t __rs, const _T *x, size_t __n, double *out) noexcept {
+    constexpr size_t __w = simd_width<_A, _T>();
+    const _T *row[4] = {a, a + __rs, a + 2 * __rs, a + 3 * __rs};
+    double total[4] = {};
+
+    for (size_t b = 0; b < __n; b += SIMD_BLOCK) {
+        size_t e = min(b + SIMD_BLOCK, __n);
+        _A acc[4][2] = {};
+        size_t i = b;
+
+        for (; i + 2 * __w <= e; i += 2 * __w) {
+            _A s0, s1;
+            simd_load(s0, x + i);
+            simd_load(s1, x + i + __w);
+            for (size_t r = 0; r < 4; r++) {
+                _A t0, t1;
+                simd_load(t0, row[r] + i);
+                simd_load(t1, row[r] + i + __w);
+                acc[r][0] += s0 * t0;
+                acc[r][1] += s1 * t1;
+            }
+        }
+        for (size_t r = 0; r < 4; r++) {
+            acc[r][0] += acc[r][1];
+            double block = 0;
+            for (size_t l = 0; l < __w; l++) {
+                block += simd_lane(acc[r][0], l);
+            }
+            for (size_t k = i; k < e; k++) {
+                block += double(row[r][k]) * double(x[k]);
+            }
+            total[r] += block;
+        }
+    }
+    for (size_t r = 0; r < 4; r++) {
+        out[r] = total[r];
+    }
+}
+
+
+// Instantiations ----------------------------------------------------------------
+template<class _T>
+struct SimdKernels {
+    double (*sum)(const _T*, size_t) noexcept;
+    _T (*min)(const _T*, size_t) noexcept;
+    _T (*max)(const _T*, size_t) noexcept;
+    size_t (*argmax)(const _T*, size_t) noexcept;
+    double (*dot)(const _T*, const _T*, size_t) noexcept;
+    void (*dot4)(const _T*, size_t, const _T*, size_t, double*) noexcept;
+};
+
+// the scalar accumulator of integers is double, so long sums do not overflow
+template<class _T>
+using simd_scalar_t = conditional_t<is_floating_point_v<_T>, _T, double>;
+
+template<class _T> double simd_sum_scalar(const _T *p, size_t __n) noexcept { return simd_sum_kernel<simd_scalar_t<_T>>(p, __n); }
+template<class _T> _T simd_min_scalar(const _T *p, size_t __n) noexcept { return simd_extreme_kernel<_T, _T, false>(p, __n); }
+template<class _T> _T simd_max_scalar(const _T *p, size_t __n) noexcept { return simd_extreme_kernel<_T, _T, true>(p, __n); }
+template<class _T> size_t simd_argmax_scalar(const _T *p, size_t __n) noexcept { return simd_argmax_kernel<_T>(p, __n); }
+template<class _T> double simd_dot_scalar(const _T *x, const _T *y, size_t __n) noexcept { return simd_dot_kernel<simd_scalar_t<_T>>(x, y, __n); }
+template<class _T> void simd_dot4_scalar(const _T *a, size_t __rs, const _T *x, size_t __n, double *out) noexcept { simd_dot4_kernel<simd_scalar_t<_T>>(a, __rs, x, __n, out); }
+
+#ifdef _SIMD_VECTOR_EXT
+template<class _T, size_t _B>
+struct simd_vector {
+    typedef _T type __attribute__((vector_size(_B)));
+};
+
+template<class _T> using simd_v128_t = typename simd_vector<_T, 16>::type;
+template<class _T> using simd_v256_t = typename simd_vector<_T, 32>::type;
+template<class _T> using simd_v512_t = typename simd_vector<_T, 64>::type;
+
+template<class _T> double simd_sum_base(const _T *p, size_t __n) noexcept { return simd_sum_kernel<simd_v128_t<_T>>(p, __n); }
+template<class _T> _T simd_min_base(const _T *p, size_t __n) noexcept { return simd_extreme_kernel<simd_v128_t<_T>, _T, false>(p, __n); }
+template<class _T> _T simd_max_base(const _T *p, size_t __n) noexcept { return simd_extreme_kernel<simd_v128_t<_T>, _T, true>(p, __n); }
+template<class _T> size_t simd_argmax_base(const _T *p, size_t __n) noexcept { return simd_argmax_kernel<simd_v128_t<_T>>(p, __n); }
+template<class _T> double simd_dot_base(const _T *x, const _T *y, size_t __n) noexcept { return simd_dot_kernel<simd_v128_t<_T>>(x, y, __n); }
+template<class _T> void simd_dot4_base(const _T *a, size_t __rs, const _T *x, size_t __n, double *out) noexcept { simd_dot4_kernel<simd_v128_t<_T>>(a, __rs, x, __n, out); }
+#endif
+
+#ifdef _SIMD_X86_DISPATCH
+template<class _T> __attribute__((target("avx2,fma"))) double simd_sum_avx2(const _T *p, size_t __n) noexcept { return simd_sum_kernel<simd_v256_t<_T>>(p, __n); }
+template<class _T> __attribute__((target("avx2,fma"))) _T simd_min_avx2(const _T *p, size_t __n) noexcept { return simd_extreme_kernel<simd_v256_t<_T>, _T, false>(p, __n); }
+template<class _T> __attribute__((target("avx2,fma"))) _T simd_max_avx2(const _T *p, size_t __n) noexcept { return simd_extreme_kernel<simd_v256_t<_T>, _T, true>(p, __n); }
+template<class _T> __attribute__((target("avx2,fma"))) size_t simd_argmax_avx2(const _T *p, size_t __n) noexcept { return simd_argmax_kernel<simd_v256_t<_T>>(p, __n); }
+template<class _T> __attribute__((target("avx2,fma"))) double simd_dot_avx2(const _T *x, const _T *y, size_t __n) noexcept { return simd_dot_kernel<simd_v256_t<_T>>(x, y, __n); }
+template<class _T> __attribute__((target("avx2,fma"))) void simd_dot4_avx2(const _T *a, size_t __rs, const _T *x, size_t __n, double *out) noexcept { simd_dot4_kernel<simd_v256_t<_T>>(a, __rs, x, __n, out); }
+
+template<class _T> __attribute__((target("avx512f"))) double simd_sum_avx512(const _T *p, size_t __n) noexcept { return simd_sum_kernel<simd_v512_t<_T>>(p, __n); }
+template<class _T> __attribute__((target("avx512f"))) _T simd_min_avx512(const _T *p, size_t __n) noexcept { return simd_extreme_kernel<simd_v512_t<_T>, _T, false>(p, __n); }
+template<class _T> __attribute__((target("avx512f"))) _T simd_max_avx512(const _T *p, size_t __n) noexcept { return simd_extreme_kernel<simd_v512_t<_T>, _T, true>(p, __n); }
+template<class _T> __attribute__((target("avx512f"))) size_t simd_argmax_avx512(const _T *p, size_t __n) noexcept { return simd_argmax_kernel<simd_v512_t<_T>>(p, __n); }
+template<class _T> __attribute__((target("avx512f"))) double simd_dot_avx512(const _T *x, const _T *y, size_t __n) noexcept { return simd_dot_kernel<simd_v512_t<_T>>(x, y, __n); }
+template<class _T> __attribute__((target("avx512f"))) void simd_dot4_avx512(const _T *a, size_t __rs, const _T *x, size_t __n, double *out) noexcept { simd_dot4_kernel<simd_v512_t<_T>>(a, __rs, x, __n, out); }
+#endif
+
+
+// Kernel selection ----------------------------------------------------------------
+template<class _T>
+SimdKernels<_T> simd_select_kernels() noexcept {
+    if constexpr (is_same_v<_T, float> || is_same_v<_T, double>) {
+        switch (simd_level()) {
+#ifdef _SIMD_X86_DISPATCH
+            case SimdLevel::AVX512 : return { simd_sum_avx512<_T>, simd_min_avx512<_T>, simd_max_avx512<_T>, simd_argmax_avx512<_T>,
+                                              simd_dot_avx512<_T>, simd_dot4_avx512<_T> };
+            case SimdLevel::AVX2 : return { simd_sum_avx2<_T>, simd_min_avx2<_T>, simd_max_avx2<_T>, simd_argmax_avx2<_T>,
+                                            simd_dot_avx2<_T>, simd_dot4_avx2<_T> };
+#endif
+#ifdef _SIMD_VECTOR_EXT
+            case SimdLevel::BASE : return { simd_sum_base<_T>, simd_min_base<_T>, simd_max_base<_T>, simd_argmax_base<_T>,
+                                            simd_dot_base<_T>, simd_dot4_base<_T> };
+#endif
+            default : break;
+        }
+    }
+    return { simd_sum_scalar<_T>, simd_min_scalar<_T>, simd_max_scalar<_T>, simd_argmax_scalar<_T>,
+             simd_dot_scalar<_T>, simd_dot4_scalar<_T> };
+}
+
+
+template<class _T>
+const SimdKernels<_T>& simd_kernels() noexcept {
+    static const SimdKernels<_T> kernels = simd_select_kernels<_T>();
+    return kernels;
+}
+
+
+// Element-wise loops ----------------------------------------------------------------
+// f(i) for i in [lo, hi), f is inlined into a copy of the loop built for the selected ISA
+template<class _F>
+_SIMD_VECTORIZE inline void simd_for_base(size_t __lo, size_t __hi, _F &f) noexcept {
+    #pragma GCC ivdep
+    for (size_t i = __lo; i < __hi; i++) {
+        f(i);
+    }
+}
+
+#ifdef _SIMD_X86_DISPATCH
+template<class _F>
+_SIMD_VECTORIZE __attribute__((target("avx2,fma"))) void simd_for_avx2(size_t __lo, size_t __hi, _F &f) noexcept {
+    #pragma GCC ivdep
+    for (size_t i = __lo; i < __hi; i++) {
+        f(i);
+    }
+}
+
+
+template<class _F>
+_SIMD_VECTORIZE __attribute__((target("avx512f"))) void simd_for_avx512(size_t __lo, size_t __hi, _F &f) noexcept {
+    #pragma GCC ivdep
+    for (size_t i = __lo; i < __hi; i++) {
+        f(i);
+    }
+}
+#endif
+
+
+template<class _F>
+void simd_for(size_t __lo, size_t __hi, _F &&f) noexcept {
+    switch (simd_level()) {
+#ifdef _SIMD_X86_DISPATCH
+        case SimdLevel::AVX512 : return simd_for_avx512(__lo, __hi, f);
+        case SimdLevel::AVX2 : return simd_for_avx2(__lo, __hi, f);
+#endif
+        default : return simd_for_base(__lo, __hi, f);
+    }
+}
+
+#endif // !_SIMD_H_
@@ -0,0 +1,422 @@
+#ifndef _SORT_H_
+#define _SORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+#include "Memory.hpp"
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+// Sorting and selection over a contiguous buffer, the kernels behind Sort, Argsort, TopK and Quantile
+// of Vector and Matrix2D:
+//   every value is first mapped to an unsigned key of the same width that compares like the value
+//   (floats: the sign bit flipped, negatives inverted; signed integers: the sign bit flipped), NaN is
+//   made the largest key so it sorts last, -0 takes the key of 0, and a descending order inverts the
+//   key except for NaN;
+//   sorts are LSD radix sorts on 8-bit digits, stable, with the index carried along for argsort. Each
+//   pass counts digits per panel in parallel and scatters the panels in parallel, passes where every
+//   key has the same digit are skipped;
+//   selection is a radix select: the top digits are counted in parallel until the rank falls in a
+//   bucket of at most SORT_SELECT_SMALL keys, which are gathered and finished with nth_element;
+//   top-k selects the k-th key, gathers the keys below it and the first of those equal to it, and
+//   sorts only those.
+// Panels only depend on the length, so results do not depend on the thread count. Ties always keep
+// the lower index first.
+
+constexpr size_t SORT_BUCKETS = 256;
+constexpr size_t SORT_PANELS = 64;
+constexpr size_t SORT_PANEL_ELEMENTS = 1 << 16;
+// below these, insertion sort and nth_element on a copy beat the counting passes
+constexpr size_t SORT_INSERTION = 64;
+constexpr size_t SORT_SELECT_SMALL = 1 << 14;
+// columns of a Matrix2D gathered by one task of the column variants
+constexpr size_t SORT_COLUMNS = 16;
+
+template<class _T>
+using sort_key_t = conditional_t<sizeof(_T) == 8, uint64_t,
+                   conditional_t<sizeof(_T) == 4, uint32_t,
+                   conditional_t<sizeof(_T) == 2, uint16_t, uint8_t>>>;
+
+
+// Keys ----------------------------------------------------------------
+template<class _T>
+constexpr bool sort_is_nan(_T x) noexcept {
+    if constexpr (is_floating_point_v<_T>) {
+        return x != x;
+    } else {
+        return false;
+    }
+}
+
+
+template<class _T>
+inline sort_key_t<_T> sort_key(_T x, bool __descending = false) noexcept {
+    typedef sort_key_t<_T> _K;
+    constexpr _K __sign = _K(1) << (8 * sizeof(_K) - 1);
+
+    if (sort_is_nan(x)) {
+        return _K(~_K(0));
+    }
+    // -0 and 0 compare equal, and so share the key of 0
+    if (x == _T(0)) {
+        x = _T(0);
+    }
+    _K k;
+    memcpy(&k, &x, sizeof(_K));
+    if constexpr (is_floating_point_v<_T>) {
+        k = (k & __sign) ? _K(~k) : _K(k | __sign);
+    } else if constexpr (is_signed_v<_T>) {
+        k = _K(k ^ __sign);
+    }
+    return __descending ? _K(~k) : k;
+}
+
+
+template<class _T>
+inline _T sort_value(sort_key_t<_T> k, bool __descending = false) noexcept {
+    typedef sort_key_t<_T> _K;
+    constexpr _K __sign = _K(1) << (8 * sizeof(_K) - 1);
+
+    if constexpr (is_floating_point_v<_T>) {
+        if (k == _K(~_K(0))) {
+            return numeric_limits<_T>::quiet_NaN();
+        }
+    }
+    k = __descending ? _K(~k) : k;
+    if constexpr (is_floating_point_v<_T>) {
+        k = (k & __sign) ? _K(k & ~__sign) : _K(~k);
+    } else if constexpr (is_signed_v<_T>) {
+        k = _K(k ^ __sign);
+    }
+    _T x;
+    memcpy(&x, &k, sizeof(_K));
+    return x;
+}
+
+
+// panel p of n elements split into P panels
+inline size_t sort_panels(size_t __n) noexcept {
+    return min(SORT_PANELS, max<size_t>(1, __n / SORT_PANEL_ELEMENTS));
+}
+
+
+inline size_t sort_panel_begin(size_t p, size_t __n, size_t __panels) noexcept { return p * __n / __panels; }
+
+
+template<class _T>
+void sort_fill_keys(const _T *x, size_t __n, bool __descending, sort_key_t<_T> *keys) noexcept {
+    ThreadPool::Global().ParallelFor(0, __n, 1, [=](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            keys[i] = sort_key(x[i], __descending);
+        }
+    });
+}
+
+
+// Radix sort ----------------------------------------------------------------
+// stable insertion sort of keys, and of the indices along with them when idx is not null
+template<class _K>
+void sort_insertion(size_t __n, _K *keys, size_t *idx) noexcept {
+    for (size_t i = 1; i < __n; i++) {
+        _K k = keys[i];
+        size_t __v = idx ? idx[i] : 0, j = i;
+        for (; j > 0 && keys[j - 1] > k; j--) {
+            keys[j] = keys[j - 1];
+            if (idx) {
+                idx[j] = idx[j - 1];
+            }
+        }
+        keys[j] = k;
+        if (idx) {
+            idx[j] = __v;
+        }
+    }
+}
+
+
+// LSD radix sort of n keys (and indices when idx is not null), stable; tk and ti hold n scratch
+// elements each, the result is left in keys and idx
+template<class _K>
+void sort_radix(size_t __n, _K *keys, size_t *idx, _K *tk, size_t *ti) noexcept {
+    if (__n < SORT_INSERTION) {
+        sort_insertion(__n, keys, idx);
+        return;
+    }
+    auto &pool = ThreadPool::Global();
+    size_t __panels = sort_panels(__n), __cost = __n / __panels;
+    vector<size_t> count(__panels * SORT_BUCKETS);
+    _K *src = keys, *dst = tk;
+    size_t *si = idx, *di = ti;
+
+    for (size_t __shift = 0; __shift < 8 * sizeof(_K); __shift += 8) {
+        fill(count.begin(), count.end(), 0);
+        pool.ParallelFor(0, __panels, __cost, [&](size_t lo, size_t hi) {
+            for (size_t p = lo; p < hi; p++) {
+                size_t *c = count.data() + p * SORT_BUCKETS;
+                size_t __e = sort_panel_begin(p + 1, __n, __panels);
+                for (size_t i = sort_panel_begin(p, __n, __panels); i < __e; i++) {
+                    c[(src[i] >> __shift) & 0xff]++;
+                }
+            }
+        });
+
+        // every key has the same digit, the pass would not move anything
+        size_t __d0 = (src[0] >> __shift) & 0xff, __same = 0;
+        for (size_t p = 0; p < __panels; p++) {
+            __same += count[p * SORT_BUCKETS + __d0];
+        }
+        if (__same == __n) {
+            continue;
+        }
+
+        // digit-major, panel-minor offsets keep equal digits in their panel order
+        size_t __off = 0;
+        for (size_t d = 0; d < SORT_BUCKETS; d++) {
+            for (size_t p = 0; p < __panels; p++) {
+                size_t t = count[p * SORT_BUCKETS + d];
+                count[p * SORT_BUCKETS + d] = __off;
+                __off += t;
+            }
+        }
+
+        pool.ParallelFor(0, __panels, __cost, [&](size_t lo, size_t hi) {
+            for (size_t p = lo; p < hi; p++) {
+                size_t *c = count.data() + p * SORT_BUCKETS;
+                size_t __e = sort_panel_begin(p + 1, __n, __panels);
+                for (size_t i = sort_panel_begin(p, __n, __panels); i < __e; i++) {
+                    size_t __pos = c[(src[i] >> __shift) & 0xff]++;
+                    dst[__pos] = src[i];
+                    if (si) {
+                        di[__pos] = si[i];
+                    }
+                }
+            }
+        });
+        swap(src, dst);
+        swap(si, di);
+    }
+
+    if (src != keys) {
+        pool.ParallelFor(0, __n, 1, [&](size_t lo, size_t hi) {
+            memcpy(keys + lo, src + lo, (hi - lo) * sizeof(_K));
+            if (idx) {
+                memcpy(idx + lo, si + lo, (hi - lo) * sizeof(size_t));
+            }
+        });
+    }
+}
+
+
+// x sorted into out, both of n elements
+template<class _T>
+void sort_values(const _T *x, size_t __n, bool __descending, _T *out) noexcept {
+    typedef sort_key_t<_T> _K;
+    _K *keys = aligned_new<_K>(2 * __n);
+
+    sort_fill_keys(x, __n, __descending, keys);
+    sort_radix<_K>(__n, keys, nullptr, keys + __n, nullptr);
+    ThreadPool::Global().ParallelFor(0, __n, 1, [=](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            out[i] = sort_value<_T>(keys[i], __descending);
+        }
+    });
+    aligned_delete(keys);
+}
+
+
+// the indices that sort x, equal values in index order
+template<class _T>
+void sort_indices(const _T *x, size_t __n, bool __descending, size_t *out) noexcept {
+    typedef sort_key_t<_T> _K;
+    _K *keys = aligned_new<_K>(2 * __n);
+    size_t *tmp = aligned_new<size_t>(__n);
+
+    sort_fill_keys(x, __n, __descending, keys);
+    ThreadPool::Global().ParallelFor(0, __n, 1, [=](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            out[i] = i;
+        }
+    });
+    sort_radix<_K>(__n, keys, out, keys + __n, tmp);
+    aligned_delete(tmp);
+    aligned_delete(keys);
+}
+
+
+// Selection ----------------------------------------------------------------
+// the key of rank r (0 based) among the keys of x, with r < n
+template<class _T>
+sort_key_t<_T> sort_select(const _T *x, size_t __n, size_t __r, bool __descending = false) noexcept {
+    typedef sort_key_t<_T> _K;
+    auto &pool = ThreadPool::Global();
+    size_t __panels = sort_panels(__n), __cost = __n / __panels;
+    vector<size_t> count(__panels * SORT_BUCKETS), found(__panels, 0);
+    size_t __candidates = __n;
+    _K __prefix = 0, __mask = 0;
+
+    // keys with (key & mask) == prefix are the candidates, r is the rank among them
+    for (int __shift = 8 * sizeof(_K) - 8; ; __shift -= 8) {
+        if (__shift < 0) {
+            return __prefix;
+        }
+        if (__candidates <= SORT_SELECT_SMALL) {
+            vector<_K> c(__candidates);
+            if (__candidates == __n) {
+                for (size_t i = 0; i < __n; i++) {
+                    c[i] = sort_key(x[i], __descending);
+                }
+            } else {
+                // found holds the candidates of each panel, so the panels gather in parallel
+                vector<size_t> __at(__panels + 1, 0);
+                for (size_t p = 0; p < __panels; p++) {
+                    __at[p + 1] = __at[p] + found[p];
+                }
+                pool.ParallelFor(0, __panels, __cost, [&](size_t lo, size_t hi) {
+                    for (size_t p = lo; p < hi; p++) {
+                        size_t __e = sort_panel_begin(p + 1, __n, __panels), __o = __at[p];
+                        for (size_t i = sort_panel_begin(p, __n, __panels); i < __e; i++) {
+                            _K k = sort_key(x[i], __descending);
+                            if ((k & __mask) == __prefix) {
+                                c[__o++] = k;
+                            }
+                        }
+                    }
+                });
+            }
+            nth_element(c.begin(), c.begin() + __r, c.end());
+            return c[__r];
+        }
+
+        fill(count.begin(), count.end(), 0);
+        pool.ParallelFor(0, __panels, __cost, [&](size_t lo, size_t hi) {
+            for (size_t p = lo; p < hi; p++) {
+                size_t *c = count.data() + p * SORT_BUCKETS;
+                size_t __e = sort_panel_begin(p + 1, __n, __panels);
+                for (size_t i = sort_panel_begin(p, __n, __panels); i < __e; i++) {
+                    _K k = sort_key(x[i], __descending);
+                    if ((k & __mask) == __prefix) {
+                        c[(k >> __shift) & 0xff]++;
+                    }
+                }
+            }
+        });
+
+        size_t d = 0;
+        for (;; d++) {
+            size_t __total = 0;
+            for (size_t p = 0; p < __panels; p++) {
+                __total += count[p * SORT_BUCKETS + d];
+            }
+            if (__r < __total) {
+                __candidates = __total;
+                break;
+            }
+            __r -= __total;
+        }
+        for (size_t p = 0; p < __panels; p++) {
+            found[p] = count[p * SORT_BUCKETS + d];
+        }
+        __prefix |= _K(d) << __shift;
+        __mask |= _K(0xff) << __shift;
+    }
+}
+
+
+// the q quantile of x with linear interpolation between the two closest ranks (NumPy's default),
+// q clamped to [0, 1]; 0 when x is empty
+template<class _T>
+_T sort_quantile(const _T *x, size_t __n, double __q) noexcept {
+    if (__n == 0) {
+        return _T(0);
+    }
+    __q = __q < 0 ? 0 : (__q > 1 ? 1 : __q);
+    double __pos = __q * double(__n - 1);
+    size_t __lo = size_t(__pos);
+    double __frac = __pos - double(__lo);
+    _T __a = sort_value<_T>(sort_select(x, __n, __lo));
+
+    if (__frac == 0 || __lo + 1 >= __n) {
+        return __a;
+    }
+    _T __b = sort_value<_T>(sort_select(x, __n, __lo + 1));
+    // in double: b - a overflows an int, or a float between -max and max; equal infinities stay put
+    if (__a == __b) {
+        return __a;
+    }
+    return _T(double(__a) + __frac * (double(__b) - double(__a)));
+}
+
+
+// indices of the k largest (or smallest) values of x, ordered from the largest (smallest), equal values
+// in index order; returns min(k, n), the number written to out
+template<class _T>
+size_t sort_top_k(const _T *x, size_t __n, size_t __k, bool __largest, size_t *out) noexcept {
+    typedef sort_key_t<_T> _K;
+    __k = min(__k, __n);
+    if (__k == 0) {
+        return 0;
+    }
+    auto &pool = ThreadPool::Global();
+    _K __t = sort_select(x, __n, __k - 1, __largest);
+    size_t __panels = sort_panels(__n), __cost = __n / __panels;
+    vector<size_t> less(__panels, 0), equal(__panels, 0);
+
+    pool.ParallelFor(0, __panels, __cost, [&](size_t lo, size_t hi) {
+        for (size_t p = lo; p < hi; p++) {
+            size_t __e = sort_panel_begin(p + 1, __n, __panels);
+            for (size_t i = sort_panel_begin(p, __n, __panels); i < __e; i++) {
+                _K k = sort_key(x[i], __largest);
+                less[p] += k < __t;
+                equal[p] += k == __t;
+            }
+        }
+    });
+
+    // every key below t is taken, then the first keys equal to t until there are k
+    size_t __need = __k;
+    for (size_t p = 0; p < __panels; p++) {
+        __need -= less[p];
+    }
+    vector<size_t> take(__panels), __at(__panels + 1, 0);
+    for (size_t p = 0; p < __panels; p++) {
+        take[p] = min(equal[p], __need);
+        __need -= take[p];
+        __at[p + 1] = __at[p] + less[p] + take[p];
+    }
+
+    _K *keys = aligned_new<_K>(2 * __k);
+    size_t *tmp = aligned_new<size_t>(__k);
+    pool.ParallelFor(0, __panels, __cost, [&](size_t lo, size_t hi) {
+        for (size_t p = lo; p < hi; p++) {
+            size_t __e = sort_panel_begin(p + 1, __n, __panels), __o = __at[p], __eq = take[p];
+            for (size_t i = sort_panel_begin(p, __n, __panels); i < __e; i++) {
+                _K k = sort_key(x[i], __largest);
+                bool __take = k < __t;
+                if (k == __t && __eq > 0) {
+                    __eq--;
+                    __take = true;
+                }
+                if (__take) {
+                    keys[__o] = k;
+                    out[__o++] = i;
+                }
+            }
+        }
+    });
+    // gathered in index order, so the stable sort leaves equal keys in index order
+    sort_radix<_K>(__k, keys, out, keys + __k, tmp);
+    aligned_delete(tmp);
+    aligned_delete(keys);
+    return __k;
+}
+
+#endif // !_SORT_H_
@@ -0,0 +1,689 @@
+#ifndef _SPARSE_H_
+#define _SPARSE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+
+#include "Memory.hpp"
+#include "Profile.hpp"
+#include "ThreadPool.hpp"
+#include "Simd.hpp"
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+
+using namespace std;
+
+// Compressed sparse matrices:
+//   CSR stores the nonzeros row by row, entries offsets[i] .. offsets[i + 1] belong to row i and index
+//   holds their columns in increasing order; CSC is the same by columns. The layout is a template
+//   argument, so the transpose of a CSR matrix is the CSC matrix over the same three arrays, and
+//   converting between CSR and CSC is the actual transpose.
+//   The compressed dimension is the major one (rows of CSR). Work along it is cut into tasks of about
+//   the same number of nonzeros. Work that scatters into the minor dimension runs on at most
+//   SPARSE_PANELS panels of lines with accumulators of their own, added in panel order. Both only depend
+//   on the matrix, so results are the same whatever the thread count.
+// Minor indices are 32 bit: 100M nonzeros of float take 800 MB plus the offsets.
+
+enum class SparseLayout {
+    CSR,
+    CSC
+};
+
+constexpr size_t SPARSE_PANELS = 64;
+constexpr size_t SPARSE_PANEL_NONZEROS = size_t(1) << 16;
+
+template<class _T, SparseLayout _L = SparseLayout::CSR>
+class SparseMatrix {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        typedef uint32_t index_type;
+        static constexpr SparseLayout layout = _L;
+        static constexpr SparseLayout other_layout = _L == SparseLayout::CSR ? SparseLayout::CSC : SparseLayout::CSR;
+
+    private:
+        // the matrix owns the three buffers, allocated with aligned_new and released in the destructor
+        _T *_values = nullptr;
+        index_type *_index = nullptr;
+        size_type *_offsets = nullptr;
+        size_type _row = 0;
+        size_type _col = 0;
+        size_type _nnz = 0;
+
+        static auto allocate(size_type, size_type, size_type) noexcept;
+
+        template<class _F> void sweep_major(size_type, _F) const noexcept;
+        template<class _R, class _F, class _M> vector<_R> sweep_minor(_R, _F, _M) const noexcept;
+        template<class _F, class _M> vector<double> reduce_along(Axis2D, double, _F, _M) const noexcept;
+        size_type length_along(Axis2D) const noexcept;
+        Vector<_T> gather(const _T*) const noexcept;
+        Vector<_T> scatter(const _T*) const noexcept;
+        SparseMatrix<_T, other_layout> convert() const noexcept;
+
+        template<class, SparseLayout> friend class SparseMatrix;
+
+    public:
+        constexpr SparseMatrix() noexcept = default;
+        template<class _E> explicit SparseMatrix(const Matrix2DExpr<_E>&) noexcept;
+        SparseMatrix(const SparseMatrix<_T, _L>&) noexcept;
+        SparseMatrix(SparseMatrix<_T, _L>&&) noexcept;
+        ~SparseMatrix() noexcept;
+
+        // r x c matrix with values[k] at (rows[k], cols[k]), duplicates are summed in input order; an
+        // empty matrix when an index is out of range
+        static auto FromTriplets(size_type, size_type, const index_type *__rows, const index_type *__cols,
+                                 const _T *__values, size_type __n) noexcept;
+
+        constexpr size_type Row() const noexcept { return this->_row; }
+        constexpr size_type Col() const noexcept { return this->_col; }
+        constexpr size_type NonZeros() const noexcept { return this->_nnz; }
+        constexpr size_type Major() const noexcept { return _L == SparseLayout::CSR ? this->_row : this->_col; }
+        constexpr size_type Minor() const noexcept { return _L == SparseLayout::CSR ? this->_col : this->_row; }
+        constexpr const _T* Values() const noexcept { return this->_values; }
+        constexpr const index_type* Index() const noexcept { return this->_index; }
+        constexpr const size_type* Offsets() const noexcept { return this->_offsets; }
+        double Density() const noexcept;
+
+        Matrix2D<_T> Dense() const noexcept;
+        SparseMatrix<_T, SparseLayout::CSR> ToCSR() const noexcept;
+        SparseMatrix<_T, SparseLayout::CSC> ToCSC() const noexcept;
+        // the transpose in the other layout, a copy of the arrays; a temporary hands its arrays over
+        SparseMatrix<_T, other_layout> T() const & noexcept;
+        SparseMatrix<_T, other_layout> T() && noexcept;
+
+        // y = A x and y = A^T x, sparse x dense; an empty result when the sizes do not match
+        template<class _R> Vector<_T> MatVec(const VectorExpr<_R>&) const noexcept;
+        template<class _R> Vector<_T> MatVecT(const VectorExpr<_R>&) const noexcept;
+        template<class _E> Matrix2D<_T> operator * (const Matrix2DExpr<_E>&) const noexcept;
+
+        // the zeros that are not stored count like in the dense matrix, see Axis2D
+        Vector<_T> Mean(Axis2D) const noexcept;
+        Vector<_T> STD(Axis2D) const noexcept;
+        Vector<_T> Min(Axis2D) const noexcept;
+        Vector<_T> Max(Axis2D) const noexcept;
+
+        SparseMatrix<_T, _L>& operator = (const SparseMatrix<_T, _L>&) noexcept;
+        SparseMatrix<_T, _L>& operator = (SparseMatrix<_T, _L>&&) noexcept;
+};
+
+template<class _T> using CSRMatrix = SparseMatrix<_T, SparseLayout::CSR>;
+template<class _T> using CSCMatrix = SparseMatrix<_T, SparseLayout::CSC>;
+
+
+template<class _T, SparseLayout _L>
+auto SparseMatrix<_T, _L>::allocate(size_type __r, size_type __c, size_type __nnz) noexcept {
+    SparseMatrix<_T, _L> m;
+    m._row = __r;
+    m._col = __c;
+    m._nnz = __nnz;
+    m._values = aligned_new<_T>(__nnz);
+    m._index = aligned_new<index_type>(__nnz);
+    m._offsets = aligned_new<size_type>(m.Major() + 1);
+    return m;
+}
+
+
+// zeros are dropped; CSC is built as CSR and converted
+template<class _T, SparseLayout _L>
+template<class _E>
+SparseMatrix<_T, _L>::SparseMatrix(const Matrix2DExpr<_E> &e) noexcept {
+    _PROFILE_SCOPE("SparseMatrix::SparseMatrix(dense)", 0);
+    if constexpr (_L == SparseLayout::CSC) {
+        *this = CSRMatrix<_T>(e).ToCSC();
+    } else {
+        const _E &x = e.self();
+        size_type __r = x.Row(), __c = x.Col();
+        vector<size_type> offsets(__r + 1, 0);
+        size_type *o = offsets.data();
+
+        ThreadPool::Global().ParallelFor(0, __r, __c, [&x, o, __c](size_type lo, size_type hi) {
+            for (size_type i = lo; i < hi; i++) {
+                size_type __n = 0;
+                for (size_type j = 0; j < __c; j++) {
+                    __n += x(i, j) != _T(0);
+                }
+                o[i + 1] = __n;
+            }
+        });
+        partial_sum(o, o + __r + 1, o);
+
+        *this = SparseMatrix::allocate(__r, __c, o[__r]);
+        memcpy(this->_offsets, o, (__r + 1) * sizeof(size_type));
+        _T *ref_v = this->_values;
+        index_type *ref_i = this->_index;
+        ThreadPool::Global().ParallelFor(0, __r, __c, [&x, o, __c, ref_v, ref_i](size_type lo, size_type hi) {
+            for (size_type i = lo; i < hi; i++) {
+                size_type k = o[i];
+                for (size_type j = 0; j < __c; j++) {
+                    _T v = x(i, j);
+                    if (v != _T(0)) {
+                        ref_v[k] = v;
+                        ref_i[k++] = index_type(j);
+                    }
+                }
+            }
+        });
+    }
+}
+
+
+template<class _T, SparseLayout _L>
+SparseMatrix<_T, _L>::SparseMatrix(const SparseMatrix<_T, _L> &y) noexcept {
+    *this = SparseMatrix::allocate(y._row, y._col, y._nnz);
+    memcpy(this->_values, y._values, y._nnz * sizeof(_T));
+    memcpy(this->_index, y._index, y._nnz * sizeof(index_type));
+    memcpy(this->_offsets, y._offsets, (y.Major() + 1) * sizeof(size_type));
+}
+
+
+template<class _T, SparseLayout _L>
+SparseMatrix<_T, _L>::SparseMatrix(SparseMatrix<_T, _L> &&y) noexcept { *this = move(y); }
+
+
+template<class _T, SparseLayout _L>
+SparseMatrix<_T, _L>::~SparseMatrix() noexcept {
+    aligned_delete(this->_values);
+    aligned_delete(this->_index);
+    aligned_delete(this->_offsets);
+}
+
+
+template<class _T, SparseLayout _L>
+SparseMatrix<_T, _L>& SparseMatrix<_T, _L>::operator = (const SparseMatrix<_T, _L> &y) noexcept {
+    if (this != &y) {
+        *this = SparseMatrix<_T, _L>(y);
+    }
+    return *this;
+}
+
+
+template<class _T, SparseLayout _L>
+SparseMatrix<_T, _L>& SparseMatrix<_T, _L>::operator = (SparseMatrix<_T, _L> &&y) noexcept {
+    if (this != &y) {
+        swap(this->_values, y._values);
+        swap(this->_index, y._index);
+        swap(this->_offsets, y._offsets);
+        this->_row = exchange(y._row, 0);
+        this->_col = exchange(y._col, 0);
+        this->_nnz = exchange(y._nnz, 0);
+    }
+    return *this;
+}
+
+
+// entries are bucketed by line, every line is sorted stably on its minor index and equal indices summed
+template<class _T, SparseLayout _L>
+auto SparseMatrix<_T, _L>::FromTriplets(size_type __r, size_type __c, const index_type *__rows, const index_type *__cols,
+                                        const _T *__values, size_type __n) noexcept {
+    _PROFILE_SCOPE("SparseMatrix::FromTriplets", 0);
+    typedef pair<index_type, _T> entry_type;
+    const index_type *major = _L == SparseLayout::CSR ? __rows : __cols;
+    const index_type *minor = _L == SparseLayout::CSR ? __cols : __rows;
+    size_type __m = _L == SparseLayout::CSR ? __r : __c;
+
+    for (size_type k = 0; k < __n; k++) {
+        if (__rows[k] >= __r || __cols[k] >= __c) {
+            return SparseMatrix<_T, _L>();
+        }
+    }
+
+    vector<size_type> offsets(__m + 1, 0);
+    size_type *o = offsets.data();
+    for (size_type k = 0; k < __n; k++) {
+        o[major[k] + 1]++;
+    }
+    partial_sum(o, o + __m + 1, o);
+    vector<entry_type> entries(__n);
+    vector<size_type> next(o, o + __m);
+    for (size_type k = 0; k < __n; k++) {
+        entries[next[major[k]]++] = entry_type(minor[k], __values[k]);
+    }
+
+    // next[i] becomes the number of distinct entries of line i
+    entry_type *ref_e = entries.data();
+    size_type *ref_n = next.data();
+    ThreadPool::Global().ParallelFor(0, __m, __n / max<size_type>(__m, 1) + 1, [o, ref_e, ref_n](size_type lo, size_type hi) {
+        for (size_type i = lo; i < hi; i++) {
+            entry_type *b = ref_e + o[i], *e = ref_e + o[i + 1];
+            stable_sort(b, e, [](const entry_type &x, const entry_type &y) { return x.first < y.first; });
+            entry_type *w = b;
+            for (entry_type *p = b; p < e; p++) {
+                if (w != b && (w - 1)->first == p->first) {
+                    (w - 1)->second += p->second;
+                } else {
+                    *w++ = *p;
+                }
+            }
+            ref_n[i] = size_type(w - b);
+        }
+    });
+
+    size_type __nnz = accumulate(next.begin(), next.end(), size_type(0));
+    auto s = SparseMatrix::allocate(__r, __c, __nnz);
+    size_type *so = s._offsets;
+    so[0] = 0;
+    for (size_type i = 0; i < __m; i++) {
+        so[i + 1] = so[i] + next[i];
+    }
+    _T *ref_v = s._values;
+    index_type *ref_i = s._index;
+    ThreadPool::Global().ParallelFor(0, __m, __nnz / max<size_type>(__m, 1) + 1, [o, so, ref_e, ref_v, ref_i](size_type lo, size_type hi) {
+        for (size_type i = lo; i < hi; i++) {
+            for (size_type k = so[i], p = o[i]; k < so[i + 1]; k++, p++) {
+                ref_i[k] = ref_e[p].first;
+                ref_v[k] = ref_e[p].second;
+            }
+        }
+    });
+    return s;
+}
+
+
+template<class _T, SparseLayout _L>
+double SparseMatrix<_T, _L>::Density() const noexcept {
+    double __cells = double(this->_row) * double(this->_col);
+    return __cells > 0 ? double(this->_nnz) / __cells : 0.0;
+}
+
+
+// Partitioning ----------------------------------------------------------------
+// f(lo, hi) on ranges of lines holding about the same number of nonzeros, __cost per nonzero; a line
+// goes to the range that holds its first entry, so lines are never split and empty lines are covered
+template<class _T, SparseLayout _L>
+template<class _F>
+void SparseMatrix<_T, _L>::sweep_major(size_type __cost, _F f) const noexcept {
+    const size_type *o = this->_offsets;
+    size_type __m = this->Major(), __nnz = this->_nnz;
+
+    if (__nnz == 0) {
+        f(size_type(0), __m);
+        return;
+    }
+    ThreadPool::Global().ParallelFor(0, __nnz, __cost, [o, __m, __nnz, &f](size_type lo, size_type hi) {
+        size_type i0 = size_type(lower_bound(o, o + __m, lo) - o);
+        size_type i1 = hi == __nnz ? __m : size_type(lower_bound(o, o + __m, hi) - o);
+        f(i0, i1);
+    });
+}
+
+
+// f(lo, hi, acc) accumulates the lines [lo, hi) into acc, one _R per minor index starting at init;
+// panels of lines have their own acc, merged with merge(a, b) in panel order. There are at most
+// SPARSE_PANELS panels and never more accumulators than nonzeros
+template<class _T, SparseLayout _L>
+template<class _R, class _F, class _M>
+vector<_R> SparseMatrix<_T, _L>::sweep_minor(_R init, _F f, _M merge) const noexcept {
+    const size_type *o = this->_offsets;
+    size_type __m = this->Major(), __n = this->Minor(), __nnz = this->_nnz;
+    size_type __panels = min(SPARSE_PANELS, max<size_type>(1, __nnz / max(SPARSE_PANEL_NONZEROS, __n)));
+
+    if (__panels == 1) {
+        vector<_R> acc(__n, init);
+        f(size_type(0), __m, acc.data());
+        return acc;
+    }
+    vector<_R> part(__panels * __n, init);
+    _R *ref_p = part.data();
+    ThreadPool::Global().ParallelFor(0, __panels, __nnz / __panels, [&](size_type lo, size_type hi) {
+        for (size_type p = lo; p < hi; p++) {
+            size_type i0 = size_type(lower_bound(o, o + __m, p * __nnz / __panels) - o);
+            size_type i1 = p + 1 == __panels ? __m : size_type(lower_bound(o, o + __m, (p + 1) * __nnz / __panels) - o);
+            f(i0, i1, ref_p + p * __n);
+        }
+    });
+    ThreadPool::Global().ParallelFor(0, __n, __panels, [&](size_type lo, size_type hi) {
+        for (size_type p = 1; p < __panels; p++) {
+            const _R *src = ref_p + p * __n;
+            for (size_type j = lo; j < hi; j++) {
+                ref_p[j] = merge(ref_p[j], src[j]);
+            }
+        }
+    });
+    part.resize(__n);
+    return part;
+}
+
+
+// Conversion ----------------------------------------------------------------
+template<class _T, SparseLayout _L>
+Matrix2D<_T> SparseMatrix<_T, _L>::Dense() const noexcept {
+    _PROFILE_SCOPE("SparseMatrix::Dense", 0);
+    auto m = Matrix2D<_T>::ZeroInit(this->_row, this->_col);
+    const _T *v = this->_values;
+    const index_type *idx = this->_index;
+    const size_type *o = this->_offsets;
+    _T *ref_m = m.Begin();
+    size_type __s = m.Stride();
+
+    this->sweep_major(1, [v, idx, o, ref_m, __s](size_type lo, size_type hi) {
+        for (size_type i = lo; i < hi; i++) {
+            for (size_type k = o[i]; k < o[i + 1]; k++) {
+                if constexpr (_L == SparseLayout::CSR) {
+                    ref_m[i * __s + idx[k]] = v[k];
+                } else {
+                    ref_m[size_type(idx[k]) * __s + i] = v[k];
+                }
+            }
+        }
+    });
+    return m;
+}
+
+
+// the same matrix in the other layout: entries are counted per minor index, then scattered line by
+// line, so the new lines come out sorted
+template<class _T, SparseLayout _L>
+SparseMatrix<_T, SparseMatrix<_T, _L>::other_layout> SparseMatrix<_T, _L>::convert() const noexcept {
+    _PROFILE_SCOPE("SparseMatrix::convert", 0);
+    auto m = SparseMatrix<_T, other_layout>::allocate(this->_row, this->_col, this->_nnz);
+    size_type __m = this->Major(), __n = this->Minor();
+    size_type *o = m._offsets;
+
+    fill(o, o + __n + 1, size_type(0));
+    for (size_type k = 0; k < this->_nnz; k++) {
+        o[this->_index[k] + 1]++;
+    }
+    partial_sum(o, o + __n + 1, o);
+    vector<size_type> next(o, o + __n);
+    for (size_type i = 0; i < __m; i++) {
+        for (size_type k = this->_offsets[i]; k < this->_offsets[i + 1]; k++) {
+            size_type p = next[this->_index[k]]++;
+            m._index[p] = index_type(i);
+            m._values[p] = this->_values[k];
+        }
+    }
+    return m;
+}
+
+
+template<class _T, SparseLayout _L>
+SparseMatrix<_T, SparseLayout::CSR> SparseMatrix<_T, _L>::ToCSR() const noexcept {
+    if constexpr (_L == SparseLayout::CSR) {
+        return *this;
+    } else {
+        return this->convert();
+    }
+}
+
+
+template<class _T, SparseLayout _L>
+SparseMatrix<_T, SparseLayout::CSC> SparseMatrix<_T, _L>::ToCSC() const noexcept {
+    if constexpr (_L == SparseLayout::CSC) {
+        return *this;
+    } else {
+        return this->convert();
+    }
+}
+
+
+// the lines of A are the lines of A^T in the other layout
+template<class _T, SparseLayout _L>
+SparseMatrix<_T, SparseMatrix<_T, _L>::other_layout> SparseMatrix<_T, _L>::T() const & noexcept {
+    return SparseMatrix<_T, _L>(*this).T();
+}
+
+
+template<class _T, SparseLayout _L>
+SparseMatrix<_T, SparseMatrix<_T, _L>::other_layout> SparseMatrix<_T, _L>::T() && noexcept {
+    SparseMatrix<_T, other_layout> m;
+    m._values = exchange(this->_values, nullptr);
+    m._index = exchange(this->_index, nullptr);
+    m._offsets = exchange(this->_offsets, nullptr);
+    m._row = exchange(this->_col, 0);
+    m._col = exchange(this->_row, 0);
+    m._nnz = exchange(this->_nnz, 0);
+    return m;
+}
+
+
+// Products ----------------------------------------------------------------
+// y[i] = dot(line i, x), x indexed by the minor dimension
+template<class _T, SparseLayout _L>
+Vector<_T> SparseMatrix<_T, _L>::gather(const _T *x) const noexcept {
+    auto y = Vector<_T>::ZeroInit(this->Major());
+    const _T *v = this->_values;
+    const index_type *idx = this->_index;
+    const size_type *o = this->_offsets;
+    _T *ref_y = y.Begin();
+
+    this->sweep_major(1, [v, idx, o, x, ref_y](size_type lo, size_type hi) {
+        for (size_type i = lo; i < hi; i++) {
+            _T s = _T(0);
+            for (size_type k = o[i]; k < o[i + 1]; k++) {
+                s += v[k] * x[idx[k]];
+            }
+            ref_y[i] = s;
+        }
+    });
+    return y;
+}
+
+
+// y = sum of x[i] * line i, x indexed by the major dimension
+template<class _T, SparseLayout _L>
+Vector<_T> SparseMatrix<_T, _L>::scatter(const _T *x) const noexcept {
+    const _T *v = this->_values;
+    const index_type *idx = this->_index;
+    const size_type *o = this->_offsets;
+
+    auto acc = this->sweep_minor(_T(0), [v, idx, o, x](size_type lo, size_type hi, _T *y) {
+        for (size_type i = lo; i < hi; i++) {
+            _T __x = x[i];
+            for (size_type k = o[i]; k < o[i + 1]; k++) {
+                y[idx[k]] += v[k] * __x;
+            }
+        }
+    }, plus<_T>());
+    auto y = Vector<_T>::ZeroInit(acc.size());
+    copy(acc.begin(), acc.end(), y.Begin());
+    return y;
+}
+
+
+template<class _T, SparseLayout _L>
+template<class _R>
+Vector<_T> SparseMatrix<_T, _L>::MatVec(const VectorExpr<_R> &e) const noexcept {
+    if constexpr (!is_same_v<_R, Vector<_T>>) {
+        if (vector_data(e.self()) == nullptr) {
+            return this->MatVec(Vector<_T>(e));
+        }
+    }
+    if (e.self().Size() != this->_col) {
+        return Vector<_T>();
+    }
+    _PROFILE_SCOPE("SparseMatrix::MatVec", 2 * this->_nnz);
+    const _T *x = vector_data(e.self());
+    return _L == SparseLayout::CSR ? this->gather(x) : this->scatter(x);
+}
+
+
+template<class _T, SparseLayout _L>
+template<class _R>
+Vector<_T> SparseMatrix<_T, _L>::MatVecT(const VectorExpr<_R> &e) const noexcept {
+    if constexpr (!is_same_v<_R, Vector<_T>>) {
+        if (vector_data(e.self()) == nullptr) {
+            return this->MatVecT(Vector<_T>(e));
+        }
+    }
+    if (e.self().Size() != this->_row) {
+        return Vector<_T>();
+    }
+    _PROFILE_SCOPE("SparseMatrix::MatVecT", 2 * this->_nnz);
+    const _T *x = vector_data(e.self());
+    return _L == SparseLayout::CSR ? this->scatter(x) : this->gather(x);
+}
+
+
+// row i of the result is the sum of A(i, k) times row k of y, rows are split by nonzeros; a CSC matrix
+// is converted first and y is evaluated unless it is a Matrix2D
+template<class _T, SparseLayout _L>
+template<class _E>
+Matrix2D<_T> SparseMatrix<_T, _L>::operator * (const Matrix2DExpr<_E> &e) const noexcept {
+    if constexpr (_L == SparseLayout::CSC) {
+        return this->ToCSR() * e;
+    } else if constexpr (!is_same_v<_E, Matrix2D<_T>>) {
+        return *this * Matrix2D<_T>(e);
+    } else {
+        const Matrix2D<_T> &y = e.self();
+        if (y.Row() != this->_col) {
+            return Matrix2D<_T>();
+        }
+        _PROFILE_SCOPE("SparseMatrix::operator*", 2.0 * this->_nnz * y.Col());
+        size_type __n = y.Col();
+        auto m = Matrix2D<_T>::ZeroInit(this->_row, __n);
+        const _T *v = this->_values;
+        const index_type *idx = this->_index;
+        const size_type *o = this->_offsets;
+        _T *ref_m = m.Begin();
+        size_type __s = m.Stride();
+
+        this->sweep_major(__n, [v, idx, o, &y, ref_m, __s, __n](size_type lo, size_type hi) {
+            for (size_type i = lo; i < hi; i++) {
+                _T *row = ref_m + i * __s;
+                for (size_type k = o[i]; k < o[i + 1]; k++) {
+                    _T a = v[k];
+                    const _T *b = y.RowBegin(idx[k]);
+                    simd_for(0, __n, [=](size_type j) { row[j] += a * b[j]; });
+                }
+            }
+        });
+        return m;
+    }
+}
+
+
+// Statistics ----------------------------------------------------------------
+// elements the result summarises per entry: every element for ALL, a column for COL, a row for ROW
+template<class _T, SparseLayout _L>
+typename SparseMatrix<_T, _L>::size_type SparseMatrix<_T, _L>::length_along(Axis2D axis) const noexcept {
+    switch (axis) {
+        case Axis2D::ALL : return this->_row * this->_col;
+        case Axis2D::COL : return this->_row;
+        default : return this->_col;
+    }
+}
+
+
+// merge(acc, f(v, j)) over the stored entries, j the index of the result the entry belongs to: one
+// result for ALL, one per column for COL, one per row for ROW. Along the major dimension every line
+// is reduced on its own, along the minor one through the panels of sweep_minor
+template<class _T, SparseLayout _L>
+template<class _F, class _M>
+vector<double> SparseMatrix<_T, _L>::reduce_along(Axis2D axis, double init, _F f, _M merge) const noexcept {
+    const _T *v = this->_values;
+    const index_type *idx = this->_index;
+    const size_type *o = this->_offsets;
+    bool __major = (axis == Axis2D::ROW) == (_L == SparseLayout::CSR);
+
+    if (axis == Axis2D::ALL) {
+        double r = ThreadPool::Global().ParallelReduce(0, this->_nnz, 1, init, [v, init, &f, &merge](size_type lo, size_type hi) {
+            double acc = init;
+            for (size_type k = lo; k < hi; k++) {
+                acc = merge(acc, f(v[k], size_type(0)));
+            }
+            return acc;
+        }, merge);
+        return vector<double>(1, r);
+    }
+    if (__major) {
+        vector<double> out(this->Major(), init);
+        double *ref_o = out.data();
+        this->sweep_major(1, [v, o, init, ref_o, &f, &merge](size_type lo, size_type hi) {
+            for (size_type i = lo; i < hi; i++) {
+                double acc = init;
+                for (size_type k = o[i]; k < o[i + 1]; k++) {
+                    acc = merge(acc, f(v[k], i));
+                }
+                ref_o[i] = acc;
+            }
+        });
+        return out;
+    }
+    return this->sweep_minor(init, [v, idx, o, &f, &merge](size_type lo, size_type hi, double *acc) {
+        for (size_type i = lo; i < hi; i++) {
+            for (size_type k = o[i]; k < o[i + 1]; k++) {
+                acc[idx[k]] = merge(acc[idx[k]], f(v[k], size_type(idx[k])));
+            }
+        }
+    }, merge);
+}
+
+
+template<class _T, SparseLayout _L>
+Vector<_T> SparseMatrix<_T, _L>::Mean(Axis2D axis) const noexcept {
+    _PROFILE_SCOPE("SparseMatrix::Mean", this->_nnz);
+    double __l = double(this->length_along(axis));
+    auto sum = this->reduce_along(axis, 0.0, [](_T v, size_type) { return double(v); }, plus<double>());
+    auto vec = Vector<_T>::ZeroInit(sum.size());
+
+    for (size_type j = 0; j < sum.size(); j++) {
+        vec[j] = __l > 0 ? _T(sum[j] / __l) : _T(0);
+    }
+    return vec;
+}
+
+
+// two passes, the zeros that are not stored add (count of zeros) * mean^2 to the squared deviations
+template<class _T, SparseLayout _L>
+Vector<_T> SparseMatrix<_T, _L>::STD(Axis2D axis) const noexcept {
+    _PROFILE_SCOPE("SparseMatrix::STD", 4 * this->_nnz);
+    double __l = double(this->length_along(axis));
+    auto sum = this->reduce_along(axis, 0.0, [](_T v, size_type) { return double(v); }, plus<double>());
+    auto count = this->reduce_along(axis, 0.0, [](_T, size_type) { return 1.0; }, plus<double>());
+    for (auto &s : sum) {
+        s = __l > 0 ? s / __l : 0.0;
+    }
+    const double *mean = sum.data();
+    auto m2 = this->reduce_along(axis, 0.0, [mean](_T v, size_type j) {
+        double d = double(v) - mean[j];
+        return d * d;
+    }, plus<double>());
+    auto vec = Vector<_T>::ZeroInit(sum.size());
+
+    for (size_type j = 0; j < sum.size(); j++) {
+        double __zeros = __l - count[j];
+        vec[j] = __l > 0 ? _T(sqrt((m2[j] + __zeros * mean[j] * mean[j]) / __l)) : _T(0);
+    }
+    return vec;
+}
+
+
+template<class _T, SparseLayout _L>
+Vector<_T> SparseMatrix<_T, _L>::Min(Axis2D axis) const noexcept {
+    _PROFILE_SCOPE("SparseMatrix::Min", 0);
+    double __l = double(this->length_along(axis));
+    auto best = this->reduce_along(axis, numeric_limits<double>::infinity(), [](_T v, size_type) { return double(v); },
+                                   [](double a, double b) { return b < a ? b : a; });
+    auto count = this->reduce_along(axis, 0.0, [](_T, size_type) { return 1.0; }, plus<double>());
+    auto vec = Vector<_T>::ZeroInit(best.size());
+
+    for (size_type j = 0; j < best.size(); j++) {
+        vec[j] = count[j] < __l ? _T(min(best[j], 0.0)) : _T(best[j]);
+    }
+    return vec;
+}
+
+
+template<class _T, SparseLayout _L>
+Vector<_T> SparseMatrix<_T, _L>::Max(Axis2D axis) const noexcept {
+    _PROFILE_SCOPE("SparseMatrix::Max", 0);
+    double __l = double(this->length_along(axis));
+    auto best = this->reduce_along(axis, -numeric_limits<double>::infinity(), [](_T v, size_type) { return double(v); },
+                                   [](double a, double b) { return b > a ? b : a; });
+    auto count = this->reduce_along(axis, 0.0, [](_T, size_type) { return 1.0; }, plus<double>());
+    auto vec = Vector<_T>::ZeroInit(best.size());
+
+    for (size_type j = 0; j < best.size(); j++) {
+        vec[j] = count[j] < __l ? _T(max(best[j], 0.0)) : _T(best[j]);
+    }
+    return vec;
+}
+
+#endif // !_SPARSE_H_
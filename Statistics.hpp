@@ -0,0 +1,195 @@
+#ifndef _STATISTICS_H_
+#define _STATISTICS_H_
+
+#include <iostream>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+// number of elements summarised with an exact two-pass inside L1 before being merged
+constexpr size_t STATISTICS_BLOCK = 256;
+
+// count, mean, variance, min, max, argmin and argmax of a sequence, gathered in one sweep.
+// Variance is carried as M2 = sum((x - mean)^2) and updated with Welford's recurrence; two summaries
+// of disjoint ranges merge exactly (Chan et al.), so a range can be cut into chunks, summarised in
+// parallel and merged. Indices are absolute, ties keep the first index.
+template<class _T>
+class Description {
+    public:
+        typedef size_t size_type;
+        typedef conditional_t<is_floating_point_v<_T>, _T, double> stat_type;
+
+    private:
+        size_type count = 0;
+        stat_type mean = 0;
+        stat_type m2 = 0;
+        _T min = _T(0);
+        _T max = _T(0);
+        size_type argmin = 0;
+        size_type argmax = 0;
+
+    public:
+        constexpr Description() noexcept = default;
+        constexpr Description(size_type, stat_type, stat_type, _T, _T, size_type, size_type) noexcept;
+
+        constexpr size_type Count() const noexcept { return this->count; }
+        constexpr stat_type Mean() const noexcept { return this->mean; }
+        constexpr stat_type Variance() const noexcept { return this->count ? this->m2 / this->count : stat_type(0); }
+        constexpr auto STD() const noexcept { return sqrt(this->Variance()); }
+        constexpr _T Min() const noexcept { return this->min; }
+        constexpr _T Max() const noexcept { return this->max; }
+        constexpr size_type Argmin() const noexcept { return this->argmin; }
+        constexpr size_type Argmax() const noexcept { return this->argmax; }
+
+        constexpr void Push(_T, size_type) noexcept;
+        constexpr Description<_T>& Merge(const Description<_T>&) noexcept;
+
+        friend auto& operator << (ostream &str, const Description<_T> &d) noexcept {
+            str<<"count "<<d.Count()<<", mean "<<d.Mean()<<", std "<<d.STD()
+               <<", min "<<d.Min()<<" @"<<d.Argmin()<<", max "<<d.Max()<<" @"<<d.Argmax();
+            return str;
+        }
+};
+
+
+template<class _T>
+constexpr Description<_T>::Description(size_type __n, stat_type __mean, stat_type __m2, _T __min, _T __max, size_type __argmin, size_type __argmax) noexcept {
+    this->count = __n;
+    this->mean = __mean;
+    this->m2 = __m2;
+    this->min = __min;
+    this->max = __max;
+    this->argmin = __argmin;
+    this->argmax = __argmax;
+}
+
+
+template<class _T>
+constexpr void Description<_T>::Push(_T value, size_type indx) noexcept {
+    if (this->count == 0 || value < this->min) {
+        this->min = value;
+        this->argmin = indx;
+    }
+    if (this->count == 0 || value > this->max) {
+        this->max = value;
+        this->argmax = indx;
+    }
+    this->count++;
+    stat_type delta = value - this->mean;
+    this->mean += delta / this->count;
+    this->m2 += delta * (value - this->mean);
+}
+
+
+template<class _T>
+constexpr Description<_T>& Description<_T>::Merge(const Description<_T> &y) noexcept {
+    if (y.count == 0) {
+        return *this;
+    }
+    if (this->count == 0) {
+        return *this = y;
+    }
+    size_type __n = this->count + y.count;
+    stat_type delta = y.mean - this->mean;
+
+    this->mean += delta * y.count / __n;
+    this->m2 += y.m2 + delta * delta * (stat_type(this->count) * y.count / __n);
+    this->count = __n;
+
+    if (y.min < this->min || (y.min == this->min && y.argmin < this->argmin)) {
+        this->min = y.min;
+        this->argmin = y.argmin;
+    }
+    if (y.max > this->max || (y.max == this->max && y.argmax < this->argmax)) {
+        this->max = y.max;
+        this->argmax = y.argmax;
+    }
+    return *this;
+}
+
+
+// get(k) for k in [lo, hi): every L1 sized block is summarised with an exact two-pass, then merged
+template<class _T, class _Get>
+Description<_T> describe_range(size_t __lo, size_t __hi, _Get &&get) noexcept {
+    typedef typename Description<_T>::stat_type stat_type;
+    Description<_T> d;
+
+    for (size_t b = __lo; b < __hi; b += STATISTICS_BLOCK) {
+        size_t e = min(b + STATISTICS_BLOCK, __hi);
+        stat_type sum = 0;
+        _T min = get(b), max = get(b);
+        size_t argmin = b, argmax = b;
+
+        for (size_t k = b; k < e; k++) {
+            _T v = get(k);
+            sum += v;
+            if (v < min) {
+                min = v;
+                argmin = k;
+            }
+            if (v > max) {
+                max = v;
+                argmax = k;
+            }
+        }
+        stat_type mean = sum / (e - b);
+        stat_type m2 = 0;
+        for (size_t k = b; k < e; k++) {
+            stat_type dv = get(k) - mean;
+            m2 += dv * dv;
+        }
+        d.Merge(Description<_T>(e - b, mean, m2, min, max, argmin, argmax));
+    }
+    return d;
+}
+
+
+// one Description per column of rows [lo, hi); x(i, j) is read row by row, every row updates all the
+// column accumulators with the same 1 / n so the inner loop runs over contiguous columns
+template<class _T, class _E>
+vector<Description<_T>> describe_columns(const _E &x, size_t __lo, size_t __hi) noexcept {
+    typedef typename Description<_T>::stat_type stat_type;
+    size_t __c = x.Col();
+    vector<stat_type> mean(__c, stat_type(0)), m2(__c, stat_type(0));
+    vector<_T> min(__c), max(__c);
+    vector<size_t> argmin(__c, __lo), argmax(__c, __lo);
+
+    for (size_t j = 0; j < __c; j++) {
+        min[j] = max[j] = x(__lo, j);
+    }
+    for (size_t i = __lo; i < __hi; i++) {
+        stat_type inv = stat_type(1) / stat_type(i - __lo + 1);
+        for (size_t j = 0; j < __c; j++) {
+            stat_type v = x(i, j);
+            stat_type delta = v - mean[j];
+            mean[j] += delta * inv;
+            m2[j] += delta * (v - mean[j]);
+        }
+        for (size_t j = 0; j < __c; j++) {
+            _T v = x(i, j);
+            if (v < min[j]) {
+                min[j] = v;
+                argmin[j] = i;
+            }
+            if (v > max[j]) {
+                max[j] = v;
+                argmax[j] = i;
+            }
+        }
+    }
+
+    vector<Description<_T>> d;
+    d.reserve(__c);
+    for (size_t j = 0; j < __c; j++) {
+        d.emplace_back(__hi - __lo, mean[j], m2[j], min[j], max[j], argmin[j], argmax[j]);
+    }
+    return d;
+}
+
+#endif // !_STATISTICS_H_
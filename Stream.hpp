@@ -0,0 +1,466 @@
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <utility>
+#include <algorithm>
+
+#include "Memory.hpp"
+#include "Profile.hpp"
+#include "ThreadPool.hpp"
+#include "Statistics.hpp"
+#include "Serialize.hpp"
+#include "View.hpp"
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+
+using namespace std;
+
+// Matrices too large for memory, read as consecutive blocks of rows:
+//   a RowSource hands out rows from a generator or from a file written by Matrix2D::Save (the
+//   checksum is verified once the last row is read), a RowSink writes rows to a file that
+//   Matrix2D::Load / Map read back. stream_chunks reads the next block on its own thread while the
+//   current one is processed, so at most two blocks of about STREAM_CHUNK_BYTES are resident.
+//   stream_column_stats gathers Mean / STD / Min / Max of every column in one pass, stream_transform
+//   writes f(block) for every block (a Matrix2D expression, so anything element-wise or broadcasting
+//   a Vector), writing block k while block k + 1 is computed.
+// Blocks hold a multiple of the rows ThreadPool::Grain gives the in-memory column sweeps, which see
+// the same row ranges and fold them in the same order: the statistics equal calc_*_for_each_col of
+// the whole matrix bit for bit, whatever the block size and thread count.
+
+constexpr size_t STREAM_CHUNK_BYTES = size_t(1) << 26;
+
+
+// Sources ----------------------------------------------------------------
+template<class _T>
+class RowSource {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        // writes up to n rows of Col() packed elements at dst and returns how many, 0 at the end
+        typedef function<size_type(_T*, size_type)> reader_type;
+
+    private:
+        size_type _col = 0;
+        size_type _rows = 0;
+        reader_type _reader;
+        bool _ok = false;
+
+        // file sources: the data bytes go through _stage one SERIAL_CHUNK at a time, so they are
+        // hashed in the chunks of the checksum; _pos is the data offset of _stage[_used]
+        ifstream _file;
+        SerialHeader _header;
+        vector<char> _stage;
+        size_type _pos = 0;
+        size_type _used = 0;
+        vector<uint64_t> _chunks;
+
+        size_type read_file(_T*, size_type) noexcept;
+
+    public:
+        RowSource() noexcept = default;
+        RowSource(size_type __col, reader_type __reader) noexcept : _col(__col), _reader(move(__reader)), _ok(__col > 0) {}
+        // a Matrix2D file, not Ok() when it cannot be read or does not hold a matrix of _T
+        explicit RowSource(const string&) noexcept;
+        RowSource(RowSource<_T>&&) noexcept = default;
+        RowSource<_T>& operator = (RowSource<_T>&&) noexcept = default;
+
+        constexpr size_type Col() const noexcept { return this->_col; }
+        // rows read so far
+        constexpr size_type Rows() const noexcept { return this->_rows; }
+        // false once a read failed or the checksum of a file did not match
+        constexpr bool Ok() const noexcept { return this->_ok; }
+
+        // up to n rows, fewer only at the end of the source
+        size_type Read(_T*, size_type) noexcept;
+};
+
+
+template<class _T>
+RowSource<_T>::RowSource(const string &__path) noexcept : _file(__path, ios::binary) {
+    if (!this->_file.read(reinterpret_cast<char*>(&this->_header), sizeof(SerialHeader)) || !serial_valid<_T>(this->_header, 2) ||
+        !this->_file.ignore(streamsize(this->_header.offset - sizeof(SerialHeader)))) {
+        return;
+    }
+    this->_col = size_type(this->_header.col);
+    this->_ok = true;
+}
+
+
+template<class _T>
+typename RowSource<_T>::size_type RowSource<_T>::Read(_T *dst, size_type __n) noexcept {
+    size_type __got = 0;
+    if (!this->_ok) {
+        return 0;
+    }
+    if (!this->_reader) {
+        __got = this->read_file(dst, __n);
+    } else {
+        for (size_type k; __got < __n && (k = this->_reader(dst + __got * this->_col, __n - __got)) > 0;) {
+            __got += k;
+        }
+    }
+    this->_rows += __got;
+    return __got;
+}
+
+
+// rows [_pos / stride, + n) of the file, the padding of each row dropped
+template<class _T>
+typename RowSource<_T>::size_type RowSource<_T>::read_file(_T *dst, size_type __n) noexcept {
+    size_type __bytes = serial_data_bytes(this->_header), __row = this->_col * sizeof(_T);
+    size_type __stride = size_type(this->_header.stride) * sizeof(_T);
+    size_type __first = this->_pos / __stride;
+    size_type __end = min(__bytes, (__first + __n) * __stride);
+    char *out = reinterpret_cast<char*>(dst);
+
+    while (this->_pos < __end) {
+        if (this->_used == this->_stage.size()) {
+            size_type __k = min(SERIAL_CHUNK, __bytes - this->_pos);
+            this->_stage.resize(__k);
+            if (!this->_file.read(this->_stage.data(), streamsize(__k))) {
+                this->_ok = false;
+                return 0;
+            }
+            this->_chunks.push_back(serial_hash(this->_stage.data(), __k, this->_chunks.size()));
+            this->_used = 0;
+        }
+        size_type __in_row = this->_pos % __stride;
+        size_type __take = min({this->_stage.size() - this->_used, __stride - __in_row, __end - this->_pos});
+        if (__in_row < __row) {
+            memcpy(out + (this->_pos / __stride - __first) * __row + __in_row, this->_stage.data() + this->_used, min(__take, __row - __in_row));
+        }
+        this->_pos += __take;
+        this->_used += __take;
+    }
+    if (this->_pos == __bytes && serial_combine(this->_chunks, __bytes) != this->_header.checksum) {
+        this->_ok = false;
+        return 0;
+    }
+    return this->_pos / __stride - __first;
+}
+
+
+// Sinks ----------------------------------------------------------------
+// a Matrix2D file written row block by row block; the header, which holds the row count and the
+// checksum, is written last by Close
+template<class _T>
+class RowSink {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+
+    private:
+        ofstream _file;
+        size_type _col = 0;
+        size_type _rows = 0;
+        vector<char> _stage;
+        vector<uint64_t> _chunks;
+        bool _ok = false;
+
+        void flush_stage() noexcept;
+
+    public:
+        RowSink() noexcept = default;
+        RowSink(const string&, size_type __col) noexcept;
+        RowSink(RowSink<_T>&&) noexcept = default;
+        RowSink<_T>& operator = (RowSink<_T>&&) noexcept = default;
+        ~RowSink() noexcept { this->Close(); }
+
+        constexpr size_type Col() const noexcept { return this->_col; }
+        constexpr size_type Rows() const noexcept { return this->_rows; }
+        constexpr bool Ok() const noexcept { return this->_ok; }
+
+        // n rows of Col() elements, rows stride elements apart; false once anything failed
+        bool Write(const _T*, size_type __n, size_type __stride) noexcept;
+        template<class _E> bool Write(const Matrix2DExpr<_E>&) noexcept;
+        // writes the header, false when the file is incomplete; later writes fail
+        bool Close() noexcept;
+};
+
+
+template<class _T>
+RowSink<_T>::RowSink(const string &__path, size_type __col) noexcept : _file(__path, ios::binary | ios::trunc), _col(__col) {
+    char pad[SERIAL_DATA_OFFSET] = {};
+    this->_ok = bool(this->_file.write(pad, sizeof(pad)));
+    this->_stage.reserve(SERIAL_CHUNK);
+}
+
+
+template<class _T>
+void RowSink<_T>::flush_stage() noexcept {
+    this->_chunks.push_back(serial_hash(this->_stage.data(), this->_stage.size(), this->_chunks.size()));
+    this->_ok = this->_ok && this->_file.write(this->_stage.data(), streamsize(this->_stage.size()));
+    this->_stage.clear();
+}
+
+
+template<class _T>
+bool RowSink<_T>::Write(const _T *src, size_type __n, size_type __stride) noexcept {
+    _PROFILE_SCOPE("RowSink::Write", 0);
+    size_type __row = this->_col * sizeof(_T);
+    if (!this->_file.is_open()) {
+        return false;
+    }
+    for (size_type i = 0; i < __n && this->_ok; i++) {
+        const char *p = reinterpret_cast<const char*>(src + i * __stride);
+        for (size_type k = 0; k < __row;) {
+            size_type __take = min(__row - k, SERIAL_CHUNK - this->_stage.size());
+            this->_stage.insert(this->_stage.end(), p + k, p + k + __take);
+            k += __take;
+            if (this->_stage.size() == SERIAL_CHUNK) {
+                this->flush_stage();
+            }
+        }
+    }
+    this->_rows += this->_ok ? __n : 0;
+    return this->_ok;
+}
+
+
+template<class _T>
+template<class _E>
+bool RowSink<_T>::Write(const Matrix2DExpr<_E> &e) noexcept {
+    const _E &x = e.self();
+    if (x.Col() != this->_col) {
+        return this->_ok = false;
+    }
+    if constexpr (is_same_v<_E, Matrix2D<_T>>) {
+        return this->Write(x.Begin(), x.Row(), x.Stride());
+    } else {
+        Matrix2D<_T> m(x);
+        return this->Write(m.Begin(), m.Row(), m.Stride());
+    }
+}
+
+
+template<class _T>
+bool RowSink<_T>::Close() noexcept {
+    if (!this->_file.is_open()) {
+        return this->_ok;
+    }
+    if (!this->_stage.empty()) {
+        this->flush_stage();
+    }
+    SerialHeader h = serial_header<_T>(2, this->_rows, this->_col, this->_col);
+    h.checksum = serial_combine(this->_chunks, serial_data_bytes(h));
+    this->_ok = this->_ok && this->_file.seekp(0) && this->_file.write(reinterpret_cast<const char*>(&h), sizeof(h)) && this->_file.flush();
+    this->_file.close();
+    return this->_ok;
+}
+
+
+// Chunks ----------------------------------------------------------------
+// rows [first, first + n) of the stream in a packed buffer, read as x(i, j) with the absolute row
+template<class _T>
+struct StreamRows {
+    typedef _T value_type;
+
+    const _T *data;
+    size_t first;
+    size_t col;
+
+    constexpr size_t Col() const noexcept { return this->col; }
+    constexpr _T operator () (size_t i, size_t j) const noexcept { return this->data[(i - this->first) * this->col + j]; }
+};
+
+
+// rows per block: about __bytes, a multiple of the grain of a column sweep over Col() columns
+inline size_t stream_block_rows(size_t __col, size_t __size, size_t __bytes) noexcept {
+    size_t __grain = ThreadPool::Global().Grain(__col);
+    size_t __rows = max<size_t>(1, __bytes / max<size_t>(1, __col * __size));
+    return (__rows + __grain - 1) / __grain * __grain;
+}
+
+
+// f(block, first) for consecutive blocks of rows, block a Matrix2DView of rows [first, first +
+// block.Row()); the next block is read meanwhile. Returns the number of rows
+template<class _T, class _F>
+size_t stream_chunks(RowSource<_T> &source, size_t __rows, _F &&f) noexcept {
+    size_t __c = source.Col(), __first = 0;
+    if (__c == 0 || __rows == 0) {
+        return 0;
+    }
+    _T *buffer[2] = {aligned_new<_T>(__rows * __c), aligned_new<_T>(__rows * __c)};
+    size_t __n = source.Read(buffer[0], __rows);
+
+    for (size_t __cur = 0; __n > 0; __cur ^= 1) {
+        future<size_t> next;
+        if (__n == __rows) {
+            next = async(launch::async, [&source, b = buffer[__cur ^ 1], __rows]() { return source.Read(b, __rows); });
+        }
+        f(Matrix2DView<_T>(buffer[__cur], __n, __c, __c, 1), __first);
+        __first += __n;
+        __n = next.valid() ? next.get() : 0;
+    }
+    aligned_delete(buffer[0]);
+    aligned_delete(buffer[1]);
+    return __first;
+}
+
+
+// Statistics ----------------------------------------------------------------
+template<class _T>
+class StreamStats;
+
+template<class _T>
+StreamStats<_T> stream_column_stats(RowSource<_T>&, size_t __bytes = STREAM_CHUNK_BYTES) noexcept;
+
+
+template<class _T>
+class StreamStats {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+
+    private:
+        size_type _rows = 0;
+        vector<_T> _sum;
+        vector<_T> _min;
+        vector<_T> _max;
+        vector<Description<_T>> _describe;
+
+        template<class _U> friend StreamStats<_U> stream_column_stats(RowSource<_U>&, size_t) noexcept;
+
+    public:
+        constexpr size_type Rows() const noexcept { return this->_rows; }
+        // as Matrix2D::Mean / STD / Min / Max with Axis2D::COL, empty when no row was read
+        Vector<_T> Mean() const noexcept;
+        Vector<_T> STD() const noexcept;
+        Vector<_T> Min() const noexcept { return this->_rows ? Vector<_T>(this->_min.data(), this->_min.size()) : Vector<_T>(); }
+        Vector<_T> Max() const noexcept { return this->_rows ? Vector<_T>(this->_max.data(), this->_max.size()) : Vector<_T>(); }
+        // as Matrix2D::Describe(Axis2D::COL), argmin and argmax are absolute rows
+        const vector<Description<_T>>& Describe() const noexcept { return this->_describe; }
+};
+
+
+template<class _T>
+Vector<_T> StreamStats<_T>::Mean() const noexcept {
+    if (this->_rows == 0) {
+        return Vector<_T>();
+    }
+    Vector<_T> vec(this->_sum.data(), this->_sum.size());
+    _T __r = _T(this->_rows);
+    for (size_type j = 0; j < vec.Size(); j++) {
+        vec[j] /= __r;
+    }
+    return vec;
+}
+
+
+template<class _T>
+Vector<_T> StreamStats<_T>::STD() const noexcept {
+    if (this->_rows == 0) {
+        return Vector<_T>();
+    }
+    auto vec = Vector<_T>::ZeroInit(this->_describe.size());
+    for (size_type j = 0; j < vec.Size(); j++) {
+        vec[j] = this->_describe[j].STD();
+    }
+    return vec;
+}
+
+
+// one pass over the source; every grain of rows is summarised on the pool like the in-memory column
+// sweeps do and folded into the totals in row order. Empty statistics when the source failed
+template<class _T>
+StreamStats<_T> stream_column_stats(RowSource<_T> &source, size_t __bytes) noexcept {
+    _PROFILE_SCOPE("stream_column_stats", 0);
+    size_t __c = source.Col(), __grain = ThreadPool::Global().Grain(__c);
+    StreamStats<_T> s;
+    s._describe.assign(__c, Description<_T>());
+
+    struct Part {
+        vector<_T> sum, min, max;
+        vector<Description<_T>> describe;
+    };
+    vector<Part> parts;
+    auto fold = [__c](vector<_T> &acc, const vector<_T> &part, auto update) {
+        if (acc.empty()) {
+            acc = part;
+            return;
+        }
+        for (size_t j = 0; j < __c; j++) {
+            update(acc[j], part[j]);
+        }
+    };
+    auto add = [](_T &acc, _T v) { acc += v; };
+    auto lower = [](_T &acc, _T v) { acc = v < acc ? v : acc; };
+    auto upper = [](_T &acc, _T v) { acc = v > acc ? v : acc; };
+
+    s._rows = stream_chunks(source, stream_block_rows(__c, sizeof(_T), __bytes), [&](const Matrix2DView<_T> &block, size_t __first) {
+        _PROFILE_SCOPE("stream_column_stats::block", 3 * block.Row() * __c);
+        StreamRows<_T> x{block.Begin(), __first, __c};
+        size_t __n = block.Row(), __parts = (__n + __grain - 1) / __grain;
+        parts.resize(__parts);
+
+        ThreadPool::Global().ParallelFor(0, __parts, __grain * __c, [&](size_t lo, size_t hi) {
+            for (size_t p = lo; p < hi; p++) {
+                size_t __lo = __first + p * __grain, __hi = __first + min(__n, (p + 1) * __grain);
+                Part &part = parts[p];
+                part.sum.resize(__c);
+                part.min.resize(__c);
+                part.max.resize(__c);
+                for (size_t j = 0; j < __c; j++) {
+                    part.sum[j] = part.min[j] = part.max[j] = x(__lo, j);
+                }
+                for (size_t i = __lo + 1; i < __hi; i++) {
+                    for (size_t j = 0; j < __c; j++) {
+                        _T v = x(i, j);
+                        part.sum[j] += v;
+                        part.min[j] = v < part.min[j] ? v : part.min[j];
+                        part.max[j] = v > part.max[j] ? v : part.max[j];
+                    }
+                }
+                part.describe = describe_columns<_T>(x, __lo, __hi);
+            }
+        });
+        for (size_t p = 0; p < __parts; p++) {
+            fold(s._sum, parts[p].sum, add);
+            fold(s._min, parts[p].min, lower);
+            fold(s._max, parts[p].max, upper);
+            for (size_t j = 0; j < __c; j++) {
+                s._describe[j].Merge(parts[p].describe[j]);
+            }
+        }
+    });
+    if (!source.Ok()) {
+        return StreamStats<_T>();
+    }
+    return s;
+}
+
+
+// Transforms ----------------------------------------------------------------
+// sink.Write(f(block)) for every block, f taking a Matrix2DView<_T> and giving a Matrix2D expression
+// with sink.Col() columns; block k is written while block k + 1 is read and computed. False when the
+// source, the sink or a shape failed; the sink is left open
+template<class _T, class _F>
+bool stream_transform(RowSource<_T> &source, RowSink<_T> &sink, _F f, size_t __bytes = STREAM_CHUNK_BYTES) noexcept {
+    _PROFILE_SCOPE("stream_transform", 0);
+    future<bool> pending;
+    Matrix2D<_T> out[2];
+    size_t __k = 0;
+
+    stream_chunks(source, stream_block_rows(source.Col(), sizeof(_T), __bytes), [&](const Matrix2DView<_T> &block, size_t) {
+        Matrix2D<_T> &m = out[__k++ & 1];
+        m = f(block);
+        if (pending.valid()) {
+            pending.get();
+        }
+        pending = async(launch::async, [&sink, &m]() { return sink.Write(m); });
+    });
+    if (pending.valid()) {
+        pending.get();
+    }
+    return source.Ok() && sink.Ok();
+}
+
+#endif // !_STREAM_H_
@@ -0,0 +1,1049 @@
+#ifndef _TENSOR_H_
+#define _TENSOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include "Memory.hpp"
+#include "Profile.hpp"
+#include "ThreadPool.hpp"
+#include "Simd.hpp"
+#include "Random.hpp"
+#include "View.hpp"
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+
+using namespace std;
+
+// N-dimensional arrays of up to TENSOR_MAX_RANK axes:
+//   a TensorView reads a buffer through a shape and one stride per axis, like VectorView and
+//   Matrix2DView; reshapes, permutations, slices and broadcasts are views of the same buffer, a
+//   broadcast axis has stride 0. A Tensor owns a contiguous row-major buffer and is its own view.
+//   Vector and Matrix2D are read as rank 1 and rank 2 views in place, and views of rank 1 and 2 hand
+//   out a VectorView / Matrix2DView, so everything of Vector and Matrix2D applies to them.
+//   Element-wise operators broadcast like NumPy: shapes are aligned on the right and an axis of
+//   size 1 (or a missing one) stretches to the other. Reductions take any set of axes, Axis2D is the
+//   rank 2 case (COL is {0}, ROW is {1}, ALL every axis).
+// Loops drop the axes of size 1 and merge neighbour axes every operand walks as one run, then split
+// the outermost axis over the pool; the innermost run is a simd_for or a Simd.hpp reduction. A
+// contiguous tensor of any rank is one loop. Reductions whose outermost axis is reduced use at most
+// TENSOR_PANELS panels with their own accumulators, added in order, so results do not depend on
+// the thread count.
+
+constexpr size_t TENSOR_MAX_RANK = 8;
+constexpr size_t TENSOR_PANELS = 64;
+constexpr size_t TENSOR_PANEL_ELEMENTS = size_t(1) << 15;
+
+typedef vector<size_t> TensorShape;
+
+template<class _T>
+class Tensor;
+
+
+// Loops ----------------------------------------------------------------
+// a loop nest over a shape walking _N operands, each with its own strides
+template<size_t _N>
+struct TensorLoop {
+    size_t rank = 0;
+    size_t shape[TENSOR_MAX_RANK] = {};
+    size_t stride[_N][TENSOR_MAX_RANK] = {};
+
+    void collapse() noexcept;
+    // elements under one index of the outermost axis
+    size_t cost() const noexcept;
+    template<class _F> void run(size_t, size_t, _F&&) const noexcept;
+    template<class _F> void parallel_run(_F&&) const noexcept;
+};
+
+
+// axes of size 1 go, an axis merges into the next one when every operand has stride = next stride *
+// next extent on it; the result has at least one axis
+template<size_t _N>
+void TensorLoop<_N>::collapse() noexcept {
+    size_t __r = 0;
+    for (size_t d = 0; d < this->rank; d++) {
+        if (this->shape[d] == 1) {
+            continue;
+        }
+        bool __merge = __r > 0;
+        for (size_t k = 0; k < _N && __merge; k++) {
+            __merge = this->stride[k][__r - 1] == this->stride[k][d] * this->shape[d];
+        }
+        if (__merge) {
+            this->shape[__r - 1] *= this->shape[d];
+            for (size_t k = 0; k < _N; k++) {
+                this->stride[k][__r - 1] = this->stride[k][d];
+            }
+            continue;
+        }
+        this->shape[__r] = this->shape[d];
+        for (size_t k = 0; k < _N; k++) {
+            this->stride[k][__r] = this->stride[k][d];
+        }
+        __r++;
+    }
+    if (__r == 0) {
+        this->shape[0] = 1;
+        for (size_t k = 0; k < _N; k++) {
+            this->stride[k][0] = 0;
+        }
+        __r = 1;
+    }
+    this->rank = __r;
+}
+
+
+template<size_t _N>
+size_t TensorLoop<_N>::cost() const noexcept {
+    size_t __c = 1;
+    for (size_t d = 1; d < this->rank; d++) {
+        __c *= this->shape[d];
+    }
+    return __c;
+}
+
+
+// f(offsets, n, steps) for every innermost run under the outermost indices [lo, hi): offsets[k] is the
+// first element of operand k, steps[k] its stride along the run. With one axis the run is [lo, hi)
+template<size_t _N>
+template<class _F>
+void TensorLoop<_N>::run(size_t __lo, size_t __hi, _F &&f) const noexcept {
+    size_t __last = this->rank - 1;
+    size_t off[_N], step[_N];
+
+    for (size_t k = 0; k < _N; k++) {
+        off[k] = __lo * this->stride[k][0];
+        step[k] = this->stride[k][__last];
+    }
+    if (__last == 0) {
+        f(off, __hi - __lo, step);
+        return;
+    }
+    size_t idx[TENSOR_MAX_RANK] = {};
+    idx[0] = __lo;
+    while (idx[0] < __hi) {
+        f(off, this->shape[__last], step);
+        // odometer over the axes before the innermost one
+        size_t d = __last - 1;
+        for (;;) {
+            idx[d]++;
+            for (size_t k = 0; k < _N; k++) {
+                off[k] += this->stride[k][d];
+            }
+            if (d == 0 || idx[d] < this->shape[d]) {
+                break;
+            }
+            for (size_t k = 0; k < _N; k++) {
+                off[k] -= idx[d] * this->stride[k][d];
+            }
+            idx[d] = 0;
+            d--;
+        }
+    }
+}
+
+
+// the outermost axis split over the pool, operands must not write to shared elements across it
+template<size_t _N>
+template<class _F>
+void TensorLoop<_N>::parallel_run(_F &&f) const noexcept {
+    ThreadPool::Global().ParallelFor(0, this->shape[0], this->cost(), [this, &f](size_t lo, size_t hi) { this->run(lo, hi, f); });
+}
+
+
+// out (contiguous) = f(x, y) element by element, x and y read with the strides of the loop; the
+// common cases of the innermost run (contiguous or broadcast operands) get loops of their own
+template<class _R, class _T, class _F>
+void tensor_map(TensorLoop<3> &loop, _R *out, const _T *x, const _T *y, _F f) noexcept {
+    loop.collapse();
+    loop.parallel_run([out, x, y, &f](const size_t *off, size_t __n, const size_t *step) {
+        _R *o = out + off[0];
+        const _T *a = x + off[1], *b = y + off[2];
+        size_t __sa = step[1], __sb = step[2];
+
+        if (__sa == 1 && __sb == 1) {
+            simd_for(0, __n, [=](size_t j) { o[j] = f(a[j], b[j]); });
+        } else if (__sa == 1 && __sb == 0) {
+            _T __b = *b;
+            simd_for(0, __n, [=](size_t j) { o[j] = f(a[j], __b); });
+        } else if (__sa == 0 && __sb == 1) {
+            _T __a = *a;
+            simd_for(0, __n, [=](size_t j) { o[j] = f(__a, b[j]); });
+        } else {
+            simd_for(0, __n, [=](size_t j) { o[j] = f(a[j * __sa], b[j * __sb]); });
+        }
+    });
+}
+
+
+// TensorView ----------------------------------------------------------------
+template<class _T>
+class TensorView {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        typedef const _T* const_iterator;
+
+    protected:
+        const_iterator _data = nullptr;
+        size_type _rank = 0;
+        size_type _shape[TENSOR_MAX_RANK] = {};
+        size_type _stride[TENSOR_MAX_RANK] = {};
+
+        bool broadcast_strides(size_type, const size_type*, size_type*) const noexcept;
+        uint32_t axes_mask(const TensorShape&) const noexcept;
+        template<class _F, class _M> vector<double> reduce(uint32_t, double, _F, _M) const noexcept;
+        Tensor<_T> reduced(uint32_t, bool, const vector<double>&) const noexcept;
+
+        template<class> friend class TensorView;
+        template<class> friend class Tensor;
+        template<class _Op, class _U> friend Tensor<_U> tensor_binary(const TensorView<_U>&, const TensorView<_U>&) noexcept;
+
+    public:
+        constexpr TensorView() noexcept = default;
+        // an empty view when the rank is above TENSOR_MAX_RANK or shape and strides differ in length
+        TensorView(const_iterator, const TensorShape&, const TensorShape&) noexcept;
+        // contiguous row-major
+        TensorView(const_iterator, const TensorShape&) noexcept;
+        explicit TensorView(const Vector<_T>&) noexcept;
+        explicit TensorView(const VectorView<_T>&) noexcept;
+        explicit TensorView(const Matrix2D<_T>&) noexcept;
+        explicit TensorView(const Matrix2DView<_T>&) noexcept;
+
+        constexpr const_iterator Begin() const noexcept { return this->_data; }
+        constexpr size_type Rank() const noexcept { return this->_rank; }
+        constexpr size_type Shape(size_type __axis) const noexcept { return this->_shape[__axis]; }
+        constexpr size_type Stride(size_type __axis) const noexcept { return this->_stride[__axis]; }
+        TensorShape Shape() const noexcept { return TensorShape(this->_shape, this->_shape + this->_rank); }
+        TensorShape Strides() const noexcept { return TensorShape(this->_stride, this->_stride + this->_rank); }
+        size_type Size() const noexcept;
+        bool Contiguous() const noexcept;
+
+        template<class... _I> _T operator () (_I... __i) const noexcept;
+
+        // views of the same buffer, empty when the arguments do not fit; Reshape needs a contiguous view
+        TensorView<_T> Reshape(const TensorShape&) const noexcept;
+        TensorView<_T> Permute(const TensorShape&) const noexcept;
+        TensorView<_T> T() const noexcept;
+        TensorView<_T> Slice(size_type __axis, size_type __begin, size_type __end, size_type __step = 1) const noexcept;
+        TensorView<_T> Index(size_type __axis, size_type i) const noexcept;
+        TensorView<_T> ExpandDims(size_type __axis) const noexcept;
+        TensorView<_T> BroadcastTo(const TensorShape&) const noexcept;
+        VectorView<_T> AsVector() const noexcept;
+        Matrix2DView<_T> AsMatrix() const noexcept;
+
+        // over a set of axes, every axis when empty; reduced axes are dropped, or kept with size 1 when
+        // __keep. STD is the population deviation. Sums accumulate in double
+        Tensor<_T> Sum(const TensorShape &__axes = {}, bool __keep = false) const noexcept;
+        Tensor<_T> Mean(const TensorShape &__axes = {}, bool __keep = false) const noexcept;
+        Tensor<_T> STD(const TensorShape &__axes = {}, bool __keep = false) const noexcept;
+        Tensor<_T> Min(const TensorShape &__axes = {}, bool __keep = false) const noexcept;
+        Tensor<_T> Max(const TensorShape &__axes = {}, bool __keep = false) const noexcept;
+
+        template<class _F> Tensor<_T> Apply(_F) const noexcept;
+};
+
+
+// the axes of Axis2D on a rank 2 tensor
+inline TensorShape tensor_axes(Axis2D axis) noexcept {
+    switch (axis) {
+        case Axis2D::COL : return {0};
+        case Axis2D::ROW : return {1};
+        default : return {};
+    }
+}
+
+
+template<class _T>
+TensorView<_T>::TensorView(const_iterator __data, const TensorShape &__shape, const TensorShape &__strides) noexcept {
+    if (__shape.size() > TENSOR_MAX_RANK || __shape.size() != __strides.size()) {
+        return;
+    }
+    this->_data = __data;
+    this->_rank = __shape.size();
+    copy(__shape.begin(), __shape.end(), this->_shape);
+    copy(__strides.begin(), __strides.end(), this->_stride);
+}
+
+
+template<class _T>
+TensorView<_T>::TensorView(const_iterator __data, const TensorShape &__shape) noexcept {
+    if (__shape.size() > TENSOR_MAX_RANK) {
+        return;
+    }
+    this->_data = __data;
+    this->_rank = __shape.size();
+    size_type __s = 1;
+    for (size_type d = this->_rank; d-- > 0;) {
+        this->_shape[d] = __shape[d];
+        this->_stride[d] = __s;
+        __s *= __shape[d];
+    }
+}
+
+
+template<class _T>
+TensorView<_T>::TensorView(const Vector<_T> &x) noexcept : TensorView(x.Begin(), {x.Size()}) {}
+
+
+template<class _T>
+TensorView<_T>::TensorView(const VectorView<_T> &x) noexcept : TensorView(x.Begin(), {x.Size()}, {x.Step()}) {}
+
+
+template<class _T>
+TensorView<_T>::TensorView(const Matrix2D<_T> &x) noexcept : TensorView(x.Begin(), {x.Row(), x.Col()}, {x.Stride(), 1}) {}
+
+
+template<class _T>
+TensorView<_T>::TensorView(const Matrix2DView<_T> &x) noexcept
+    : TensorView(x.Begin(), {x.Row(), x.Col()}, {x.RowStride(), x.ColStride()}) {}
+
+
+template<class _T>
+typename TensorView<_T>::size_type TensorView<_T>::Size() const noexcept {
+    if (this->_data == nullptr) {
+        return 0;
+    }
+    size_type __n = 1;
+    for (size_type d = 0; d < this->_rank; d++) {
+        __n *= this->_shape[d];
+    }
+    return __n;
+}
+
+
+template<class _T>
+bool TensorView<_T>::Contiguous() const noexcept {
+    size_type __s = 1;
+    for (size_type d = this->_rank; d-- > 0;) {
+        if (this->_shape[d] != 1 && this->_stride[d] != __s) {
+            return false;
+        }
+        __s *= this->_shape[d];
+    }
+    return true;
+}
+
+
+template<class _T>
+template<class... _I>
+_T TensorView<_T>::operator () (_I... __i) const noexcept {
+    const size_type idx[] = {size_type(__i)..., 0};
+    size_type __off = 0;
+    for (size_type d = 0; d < sizeof...(_I); d++) {
+        __off += idx[d] * this->_stride[d];
+    }
+    return this->_data[__off];
+}
+
+
+// Views ----------------------------------------------------------------
+template<class _T>
+TensorView<_T> TensorView<_T>::Reshape(const TensorShape &__shape) const noexcept {
+    size_type __n = 1;
+    for (size_type s : __shape) {
+        __n *= s;
+    }
+    if (!this->Contiguous() || __n != this->Size()) {
+        return TensorView<_T>();
+    }
+    return TensorView<_T>(this->_data, __shape);
+}
+
+
+// axis d of the result is axis axes[d] of this view
+template<class _T>
+TensorView<_T> TensorView<_T>::Permute(const TensorShape &__axes) const noexcept {
+    if (__axes.size() != this->_rank) {
+        return TensorView<_T>();
+    }
+    TensorView<_T> v = *this;
+    uint32_t __seen = 0;
+    for (size_type d = 0; d < this->_rank; d++) {
+        if (__axes[d] >= this->_rank || (__seen >> __axes[d] & 1)) {
+            return TensorView<_T>();
+        }
+        __seen |= uint32_t(1) << __axes[d];
+        v._shape[d] = this->_shape[__axes[d]];
+        v._stride[d] = this->_stride[__axes[d]];
+    }
+    return v;
+}
+
+
+template<class _T>
+TensorView<_T> TensorView<_T>::T() const noexcept {
+    TensorView<_T> v = *this;
+    reverse(v._shape, v._shape + v._rank);
+    reverse(v._stride, v._stride + v._rank);
+    return v;
+}
+
+
+template<class _T>
+TensorView<_T> TensorView<_T>::Slice(size_type __axis, size_type __begin, size_type __end, size_type __step) const noexcept {
+    if (__axis >= this->_rank || __step == 0) {
+        return TensorView<_T>();
+    }
+    TensorView<_T> v = *this;
+    __end = min(__end, this->_shape[__axis]);
+    __begin = min(__begin, __end);
+    v._data += __begin * this->_stride[__axis];
+    v._shape[__axis] = slice_size(__begin, __end, __step);
+    v._stride[__axis] *= __step;
+    return v;
+}
+
+
+template<class _T>
+TensorView<_T> TensorView<_T>::Index(size_type __axis, size_type i) const noexcept {
+    if (__axis >= this->_rank || i >= this->_shape[__axis]) {
+        return TensorView<_T>();
+    }
+    TensorView<_T> v = *this;
+    v._data += i * this->_stride[__axis];
+    copy(this->_shape + __axis + 1, this->_shape + this->_rank, v._shape + __axis);
+    copy(this->_stride + __axis + 1, this->_stride + this->_rank, v._stride + __axis);
+    v._rank--;
+    return v;
+}
+
+
+template<class _T>
+TensorView<_T> TensorView<_T>::ExpandDims(size_type __axis) const noexcept {
+    if (__axis > this->_rank || this->_rank == TENSOR_MAX_RANK) {
+        return TensorView<_T>();
+    }
+    TensorView<_T> v = *this;
+    copy_backward(this->_shape + __axis, this->_shape + this->_rank, v._shape + this->_rank + 1);
+    copy_backward(this->_stride + __axis, this->_stride + this->_rank, v._stride + this->_rank + 1);
+    v._shape[__axis] = 1;
+    v._stride[__axis] = 0;
+    v._rank++;
+    return v;
+}
+
+
+// strides reading this view as __shape: axes aligned on the right, an axis of size 1 or a missing one
+// repeats with stride 0; false when an axis can not stretch
+template<class _T>
+bool TensorView<_T>::broadcast_strides(size_type __rank, const size_type *__shape, size_type *__strides) const noexcept {
+    if (this->_rank > __rank) {
+        return false;
+    }
+    size_type __lead = __rank - this->_rank;
+    for (size_type d = 0; d < __rank; d++) {
+        if (d < __lead) {
+            __strides[d] = 0;
+        } else if (this->_shape[d - __lead] == __shape[d]) {
+            __strides[d] = this->_stride[d - __lead];
+        } else if (this->_shape[d - __lead] == 1) {
+            __strides[d] = 0;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+template<class _T>
+TensorView<_T> TensorView<_T>::BroadcastTo(const TensorShape &__shape) const noexcept {
+    TensorView<_T> v;
+    if (__shape.size() > TENSOR_MAX_RANK || !this->broadcast_strides(__shape.size(), __shape.data(), v._stride)) {
+        return TensorView<_T>();
+    }
+    v._data = this->_data;
+    v._rank = __shape.size();
+    copy(__shape.begin(), __shape.end(), v._shape);
+    return v;
+}
+
+
+template<class _T>
+VectorView<_T> TensorView<_T>::AsVector() const noexcept {
+    return this->_rank == 1 ? VectorView<_T>(this->_data, this->_shape[0], this->_stride[0]) : VectorView<_T>();
+}
+
+
+template<class _T>
+Matrix2DView<_T> TensorView<_T>::AsMatrix() const noexcept {
+    if (this->_rank != 2) {
+        return Matrix2DView<_T>();
+    }
+    return Matrix2DView<_T>(this->_data, this->_shape[0], this->_shape[1], this->_stride[0], this->_stride[1]);
+}
+
+
+template<class _T>
+template<class _F>
+Tensor<_T> TensorView<_T>::Apply(_F f) const noexcept {
+    _PROFILE_SCOPE("TensorView::Apply", this->Size());
+    if (this->_data == nullptr) {
+        return Tensor<_T>();
+    }
+    auto t = Tensor<_T>::allocate(this->Shape());
+    TensorLoop<3> loop;
+    loop.rank = this->_rank;
+    for (size_type d = 0; d < this->_rank; d++) {
+        loop.shape[d] = this->_shape[d];
+        loop.stride[0][d] = t._stride[d];
+        loop.stride[1][d] = loop.stride[2][d] = this->_stride[d];
+    }
+    tensor_map(loop, t.Begin(), this->_data, this->_data, [f](_T x, _T) { return _T(f(x)); });
+    return t;
+}
+
+
+// Reductions ----------------------------------------------------------------
+// bit d for axis d, every axis for an empty set; 0 when an axis is out of range
+template<class _T>
+uint32_t TensorView<_T>::axes_mask(const TensorShape &__axes) const noexcept {
+    if (__axes.empty()) {
+        return (uint32_t(1) << this->_rank) - 1;
+    }
+    uint32_t __mask = 0;
+    for (size_type a : __axes) {
+        if (a >= this->_rank) {
+            return 0;
+        }
+        __mask |= uint32_t(1) << a;
+    }
+    return __mask;
+}
+
+
+// one double per element of the result (row-major over the kept axes) starting at init and folded
+// with run(x, sx, acc, o, sa, n) over every innermost run: x the input run with step sx, acc + o the
+// accumulators with step sa, 0 when the innermost axis is reduced. When the outermost axis of the loop
+// is reduced it is cut into panels that own accumulators, merged with merge(a, b) in panel order
+template<class _T>
+template<class _F, class _M>
+vector<double> TensorView<_T>::reduce(uint32_t __mask, double init, _F run, _M merge) const noexcept {
+    TensorLoop<2> loop;
+    size_type __out = 1, __n = this->Size();
+    loop.rank = this->_rank;
+    for (size_type d = this->_rank; d-- > 0;) {
+        loop.shape[d] = this->_shape[d];
+        loop.stride[0][d] = this->_stride[d];
+        loop.stride[1][d] = (__mask >> d & 1) ? 0 : __out;
+        __out *= (__mask >> d & 1) ? 1 : this->_shape[d];
+    }
+    if (__n == 0) {
+        return vector<double>(__out, init);
+    }
+    loop.collapse();
+
+    const _T *x = this->_data;
+    auto fold = [x, &run](double *acc) {
+        return [x, acc, &run](const size_t *off, size_t __len, const size_t *step) { run(x + off[0], step[0], acc, off[1], step[1], __len); };
+    };
+    if (loop.stride[1][0] != 0 || loop.shape[0] == 1) {
+        vector<double> acc(__out, init);
+        loop.parallel_run(fold(acc.data()));
+        return acc;
+    }
+    size_type __outer = loop.shape[0];
+    size_type __panels = min({TENSOR_PANELS, __outer, max<size_type>(1, __n / max(TENSOR_PANEL_ELEMENTS, __out))});
+    vector<double> part(__panels * __out, init);
+    double *ref_p = part.data();
+    ThreadPool::Global().ParallelFor(0, __panels, __n / __panels, [&](size_type lo, size_type hi) {
+        for (size_type p = lo; p < hi; p++) {
+            loop.run(p * __outer / __panels, (p + 1) * __outer / __panels, fold(ref_p + p * __out));
+        }
+    });
+    for (size_type p = 1; p < __panels; p++) {
+        for (size_type j = 0; j < __out; j++) {
+            ref_p[j] = merge(ref_p[j], ref_p[p * __out + j]);
+        }
+    }
+    part.resize(__out);
+    return part;
+}
+
+
+template<class _T>
+Tensor<_T> TensorView<_T>::reduced(uint32_t __mask, bool __keep, const vector<double> &__acc) const noexcept {
+    TensorShape __shape;
+    for (size_type d = 0; d < this->_rank; d++) {
+        if (!(__mask >> d & 1)) {
+            __shape.push_back(this->_shape[d]);
+        } else if (__keep) {
+            __shape.push_back(1);
+        }
+    }
+    auto t = Tensor<_T>::allocate(__shape);
+    transform(__acc.begin(), __acc.end(), t.Begin(), [](double v) { return _T(v); });
+    return t;
+}
+
+
+template<class _T>
+Tensor<_T> TensorView<_T>::Sum(const TensorShape &__axes, bool __keep) const noexcept {
+    _PROFILE_SCOPE("TensorView::Sum", this->Size());
+    uint32_t __mask = this->axes_mask(__axes);
+    if (__mask == 0 && this->_rank > 0) {
+        return Tensor<_T>();
+    }
+    auto acc = this->reduce(__mask, 0.0, [](const _T *x, size_t __sx, double *acc, size_t o, size_t __sa, size_t __n) {
+        if (__sa == 0) {
+            double s = 0;
+            if (__sx == 1) {
+                s = simd_kernels<_T>().sum(x, __n);
+            } else {
+                for (size_t j = 0; j < __n; j++) {
+                    s += double(x[j * __sx]);
+                }
+            }
+            acc[o] += s;
+        } else if (__sx == 1 && __sa == 1) {
+            double *a = acc + o;
+            simd_for(0, __n, [=](size_t j) { a[j] += double(x[j]); });
+        } else {
+            for (size_t j = 0; j < __n; j++) {
+                acc[o + j * __sa] += double(x[j * __sx]);
+            }
+        }
+    }, plus<double>());
+    return this->reduced(__mask, __keep, acc);
+}
+
+
+template<class _T>
+Tensor<_T> TensorView<_T>::Mean(const TensorShape &__axes, bool __keep) const noexcept {
+    _PROFILE_SCOPE("TensorView::Mean", this->Size());
+    uint32_t __mask = this->axes_mask(__axes);
+    if (__mask == 0 && this->_rank > 0) {
+        return Tensor<_T>();
+    }
+    auto t = this->Sum(__axes, __keep);
+    size_type __out = t.Size();
+    double __count = __out ? double(this->Size()) / double(__out) : 0.0;
+    _T *p = t.Begin();
+    for (size_type j = 0; j < __out; j++) {
+        p[j] = __count > 0 ? _T(double(p[j]) / __count) : _T(0);
+    }
+    return t;
+}
+
+
+// two passes: the sums give the means, then the squared deviations from them
+template<class _T>
+Tensor<_T> TensorView<_T>::STD(const TensorShape &__axes, bool __keep) const noexcept {
+    _PROFILE_SCOPE("TensorView::STD", 4 * this->Size());
+    uint32_t __mask = this->axes_mask(__axes);
+    if (__mask == 0 && this->_rank > 0) {
+        return Tensor<_T>();
+    }
+    auto sum = this->reduce(__mask, 0.0, [](const _T *x, size_t __sx, double *acc, size_t o, size_t __sa, size_t __n) {
+        for (size_t j = 0; j < __n; j++) {
+            acc[o + j * __sa] += double(x[j * __sx]);
+        }
+    }, plus<double>());
+    double __count = sum.empty() ? 0.0 : double(this->Size()) / double(sum.size());
+    for (auto &s : sum) {
+        s = __count > 0 ? s / __count : 0.0;
+    }
+    const double *mean = sum.data();
+    auto m2 = this->reduce(__mask, 0.0, [mean](const _T *x, size_t __sx, double *acc, size_t o, size_t __sa, size_t __n) {
+        if (__sa == 0) {
+            double m = mean[o], s = 0;
+            for (size_t j = 0; j < __n; j++) {
+                double d = double(x[j * __sx]) - m;
+                s += d * d;
+            }
+            acc[o] += s;
+        } else if (__sx == 1 && __sa == 1) {
+            double *a = acc + o;
+            const double *m = mean + o;
+            simd_for(0, __n, [=](size_t j) {
+                double d = double(x[j]) - m[j];
+                a[j] += d * d;
+            });
+        } else {
+            for (size_t j = 0; j < __n; j++) {
+                double d = double(x[j * __sx]) - mean[o + j * __sa];
+                acc[o + j * __sa] += d * d;
+            }
+        }
+    }, plus<double>());
+    for (auto &s : m2) {
+        s = __count > 0 ? sqrt(s / __count) : 0.0;
+    }
+    return this->reduced(__mask, __keep, m2);
+}
+
+
+template<class _T>
+Tensor<_T> TensorView<_T>::Min(const TensorShape &__axes, bool __keep) const noexcept {
+    _PROFILE_SCOPE("TensorView::Min", 0);
+    uint32_t __mask = this->axes_mask(__axes);
+    if (__mask == 0 && this->_rank > 0) {
+        return Tensor<_T>();
+    }
+    auto lower = [](double a, double b) { return b < a ? b : a; };
+    auto acc = this->reduce(__mask, numeric_limits<double>::infinity(), [lower](const _T *x, size_t __sx, double *acc, size_t o, size_t __sa, size_t __n) {
+        if (__sa == 0 && __sx == 1) {
+            acc[o] = lower(acc[o], double(simd_kernels<_T>().min(x, __n)));
+        } else {
+            for (size_t j = 0; j < __n; j++) {
+                acc[o + j * __sa] = lower(acc[o + j * __sa], double(x[j * __sx]));
+            }
+        }
+    }, lower);
+    return this->reduced(__mask, __keep, acc);
+}
+
+
+template<class _T>
+Tensor<_T> TensorView<_T>::Max(const TensorShape &__axes, bool __keep) const noexcept {
+    _PROFILE_SCOPE("TensorView::Max", 0);
+    uint32_t __mask = this->axes_mask(__axes);
+    if (__mask == 0 && this->_rank > 0) {
+        return Tensor<_T>();
+    }
+    auto upper = [](double a, double b) { return b > a ? b : a; };
+    auto acc = this->reduce(__mask, -numeric_limits<double>::infinity(), [upper](const _T *x, size_t __sx, double *acc, size_t o, size_t __sa, size_t __n) {
+        if (__sa == 0 && __sx == 1) {
+            acc[o] = upper(acc[o], double(simd_kernels<_T>().max(x, __n)));
+        } else {
+            for (size_t j = 0; j < __n; j++) {
+                acc[o + j * __sa] = upper(acc[o + j * __sa], double(x[j * __sx]));
+            }
+        }
+    }, upper);
+    return this->reduced(__mask, __keep, acc);
+}
+
+
+// Tensor ----------------------------------------------------------------
+// owns a contiguous row-major buffer and reads it as a TensorView
+template<class _T>
+class Tensor : public TensorView<_T> {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        typedef _T* iterator;
+        typedef const _T* const_iterator;
+
+    private:
+        _T *_buffer = nullptr;
+
+        static auto allocate(const TensorShape&, MemoryArena *arena = ArenaScope::Active()) noexcept;
+        void take(Tensor<_T>&&) noexcept;
+        template<class _Op> Tensor<_T>& update(const TensorView<_T>&) noexcept;
+        template<class _Op> Tensor<_T>& update(const _T&) noexcept;
+
+        template<class> friend class TensorView;
+        template<class _Op, class _U> friend Tensor<_U> tensor_binary(const TensorView<_U>&, const TensorView<_U>&) noexcept;
+
+    public:
+        constexpr Tensor() noexcept = default;
+        explicit Tensor(const TensorView<_T>&) noexcept;
+        template<class _E> explicit Tensor(const VectorExpr<_E>&) noexcept;
+        template<class _E> explicit Tensor(const Matrix2DExpr<_E>&) noexcept;
+        Tensor(const Tensor<_T>&) noexcept;
+        Tensor(Tensor<_T>&&) noexcept;
+        ~Tensor() noexcept;
+
+        static auto ZeroInit(const TensorShape&) noexcept;
+        static auto OneInit(const TensorShape&) noexcept;
+        static auto RandomInit(const TensorShape&, uint64_t __seed = random_seed()) noexcept;
+        static auto NormalInit(const TensorShape&, _T __mean = _T(0), _T __std = _T(1), uint64_t __seed = random_seed()) noexcept;
+
+        using TensorView<_T>::Begin;
+        constexpr iterator Begin() noexcept { return this->_buffer; }
+        const TensorView<_T>& View() const noexcept { return *this; }
+
+        using TensorView<_T>::operator ();
+        template<class... _I> _T& operator () (_I... __i) noexcept;
+
+        // the right side broadcasts to the shape of this tensor, which is left as it is when it can not
+        Tensor<_T>& operator += (const TensorView<_T>&) noexcept;
+        Tensor<_T>& operator -= (const TensorView<_T>&) noexcept;
+        Tensor<_T>& operator *= (const TensorView<_T>&) noexcept;
+        Tensor<_T>& operator /= (const TensorView<_T>&) noexcept;
+        Tensor<_T>& operator += (const _T&) noexcept;
+        Tensor<_T>& operator -= (const _T&) noexcept;
+        Tensor<_T>& operator *= (const _T&) noexcept;
+        Tensor<_T>& operator /= (const _T&) noexcept;
+
+        Tensor<_T>& operator = (const Tensor<_T>&) noexcept;
+        Tensor<_T>& operator = (Tensor<_T>&&) noexcept;
+};
+
+
+template<class _T>
+auto Tensor<_T>::allocate(const TensorShape &__shape, MemoryArena *arena) noexcept {
+    Tensor<_T> t;
+    if (__shape.size() > TENSOR_MAX_RANK) {
+        return t;
+    }
+    size_t __n = 1;
+    for (size_t s : __shape) {
+        __n *= s;
+    }
+    static_cast<TensorView<_T>&>(t) = TensorView<_T>(nullptr, __shape);
+    t._buffer = memory_new<_T>(__n, arena);
+    t._data = t._buffer;
+    return t;
+}
+
+
+// the buffer and shape of y, whatever they are; constructors take their result this way
+template<class _T>
+void Tensor<_T>::take(Tensor<_T> &&y) noexcept {
+    swap(this->_buffer, y._buffer);
+    swap(static_cast<TensorView<_T>&>(*this), static_cast<TensorView<_T>&>(y));
+}
+
+
+template<class _T>
+Tensor<_T>::Tensor(const TensorView<_T> &x) noexcept {
+    _PROFILE_SCOPE("Tensor::Tensor(view)", 0);
+    // an empty view stays empty, like a copy of an empty tensor
+    if (x.Begin() == nullptr) {
+        return;
+    }
+    this->take(x.Apply([](_T v) { return v; }));
+}
+
+
+template<class _T>
+template<class _E>
+Tensor<_T>::Tensor(const VectorExpr<_E> &e) noexcept {
+    _PROFILE_SCOPE("Tensor::Tensor(vector)", 0);
+    const _E &x = e.self();
+    this->take(Tensor::allocate({x.Size()}));
+    _T *p = this->_buffer;
+    ThreadPool::Global().ParallelFor(0, x.Size(), 1, [&x, p](size_type lo, size_type hi) {
+        for (size_type i = lo; i < hi; i++) {
+            p[i] = x[i];
+        }
+    });
+}
+
+
+template<class _T>
+template<class _E>
+Tensor<_T>::Tensor(const Matrix2DExpr<_E> &e) noexcept {
+    _PROFILE_SCOPE("Tensor::Tensor(matrix)", 0);
+    const _E &x = e.self();
+    size_type __c = x.Col();
+    this->take(Tensor::allocate({x.Row(), __c}));
+    _T *p = this->_buffer;
+    ThreadPool::Global().ParallelFor(0, x.Row(), __c, [&x, p, __c](size_type lo, size_type hi) {
+        for (size_type i = lo; i < hi; i++) {
+            for (size_type j = 0; j < __c; j++) {
+                p[i * __c + j] = x(i, j);
+            }
+        }
+    });
+}
+
+
+template<class _T>
+Tensor<_T>::Tensor(const Tensor<_T> &y) noexcept : TensorView<_T>() {
+    // an empty tensor (what failed operations give) stays empty rather than becoming a scalar
+    if (y._buffer == nullptr) {
+        return;
+    }
+    this->take(Tensor::allocate(y.Shape()));
+    if (this->_buffer != nullptr) {
+        memcpy(this->_buffer, y._buffer, y.Size() * sizeof(_T));
+    }
+}
+
+
+template<class _T>
+Tensor<_T>::Tensor(Tensor<_T> &&y) noexcept : TensorView<_T>() { this->take(move(y)); }
+
+
+template<class _T>
+Tensor<_T>::~Tensor() noexcept { aligned_delete(this->_buffer); }
+
+
+template<class _T>
+Tensor<_T>& Tensor<_T>::operator = (const Tensor<_T> &y) noexcept {
+    if (this != &y) {
+        *this = Tensor<_T>(y);
+    }
+    return *this;
+}
+
+
+// an arena buffer only moves into a tensor whose buffer is from the same arena, any other tensor
+// gets a copy in a buffer like the one it had, see aligned_new_like
+template<class _T>
+Tensor<_T>& Tensor<_T>::operator = (Tensor<_T> &&y) noexcept {
+    if (this == &y) {
+        return *this;
+    }
+    MemoryArena *arena = memory_arena_of(y._buffer);
+    if (arena != nullptr && arena != memory_arena_of(this->_buffer)) {
+        auto t = Tensor::allocate(y.Shape(), memory_arena_of(this->_buffer));
+        if (t._buffer != nullptr) {
+            memcpy(t._buffer, y._buffer, y.Size() * sizeof(_T));
+        }
+        this->take(move(t));
+    } else {
+        this->take(move(y));
+    }
+    return *this;
+}
+
+
+template<class _T>
+auto Tensor<_T>::ZeroInit(const TensorShape &__shape) noexcept {
+    _PROFILE_SCOPE("Tensor::ZeroInit", 0);
+    auto t = Tensor::allocate(__shape);
+    _T *p = t.Begin();
+    ThreadPool::Global().ParallelFor(0, t.Size(), 1, [p](size_type lo, size_type hi) { fill(p + lo, p + hi, _T(0)); });
+    return t;
+}
+
+
+template<class _T>
+auto Tensor<_T>::OneInit(const TensorShape &__shape) noexcept {
+    _PROFILE_SCOPE("Tensor::OneInit", 0);
+    auto t = Tensor::allocate(__shape);
+    _T *p = t.Begin();
+    ThreadPool::Global().ParallelFor(0, t.Size(), 1, [p](size_type lo, size_type hi) { fill(p + lo, p + hi, _T(1)); });
+    return t;
+}
+
+
+template<class _T>
+auto Tensor<_T>::RandomInit(const TensorShape &__shape, uint64_t __seed) noexcept {
+    _PROFILE_SCOPE("Tensor::RandomInit", 0);
+    auto t = Tensor::allocate(__shape);
+    random_uniform(t.Begin(), t.Size(), __seed, _T(-1), _T(1));
+    return t;
+}
+
+
+template<class _T>
+auto Tensor<_T>::NormalInit(const TensorShape &__shape, _T __mean, _T __std, uint64_t __seed) noexcept {
+    _PROFILE_SCOPE("Tensor::NormalInit", 0);
+    auto t = Tensor::allocate(__shape);
+    random_normal(t.Begin(), t.Size(), __seed, __mean, __std);
+    return t;
+}
+
+
+template<class _T>
+template<class... _I>
+_T& Tensor<_T>::operator () (_I... __i) noexcept {
+    const size_type idx[] = {size_type(__i)..., 0};
+    size_type __off = 0;
+    for (size_type d = 0; d < sizeof...(_I); d++) {
+        __off += idx[d] * this->_stride[d];
+    }
+    return this->_buffer[__off];
+}
+
+
+// Operators ----------------------------------------------------------------
+// y may be a view of this tensor: unless it reads every element at the position it updates, it is
+// copied first, as NumPy does, so no element is read after it was written
+template<class _T>
+template<class _Op>
+Tensor<_T>& Tensor<_T>::update(const TensorView<_T> &y) noexcept {
+    _PROFILE_SCOPE("Tensor::update", this->Size());
+    // an empty operand, the result of a failed operation, leaves the tensor as it is
+    if (y._data == nullptr || this->_buffer == nullptr) {
+        return *this;
+    }
+    const _T *__last = y._data;
+    for (size_type k = 0; k < y._rank; k++) {
+        __last += y._shape[k] ? (y._shape[k] - 1) * y._stride[k] : 0;
+    }
+    bool __same = y._data == this->_data && y.Shape() == this->Shape() && y.Strides() == this->Strides();
+    if (!__same && __last >= this->_buffer && y._data < this->_buffer + this->Size()) {
+        return this->template update<_Op>(Tensor<_T>(y).View());
+    }
+    TensorLoop<3> loop;
+    loop.rank = this->_rank;
+    copy(this->_shape, this->_shape + this->_rank, loop.shape);
+    if (!y.broadcast_strides(this->_rank, this->_shape, loop.stride[2])) {
+        return *this;
+    }
+    copy(this->_stride, this->_stride + this->_rank, loop.stride[0]);
+    copy(this->_stride, this->_stride + this->_rank, loop.stride[1]);
+    tensor_map(loop, this->_buffer, this->_data, y._data, _Op());
+    return *this;
+}
+
+
+template<class _T>
+template<class _Op>
+Tensor<_T>& Tensor<_T>::update(const _T &y) noexcept {
+    _PROFILE_SCOPE("Tensor::update", this->Size());
+    _T *p = this->_buffer;
+    ThreadPool::Global().ParallelFor(0, this->Size(), 1, [p, y](size_type lo, size_type hi) {
+        simd_for(lo, hi, [=](size_t i) { p[i] = _Op()(p[i], y); });
+    });
+    return *this;
+}
+
+
+template<class _T> Tensor<_T>& Tensor<_T>::operator += (const TensorView<_T> &y) noexcept { return this->template update<plus<>>(y); }
+template<class _T> Tensor<_T>& Tensor<_T>::operator -= (const TensorView<_T> &y) noexcept { return this->template update<minus<>>(y); }
+template<class _T> Tensor<_T>& Tensor<_T>::operator *= (const TensorView<_T> &y) noexcept { return this->template update<multiplies<>>(y); }
+template<class _T> Tensor<_T>& Tensor<_T>::operator /= (const TensorView<_T> &y) noexcept { return this->template update<divides<>>(y); }
+template<class _T> Tensor<_T>& Tensor<_T>::operator += (const _T &y) noexcept { return this->template update<plus<>>(y); }
+template<class _T> Tensor<_T>& Tensor<_T>::operator -= (const _T &y) noexcept { return this->template update<minus<>>(y); }
+template<class _T> Tensor<_T>& Tensor<_T>::operator *= (const _T &y) noexcept { return this->template update<multiplies<>>(y); }
+template<class _T> Tensor<_T>& Tensor<_T>::operator /= (const _T &y) noexcept { return this->template update<divides<>>(y); }
+
+
+// x op y into a new tensor of the broadcast shape, empty when the shapes do not broadcast
+template<class _Op, class _T>
+Tensor<_T> tensor_binary(const TensorView<_T> &x, const TensorView<_T> &y) noexcept {
+    _PROFILE_SCOPE("Tensor::operator", max(x.Size(), y.Size()));
+    if (x.Begin() == nullptr || y.Begin() == nullptr) {
+        return Tensor<_T>();
+    }
+    size_t __rank = max(x.Rank(), y.Rank());
+    TensorShape __shape(__rank);
+    for (size_t d = 0; d < __rank; d++) {
+        size_t a = d + x.Rank() >= __rank ? x.Shape(d + x.Rank() - __rank) : 1;
+        size_t b = d + y.Rank() >= __rank ? y.Shape(d + y.Rank() - __rank) : 1;
+        if (a != b && a != 1 && b != 1) {
+            return Tensor<_T>();
+        }
+        __shape[d] = a == 1 ? b : a;
+    }
+
+    auto t = Tensor<_T>::allocate(__shape);
+    TensorLoop<3> loop;
+    loop.rank = __rank;
+    copy(__shape.begin(), __shape.end(), loop.shape);
+    copy(t._stride, t._stride + __rank, loop.stride[0]);
+    x.broadcast_strides(__rank, loop.shape, loop.stride[1]);
+    y.broadcast_strides(__rank, loop.shape, loop.stride[2]);
+    tensor_map(loop, t.Begin(), x.Begin(), y.Begin(), _Op());
+    return t;
+}
+
+
+template<class _T> Tensor<_T> operator + (const TensorView<_T> &x, const TensorView<_T> &y) noexcept { return tensor_binary<plus<>>(x, y); }
+template<class _T> Tensor<_T> operator - (const TensorView<_T> &x, const TensorView<_T> &y) noexcept { return tensor_binary<minus<>>(x, y); }
+template<class _T> Tensor<_T> operator * (const TensorView<_T> &x, const TensorView<_T> &y) noexcept { return tensor_binary<multiplies<>>(x, y); }
+template<class _T> Tensor<_T> operator / (const TensorView<_T> &x, const TensorView<_T> &y) noexcept { return tensor_binary<divides<>>(x, y); }
+
+// a scalar is a rank 0 view
+template<class _T> Tensor<_T> operator + (const TensorView<_T> &x, const typename TensorView<_T>::value_type &y) noexcept { return tensor_binary<plus<>>(x, TensorView<_T>(&y, {})); }
+template<class _T> Tensor<_T> operator - (const TensorView<_T> &x, const typename TensorView<_T>::value_type &y) noexcept { return tensor_binary<minus<>>(x, TensorView<_T>(&y, {})); }
+template<class _T> Tensor<_T> operator * (const TensorView<_T> &x, const typename TensorView<_T>::value_type &y) noexcept { return tensor_binary<multiplies<>>(x, TensorView<_T>(&y, {})); }
+template<class _T> Tensor<_T> operator / (const TensorView<_T> &x, const typename TensorView<_T>::value_type &y) noexcept { return tensor_binary<divides<>>(x, TensorView<_T>(&y, {})); }
+
+#endif // !_TENSOR_H_
@@ -0,0 +1,486 @@
+#ifndef _TEXT_H_
+#define _TEXT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <charconv>
+#include <limits>
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <algorithm>
+#include <type_traits>
+
+#include "Memory.hpp"
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+// Numbers are written with to_chars and read with from_chars, which ignore the locale and allocate
+// nothing. Output goes through a TEXT_BUFFER byte buffer that is handed to the stream in one write
+// when full, so printing a matrix costs a few stream calls instead of one per element and never
+// flushes. CSV input is cut into TEXT_CHUNK byte pieces at line ends: the lines of every piece are
+// counted, then parsed into their rows of the matrix, both on the pool.
+
+constexpr size_t TEXT_BUFFER = size_t(1) << 16;
+constexpr size_t TEXT_CHUNK = size_t(1) << 20;
+constexpr size_t TEXT_NUMBER = 64;      // room for any formatted number
+
+// what operator<< prints: containers with more than threshold elements only show edge_items
+// elements (rows and columns for a matrix) at each end, like numpy's print options
+struct TextFormat {
+    size_t threshold = 1000;
+    size_t edge_items = 3;
+
+    static TextFormat& Global() noexcept {
+        static TextFormat format;
+        return format;
+    }
+};
+
+
+// Writer ----------------------------------------------------------------
+// writes x at p (at most TEXT_NUMBER chars), returns the end; precision < 0 gives the shortest text
+// that reads back to the same value
+template<class _T>
+char* text_number(char *p, _T __x, int __precision, chars_format __notation = chars_format::general) noexcept {
+    if constexpr (is_floating_point_v<_T>) {
+#if defined(__cpp_lib_to_chars)
+        return __precision < 0 ? to_chars(p, p + TEXT_NUMBER, __x).ptr : to_chars(p, p + TEXT_NUMBER, __x, __notation, __precision).ptr;
+#else
+        const char *__fmt = __notation == chars_format::fixed ? "%.*f" : __notation == chars_format::scientific ? "%.*e" : "%.*g";
+        return p + snprintf(p, TEXT_NUMBER, __fmt, __precision < 0 ? numeric_limits<_T>::max_digits10 : __precision, double(__x));
+#endif
+    } else {
+        return to_chars(p, p + TEXT_NUMBER, __x).ptr;
+    }
+}
+
+
+// buffered writer over a stream, numbers as text_number with the stream's floatfield (fixed,
+// scientific or neither) as notation
+class TextWriter {
+    private:
+        ostream &out;
+        int precision;
+        chars_format notation;
+        size_t used = 0;
+        char buffer[TEXT_BUFFER];
+
+    public:
+        TextWriter(ostream &__out, int __precision) noexcept;
+        TextWriter(const TextWriter&) = delete;
+        TextWriter& operator = (const TextWriter&) = delete;
+        ~TextWriter() noexcept { this->Flush(); }
+
+        void Put(char) noexcept;
+        void Put(const char*, size_t) noexcept;
+        template<class _T> void Number(_T) noexcept;
+        void Flush() noexcept;
+};
+
+
+inline TextWriter::TextWriter(ostream &__out, int __precision) noexcept : out(__out), precision(__precision) {
+    auto __field = __out.flags() & ios::floatfield;
+    this->notation = __field == ios::fixed ? chars_format::fixed
+                   : __field == ios::scientific ? chars_format::scientific : chars_format::general;
+}
+
+
+inline void TextWriter::Put(char __ch) noexcept {
+    if (this->used == TEXT_BUFFER) {
+        this->Flush();
+    }
+    this->buffer[this->used++] = __ch;
+}
+
+
+inline void TextWriter::Put(const char *__s, size_t __n) noexcept {
+    while (__n > 0) {
+        if (this->used == TEXT_BUFFER) {
+            this->Flush();
+        }
+        size_t __take = min(__n, TEXT_BUFFER - this->used);
+        memcpy(this->buffer + this->used, __s, __take);
+        this->used += __take;
+        __s += __take;
+        __n -= __take;
+    }
+}
+
+
+template<class _T>
+void TextWriter::Number(_T __x) noexcept {
+    if (TEXT_BUFFER - this->used < TEXT_NUMBER) {
+        this->Flush();
+    }
+    char *p = text_number(this->buffer + this->used, __x, this->precision, this->notation);
+    this->used = size_t(p - this->buffer);
+}
+
+
+inline void TextWriter::Flush() noexcept {
+    this->out.write(this->buffer, streamsize(this->used));
+    this->used = 0;
+}
+
+
+// Printing ----------------------------------------------------------------
+// [ x0 x1 ... ] on one line, the middle left out past the threshold
+template<class _E>
+void text_print_vector(ostream &out, const _E &x) noexcept {
+    const TextFormat &format = TextFormat::Global();
+    size_t __n = x.Size(), __edge = format.edge_items;
+    bool __cut = __n > format.threshold && __n > 2 * __edge;
+    TextWriter w(out, int(out.precision()));
+
+    w.Put("[ ", 2);
+    for (size_t i = 0; i < __n; i++) {
+        if (__cut && i == __edge) {
+            w.Put("... ", 4);
+            i = __n - __edge;
+        }
+        w.Number(x[i]);
+        w.Put(' ');
+    }
+    w.Put("]\n", 2);
+}
+
+
+// one line per row, elements followed by two spaces; rows and columns are cut like a vector
+template<class _E>
+void text_print_matrix(ostream &out, const _E &m) noexcept {
+    const TextFormat &format = TextFormat::Global();
+    size_t __r = m.Row(), __c = m.Col(), __edge = format.edge_items;
+    bool __cut = __r * __c > format.threshold;
+    bool __cut_rows = __cut && __r > 2 * __edge, __cut_cols = __cut && __c > 2 * __edge;
+    TextWriter w(out, int(out.precision()));
+
+    for (size_t i = 0; i < __r; i++) {
+        if (__cut_rows && i == __edge) {
+            w.Put("...\n", 4);
+            i = __r - __edge;
+        }
+        for (size_t j = 0; j < __c; j++) {
+            if (__cut_cols && j == __edge) {
+                w.Put("...  ", 5);
+                j = __c - __edge;
+            }
+            w.Number(m(i, j));
+            w.Put("  ", 2);
+        }
+        w.Put('\n');
+    }
+}
+
+
+// CSV output ----------------------------------------------------------------
+// every element of m, rows formatted on the pool a group at a time and written in order; an optional
+// header line of names first. False when the stream failed
+template<class _E>
+bool text_write_csv(ostream &out, const _E &m, const vector<string> &__names, char __delim, int __precision) noexcept {
+    size_t __r = m.Row(), __c = m.Col();
+    size_t __rows = max<size_t>(1, TEXT_CHUNK / TEXT_NUMBER / max<size_t>(__c, 1));
+    size_t __blocks = (__r + __rows - 1) / __rows;
+    size_t __group = 64;
+    vector<string> text(min(__group, __blocks));
+
+    {
+        TextWriter w(out, __precision);
+        for (size_t j = 0; j < __names.size(); j++) {
+            if (j > 0) {
+                w.Put(__delim);
+            }
+            w.Put(__names[j].data(), __names[j].size());
+        }
+        if (!__names.empty()) {
+            w.Put('\n');
+        }
+    }
+    for (size_t g = 0; g < __blocks && out; g += __group) {
+        size_t __n = min(__group, __blocks - g);
+        ThreadPool::Global().ParallelFor(0, __n, __rows * __c, [&](size_t lo, size_t hi) {
+            for (size_t b = lo; b < hi; b++) {
+                text[b].clear();
+                string &s = text[b];
+                char number[TEXT_NUMBER];
+                size_t __end = min(__r, (g + b + 1) * __rows);
+                for (size_t i = (g + b) * __rows; i < __end; i++) {
+                    for (size_t j = 0; j < __c; j++) {
+                        if (j > 0) {
+                            s.push_back(__delim);
+                        }
+                        s.append(number, text_number(number, m(i, j), __precision));
+                    }
+                    s.push_back('\n');
+                }
+            }
+        });
+        for (size_t b = 0; b < __n; b++) {
+            out.write(text[b].data(), streamsize(text[b].size()));
+        }
+    }
+    return bool(out.flush());
+}
+
+
+// CSV input ----------------------------------------------------------------
+// kind of a column, the widest kind seen in any of its rows
+enum class CSVType {
+    INTEGER,
+    REAL,
+    TEXT
+};
+
+// what ReadCSV found besides the numbers; delimiter ' ' stands for runs of spaces and tabs
+struct CSVInfo {
+    bool header = false;
+    char delimiter = ',';
+    vector<string> names;
+    vector<CSVType> types;
+};
+
+
+inline bool text_space(char __ch) noexcept { return __ch == ' ' || __ch == '\t' || __ch == '\r'; }
+
+
+// the next field of [p, e) ends at the returned pointer (the delimiter or e); quotes protect delimiters
+inline const char* csv_field_end(const char *p, const char *e, char __delim) noexcept {
+    if (__delim == ' ') {
+        while (p < e && !text_space(*p)) {
+            p++;
+        }
+        return p;
+    }
+    bool __quoted = false;
+    for (; p < e; p++) {
+        if (*p == '"') {
+            __quoted = !__quoted;
+        } else if (*p == __delim && !__quoted) {
+            break;
+        }
+    }
+    return p;
+}
+
+
+// calls f(begin, end) on the fields of the line [p, e), trimmed and unquoted
+template<class _F>
+void csv_fields(const char *p, const char *e, char __delim, _F &&f) noexcept {
+    while (true) {
+        while (p < e && text_space(*p) && (__delim == ' ' || *p != __delim)) {
+            p++;
+        }
+        if (__delim == ' ' && p == e) {
+            return;
+        }
+        const char *__end = csv_field_end(p, e, __delim);
+        const char *b = p, *t = __end;
+        while (t > b && text_space(t[-1])) {
+            t--;
+        }
+        if (t - b >= 2 && *b == '"' && t[-1] == '"') {
+            b++;
+            t--;
+        }
+        f(b, t);
+        if (__end == e) {
+            return;
+        }
+        p = __end + 1;
+    }
+}
+
+
+// parses the field [b, e) into x and tells what it held; text and empty fields read as NaN (0 for
+// integer types), an empty field counts as INTEGER so a missing value never widens its column
+template<class _T>
+CSVType csv_number(const char *b, const char *e, _T &x) noexcept {
+    if (b == e) {
+        x = is_floating_point_v<_T> ? numeric_limits<_T>::quiet_NaN() : _T(0);
+        return CSVType::INTEGER;
+    }
+    if (*b == '+' && e - b > 1 && *(b + 1) != '-') {
+        b++;
+    }
+    bool __integer = true;
+    for (const char *p = b; p < e; p++) {
+        __integer &= (*p >= '0' && *p <= '9') || (p == b && *p == '-');
+    }
+    if (__integer && is_integral_v<_T>) {
+        auto r = from_chars(b, e, x);
+        if (r.ec == errc() && r.ptr == e) {
+            return CSVType::INTEGER;
+        }
+    }
+    double __d;
+#if defined(__cpp_lib_to_chars)
+    auto r = from_chars(b, e, __d);
+    bool ok = r.ptr == e && (r.ec == errc() || r.ec == errc::result_out_of_range);
+    if (r.ec == errc::result_out_of_range) {
+        // from_chars leaves the value alone, strtod gives the infinity or zero
+        string copy(b, e);
+        __d = strtod(copy.c_str(), nullptr);
+    }
+#else
+    string copy(b, e);
+    char *__stop;
+    __d = strtod(copy.c_str(), &__stop);
+    bool ok = size_t(__stop - copy.c_str()) == copy.size();
+#endif
+    if (!ok) {
+        x = is_floating_point_v<_T> ? numeric_limits<_T>::quiet_NaN() : _T(0);
+        return CSVType::TEXT;
+    }
+    if constexpr (is_same_v<_T, float>) {
+        // straight to float, rounding through double could be off by one ulp
+#if defined(__cpp_lib_to_chars)
+        if (from_chars(b, e, x).ec != errc()) {
+            x = _T(__d);
+        }
+#else
+        x = _T(__d);
+#endif
+    } else {
+        x = _T(__d);
+    }
+    return __integer ? CSVType::INTEGER : CSVType::REAL;
+}
+
+
+// ',', '\t' or ';', whichever the first line holds most of outside quotes, else whitespace
+inline char csv_delimiter(const char *p, const char *e) noexcept {
+    size_t __count[3] = {0, 0, 0};
+    const char __delims[3] = {',', '\t', ';'};
+    bool __quoted = false;
+    for (; p < e; p++) {
+        __quoted ^= *p == '"';
+        for (size_t k = 0; k < 3 && !__quoted; k++) {
+            __count[k] += *p == __delims[k];
+        }
+    }
+    size_t __best = size_t(max_element(__count, __count + 3) - __count);
+    return __count[__best] > 0 ? __delims[__best] : ' ';
+}
+
+
+inline bool csv_blank(const char *p, const char *e) noexcept {
+    for (; p < e; p++) {
+        if (!text_space(*p)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// calls f(begin, end) on every non-blank line of [p, e)
+template<class _F>
+void csv_lines(const char *p, const char *e, _F &&f) noexcept {
+    while (p < e) {
+        const char *__nl = static_cast<const char*>(memchr(p, '\n', size_t(e - p)));
+        const char *__end = __nl == nullptr ? e : __nl;
+        if (!csv_blank(p, __end)) {
+            f(p, __end);
+        }
+        p = __end + 1;
+    }
+}
+
+
+// parses the text [p, e) into the row-major buffer returned by allocate(row, col). The first non-blank
+// line sets the delimiter (unless given), the column count and, when one of its fields is not a number,
+// the column names. Missing fields read as NaN (0 for integer types), extra ones are dropped. Quoted
+// fields may hold the delimiter but not line breaks.
+template<class _T, class _Allocate>
+void csv_parse(const char *p, const char *e, char __delim, CSVInfo &info, _Allocate allocate) noexcept {
+    info = CSVInfo();
+    while (p < e) {
+        const char *__nl = static_cast<const char*>(memchr(p, '\n', size_t(e - p)));
+        const char *__end = __nl == nullptr ? e : __nl;
+        if (!csv_blank(p, __end)) {
+            break;
+        }
+        p = __end + (__end < e);
+    }
+    if (p == e) {
+        allocate(0, 0);
+        return;
+    }
+    const char *__first_end = static_cast<const char*>(memchr(p, '\n', size_t(e - p)));
+    __first_end = __first_end == nullptr ? e : __first_end;
+    info.delimiter = __delim != 0 ? __delim : csv_delimiter(p, __first_end);
+
+    csv_fields(p, __first_end, info.delimiter, [&info](const char *b, const char *t) {
+        _T x;
+        info.header |= csv_number(b, t, x) == CSVType::TEXT;
+        info.names.emplace_back(b, t);
+    });
+    size_t __c = info.names.size();
+    if (!info.header) {
+        info.names.clear();
+    } else {
+        p = min(e, __first_end + 1);
+    }
+
+    // piece boundaries sit just after a line break
+    vector<const char*> bounds{p};
+    while (size_t(e - bounds.back()) > TEXT_CHUNK) {
+        const char *__nl = static_cast<const char*>(memchr(bounds.back() + TEXT_CHUNK, '\n', size_t(e - bounds.back() - TEXT_CHUNK)));
+        if (__nl == nullptr) {
+            break;
+        }
+        bounds.push_back(__nl + 1);
+    }
+    bounds.push_back(e);
+    size_t __pieces = bounds.size() - 1;
+
+    vector<size_t> first_row(__pieces + 1, 0);
+    ThreadPool::Global().ParallelFor(0, __pieces, TEXT_CHUNK, [&](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; k++) {
+            size_t __n = 0;
+            csv_lines(bounds[k], bounds[k + 1], [&__n](const char*, const char*) { __n++; });
+            first_row[k + 1] = __n;
+        }
+    });
+    for (size_t k = 0; k < __pieces; k++) {
+        first_row[k + 1] += first_row[k];
+    }
+
+    _T *out = allocate(first_row[__pieces], __c);
+    char __d = info.delimiter;
+    vector<vector<CSVType>> types(__pieces, vector<CSVType>(__c, CSVType::INTEGER));
+    ThreadPool::Global().ParallelFor(0, __pieces, TEXT_CHUNK, [&](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; k++) {
+            _T *row = out + first_row[k] * __c;
+            CSVType *kind = types[k].data();
+            csv_lines(bounds[k], bounds[k + 1], [&](const char *b, const char *t) {
+                size_t j = 0;
+                csv_fields(b, t, __d, [&](const char *fb, const char *ft) {
+                    if (j < __c) {
+                        kind[j] = max(kind[j], csv_number(fb, ft, row[j]));
+                        j++;
+                    }
+                });
+                for (; j < __c; j++) {
+                    csv_number(b, b, row[j]);
+                }
+                row += __c;
+            });
+        }
+    });
+
+    info.types.assign(__c, CSVType::INTEGER);
+    for (auto &piece : types) {
+        for (size_t j = 0; j < __c; j++) {
+            info.types[j] = max(info.types[j], piece[j]);
+        }
+    }
+}
+
+#endif // !_TEXT_H_
@@ -0,0 +1,301 @@
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Work-stealing pool shared by Vector and Matrix2D.
+//   every worker owns a deque, pushes/pops at the back and steals from the front of the others,
+//   a thread waiting on a ParallelFor keeps running queued tasks so nested calls never deadlock.
+// ParallelFor/ParallelReduce split [begin, end) into chunks whose size only depends on the serial
+// threshold, never on the thread count, and partial results are combined in chunk order, so a
+// reduction gives bit-identical results with 1 or 64 threads.
+class ThreadPool {
+    public:
+        typedef size_t size_type;
+        typedef function<void()> task_type;
+
+    private:
+        struct queue_type {
+            mutex lock;
+            deque<task_type> tasks;
+        };
+
+        vector<unique_ptr<queue_type>> queues;
+        vector<thread> workers;
+        mutex sleep_lock;
+        condition_variable wake;
+        atomic<size_type> queued{0};
+        atomic<size_type> next_queue{0};
+        atomic<bool> stopping{false};
+        atomic<size_type> serial_threshold{1 << 15};
+
+        static const ThreadPool*& worker_owner() noexcept;
+        static long& worker_index() noexcept;
+        long self_index() const noexcept;
+        static unique_ptr<ThreadPool>& global() noexcept;
+
+        bool pop_task(size_type, task_type&) noexcept;
+        bool steal_task(size_type, task_type&) noexcept;
+        bool run_pending_task() noexcept;
+        void worker_loop(size_type) noexcept;
+
+    public:
+        explicit ThreadPool(size_type __threads = thread::hardware_concurrency()) noexcept;
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator = (const ThreadPool&) = delete;
+        ~ThreadPool() noexcept;
+
+        static ThreadPool& Global() noexcept;
+        static void SetThreadCount(size_type) noexcept;
+
+        size_type Size() const noexcept { return this->workers.size() + 1; }
+        size_type SerialThreshold() const noexcept { return this->serial_threshold; }
+        void SetSerialThreshold(size_type __t) noexcept { this->serial_threshold = __t ? __t : 1; }
+
+        // number of indices handed to one task when each index costs __cost units of work
+        size_type Grain(size_type __cost) const noexcept;
+
+        void Submit(task_type) noexcept;
+
+        template<class _F>
+        void ParallelFor(size_type __begin, size_type __end, size_type __cost, _F &&f) noexcept;
+
+        template<class _R, class _Map, class _Reduce>
+        _R ParallelReduce(size_type __begin, size_type __end, size_type __cost, _R init, _Map &&map, _Reduce &&reduce) noexcept;
+};
+
+
+inline const ThreadPool*& ThreadPool::worker_owner() noexcept {
+    static thread_local const ThreadPool *owner = nullptr;
+    return owner;
+}
+
+
+inline long& ThreadPool::worker_index() noexcept {
+    static thread_local long indx = -1;
+    return indx;
+}
+
+
+// index of the calling thread's queue, -1 when it is not one of this pool's workers
+inline long ThreadPool::self_index() const noexcept {
+    return ThreadPool::worker_owner() == this ? ThreadPool::worker_index() : -1;
+}
+
+
+inline unique_ptr<ThreadPool>& ThreadPool::global() noexcept {
+    static unique_ptr<ThreadPool> pool;
+    return pool;
+}
+
+
+// the calling thread always takes part in the work, so n threads means n - 1 workers
+inline ThreadPool::ThreadPool(size_type __threads) noexcept {
+    size_type __w = __threads > 1 ? __threads - 1 : 0;
+
+    for (size_type i = 0; i < __w; i++) {
+        this->queues.emplace_back(new queue_type());
+    }
+    for (size_type i = 0; i < __w; i++) {
+        this->workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+
+inline ThreadPool::~ThreadPool() noexcept {
+    {
+        lock_guard<mutex> guard(this->sleep_lock);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (auto &w : this->workers) {
+        w.join();
+    }
+}
+
+
+inline ThreadPool& ThreadPool::Global() noexcept {
+    auto &pool = ThreadPool::global();
+    static once_flag init;
+    call_once(init, [&pool]() { pool.reset(new ThreadPool()); });
+    return *pool;
+}
+
+
+// must not be called while work is running on the global pool
+inline void ThreadPool::SetThreadCount(size_type __threads) noexcept {
+    ThreadPool::Global();
+    auto &pool = ThreadPool::global();
+    size_type __t = pool->SerialThreshold();
+    pool.reset(new ThreadPool(__threads));
+    pool->SetSerialThreshold(__t);
+}
+
+
+inline ThreadPool::size_type ThreadPool::Grain(size_type __cost) const noexcept {
+    size_type __g = this->serial_threshold / (__cost ? __cost : 1);
+    return __g ? __g : 1;
+}
+
+
+inline void ThreadPool::Submit(task_type task) noexcept {
+    if (this->workers.empty()) {
+        task();
+        return;
+    }
+    long self = this->self_index();
+    size_type __q = self >= 0 ? size_type(self) : this->next_queue++ % this->queues.size();
+    {
+        lock_guard<mutex> guard(this->queues[__q]->lock);
+        this->queues[__q]->tasks.push_back(move(task));
+    }
+    {
+        lock_guard<mutex> guard(this->sleep_lock);
+        this->queued++;
+    }
+    this->wake.notify_one();
+}
+
+
+inline bool ThreadPool::pop_task(size_type __q, task_type &task) noexcept {
+    lock_guard<mutex> guard(this->queues[__q]->lock);
+    auto &tasks = this->queues[__q]->tasks;
+    if (tasks.empty()) {
+        return false;
+    }
+    task = move(tasks.back());
+    tasks.pop_back();
+    this->queued--;
+    return true;
+}
+
+
+inline bool ThreadPool::steal_task(size_type __q, task_type &task) noexcept {
+    size_type __n = this->queues.size();
+
+    for (size_type i = 1; i <= __n; i++) {
+        auto &victim = *this->queues[(__q + i) % __n];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            this->queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+inline bool ThreadPool::run_pending_task() noexcept {
+    if (this->queues.empty()) {
+        return false;
+    }
+    task_type task;
+    long self = this->self_index();
+    size_type __q = self >= 0 ? size_type(self) : 0;
+
+    if ((self >= 0 && this->pop_task(__q, task)) || this->steal_task(__q, task)) {
+        task();
+        return true;
+    }
+    return false;
+}
+
+
+inline void ThreadPool::worker_loop(size_type __q) noexcept {
+    ThreadPool::worker_owner() = this;
+    ThreadPool::worker_index() = long(__q);
+
+    while (true) {
+        task_type task;
+        if (this->pop_task(__q, task) || this->steal_task(__q, task)) {
+            task();
+            continue;
+        }
+        unique_lock<mutex> guard(this->sleep_lock);
+        this->wake.wait(guard, [this]() { return this->stopping || this->queued > 0; });
+        if (this->stopping && this->queued == 0) {
+            return;
+        }
+    }
+}
+
+
+// calls f(lo, hi) on consecutive sub-ranges of [begin, end)
+template<class _F>
+void ThreadPool::ParallelFor(size_type __begin, size_type __end, size_type __cost, _F &&f) noexcept {
+    if (__end <= __begin) {
+        return;
+    }
+    size_type __grain = this->Grain(__cost);
+    size_type __chunks = (__end - __begin + __grain - 1) / __grain;
+
+    if (__chunks == 1 || this->workers.empty()) {
+        f(__begin, __end);
+        return;
+    }
+
+    // helpers and the caller pull chunk indices from a shared counter until the range is drained
+    atomic<size_type> next{0};
+    atomic<size_type> running{0};
+    auto drain = [&]() {
+        size_type c;
+        while ((c = next++) < __chunks) {
+            size_type lo = __begin + c * __grain;
+            f(lo, min(lo + __grain, __end));
+        }
+    };
+
+    size_type __helpers = min(this->workers.size(), __chunks - 1);
+    running = __helpers;
+    for (size_type i = 0; i < __helpers; i++) {
+        this->Submit([&]() {
+            drain();
+            running--;
+        });
+    }
+    drain();
+    while (running > 0) {
+        if (!this->run_pending_task()) {
+            this_thread::yield();
+        }
+    }
+}
+
+
+// map(lo, hi) -> _R on every chunk, then reduce(acc, partial) over the chunks in order
+template<class _R, class _Map, class _Reduce>
+_R ThreadPool::ParallelReduce(size_type __begin, size_type __end, size_type __cost, _R init, _Map &&map, _Reduce &&reduce) noexcept {
+    if (__end <= __begin) {
+        return init;
+    }
+    size_type __grain = this->Grain(__cost);
+    size_type __chunks = (__end - __begin + __grain - 1) / __grain;
+    vector<_R> partial(__chunks, init);
+
+    this->ParallelFor(0, __chunks, __grain * __cost, [&](size_type lo, size_type hi) {
+        for (size_type c = lo; c < hi; c++) {
+            size_type b = __begin + c * __grain;
+            partial[c] = map(b, min(b + __grain, __end));
+        }
+    });
+
+    _R acc = init;
+    for (size_type c = 0; c < __chunks; c++) {
+        acc = reduce(acc, partial[c]);
+    }
+    return acc;
+}
+
+#endif // !_THREADPOOL_H_
@@ -0,0 +1,199 @@
+#ifndef _TRANSPOSE_H_
+#define _TRANSPOSE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include <utility>
+
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+// B = A^T one TRANSPOSE_TILE x TRANSPOSE_TILE tile at a time: a tile of the source and the matching
+// tile of the destination both fit in L1, so every cache line is read and written once instead of
+// once per element. Inside a tile, 4 x 4 blocks of 4 byte elements (2 x 2 of 8 byte ones) are loaded
+// as rows, transposed in registers with shuffles and stored as rows. Elements are only moved, never
+// interpreted, so the block kernels work on their bits and serve every element type of that size.
+
+#if defined(__GNUC__) && !defined(__clang__)
+#define _TRANSPOSE_SHUFFLE 1
+#endif
+
+constexpr size_t TRANSPOSE_TILE = 32;
+
+#ifdef _TRANSPOSE_SHUFFLE
+typedef uint32_t transpose_u32x4 __attribute__((vector_size(16)));
+typedef uint64_t transpose_u64x2 __attribute__((vector_size(16)));
+typedef transpose_u32x4 transpose_mask4;
+typedef transpose_u64x2 transpose_mask2;
+#endif
+
+
+// Block kernels ----------------------------------------------------------------
+// width of the square block transposed in registers, 1 when elements go one by one
+template<class _T>
+constexpr size_t transpose_block_width() noexcept {
+#ifdef _TRANSPOSE_SHUFFLE
+    if constexpr (sizeof(_T) == 4 || sizeof(_T) == 8) {
+        return 16 / sizeof(_T);
+    }
+#endif
+    return 1;
+}
+
+
+#ifdef _TRANSPOSE_SHUFFLE
+// rows in, columns out: 4 x 4 lanes of 4 bytes or 2 x 2 lanes of 8 bytes
+inline void transpose_registers(transpose_u32x4 r[4]) noexcept {
+    transpose_u32x4 t0 = __builtin_shuffle(r[0], r[1], transpose_mask4{0, 4, 1, 5});
+    transpose_u32x4 t1 = __builtin_shuffle(r[0], r[1], transpose_mask4{2, 6, 3, 7});
+    transpose_u32x4 t2 = __builtin_shuffle(r[2], r[3], transpose_mask4{0, 4, 1, 5});
+    transpose_u32x4 t3 = __builtin_shuffle(r[2], r[3], transpose_mask4{2, 6, 3, 7});
+    r[0] = __builtin_shuffle(t0, t2, transpose_mask4{0, 1, 4, 5});
+    r[1] = __builtin_shuffle(t0, t2, transpose_mask4{2, 3, 6, 7});
+    r[2] = __builtin_shuffle(t1, t3, transpose_mask4{0, 1, 4, 5});
+    r[3] = __builtin_shuffle(t1, t3, transpose_mask4{2, 3, 6, 7});
+}
+
+
+inline void transpose_registers(transpose_u64x2 r[2]) noexcept {
+    transpose_u64x2 t0 = __builtin_shuffle(r[0], r[1], transpose_mask2{0, 2});
+    transpose_u64x2 t1 = __builtin_shuffle(r[0], r[1], transpose_mask2{1, 3});
+    r[0] = t0;
+    r[1] = t1;
+}
+#endif
+
+
+// loads the w x w block at src (row stride rss), stores its transpose at dst (row stride rsd)
+template<class _T>
+inline void transpose_block(const _T *src, size_t __rss, _T *dst, size_t __rsd) noexcept {
+    constexpr size_t __w = transpose_block_width<_T>();
+#ifdef _TRANSPOSE_SHUFFLE
+    if constexpr (__w > 1) {
+        typedef conditional_t<sizeof(_T) == 4, transpose_u32x4, transpose_u64x2> _V;
+        _V r[__w];
+        for (size_t i = 0; i < __w; i++) {
+            memcpy(&r[i], src + i * __rss, sizeof(_V));
+        }
+        transpose_registers(r);
+        for (size_t i = 0; i < __w; i++) {
+            memcpy(dst + i * __rsd, &r[i], sizeof(_V));
+        }
+        return;
+    }
+#endif
+    dst[0] = src[0];
+}
+
+
+// swaps the w x w block at p with the transpose of the one at q (and q with the transpose of p),
+// both are loaded before anything is stored so p == q transposes a diagonal block in place
+template<class _T>
+inline void transpose_swap_block(_T *p, _T *q, size_t __rs) noexcept {
+    constexpr size_t __w = transpose_block_width<_T>();
+#ifdef _TRANSPOSE_SHUFFLE
+    if constexpr (__w > 1) {
+        typedef conditional_t<sizeof(_T) == 4, transpose_u32x4, transpose_u64x2> _V;
+        _V rp[__w], rq[__w];
+        for (size_t i = 0; i < __w; i++) {
+            memcpy(&rp[i], p + i * __rs, sizeof(_V));
+            memcpy(&rq[i], q + i * __rs, sizeof(_V));
+        }
+        transpose_registers(rp);
+        transpose_registers(rq);
+        for (size_t i = 0; i < __w; i++) {
+            memcpy(q + i * __rs, &rp[i], sizeof(_V));
+            memcpy(p + i * __rs, &rq[i], sizeof(_V));
+        }
+        return;
+    }
+#endif
+    swap(p[0], q[0]);
+}
+
+
+// Tiles ----------------------------------------------------------------
+// dst[j][i] = src[i][j] for the r x c tile at src
+template<class _T>
+void transpose_tile(size_t __r, size_t __c, const _T *src, size_t __rss, _T *dst, size_t __rsd) noexcept {
+    constexpr size_t __w = transpose_block_width<_T>();
+    size_t __rb = __r - __r % __w, __cb = __c - __c % __w;
+
+    for (size_t i = 0; i < __rb; i += __w) {
+        for (size_t j = 0; j < __cb; j += __w) {
+            transpose_block(src + i * __rss + j, __rss, dst + j * __rsd + i, __rsd);
+        }
+    }
+    // ragged right and bottom edges of the tile
+    for (size_t i = 0; i < __r; i++) {
+        for (size_t j = i < __rb ? __cb : 0; j < __c; j++) {
+            dst[j * __rsd + i] = src[i * __rss + j];
+        }
+    }
+}
+
+
+// swaps the r x c tile at p with the transpose of the c x r tile at q, p == q for a diagonal tile
+template<class _T>
+void transpose_swap_tile(size_t __r, size_t __c, _T *p, _T *q, size_t __rs) noexcept {
+    constexpr size_t __w = transpose_block_width<_T>();
+    size_t __rb = __r - __r % __w, __cb = __c - __c % __w;
+    bool __diag = p == q;
+
+    for (size_t i = 0; i < __rb; i += __w) {
+        for (size_t j = __diag ? i : 0; j < __cb; j += __w) {
+            transpose_swap_block(p + i * __rs + j, q + j * __rs + i, __rs);
+        }
+    }
+    for (size_t i = 0; i < __r; i++) {
+        for (size_t j = i < __rb ? __cb : 0; j < __c; j++) {
+            if (!__diag || j > i) {
+                swap(p[i * __rs + j], q[j * __rs + i]);
+            }
+        }
+    }
+}
+
+
+// Drivers ----------------------------------------------------------------
+// dst (c x r, row stride rsd) = transpose of src (r x c, row stride rss); bands of tile rows run on the pool
+template<class _T>
+void transpose(size_t __r, size_t __c, const _T *src, size_t __rss, _T *dst, size_t __rsd) noexcept {
+    size_t __tiles = (__r + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+
+    ThreadPool::Global().ParallelFor(0, __tiles, TRANSPOSE_TILE * __c, [=](size_t lo, size_t hi) {
+        for (size_t ti = lo; ti < hi; ti++) {
+            size_t i = ti * TRANSPOSE_TILE;
+            size_t __tr = min(TRANSPOSE_TILE, __r - i);
+            for (size_t j = 0; j < __c; j += TRANSPOSE_TILE) {
+                size_t __tc = min(TRANSPOSE_TILE, __c - j);
+                transpose_tile(__tr, __tc, src + i * __rss + j, __rss, dst + j * __rsd + i, __rsd);
+            }
+        }
+    });
+}
+
+
+// transposes the n x n matrix at a (row stride rs) in place: tile (I, J) and tile (J, I) are swapped
+// for J >= I, so every tile pair is touched by exactly one task
+template<class _T>
+void transpose_in_place(size_t __n, _T *a, size_t __rs) noexcept {
+    size_t __tiles = (__n + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+
+    ThreadPool::Global().ParallelFor(0, __tiles, TRANSPOSE_TILE * __n / 2, [=](size_t lo, size_t hi) {
+        for (size_t ti = lo; ti < hi; ti++) {
+            size_t i = ti * TRANSPOSE_TILE;
+            size_t __tr = min(TRANSPOSE_TILE, __n - i);
+            for (size_t j = i; j < __n; j += TRANSPOSE_TILE) {
+                size_t __tc = min(TRANSPOSE_TILE, __n - j);
+                transpose_swap_tile(__tr, __tc, a + i * __rs + j, a + j * __rs + i, __rs);
+            }
+        }
+    });
+}
+
+#endif // !_TRANSPOSE_H_
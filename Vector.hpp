@@ -10,387 +10,648 @@ class Matrix2D;
 #include <random>
 #include <chrono>
 #include <math.h>
+#include <cstring>
+#include <utility>
+
+#include "Memory.hpp"
+#include "Profile.hpp"
+#include "Expression.hpp"
+#include "View.hpp"
+#include "ThreadPool.hpp"
+#include "Statistics.hpp"
+#include "Simd.hpp"
+#include "Sort.hpp"
+#include "Random.hpp"
+#include "Serialize.hpp"
+#include "Text.hpp"
 
 using namespace std;
 using namespace chrono;
 
+// any vector-shaped operand: a Vector or a lazy expression over Vectors, see Expression.hpp
+template<class _E>
+class VectorExpr {
+    private:
+        template<class _R, class _Map, class _Reduce> _R reduce_blocks(_R, _Map, _Reduce) const noexcept;
+        template<class _F> auto with_data(_F) const noexcept;
+
+    public:
+        constexpr const _E& self() const noexcept { return static_cast<const _E&>(*this); }
+
+        constexpr auto STD() const noexcept;
+        constexpr auto Mean() const noexcept;
+        constexpr auto Max() const noexcept;
+        constexpr auto Min() const noexcept;
+
+	    constexpr auto Argmax() const noexcept;
+
+        // sum of x[i] * y[i] with the fused multiply-add kernels of Simd.hpp, 0 when the sizes differ
+        template<class _R> auto Dot(const VectorExpr<_R>&) const noexcept;
+
+        auto Describe() const noexcept;
+
+        // sorting and selection, see Sort.hpp; equal values keep their index order and NaN sorts last.
+        // TopK gives the indices of the k largest (smallest) values, largest (smallest) first; Quantile
+        // interpolates linearly between the two closest ranks, q is clamped to [0, 1], 0 when empty
+        auto Sort(bool __descending = false) const noexcept;
+        auto Argsort(bool __descending = false) const noexcept;
+        auto TopK(size_t, bool __largest = true) const noexcept;
+        auto Quantile(double) const noexcept;
+        auto Median() const noexcept { return this->Quantile(0.5); }
+
+        // buffered, with the stream's precision and TextFormat::Global() summarizing long vectors
+        friend ostream& operator << (ostream &str, const VectorExpr<_E> &e) noexcept {
+            text_print_vector(str, e.self());
+            return str;
+        }
+};
+
+
 template<class _T>
-class Vector {
+class Vector : public VectorExpr<Vector<_T>> {
     public:
+        typedef _T value_type;
         typedef size_t size_type;
+        typedef _T* iterator;
         typedef const _T* const_iterator;
 
     private:
-        const_iterator _vec;
-        size_type vec_size;
+        // the vector owns its buffer, allocated with aligned_new and released in the destructor
+        iterator _vec = nullptr;
+        size_type vec_size = 0;
+
+        static auto allocate(size_type) noexcept;
+
+        template<class _Op, class _E> Vector<_T>& update(const VectorExpr<_E>&) noexcept;
+        template<class _Op> Vector<_T>& update(const _T&) noexcept;
+
+        template<class> friend class VectorExpr;
+        template<class> friend class Matrix2D;
+        template<class> friend class Matrix2DExpr;
 
     public:
         constexpr Vector() noexcept = default;
-        constexpr Vector(initializer_list<_T>) noexcept;
-        constexpr Vector(const_iterator, size_type) noexcept;
+        Vector(initializer_list<_T>) noexcept;
+        Vector(const_iterator, size_type) noexcept;
+        Vector(const Vector<_T>&) noexcept;
+        Vector(Vector<_T>&&) noexcept;
+        template<class _E> Vector(const VectorExpr<_E>&) noexcept;
+        ~Vector() noexcept;
 
         constexpr auto Size() const noexcept;
-        constexpr auto Begin() const noexcept;
-        constexpr auto End() const noexcept;
-
-        constexpr auto STD() const noexcept;
-        constexpr auto Mean() const noexcept;
-        constexpr auto Max() const noexcept;
-        constexpr auto Min() const noexcept;
-
-	    constexpr auto Argmax() const noexcept;
+        constexpr const_iterator Begin() const noexcept;
+        constexpr iterator Begin() noexcept;
+        constexpr const_iterator End() const noexcept;
+        constexpr iterator End() noexcept;
 
         static auto ZeroInit(size_type) noexcept;
         static auto OneInit(size_type) noexcept;
-        static auto RandomInit(size_type) noexcept;
+        // random factories take a seed, the same seed gives the same vector whatever the thread count
+        static auto RandomInit(size_type, uint64_t __seed = random_seed()) noexcept;
+        static auto NormalInit(size_type, _T __mean = _T(0), _T __std = _T(1), uint64_t __seed = random_seed()) noexcept;
         static auto RangeInit(_T __start, _T __end, _T __step = 1) noexcept;
 
-        auto Batch(size_type) noexcept;
+        // binary files, see Serialize.hpp; Load and Map give an empty vector when the file cannot be
+        // read, Map shares the file's pages instead of copying them
+        bool Save(ostream&) const noexcept;
+        bool Save(const string&) const noexcept;
+        static auto Load(istream&) noexcept;
+        static auto Load(const string&) noexcept;
+        static auto Map(const string&, bool __verify = false) noexcept;
+
+        // views over this vector's buffer, see View.hpp
+        constexpr auto Slice(size_type, size_type, size_type __step = 1) const & noexcept;
+        auto Slice(size_type, size_type, size_type __step = 1) && noexcept = delete;
+        constexpr auto Batch(size_type) const & noexcept;
+        auto Batch(size_type) && noexcept = delete;
 
         auto operator [] (int) const noexcept;
-        void operator = (const Vector<_T>&) const noexcept;
-        auto operator + (const Vector<_T>&) const noexcept;
-        auto operator + (const _T&) const noexcept;
-        auto operator - (const Vector<_T>&) const noexcept;
-        auto operator - (const _T&) const noexcept;
-        auto operator * (const Vector<_T>&) const noexcept;
-        auto operator * (const _T&) const noexcept;
-        auto operator / (const Vector<_T>&) const noexcept;
-        auto operator / (const _T&) const noexcept;
-
-        friend auto operator << (ostream &str, const Vector<_T> &x) noexcept {
-            auto item = x.Begin();
-            cout<<"[ ";
-            while (item != x.End()) {
-                cout << *item<<' ';
-                item++;
-            }
-            cout<<"]"<<endl;
-        }
+        _T& operator [] (int) noexcept;
+        Vector<_T>& operator = (const Vector<_T>&) noexcept;
+        Vector<_T>& operator = (Vector<_T>&&) noexcept;
+        template<class _E> Vector<_T>& operator = (const VectorExpr<_E>&) noexcept;
+
+        // in place, element by element, no allocation
+        template<class _E> Vector<_T>& operator += (const VectorExpr<_E> &e) noexcept { return this->template update<plus<>>(e); }
+        template<class _E> Vector<_T>& operator -= (const VectorExpr<_E> &e) noexcept { return this->template update<minus<>>(e); }
+        template<class _E> Vector<_T>& operator *= (const VectorExpr<_E> &e) noexcept { return this->template update<multiplies<>>(e); }
+        template<class _E> Vector<_T>& operator /= (const VectorExpr<_E> &e) noexcept { return this->template update<divides<>>(e); }
+        Vector<_T>& operator += (const _T &y) noexcept { return this->template update<plus<>>(y); }
+        Vector<_T>& operator -= (const _T &y) noexcept { return this->template update<minus<>>(y); }
+        Vector<_T>& operator *= (const _T &y) noexcept { return this->template update<multiplies<>>(y); }
+        Vector<_T>& operator /= (const _T &y) noexcept { return this->template update<divides<>>(y); }
 };
 
 
+template<class _E>
+Vector(const VectorExpr<_E>&) -> Vector<typename _E::value_type>;
+
+
 template<class _T>
-constexpr Vector<_T>::Vector(initializer_list<_T> _iter) noexcept {
-    this->_vec = _iter.begin();
-    this->vec_size = _iter.size();
+auto Vector<_T>::allocate(size_type __l) noexcept {
+    Vector<_T> v;
+    v._vec = aligned_new<_T>(__l);
+    v.vec_size = __l;
+    return v;
 }
 
 
 template<class _T>
-constexpr Vector<_T>::Vector(const_iterator __begin, size_t __l) noexcept {
-    this->_vec = __begin;
+Vector<_T>::Vector(initializer_list<_T> _iter) noexcept : Vector(_iter.begin(), _iter.size()) {}
+
+
+template<class _T>
+Vector<_T>::Vector(const_iterator __begin, size_t __l) noexcept {
+    _PROFILE_SCOPE("Vector::Vector(copy)", 0);
+    this->_vec = aligned_new<_T>(__l);
     this->vec_size = __l;
+    memcpy(this->_vec, __begin, __l * sizeof(_T));
 }
 
 
+template<class _T>
+Vector<_T>::Vector(const Vector<_T> &y) noexcept : Vector(y.Begin(), y.Size()) {}
+
+
+template<class _T>
+Vector<_T>::Vector(Vector<_T> &&y) noexcept {
+    this->_vec = y._vec;
+    this->vec_size = y.vec_size;
+    y._vec = nullptr;
+    y.vec_size = 0;
+}
+
+
+// evaluates the whole expression tree in a single pass into one new buffer
+template<class _T>
+template<class _E>
+Vector<_T>::Vector(const VectorExpr<_E> &e) noexcept {
+    _PROFILE_SCOPE("Vector::Vector(expression)", 0);
+    const _E &x = e.self();
+    this->vec_size = x.Size();
+    this->_vec = aligned_new<_T>(this->vec_size);
+
+    _T *v = this->_vec;
+    if constexpr (is_same_v<_E, VectorView<_T>>) {
+        if (x.Step() == 1) {
+            memcpy(v, x.Begin(), this->vec_size * sizeof(_T));
+            return;
+        }
+    }
+    ThreadPool::Global().ParallelFor(0, this->vec_size, 1, [&x, v](size_type lo, size_type hi) {
+        simd_for(lo, hi, [&x, v](size_type i) { v[i] = x[i]; });
+    });
+}
+
+
+template<class _T>
+Vector<_T>::~Vector() noexcept { aligned_delete(this->_vec); }
+
+
 template<class _T>
 constexpr auto Vector<_T>::Size() const noexcept { return this->vec_size; }
 
 
 template<class _T>
-constexpr auto Vector<_T>::Begin() const noexcept { return this->_vec; }
+constexpr typename Vector<_T>::const_iterator Vector<_T>::Begin() const noexcept { return this->_vec; }
+
+
+template<class _T>
+constexpr typename Vector<_T>::iterator Vector<_T>::Begin() noexcept { return this->_vec; }
 
 
 template<class _T>
-constexpr auto Vector<_T>::End() const noexcept { return this->Begin() + this->Size(); }
+constexpr typename Vector<_T>::const_iterator Vector<_T>::End() const noexcept { return this->Begin() + this->Size(); }
 
 
 template<class _T>
-constexpr auto Vector<_T>::STD() const noexcept {
-    size_type __l = this->vec_size;
-    _T mean = this->Mean();
-    _T sum = 0;
+constexpr typename Vector<_T>::iterator Vector<_T>::End() noexcept { return this->Begin() + this->Size(); }
+
+
+template<class _E>
+constexpr auto VectorExpr<_E>::STD() const noexcept { return this->Describe().STD(); }
+
 
-    auto item = this->Begin();
-    while (item != this->End()) {
-        sum += pow(*item - mean, 2);
-        item++;
+// the elements of a Vector or a unit-step view where they are stored, nullptr when x has to be evaluated
+template<class _E>
+constexpr const typename _E::value_type* vector_data(const _E &x) noexcept {
+    typedef typename _E::value_type _T;
+    if constexpr (is_same_v<_E, Vector<_T>>) {
+        return x.Begin();
+    } else if constexpr (is_same_v<_E, VectorView<_T>>) {
+        return x.Step() == 1 ? x.Begin() : nullptr;
+    } else {
+        return nullptr;
     }
-    return sqrt(sum / float(__l));
 }
 
 
-template<class _T>
-constexpr auto Vector<_T>::Mean() const noexcept {
-    size_type __l = this->vec_size;
-    _T sum = 0;
+// map(p, lo, n) on runs of elements [lo, lo + n) stored at p, combined in order with reduce. A Vector
+// or a unit-step view is read in place, anything else is evaluated SIMD_BLOCK elements at a time into
+// a buffer on the stack, so the reductions below always run the SIMD kernels of Simd.hpp
+template<class _E>
+template<class _R, class _Map, class _Reduce>
+_R VectorExpr<_E>::reduce_blocks(_R init, _Map map, _Reduce reduce) const noexcept {
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    const _T *data = vector_data(x);
 
-    auto item = this->Begin();
-    while (item != this->End()) {
-        sum += *item;
-        item++;
+    return ThreadPool::Global().ParallelReduce(0, x.Size(), 1, init, [&](size_t lo, size_t hi) {
+        if (data != nullptr) {
+            return _R(map(data + lo, lo, hi - lo));
+        }
+        alignas(MEMORY_ALIGNMENT) _T buf[SIMD_BLOCK];
+        _R r = init;
+        for (size_t b = lo; b < hi; b += SIMD_BLOCK) {
+            size_t e = min(b + SIMD_BLOCK, hi);
+            simd_for(b, e, [&x, &buf, b](size_t i) { buf[i - b] = x[i]; });
+            r = reduce(r, _R(map(buf, b, e - b)));
+        }
+        return r;
+    }, reduce);
+}
+
+
+template<class _E>
+constexpr auto VectorExpr<_E>::Mean() const noexcept {
+    typedef typename _E::value_type _T;
+    const SimdKernels<_T> &k = simd_kernels<_T>();
+
+    double sum = this->reduce_blocks(0.0, [&k](const _T *p, size_t, size_t __n) { return k.sum(p, __n); }, plus<double>());
+    return _T(sum / this->self().Size());
+}
+
+
+template<class _E>
+constexpr auto VectorExpr<_E>::Max() const noexcept {
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    const SimdKernels<_T> &k = simd_kernels<_T>();
+
+    if (x.Size() == 0) {
+        return _T(0);
     }
-    return sum / __l;
+    return this->reduce_blocks(_T(x[0]), [&k](const _T *p, size_t, size_t __n) { return k.max(p, __n); },
+                               [](_T a, _T b) { return b > a ? b : a; });
 }
 
 
-template<class _T>
-constexpr auto Vector<_T>::Max() const noexcept {
-    size_type __l = this->vec_size;
-    _T max = this->_vec[0];
+template<class _E>
+constexpr auto VectorExpr<_E>::Min() const noexcept {
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    const SimdKernels<_T> &k = simd_kernels<_T>();
 
-    auto item = this->Begin();
-    while (item != this->End()) {
-        if (*item > max) {
-            max = *item;
+    if (x.Size() == 0) {
+        return _T(0);
+    }
+    return this->reduce_blocks(_T(x[0]), [&k](const _T *p, size_t, size_t __n) { return k.min(p, __n); },
+                               [](_T a, _T b) { return b < a ? b : a; });
+}
+
+
+// first index of the largest element
+template<class _E>
+constexpr auto VectorExpr<_E>::Argmax() const noexcept {
+    typedef typename _E::value_type _T;
+    typedef pair<_T, size_t> best_type;
+    const _E &x = this->self();
+    const SimdKernels<_T> &k = simd_kernels<_T>();
+
+    if (x.Size() == 0) {
+        return size_t(0);
+    }
+    return this->reduce_blocks(best_type(x[0], 0), [&k](const _T *p, size_t lo, size_t __n) {
+        size_t j = k.argmax(p, __n);
+        return best_type(p[j], lo + j);
+    }, [](best_type a, best_type b) { return b.first > a.first ? b : a; }).second;
+}
+
+
+// operands that are not stored contiguously are evaluated once, the sum is chunked over the pool and
+// the chunks added in order
+template<class _E>
+template<class _R>
+auto VectorExpr<_E>::Dot(const VectorExpr<_R> &e) const noexcept {
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    const _R &y = e.self();
+    const _T *p = vector_data(x), *q = vector_data(y);
+
+    if (x.Size() != y.Size()) {
+        return _T(0);
+    }
+    if constexpr (!is_same_v<_E, Vector<_T>>) {
+        if (p == nullptr) {
+            return Vector<_T>(x).Dot(y);
+        }
+    }
+    if constexpr (!is_same_v<_R, Vector<_T>>) {
+        if (q == nullptr) {
+            return this->Dot(Vector<_T>(y));
         }
-        item++;
     }
-    return max;
+    _PROFILE_SCOPE("Vector::Dot", 2 * x.Size());
+    const SimdKernels<_T> &k = simd_kernels<_T>();
+    return _T(ThreadPool::Global().ParallelReduce(0, x.Size(), 2, 0.0, [&k, p, q](size_t lo, size_t hi) {
+        return k.dot(p + lo, q + lo, hi - lo);
+    }, plus<double>()));
 }
 
 
-template<class _T>
-constexpr auto Vector<_T>::Min() const noexcept {
-    size_type __l = this->vec_size;
-    _T min = this->_vec[0];
+// count, mean, std, min/max and their first index in a single sweep, see Statistics.hpp
+template<class _E>
+auto VectorExpr<_E>::Describe() const noexcept {
+    _PROFILE_SCOPE("Vector::Describe", 3 * this->self().Size());
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+    auto get = [&x](size_t k) { return x[k]; };
+
+    return ThreadPool::Global().ParallelReduce(0, x.Size(), 1, Description<_T>(), [&get](size_t lo, size_t hi) {
+        return describe_range<_T>(lo, hi, get);
+    }, [](Description<_T> acc, const Description<_T> &y) { return acc.Merge(y); });
+}
+
 
-    auto item = this->Begin();
-    while (item != this->End()) {
-        if (*item < min) {
-            min = *item;
+// Sorting and selection ----------------------------------------------------------------
+// f(p, n) over the elements in one contiguous buffer, the vector's own when it has one; an empty
+// vector has no buffer and is passed as nullptr
+template<class _E>
+template<class _F>
+auto VectorExpr<_E>::with_data(_F f) const noexcept {
+    typedef typename _E::value_type _T;
+    const _E &x = this->self();
+
+    if (x.Size() == 0) {
+        return f(static_cast<const _T*>(nullptr), size_t(0));
+    }
+    if constexpr (is_same_v<_E, Vector<_T>>) {
+        return f(x.Begin(), x.Size());
+    } else {
+        if (const _T *p = vector_data(x)) {
+            return f(p, x.Size());
         }
-        item++;
+        Vector<_T> tmp(x);
+        return f(tmp.Begin(), tmp.Size());
     }
-    return min;
 }
 
 
-template<class _T>
-constexpr auto Vector<_T>::Argmax() const noexcept {
-	_T max = *this->_vec;
-	const _T *current = this->_vec;
-	size_type indx = 0;
+template<class _E>
+auto VectorExpr<_E>::Sort(bool __descending) const noexcept {
+    _PROFILE_SCOPE("Vector::Sort", 0);
+    typedef typename _E::value_type _T;
 
-	for (int i = 0; i < this->vec_size; i++) {
-		if (*current > max) {
-			max = *current;
-			indx = i;
-		}
-		current++;
-	}
-	return indx;
+    return this->with_data([__descending](const _T *p, size_t __n) {
+        auto vec = Vector<_T>::allocate(__n);
+        sort_values(p, __n, __descending, vec.Begin());
+        return vec;
+    });
 }
 
 
+template<class _E>
+auto VectorExpr<_E>::Argsort(bool __descending) const noexcept {
+    _PROFILE_SCOPE("Vector::Argsort", 0);
+    typedef typename _E::value_type _T;
+
+    return this->with_data([__descending](const _T *p, size_t __n) {
+        auto vec = Vector<size_t>::allocate(__n);
+        sort_indices(p, __n, __descending, vec.Begin());
+        return vec;
+    });
+}
+
+
+template<class _E>
+auto VectorExpr<_E>::TopK(size_t __k, bool __largest) const noexcept {
+    _PROFILE_SCOPE("Vector::TopK", 0);
+    typedef typename _E::value_type _T;
+
+    return this->with_data([__k, __largest](const _T *p, size_t __n) {
+        auto vec = Vector<size_t>::allocate(min(__k, __n));
+        sort_top_k(p, __n, __k, __largest, vec.Begin());
+        return vec;
+    });
+}
+
+
+template<class _E>
+auto VectorExpr<_E>::Quantile(double __q) const noexcept {
+    _PROFILE_SCOPE("Vector::Quantile", 0);
+    typedef typename _E::value_type _T;
+
+    return this->with_data([__q](const _T *p, size_t __n) { return sort_quantile(p, __n, __q); });
+}
+
 template<class _T>
 auto Vector<_T>::ZeroInit(size_type __l) noexcept {
-    _T *v = new _T[__l];
+    _PROFILE_SCOPE("Vector::ZeroInit", 0);
+    auto vec = Vector::allocate(__l);
+    _T *v = vec.Begin();
 
-    for (int i = 0; i < __l; i++) {
+    for (size_type i = 0; i < __l; i++) {
         v[i] = _T(0.f);
     }
-    return Vector(v, __l);
+    return vec;
 }
 
 
 template<class _T>
 auto Vector<_T>::OneInit(size_type __l) noexcept {
-    _T *v = new _T[__l];
+    _PROFILE_SCOPE("Vector::OneInit", 0);
+    auto vec = Vector::allocate(__l);
+    _T *v = vec.Begin();
 
-    for (int i = 0; i < __l; i++) {
+    for (size_type i = 0; i < __l; i++) {
         v[i] = _T(1.f);
     }
-    return Vector(v, __l);
+    return vec;
 }
 
 
+// uniform on [-1, 1), see Random.hpp
 template<class _T>
-auto Vector<_T>::RandomInit(size_type __l) noexcept {
-    auto seed = system_clock::now().time_since_epoch().count();
-    default_random_engine engine(seed);
-    uniform_real_distribution<_T> distribution(-1., 1.);
+auto Vector<_T>::RandomInit(size_type __l, uint64_t __seed) noexcept {
+    _PROFILE_SCOPE("Vector::RandomInit", 0);
+    auto vec = Vector::allocate(__l);
+    random_uniform(vec.Begin(), __l, __seed, _T(-1), _T(1));
+    return vec;
+}
 
-    _T *v = new _T[__l];
-    
-    for (int i = 0; i < __l; i++) {
-        v[i] = distribution(engine);
-    }
-    return Vector(v, __l);
+
+template<class _T>
+auto Vector<_T>::NormalInit(size_type __l, _T __mean, _T __std, uint64_t __seed) noexcept {
+    _PROFILE_SCOPE("Vector::NormalInit", 0);
+    auto vec = Vector::allocate(__l);
+    random_normal(vec.Begin(), __l, __seed, __mean, __std);
+    return vec;
 }
 
+
 template<class _T>
 auto Vector<_T>::RangeInit(_T __start, _T __end, _T __step) noexcept {
+	_PROFILE_SCOPE("Vector::RangeInit", 0);
 	size_type __l = int(((__end - __start) / __step)+0.9999);
-    	_T *v = new _T[__l];
+	auto vec = Vector::allocate(__l);
+	_T *v = vec.Begin();
 
-	for (size_type i = 0; i <= __l; i++) {
+	for (size_type i = 0; i < __l; i++) {
 		v[i] = __start;
 		__start += __step;
 	}
-	return Vector(v, __l);
+	return vec;
 }
 
 
+// elements [begin, end) taken every step, without copying; end is clamped to the size and a step of
+// 0 gives an empty view
 template<class _T>
-auto Vector<_T>::Batch(size_type __b_size) noexcept {
-    size_type __b_count = this->vec_size / __b_size;
-    _T **v = new _T*[__b_count];
-
-    auto item  = this->Begin();
-    for (int i = 0; i < __b_count; i++) {
-        v[i] = new _T[__b_size];
-        for (int j = 0; j < __b_size; j++) {
-            v[i][j] = *item;
-            item++;
-        }
+constexpr auto Vector<_T>::Slice(size_type __begin, size_type __end, size_type __step) const & noexcept {
+    if (__step == 0) {
+        return VectorView<_T>();
     }
-    return Matrix2D(v, __b_count, __b_size);
+    __end = min(__end, this->vec_size);
+    __begin = min(__begin, __end);
+    return VectorView<_T>(this->_vec + __begin, slice_size(__begin, __end, __step), __step);
 }
 
 
+// the buffer read as rows of b_size elements, a trailing partial row is left out; empty for 0
 template<class _T>
-auto Vector<_T>::operator [] (int indx) const noexcept { return this->_vec[indx]; }
+constexpr auto Vector<_T>::Batch(size_type __b_size) const & noexcept {
+    if (__b_size == 0) {
+        return Matrix2DView<_T>();
+    }
+    size_type __b_count = this->vec_size / __b_size;
+    return Matrix2DView<_T>(this->_vec, __b_count, __b_size, __b_size, 1);
+}
 
 
 template<class _T>
-void Vector<_T>::operator = (const Vector<_T>& y) const noexcept {
-    this->_vec = y.Begin();
-    this->vec_size = y.Size();
-}
+auto Vector<_T>::operator [] (int indx) const noexcept { return this->_vec[indx]; }
 
 
 template<class _T>
-auto Vector<_T>::operator + (const Vector<_T>& y) const noexcept {
-    size_type __l = y.Size();
-    _T *v = new _T[__l];
+_T& Vector<_T>::operator [] (int indx) noexcept { return this->_vec[indx]; }
 
-    const_iterator ref_x = this->Begin();
-    const_iterator ref_y = y.Begin();
 
-    _T* ref_v = v;
-    while (ref_y != y.End()) {
-        *ref_v = (*ref_x + *ref_y);
-        ref_y++;
-        ref_x++;
-        ref_v++;
+template<class _T>
+Vector<_T>& Vector<_T>::operator = (const Vector<_T>& y) noexcept {
+    if (this != &y) {
+        if (this->vec_size != y.Size()) {
+            _T *__p = aligned_new_like<_T>(y.Size(), this->_vec);
+            aligned_delete(this->_vec);
+            this->_vec = __p;
+            this->vec_size = y.Size();
+        }
+        memcpy(this->_vec, y.Begin(), y.Size() * sizeof(_T));
     }
-    return Vector(v, __l);
+    return *this;
 }
 
 
+// an arena buffer only moves into a vector whose buffer is from the same arena, any other vector
+// (one created outside the ArenaScope, or empty) copies it into a buffer like the one it had
 template<class _T>
-auto Vector<_T>::operator + (const _T &y) const noexcept {
-    size_type __l = this->Size();
-    _T *v = new _T[__l];
-
-    const_iterator ref_x = this->Begin();
-
-    _T* ref_v = v;
-    while (ref_x != this->End()) {
-        *ref_v = (*ref_x + y);
-        ref_x++;
-        ref_v++;
+Vector<_T>& Vector<_T>::operator = (Vector<_T>&& y) noexcept {
+    MemoryArena *arena = memory_arena_of(y._vec);
+    if (arena != nullptr && arena != memory_arena_of(this->_vec)) {
+        return *this = static_cast<const Vector<_T>&>(y);
     }
-    return Vector(v, __l);
+    if (this != &y) {
+        aligned_delete(this->_vec);
+        this->_vec = y._vec;
+        this->vec_size = y.vec_size;
+        y._vec = nullptr;
+        y.vec_size = 0;
+    }
+    return *this;
 }
 
 
 template<class _T>
-auto Vector<_T>::operator - (const Vector<_T>& y) const noexcept {
-    size_type __l = y.Size();
-    _T *v = new _T[__l];
-
-    const_iterator ref_x = this->Begin();
-    const_iterator ref_y = y.Begin();
-
-    _T* ref_v = v;
-    while (ref_y != y.End()) {
-        *ref_v = (*ref_x - *ref_y);
-        ref_y++;
-        ref_x++;
-        ref_v++;
-    }
-    return Vector(v, __l);
+template<class _E>
+Vector<_T>& Vector<_T>::operator = (const VectorExpr<_E>& e) noexcept {
+    // evaluate into a fresh buffer first, the expression may still be reading this vector
+    return *this = Vector<_T>(e);
 }
 
 
+// Compound assignment ----------------------------------------------------------------
+// v[i] = op(v[i], x[i]) straight into the buffer; x may read this vector at the same index (v += v * 2)
+// but not at other ones, a shifted view of this vector would see elements already updated
 template<class _T>
-auto Vector<_T>::operator - (const _T &y) const noexcept {
-    size_type __l = this->Size();
-    _T *v = new _T[__l];
-
-    const_iterator ref_x = this->Begin();
-
-    _T* ref_v = v;
-    while (ref_x != this->End()) {
-        *ref_v = (*ref_x - y);
-        ref_x++;
-        ref_v++;
-    }
-    return Vector(v, __l);
+template<class _Op, class _E>
+Vector<_T>& Vector<_T>::update(const VectorExpr<_E> &e) noexcept {
+    _PROFILE_SCOPE("Vector::update", this->vec_size);
+    const _E &x = e.self();
+    _T *v = this->_vec;
+
+    ThreadPool::Global().ParallelFor(0, this->vec_size, 1, [&x, v](size_type lo, size_type hi) {
+        simd_for(lo, hi, [&x, v](size_type i) { v[i] = _Op()(v[i], x[i]); });
+    });
+    return *this;
 }
 
 
 template<class _T>
-auto Vector<_T>::operator * (const Vector<_T>& y) const noexcept {
-    size_type __l = y.Size();
-    _T *v = new _T[__l];
-
-    const_iterator ref_x = this->Begin();
-    const_iterator ref_y = y.Begin();
-
-    _T* ref_v = v;
-    while (ref_y != y.End()) {
-        *ref_v = (*ref_x * *ref_y);
-        ref_y++;
-        ref_x++;
-        ref_v++;
-    }
-    return Vector(v, __l);
+template<class _Op>
+Vector<_T>& Vector<_T>::update(const _T &y) noexcept {
+    _PROFILE_SCOPE("Vector::update", this->vec_size);
+    _T *v = this->_vec;
+
+    ThreadPool::Global().ParallelFor(0, this->vec_size, 1, [y, v](size_type lo, size_type hi) {
+        simd_for(lo, hi, [y, v](size_type i) { v[i] = _Op()(v[i], y); });
+    });
+    return *this;
 }
 
 
+// Serialization ----------------------------------------------------------------
 template<class _T>
-auto Vector<_T>::operator * (const _T &y) const noexcept {
-    size_type __l = this->Size();
-    _T *v = new _T[__l];
-
-    const_iterator ref_x = this->Begin();
-
-    _T* ref_v = v;
-    while (ref_x != this->End()) {
-        *ref_v = (*ref_x * y);
-        ref_x++;
-        ref_v++;
-    }
-    return Vector(v, __l);
+bool Vector<_T>::Save(ostream &out) const noexcept {
+    _PROFILE_SCOPE("Vector::Save", 0);
+    return serial_save(out, 1, 1, this->vec_size, this->vec_size, this->_vec);
 }
 
 
 template<class _T>
-auto Vector<_T>::operator / (const Vector<_T>& y) const noexcept {
-    size_type __l = y.Size();
-    _T *v = new _T[__l];
+bool Vector<_T>::Save(const string &__path) const noexcept {
+    ofstream out(__path, ios::binary | ios::trunc);
+    return this->Save(out);
+}
 
-    const_iterator ref_x = this->Begin();
-    const_iterator ref_y = y.Begin();
 
-    _T* ref_v = v;
-    while (ref_y != y.End()) {
-        *ref_v = (*ref_x / *ref_y);
-        ref_y++;
-        ref_x++;
-        ref_v++;
-    }
-    return Vector(v, __l);
+template<class _T>
+auto Vector<_T>::Load(istream &in) noexcept {
+    _PROFILE_SCOPE("Vector::Load", 0);
+    Vector<_T> vec;
+    bool ok = serial_load<_T>(in, 1, [&vec](size_type, size_type __c) {
+        vec = Vector::allocate(__c);
+        return vec.Begin();
+    });
+    return ok ? move(vec) : Vector<_T>();
 }
 
 
 template<class _T>
-auto Vector<_T>::operator / (const _T &y) const noexcept {
-    size_type __l = this->Size();
-    _T *v = new _T[__l];
+auto Vector<_T>::Load(const string &__path) noexcept {
+    ifstream in(__path, ios::binary);
+    return Vector::Load(in);
+}
 
-    const_iterator ref_x = this->Begin();
 
-    _T* ref_v = v;
-    while (ref_x != this->End()) {
-        *ref_v = (*ref_x / y);
-        ref_x++;
-        ref_v++;
+template<class _T>
+auto Vector<_T>::Map(const string &__path, bool __verify) noexcept {
+    _PROFILE_SCOPE("Vector::Map", 0);
+    Vector<_T> vec;
+    SerialHeader h;
+    if (_T *p = serial_map<_T>(__path, 1, h, __verify)) {
+        vec._vec = p;
+        vec.vec_size = size_type(h.col);
     }
-    return Vector(v, __l);
+    return vec;
 }
+
 #endif // !_VECTOR_H_
@@ -0,0 +1,111 @@
+#ifndef _VIEW_H_
+#define _VIEW_H_
+
+/*  -   -   -   -   -   -   -   -   -   -   -   */
+template<class _T>
+class Matrix2D;
+template<class _E>
+class VectorExpr;
+template<class _E>
+class Matrix2DExpr;
+/*  -   -   -   -   -   -   -   -   -   -   -   */
+
+#include <cstddef>
+
+using namespace std;
+
+// A view reads the buffer of a Vector or Matrix2D in place, it owns nothing and must not outlive the
+// container it was taken from. Element i of a VectorView lives at _vec[i * _step], element (i, j) of
+// a Matrix2DView at _mat[i * _row_stride + j * _col_stride]: slices, rows, columns, blocks and
+// transposes are all the same buffer read with other strides. Views are expressions, so the
+// reductions and operators of Vector and Matrix2D take them as they are, and Matrix2D::operator*
+// hands the strides of a Matrix2DView straight to gemm.
+
+template<class _T>
+class VectorView : public VectorExpr<VectorView<_T>> {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        typedef const _T* const_iterator;
+
+    private:
+        const_iterator _vec = nullptr;
+        size_type vec_size = 0;
+        size_type _step = 0;
+
+    public:
+        constexpr VectorView() noexcept = default;
+        constexpr VectorView(const_iterator __vec, size_type __l, size_type __step = 1) noexcept
+            : _vec(__vec), vec_size(__l), _step(__step) {}
+
+        constexpr const_iterator Begin() const noexcept { return this->_vec; }
+        constexpr size_type Size() const noexcept { return this->vec_size; }
+        constexpr size_type Step() const noexcept { return this->_step; }
+
+        constexpr auto Slice(size_type, size_type, size_type __step = 1) const noexcept;
+
+        constexpr _T operator [] (size_type i) const noexcept { return this->_vec[i * this->_step]; }
+};
+
+
+// number of elements of [begin, end) taken every step
+constexpr size_t slice_size(size_t __begin, size_t __end, size_t __step) noexcept {
+    return __end > __begin ? (__end - __begin + __step - 1) / __step : 0;
+}
+
+
+// end is clamped to the size, like TensorView::Slice; a step of 0 gives an empty view
+template<class _T>
+constexpr auto VectorView<_T>::Slice(size_type __begin, size_type __end, size_type __step) const noexcept {
+    if (__step == 0) {
+        return VectorView<_T>();
+    }
+    __end = min(__end, this->vec_size);
+    __begin = min(__begin, __end);
+    return VectorView<_T>(this->_vec + __begin * this->_step, slice_size(__begin, __end, __step), this->_step * __step);
+}
+
+
+template<class _T>
+class Matrix2DView : public Matrix2DExpr<Matrix2DView<_T>> {
+    public:
+        typedef _T value_type;
+        typedef size_t size_type;
+        typedef const _T* const_iterator;
+
+    private:
+        const_iterator _mat = nullptr;
+        size_type _row = 0;
+        size_type _col = 0;
+        size_type _row_stride = 0;
+        size_type _col_stride = 0;
+
+    public:
+        constexpr Matrix2DView() noexcept = default;
+        constexpr Matrix2DView(const_iterator __mat, size_type __r, size_type __c, size_type __rs, size_type __cs) noexcept
+            : _mat(__mat), _row(__r), _col(__c), _row_stride(__rs), _col_stride(__cs) {}
+
+        constexpr const_iterator Begin() const noexcept { return this->_mat; }
+        constexpr size_type Row() const noexcept { return this->_row; }
+        constexpr size_type Col() const noexcept { return this->_col; }
+        constexpr size_type RowStride() const noexcept { return this->_row_stride; }
+        constexpr size_type ColStride() const noexcept { return this->_col_stride; }
+
+        constexpr auto T() const noexcept { return Matrix2DView<_T>(this->_mat, this->_col, this->_row, this->_col_stride, this->_row_stride); }
+        constexpr auto Row(size_type i) const noexcept { return VectorView<_T>(this->_mat + i * this->_row_stride, this->_col, this->_col_stride); }
+        constexpr auto Column(size_type j) const noexcept { return VectorView<_T>(this->_mat + j * this->_col_stride, this->_row, this->_row_stride); }
+        // clamped to the view, like Matrix2D::Block
+        constexpr auto Block(size_type __r0, size_type __c0, size_type __r, size_type __c) const noexcept {
+            __r0 = min(__r0, this->_row);
+            __c0 = min(__c0, this->_col);
+            __r = min(__r, this->_row - __r0);
+            __c = min(__c, this->_col - __c0);
+            return Matrix2DView<_T>(this->_mat + __r0 * this->_row_stride + __c0 * this->_col_stride, __r, __c, this->_row_stride, this->_col_stride);
+        }
+
+        constexpr _T operator () (size_type i, size_type j) const noexcept {
+            return this->_mat[i * this->_row_stride + j * this->_col_stride];
+        }
+};
+
+#endif // !_VIEW_H_
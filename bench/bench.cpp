@@ -0,0 +1,322 @@
+#include <string>
+#include <benchmark/benchmark.h>
+
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+
+using namespace std;
+
+// Microbenchmarks of the Vector and Matrix2D hot paths. Every benchmark reports the bytes it moves
+// (bytes_per_second) and, where it computes, its floating point operations (FLOPS, 1000 based);
+// inputs are seeded so every run measures the same data. Run with
+//   bench --benchmark_out=bench.json --benchmark_out_format=json
+// or the bench_baseline / bench_compare targets to record a baseline on this machine and check later
+// runs against it.
+
+typedef float real;
+
+constexpr uint64_t BENCH_SEED = 42;
+
+
+void report(benchmark::State &state, double __bytes, double __flops = 0) {
+    state.SetBytesProcessed(int64_t(__bytes * double(state.iterations())));
+    if (__flops > 0) {
+        state.counters["FLOPS"] = benchmark::Counter(__flops, benchmark::Counter::kIsIterationInvariantRate,
+                                                     benchmark::Counter::kIs1000);
+    }
+}
+
+
+// GEMM ----------------------------------------------------------------
+// C (m x n) = A (m x k) * B (k x n)
+void BM_Gemm(benchmark::State &state) {
+    size_t __m = state.range(0), __n = state.range(1), __k = state.range(2);
+    auto a = Matrix2D<real>::RandomInit(__m, __k, BENCH_SEED);
+    auto b = Matrix2D<real>::RandomInit(__k, __n, BENCH_SEED + 1);
+
+    for (auto _ : state) {
+        Matrix2D<real> c = a * b;
+        benchmark::DoNotOptimize(c.Begin());
+    }
+    report(state, double(__m * __k + __k * __n + __m * __n) * sizeof(real), 2.0 * __m * __n * __k);
+}
+BENCHMARK(BM_Gemm)->ArgNames({"m", "n", "k"})
+    ->Args({64, 64, 64})->Args({256, 256, 256})->Args({512, 512, 512})->Args({1024, 1024, 1024})
+    ->Args({4096, 64, 64})->Args({64, 4096, 64})->Args({64, 64, 4096})->Args({1, 1024, 1024})
+    ->Unit(benchmark::kMicrosecond);
+
+
+// A^T * B, gemm reads the transposed operand through its strides
+void BM_GemmTransposed(benchmark::State &state) {
+    size_t __n = state.range(0);
+    auto a = Matrix2D<real>::RandomInit(__n, __n, BENCH_SEED);
+    auto b = Matrix2D<real>::RandomInit(__n, __n, BENCH_SEED + 1);
+
+    for (auto _ : state) {
+        Matrix2D<real> c = a.T() * b;
+        benchmark::DoNotOptimize(c.Begin());
+    }
+    report(state, 3.0 * __n * __n * sizeof(real), 2.0 * __n * __n * __n);
+}
+BENCHMARK(BM_GemmTransposed)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+
+// GEMV and dot ----------------------------------------------------------------
+void BM_MatVec(benchmark::State &state) {
+    size_t __r = state.range(0), __c = state.range(1);
+    auto a = Matrix2D<real>::RandomInit(__r, __c, BENCH_SEED);
+    auto x = Vector<real>::RandomInit(__c, BENCH_SEED + 1);
+
+    for (auto _ : state) {
+        auto y = a.MatVec(x);
+        benchmark::DoNotOptimize(y.Begin());
+    }
+    report(state, double(__r * __c + __r + __c) * sizeof(real), 2.0 * __r * __c);
+}
+BENCHMARK(BM_MatVec)->ArgNames({"rows", "cols"})->Args({4096, 4096})->Args({100000, 128})->Unit(benchmark::kMicrosecond);
+
+
+void BM_MatVecT(benchmark::State &state) {
+    size_t __r = state.range(0), __c = state.range(1);
+    auto a = Matrix2D<real>::RandomInit(__r, __c, BENCH_SEED);
+    auto x = Vector<real>::RandomInit(__r, BENCH_SEED + 1);
+
+    for (auto _ : state) {
+        auto y = a.MatVecT(x);
+        benchmark::DoNotOptimize(y.Begin());
+    }
+    report(state, double(__r * __c + __r + __c) * sizeof(real), 2.0 * __r * __c);
+}
+BENCHMARK(BM_MatVecT)->ArgNames({"rows", "cols"})->Args({4096, 4096})->Args({100000, 128})->Unit(benchmark::kMicrosecond);
+
+
+void BM_Dot(benchmark::State &state) {
+    size_t __n = state.range(0);
+    auto x = Vector<real>::RandomInit(__n, BENCH_SEED);
+    auto y = Vector<real>::RandomInit(__n, BENCH_SEED + 1);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x.Dot(y));
+    }
+    report(state, 2.0 * __n * sizeof(real), 2.0 * __n);
+}
+BENCHMARK(BM_Dot)->Arg(1 << 10)->Arg(1 << 20);
+
+
+// Reductions ----------------------------------------------------------------
+template<Axis2D _Axis>
+void BM_Mean(benchmark::State &state) {
+    size_t __r = state.range(0), __c = state.range(1);
+    auto m = Matrix2D<real>::RandomInit(__r, __c, BENCH_SEED);
+
+    for (auto _ : state) {
+        auto mean = m.Mean(_Axis);
+        benchmark::DoNotOptimize(mean.Begin());
+    }
+    report(state, double(__r * __c) * sizeof(real), double(__r * __c));
+}
+BENCHMARK_TEMPLATE(BM_Mean, Axis2D::COL)->ArgNames({"rows", "cols"})->Args({4096, 1024})->Args({1000000, 16})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_Mean, Axis2D::ROW)->ArgNames({"rows", "cols"})->Args({4096, 1024})->Unit(benchmark::kMicrosecond);
+
+
+template<Axis2D _Axis>
+void BM_STD(benchmark::State &state) {
+    size_t __r = state.range(0), __c = state.range(1);
+    auto m = Matrix2D<real>::RandomInit(__r, __c, BENCH_SEED);
+
+    for (auto _ : state) {
+        auto dev = m.STD(_Axis);
+        benchmark::DoNotOptimize(dev.Begin());
+    }
+    report(state, double(__r * __c) * sizeof(real), 3.0 * __r * __c);
+}
+BENCHMARK_TEMPLATE(BM_STD, Axis2D::COL)->ArgNames({"rows", "cols"})->Args({4096, 1024})->Unit(benchmark::kMicrosecond);
+
+
+template<Axis2D _Axis>
+void BM_Max(benchmark::State &state) {
+    size_t __r = state.range(0), __c = state.range(1);
+    auto m = Matrix2D<real>::RandomInit(__r, __c, BENCH_SEED);
+
+    for (auto _ : state) {
+        auto top = m.Max(_Axis);
+        benchmark::DoNotOptimize(top.Begin());
+    }
+    report(state, double(__r * __c) * sizeof(real));
+}
+BENCHMARK_TEMPLATE(BM_Max, Axis2D::COL)->ArgNames({"rows", "cols"})->Args({4096, 1024})->Unit(benchmark::kMicrosecond);
+
+
+void BM_VectorReduce(benchmark::State &state) {
+    size_t __n = state.range(0);
+    auto v = Vector<real>::RandomInit(__n, BENCH_SEED);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(v.Mean());
+        benchmark::DoNotOptimize(v.Max());
+        benchmark::DoNotOptimize(v.Argmax());
+    }
+    report(state, 3.0 * __n * sizeof(real));
+}
+BENCHMARK(BM_VectorReduce)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+
+
+// Element-wise ----------------------------------------------------------------
+// one fused pass over three inputs into a new vector
+void BM_VectorExpression(benchmark::State &state) {
+    size_t __n = state.range(0);
+    auto a = Vector<real>::RandomInit(__n, BENCH_SEED);
+    auto b = Vector<real>::RandomInit(__n, BENCH_SEED + 1);
+    auto c = Vector<real>::RandomInit(__n, BENCH_SEED + 2);
+
+    for (auto _ : state) {
+        Vector<real> r = a + b * c;
+        benchmark::DoNotOptimize(r.Begin());
+    }
+    report(state, 4.0 * __n * sizeof(real), 2.0 * __n);
+}
+BENCHMARK(BM_VectorExpression)->Arg(1 << 12)->Arg(1 << 22)->Unit(benchmark::kMicrosecond);
+
+
+void BM_MatrixExpression(benchmark::State &state) {
+    size_t __n = state.range(0);
+    auto a = Matrix2D<real>::RandomInit(__n, __n, BENCH_SEED);
+    auto b = Matrix2D<real>::RandomInit(__n, __n, BENCH_SEED + 1);
+
+    for (auto _ : state) {
+        Matrix2D<real> r = a * real(2) - b;
+        benchmark::DoNotOptimize(r.Begin());
+    }
+    report(state, 3.0 * __n * __n * sizeof(real), 2.0 * __n * __n);
+}
+BENCHMARK(BM_MatrixExpression)->Arg(256)->Arg(2048)->Unit(benchmark::kMicrosecond);
+
+
+// every row minus a vector, in place
+void BM_MatrixBroadcastUpdate(benchmark::State &state) {
+    size_t __n = state.range(0);
+    auto m = Matrix2D<real>::RandomInit(__n, __n, BENCH_SEED);
+    auto v = Vector<real>::RandomInit(__n, BENCH_SEED + 1);
+
+    for (auto _ : state) {
+        m -= v;
+        benchmark::DoNotOptimize(m.Begin());
+    }
+    report(state, 2.0 * __n * __n * sizeof(real), double(__n * __n));
+}
+BENCHMARK(BM_MatrixBroadcastUpdate)->Arg(2048)->Unit(benchmark::kMicrosecond);
+
+
+// Layout ----------------------------------------------------------------
+void BM_TransposeCopy(benchmark::State &state) {
+    size_t __r = state.range(0), __c = state.range(1);
+    auto m = Matrix2D<real>::RandomInit(__r, __c, BENCH_SEED);
+
+    for (auto _ : state) {
+        Matrix2D<real> t = m.T();
+        benchmark::DoNotOptimize(t.Begin());
+    }
+    report(state, 2.0 * __r * __c * sizeof(real));
+}
+BENCHMARK(BM_TransposeCopy)->ArgNames({"rows", "cols"})->Args({2048, 2048})->Args({100000, 16})->Unit(benchmark::kMicrosecond);
+
+
+void BM_TransposeInPlace(benchmark::State &state) {
+    size_t __n = state.range(0);
+    auto m = Matrix2D<real>::RandomInit(__n, __n, BENCH_SEED);
+
+    for (auto _ : state) {
+        m.Transpose();
+        benchmark::DoNotOptimize(m.Begin());
+    }
+    report(state, 2.0 * __n * __n * sizeof(real));
+}
+BENCHMARK(BM_TransposeInPlace)->Arg(2048)->Unit(benchmark::kMicrosecond);
+
+
+// Batch is a view, copying it into a matrix is what costs
+void BM_Batch(benchmark::State &state) {
+    size_t __n = state.range(0), __b = state.range(1);
+    auto v = Vector<real>::RandomInit(__n, BENCH_SEED);
+
+    for (auto _ : state) {
+        Matrix2D<real> m = v.Batch(__b);
+        benchmark::DoNotOptimize(m.Begin());
+    }
+    report(state, 2.0 * __n * sizeof(real));
+}
+BENCHMARK(BM_Batch)->ArgNames({"size", "batch"})->Args({1 << 22, 64})->Unit(benchmark::kMicrosecond);
+
+
+// Random ----------------------------------------------------------------
+void BM_RandomInit(benchmark::State &state) {
+    size_t __n = state.range(0);
+
+    for (auto _ : state) {
+        auto v = Vector<real>::RandomInit(__n, BENCH_SEED);
+        benchmark::DoNotOptimize(v.Begin());
+    }
+    report(state, double(__n) * sizeof(real));
+}
+BENCHMARK(BM_RandomInit)->Arg(1 << 22)->Unit(benchmark::kMicrosecond);
+
+
+void BM_NormalInit(benchmark::State &state) {
+    size_t __n = state.range(0);
+
+    for (auto _ : state) {
+        auto v = Vector<real>::NormalInit(__n, real(0), real(1), BENCH_SEED);
+        benchmark::DoNotOptimize(v.Begin());
+    }
+    report(state, double(__n) * sizeof(real));
+}
+BENCHMARK(BM_NormalInit)->Arg(1 << 22)->Unit(benchmark::kMicrosecond);
+
+
+// Allocation ----------------------------------------------------------------
+// the normalization of main.cpp, every statement materializes a new container
+void BM_NormalizeChain(benchmark::State &state) {
+    size_t __r = state.range(0), __c = state.range(1);
+    auto m = Matrix2D<real>::RandomInit(__r, __c, BENCH_SEED);
+
+    for (auto _ : state) {
+        Vector<real> mean = m.Mean(Axis2D::COL);
+        Vector<real> dev = m.STD(Axis2D::COL);
+        Matrix2D<real> centered = m - mean;
+        Matrix2D<real> r = centered / dev;
+        benchmark::DoNotOptimize(r.Begin());
+    }
+    report(state, 6.0 * __r * __c * sizeof(real));
+}
+BENCHMARK(BM_NormalizeChain)->ArgNames({"rows", "cols"})->Args({64, 64})->Args({4096, 256})->Unit(benchmark::kMicrosecond);
+
+
+// many short lived small vectors, dominated by allocation
+void BM_SmallVectorChain(benchmark::State &state) {
+    size_t __n = state.range(0);
+    auto a = Vector<real>::RandomInit(__n, BENCH_SEED);
+    auto b = Vector<real>::RandomInit(__n, BENCH_SEED + 1);
+
+    for (auto _ : state) {
+        Vector<real> s = a + b;
+        Vector<real> p = s * a;
+        Vector<real> r = (p - b) / real(2);
+        benchmark::DoNotOptimize(r.Begin());
+    }
+    report(state, 7.0 * __n * sizeof(real), 4.0 * __n);
+}
+BENCHMARK(BM_SmallVectorChain)->Arg(16)->Arg(256);
+
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    const char *levels[] = {"scalar", "base", "avx2", "avx512"};
+    benchmark::AddCustomContext("pool_threads", to_string(ThreadPool::Global().Size()));
+    benchmark::AddCustomContext("simd_level", levels[int(simd_level())]);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Compares two Google Benchmark JSON files benchmark by benchmark.
+
+    compare.py baseline.json current.json [--tolerance 0.10]
+
+Prints the real time of every benchmark in both files and the relative change, and exits with 1
+when any of them got slower than the baseline by more than the tolerance. Benchmarks missing from
+one of the files are listed but do not fail the comparison. Timings are only comparable on the
+machine that recorded the baseline: a missing baseline, or one from another host or CPU count,
+exits with 2 unless --any-machine is given.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    # with repetitions only the mean aggregate is compared
+    runs = {}
+    for b in data.get("benchmarks", []):
+        if b.get("run_type") == "aggregate" and b.get("aggregate_name") != "mean":
+            continue
+        if b.get("error_occurred"):
+            continue
+        runs[b.get("run_name", b["name"])] = b
+    return data.get("context", {}), runs
+
+
+def nanoseconds(b):
+    scale = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}[b.get("time_unit", "ns")]
+    return b["real_time"] * scale
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--tolerance", type=float, default=0.10,
+                        help="relative slowdown reported as a regression (default 0.10)")
+    parser.add_argument("--any-machine", action="store_true",
+                        help="compare even when the baseline was recorded on another machine")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.baseline):
+        print("no baseline at %s, record one on this machine with the bench_baseline target" % args.baseline)
+        return 2
+    base_context, base = load(args.baseline)
+    context, current = load(args.current)
+    other = False
+    for key in ("host_name", "num_cpus", "pool_threads", "simd_level"):
+        if base_context.get(key) != context.get(key):
+            print("note: %s differs, baseline %s, current %s" % (key, base_context.get(key), context.get(key)))
+            other |= key in ("host_name", "num_cpus")
+    if other and not args.any_machine:
+        print("the baseline comes from another machine, record one here with the bench_baseline target")
+        return 2
+
+    width = max([len(name) for name in list(base) + list(current)] + [9])
+    print("%-*s %14s %14s %9s" % (width, "benchmark", "baseline ns", "current ns", "change"))
+    regressions = []
+    for name in sorted(set(base) | set(current), key=lambda n: (n not in base, n)):
+        if name not in current or name not in base:
+            where = "baseline" if name in base else "current"
+            print("%-*s %s" % (width, name, "only in " + where))
+            continue
+        before, after = nanoseconds(base[name]), nanoseconds(current[name])
+        change = after / before - 1.0 if before > 0 else 0.0
+        flag = ""
+        if change > args.tolerance:
+            regressions.append(name)
+            flag = "  REGRESSION"
+        print("%-*s %14.0f %14.0f %+8.1f%%%s" % (width, name, before, after, 100.0 * change, flag))
+
+    if regressions:
+        print("%d of %d benchmarks regressed by more than %.0f%%" % (len(regressions), len(current), 100.0 * args.tolerance))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,67 @@
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+// The assertions of the ctest executables: a failed check prints where it is and what it compared and
+// the run goes on, main returns check_result() so ctest sees the failure. Results are compared with
+// naive references written out in each test, with a relative tolerance where the library sums in a
+// different order.
+
+inline int& check_failures() noexcept {
+    static int __failures = 0;
+    return __failures;
+}
+
+
+inline bool check_true(bool __ok, const char *__what, const char *__file, int __line) noexcept {
+    if (!__ok) {
+        check_failures()++;
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __file, __line, __what);
+    }
+    return __ok;
+}
+
+
+// |a - b| <= tol * max(1, |b|); two NaN compare equal
+inline bool check_near(double a, double b, double __tol, const char *__a, const char *__b, const char *__file, int __line) noexcept {
+    bool __ok = (std::isnan(a) && std::isnan(b)) || fabs(a - b) <= __tol * max(1.0, fabs(b));
+    if (!__ok) {
+        check_failures()++;
+        fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %.17g vs %.17g, tolerance %g\n", __file, __line, __a, __b, a, b, __tol);
+    }
+    return __ok;
+}
+
+
+#define CHECK(cond) check_true(bool(cond), #cond, __FILE__, __LINE__)
+#define CHECK_NEAR(a, b, tol) check_near(double(a), double(b), double(tol), #a, #b, __FILE__, __LINE__)
+
+
+// f once per thread count, with a small serial threshold so that even the small inputs of the tests
+// are split over the pool
+inline void check_threads(const function<void()> &f, initializer_list<size_t> __threads = {1, 4}) noexcept {
+    for (size_t __n : __threads) {
+        ThreadPool::SetThreadCount(__n);
+        ThreadPool::Global().SetSerialThreshold(1 << 10);
+        f();
+    }
+}
+
+
+inline int check_result() noexcept {
+    if (check_failures() != 0) {
+        fprintf(stderr, "%d check(s) failed\n", check_failures());
+    }
+    return check_failures() != 0;
+}
+
+#endif // !_CHECK_H_
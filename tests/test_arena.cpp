@@ -0,0 +1,102 @@
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// containers created inside an ArenaScope take arena buffers and all of them are released when the
+// scope ends; a container from outside that is assigned inside (the w = w - g * 0.1f of a training
+// step) must not pick one up, or it would read freed memory once the arena is reset
+
+
+void check_outer_assignment() {
+    MemoryArena arena;
+    auto w = Vector<float>::RandomInit(1000, 41);
+    auto m = Matrix2D<float>::RandomInit(40, 30, 42);
+    auto w0 = w;
+    auto m0 = m;
+
+    for (int __step = 0; __step < 3; __step++) {
+        ArenaScope scope(arena);
+        auto g = Vector<float>::RandomInit(1000, 43);
+        auto h = Matrix2D<float>::RandomInit(40, 30, 44);
+        CHECK(memory_arena_of(g.Begin()) == &arena && memory_arena_of(h.Begin()) == &arena);
+
+        w = w - g * 0.1f;
+        m = m - h * 0.1f;
+        auto tmp = Vector<float>(w * 2.f);
+        w = move(tmp);
+        w = w * 0.5f;
+        CHECK(memory_arena_of(w.Begin()) == nullptr && memory_arena_of(m.Begin()) == nullptr);
+    }
+    CHECK(arena.Live() == 0);
+
+    // the arena has been reset and its blocks reused, w and m must still hold their values
+    auto g = Vector<float>::RandomInit(1000, 43);
+    auto h = Matrix2D<float>::RandomInit(40, 30, 44);
+    for (size_t i = 0; i < 1000; i++) {
+        float __v = w0[i];
+        for (int __step = 0; __step < 3; __step++) {
+            __v = (__v - g[i] * 0.1f) * 2.f * 0.5f;
+        }
+        CHECK_NEAR(w[i], __v, 1e-5);
+    }
+    for (size_t i = 0; i < 40; i++) {
+        for (size_t j = 0; j < 30; j++) {
+            CHECK_NEAR(m(i, j), m0(i, j) - 3 * (h(i, j) * 0.1f), 1e-5);
+        }
+    }
+}
+
+
+void check_inner_containers() {
+    MemoryArena arena;
+    size_t __capacity = 0;
+
+    for (int __round = 0; __round < 4; __round++) {
+        ArenaScope scope(arena);
+        auto x = Vector<double>::RandomInit(5000, 45);
+        Vector<double> y = (x - x.Mean()) / x.STD();
+        auto z = y;
+        z = move(y);     // z steals the buffer of y and frees its own
+        CHECK(memory_arena_of(z.Begin()) == &arena);
+        CHECK(arena.Live() == 2);
+        CHECK_NEAR(z.Mean(), 0, 1e-12);
+        CHECK_NEAR(z.STD(), 1, 1e-12);
+
+        // the same work every round fits in the blocks of the first one
+        if (__round == 0) {
+            __capacity = arena.Capacity();
+        }
+        CHECK(arena.Capacity() == __capacity);
+    }
+    CHECK(arena.Live() == 0);
+
+    // outside any scope nothing comes from an arena
+    CHECK(ArenaScope::Active() == nullptr);
+    auto v = Vector<double>::RandomInit(10, 46);
+    CHECK(memory_arena_of(v.Begin()) == nullptr);
+}
+
+
+void check_nested() {
+    MemoryArena outer, inner;
+    ArenaScope a(outer);
+    auto x = Vector<float>::RandomInit(100, 47);
+    {
+        ArenaScope b(inner);
+        auto y = Vector<float>::RandomInit(100, 48);
+        CHECK(ArenaScope::Active() == &inner && memory_arena_of(y.Begin()) == &inner);
+        x = x + y;
+        CHECK(memory_arena_of(x.Begin()) == &outer);
+    }
+    CHECK(ArenaScope::Active() == &outer && inner.Live() == 0 && outer.Live() == 1);
+}
+
+
+int main() {
+    check_threads([] {
+        check_outer_assignment();
+        check_inner_containers();
+        check_nested();
+    });
+    return check_result();
+}
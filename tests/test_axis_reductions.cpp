@@ -0,0 +1,105 @@
+#include <vector>
+
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// Mean / STD / Min / Max / Argmax along each axis against loops over the matrix, on a shape that is
+// not a multiple of the column blocks, and the empty matrices that must give zeros rather than NaN
+
+
+template<class _M, class _V>
+void check_axis(const _M &m, Axis2D axis, size_t __lines, size_t __len, _V at) {
+    auto mean = m.Mean(axis);
+    auto sd = m.STD(axis);
+    auto mn = m.Min(axis);
+    auto mx = m.Max(axis);
+    auto am = m.Argmax(axis);
+    CHECK(mean.Size() == __lines && sd.Size() == __lines && mn.Size() == __lines);
+    CHECK(mx.Size() == __lines && am.Size() == __lines);
+
+    for (size_t l = 0; l < __lines; l++) {
+        double __s = 0, __lo = at(l, 0), __hi = at(l, 0);
+        size_t __arg = 0;
+        for (size_t k = 0; k < __len; k++) {
+            __s += at(l, k);
+            __lo = min(__lo, at(l, k));
+            if (at(l, k) > __hi) {
+                __hi = at(l, k);
+                __arg = k;
+            }
+        }
+        double __mean = __s / __len, __v = 0;
+        for (size_t k = 0; k < __len; k++) {
+            __v += (at(l, k) - __mean) * (at(l, k) - __mean);
+        }
+        CHECK_NEAR(mean[l], __mean, 1e-12);
+        CHECK_NEAR(sd[l], sqrt(__v / __len), 1e-12);
+        CHECK(mn[l] == __lo && mx[l] == __hi && am[l] == __arg);
+    }
+}
+
+
+void check_axes() {
+    size_t __r = 517, __c = 37;
+    auto m = Matrix2D<double>::NormalInit(__r, __c, 1., 3., 11);
+
+    check_axis(m, Axis2D::COL, __c, __r, [&m](size_t j, size_t i) { return m(i, j); });
+    check_axis(m, Axis2D::ROW, __r, __c, [&m](size_t i, size_t j) { return m(i, j); });
+    check_axis(m, Axis2D::ALL, 1, __r * __c, [&m, __c](size_t, size_t k) { return m(k / __c, k % __c); });
+
+    // a block view reads with the stride of its parent
+    auto v = m.Block(3, 1, 200, 20);
+    check_axis(v, Axis2D::COL, 20, 200, [&m](size_t j, size_t i) { return m(i + 3, j + 1); });
+    check_axis(v, Axis2D::ROW, 200, 20, [&m](size_t i, size_t j) { return m(i + 3, j + 1); });
+}
+
+
+void check_empty() {
+    auto rows = Matrix2D<double>::ZeroInit(0, 5);
+    auto mean = rows.Mean(Axis2D::COL);
+    auto sd = rows.STD(Axis2D::COL);
+    CHECK(mean.Size() == 5 && sd.Size() == 5);
+    for (size_t j = 0; j < 5; j++) {
+        CHECK(mean[j] == 0 && sd[j] == 0);
+    }
+    CHECK(rows.Mean(Axis2D::ROW).Size() == 0);
+    CHECK(rows.Mean(Axis2D::ALL)[0] == 0);
+    CHECK(rows.Max(Axis2D::ALL)[0] == 0 && rows.Min(Axis2D::ALL)[0] == 0);
+
+    auto cols = Matrix2D<double>::ZeroInit(4, 0);
+    CHECK(cols.Mean(Axis2D::COL).Size() == 0);
+    auto rmean = cols.Mean(Axis2D::ROW);
+    CHECK(rmean.Size() == 4);
+    for (size_t i = 0; i < 4; i++) {
+        CHECK(rmean[i] == 0);
+    }
+}
+
+
+// a float matrix far from zero: the whole-matrix mean sums in double like Vector::Mean,
+// where a float sum drifts by many units in the last place
+void check_float_mean() {
+    auto m = Matrix2D<float>::RandomInit(2000, 1500, 35);
+    m += 1000.f;
+    double __sum = 0;
+    auto flat = Vector<float>::ZeroInit(m.Row() * m.Col());
+    for (size_t i = 0; i < m.Row(); i++) {
+        for (size_t j = 0; j < m.Col(); j++) {
+            __sum += m(i, j);
+            flat[i * m.Col() + j] = m(i, j);
+        }
+    }
+    float __mean = float(__sum / (m.Row() * m.Col()));
+    CHECK_NEAR(m.Mean(Axis2D::ALL)[0], __mean, 1e-7);
+    CHECK_NEAR(m.Mean(Axis2D::ALL)[0], flat.Mean(), 1e-7);
+}
+
+
+int main() {
+    check_threads([] {
+        check_axes();
+        check_empty();
+        check_float_mean();
+    });
+    return check_result();
+}
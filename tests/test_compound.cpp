@@ -0,0 +1,120 @@
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// +=, -=, *= and /= against the element-wise loop, with vectors, scalars, expressions and views on
+// the right, the right-hand side reading the left one at the same position, and the buffer of the
+// left-hand side kept
+
+
+void check_vector() {
+    for (size_t __n : {1, 15, 16, 17, 4099}) {
+        auto x = Vector<double>::RandomInit(__n, 31);
+        auto y = Vector<double>::RandomInit(__n, 32);
+        y += 0.5;
+        auto z = x;
+        const double *__p = z.Begin();
+
+        z += y;
+        z -= y * 0.25;
+        z *= y;
+        z /= y + 1.0;
+        z += 3.0;
+        z -= 1.0;
+        z *= 2.0;
+        z /= 4.0;
+        z += z;
+        CHECK(z.Begin() == __p && z.Size() == __n);
+        for (size_t i = 0; i < __n; i++) {
+            double __v = (x[i] + y[i] - y[i] * 0.25) * y[i] / (y[i] + 1.0);
+            __v = (__v + 3.0 - 1.0) * 2.0 / 4.0;
+            CHECK_NEAR(z[i], __v + __v, 1e-12);
+        }
+    }
+
+    // a strided view on the right
+    auto x = Vector<float>::RandomInit(200, 33);
+    auto z = Vector<float>::ZeroInit(100);
+    z += x.Slice(0, 200, 2);
+    z -= x.Slice(1, 200, 2);
+    for (size_t i = 0; i < 100; i++) {
+        CHECK(z[i] == 0.f + x[2 * i] - x[2 * i + 1]);
+    }
+}
+
+
+void check_matrix() {
+    size_t __r = 67, __c = 41;
+    auto a = Matrix2D<double>::RandomInit(__r, __c, 34);
+    auto b = Matrix2D<double>::RandomInit(__r, __c, 35);
+    b += 0.5;
+    auto w = Vector<double>::RandomInit(__c, 36);
+    w += 0.5;
+    Vector<double> one = {2.0};
+
+    auto m = a;
+    const double *__p = m.Begin();
+    m += b;
+    m -= b * 0.5;
+    m /= b;
+    m += w;
+    m *= w;
+    m -= w * 0.5;
+    m /= w;
+    m *= one;
+    m += 1.0;
+    m -= 0.5;
+    m *= 3.0;
+    m /= 2.0;
+    m += m;
+    CHECK(m.Begin() == __p && m.Row() == __r && m.Col() == __c);
+    for (size_t i = 0; i < __r; i++) {
+        for (size_t j = 0; j < __c; j++) {
+            double __v = (a(i, j) + b(i, j) - b(i, j) * 0.5) / b(i, j);
+            __v = ((__v + w[j]) * w[j] - w[j] * 0.5) / w[j] * 2.0;
+            __v = (__v + 1.0 - 0.5) * 3.0 / 2.0;
+            CHECK_NEAR(m(i, j), __v + __v, 1e-12);
+        }
+    }
+
+    // a block view of another matrix and the transpose of a square one
+    auto big = Matrix2D<double>::RandomInit(100, 100, 37);
+    auto s = a;
+    s -= big.Block(10, 20, __r, __c);
+    auto q = big.Block(0, 0, __c, __c);
+    auto sq = Matrix2D<double>(q);
+    sq += big.Block(50, 50, __c, __c).T();
+    for (size_t i = 0; i < __r; i++) {
+        for (size_t j = 0; j < __c; j++) {
+            CHECK(s(i, j) == a(i, j) - big(10 + i, 20 + j));
+        }
+    }
+    for (size_t i = 0; i < __c; i++) {
+        for (size_t j = 0; j < __c; j++) {
+            CHECK(sq(i, j) == big(i, j) + big(50 + j, 50 + i));
+        }
+    }
+
+    // *= by a matrix is the matrix product
+    auto p = a;
+    p *= Matrix2D<double>(big.Block(0, 0, __c, 13));
+    CHECK(p.Row() == __r && p.Col() == 13);
+    for (size_t i = 0; i < __r; i++) {
+        for (size_t j = 0; j < 13; j++) {
+            double __s = 0;
+            for (size_t k = 0; k < __c; k++) {
+                __s += a(i, k) * big(k, j);
+            }
+            CHECK_NEAR(p(i, j), __s, 1e-12);
+        }
+    }
+}
+
+
+int main() {
+    check_threads([] {
+        check_vector();
+        check_matrix();
+    });
+    return check_result();
+}
@@ -0,0 +1,88 @@
+#include <cstring>
+#include <string>
+#include <sstream>
+
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// WriteCSV then ReadCSV gives the same bits back with the shortest format, and the reader against
+// hand-written files: delimiter and header detection, column types, missing, extra, quoted and text
+// fields, blank lines and CRLF, and an input long enough to be parsed in several pieces
+
+
+template<class _T>
+void check_round_trip() {
+    auto m = Matrix2D<_T>::NormalInit(200, 7, _T(0), _T(1e3), 81);
+    m(0, 0) = _T(0.1);
+    m(1, 1) = _T(-1e-30);
+    m(2, 2) = _T(0);
+
+    for (char __d : {',', '\t', ';'}) {
+        stringstream s;
+        CHECK(m.WriteCSV(s, {"a", "b", "c", "d", "e", "f", "g"}, __d));
+        CSVInfo info;
+        auto r = Matrix2D<_T>::ReadCSV(s, &info);
+        CHECK(info.header && info.delimiter == __d && info.names.size() == 7 && info.names[6] == "g");
+        CHECK(r.Row() == 200 && r.Col() == 7);
+        CHECK(r.Row() == 200 && memcmp(r.Begin(), m.Begin(), 200 * 7 * sizeof(_T)) == 0);
+    }
+
+    // a fixed precision rounds to it
+    stringstream s;
+    CHECK(m.WriteCSV(s, {}, ',', 3));
+    auto r = Matrix2D<_T>::ReadCSV(s);
+    CHECK(r.Row() == 200 && r.Col() == 7);
+    for (size_t i = 0; i < r.Row(); i++) {
+        for (size_t j = 0; j < r.Col(); j++) {
+            CHECK_NEAR(r(i, j), m(i, j), 1e-2);
+        }
+    }
+}
+
+
+void check_reader() {
+    istringstream in("\n  \nid;score;name\n1;2.5;\"x;y\"\n\n2;;z\r\n3;1e3\n4;5;6;7\n");
+    CSVInfo info;
+    auto m = Matrix2D<double>::ReadCSV(in, &info);
+    CHECK(info.header && info.delimiter == ';' && info.names.size() == 3 && info.names[1] == "score");
+    CHECK(m.Row() == 4 && m.Col() == 3);
+    CHECK(info.types.size() == 3 && info.types[0] == CSVType::INTEGER && info.types[1] == CSVType::REAL);
+    CHECK(info.types.size() == 3 && info.types[2] == CSVType::TEXT);
+    CHECK(m(0, 0) == 1 && m(0, 1) == 2.5 && std::isnan(m(0, 2)));
+    CHECK(std::isnan(m(1, 1)) && std::isnan(m(1, 2)) && m(2, 1) == 1000 && std::isnan(m(2, 2)));
+    CHECK(m(3, 0) == 4 && m(3, 1) == 5 && m(3, 2) == 6);
+
+    // whitespace, no header, integers
+    istringstream ws("1 2  3\n  4   5 6\n");
+    auto n = Matrix2D<int>::ReadCSV(ws, &info);
+    CHECK(!info.header && info.delimiter == ' ' && n.Row() == 2 && n.Col() == 3);
+    CHECK(n(0, 2) == 3 && n(1, 0) == 4 && n(1, 2) == 6);
+
+    istringstream empty("\n\n");
+    CHECK(Matrix2D<double>::ReadCSV(empty).Row() == 0);
+}
+
+
+// about 5 MB, so several pieces are parsed in parallel and rows straddle the piece bounds
+void check_large() {
+    auto m = Matrix2D<double>::RandomInit(40000, 6, 82);
+    stringstream s;
+    CHECK(m.WriteCSV(s));
+    string text = s.str();
+    CHECK(text.size() > 4 * TEXT_CHUNK);
+
+    istringstream in(text);
+    auto r = Matrix2D<double>::ReadCSV(in);
+    CHECK(r.Row() == 40000 && r.Col() == 6 && memcmp(r.Begin(), m.Begin(), 40000 * 6 * sizeof(double)) == 0);
+}
+
+
+int main() {
+    check_threads([] {
+        check_round_trip<float>();
+        check_round_trip<double>();
+        check_reader();
+        check_large();
+    });
+    return check_result();
+}
@@ -0,0 +1,53 @@
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// lazy Vector / Matrix2D arithmetic against element-by-element loops
+
+
+void check_vector_expressions() {
+    size_t __n = 1003;
+    auto x = Vector<float>::RandomInit(__n, 1), y = Vector<float>::RandomInit(__n, 2);
+
+    Vector<float> z = (x + y) * 2.f - x / (y * y + 1.f);
+    for (size_t i = 0; i < __n; i++) {
+        CHECK_NEAR(z[i], (x[i] + y[i]) * 2.f - x[i] / (y[i] * y[i] + 1.f), 1e-6);
+    }
+
+    // reductions run on the expression without materializing it
+    double __sum = 0;
+    for (size_t i = 0; i < __n; i++) {
+        __sum += x[i] - y[i];
+    }
+    CHECK_NEAR((x - y).Mean(), __sum / __n, 1e-5);
+
+    Vector<float> w = x;
+    w = w * 3.f + w;     // the right side reads w while w is assigned
+    for (size_t i = 0; i < __n; i++) {
+        CHECK_NEAR(w[i], 4.f * x[i], 1e-6);
+    }
+}
+
+
+void check_matrix_expressions() {
+    size_t __r = 67, __c = 45;
+    auto a = Matrix2D<double>::RandomInit(__r, __c, 3), b = Matrix2D<double>::RandomInit(__r, __c, 4);
+    auto bias = Vector<double>::RandomInit(__c, 5);
+
+    Matrix2D<double> m = (a - b) / 2. + bias;
+    CHECK(m.Row() == __r && m.Col() == __c);
+    for (size_t i = 0; i < __r; i++) {
+        for (size_t j = 0; j < __c; j++) {
+            CHECK_NEAR(m(i, j), (a(i, j) - b(i, j)) / 2. + bias[j], 1e-12);
+        }
+    }
+}
+
+
+int main() {
+    check_threads([] {
+        check_vector_expressions();
+        check_matrix_expressions();
+    });
+    return check_result();
+}
@@ -0,0 +1,88 @@
+#include "Fixed.hpp"
+#include "Check.hpp"
+
+// FixedVector / FixedMatrix2D at compile time, and at run time against the dynamic containers they
+// convert to; scalar operands take the element type, so v * 2 on a float vector compiles
+
+
+constexpr FixedMatrix2D<double, 3, 3> R(0, -1, 0,
+                                        1,  0, 0,
+                                        0,  0, 1);
+static_assert(R * R.T() == FixedMatrix2D<double, 3, 3>::Identity());
+static_assert(R.Row(0) == FixedVector<double, 3>(0, -1, 0) && R.Column(0) == FixedVector<double, 3>(0, 1, 0));
+
+constexpr FixedVector<float, 3> p(3, 4, 12);
+static_assert(p.Max() == 12 && p.Min() == 3 && p.Argmax() == 2);
+static_assert(p * 2 == FixedVector<float, 3>(6, 8, 24) && p / 2 - 1 == FixedVector<float, 3>(0.5f, 1, 5));
+static_assert(FixedVector<double, 4>(1, 1, 3, 3).STD() == 1);
+static_assert(FixedMatrix2D<int, 2, 2>(1, 2, 3, 4) * 2 + 1 == FixedMatrix2D<int, 2, 2>(3, 5, 7, 9));
+
+
+template<class _T, size_t _R, size_t _C>
+FixedMatrix2D<_T, _R, _C> fixed_random(uint64_t __seed) {
+    auto m = Matrix2D<_T>::RandomInit(_R, _C, __seed);
+    FixedMatrix2D<_T, _R, _C> f;
+    for (size_t i = 0; i < _R; i++) {
+        for (size_t j = 0; j < _C; j++) {
+            f(i, j) = m(i, j);
+        }
+    }
+    return f;
+}
+
+
+template<class _T>
+void check_against_dynamic(double __tol) {
+    auto a = fixed_random<_T, 3, 4>(91);
+    auto b = fixed_random<_T, 4, 2>(92);
+    Matrix2D<_T> da(a.Begin(), a.Row(), a.Col()), db(b.Begin(), b.Row(), b.Col());
+
+    auto prod = a * b;
+    Matrix2D<_T> dprod = da * db;
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 2; j++) {
+            CHECK_NEAR(prod(i, j), dprod(i, j), __tol);
+        }
+    }
+
+    auto col_mean = a.template Mean<Axis2D::COL>();
+    auto col_std = a.template STD<Axis2D::COL>();
+    auto row_max = a.template Max<Axis2D::ROW>();
+    auto row_min = a.template Min<Axis2D::ROW>();
+    auto dmean = da.Mean(Axis2D::COL), dstd = da.STD(Axis2D::COL);
+    auto dmax = da.Max(Axis2D::ROW), dmin = da.Min(Axis2D::ROW);
+    for (size_t j = 0; j < 4; j++) {
+        CHECK_NEAR(col_mean[j], dmean[j], __tol);
+        CHECK_NEAR(col_std[j], dstd[j], __tol);
+    }
+    for (size_t i = 0; i < 3; i++) {
+        CHECK(row_max[i] == dmax[i] && row_min[i] == dmin[i]);
+    }
+    CHECK_NEAR(a.Mean(), da.Mean(Axis2D::ALL)[0], __tol);
+    CHECK_NEAR(a.STD(), da.STD(Axis2D::ALL)[0], __tol);
+    CHECK(a.Argmax() == da.Argmax(Axis2D::ALL)[0]);
+
+    // row broadcasting and scalars, with an int literal on a floating point matrix
+    FixedVector<_T, 4> w(1, 2, 3, 4);
+    auto e = (a + w) * w / 2 - 1;
+    Matrix2D<_T> de = (da + Vector<_T>(w.Begin(), w.Size())) * Vector<_T>(w.Begin(), w.Size()) / _T(2) - _T(1);
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            CHECK_NEAR(e(i, j), de(i, j), __tol);
+        }
+    }
+
+    auto v = w * 2;
+    v += 1;
+    v /= w;
+    CHECK((v == FixedVector<_T, 4>(_T(3), _T(5) / 2, _T(7) / 3, _T(9) / 4)));
+}
+
+
+int main() {
+    check_threads([] {
+        check_against_dynamic<float>(1e-5);
+        check_against_dynamic<double>(1e-12);
+    });
+    return check_result();
+}
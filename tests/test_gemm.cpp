@@ -0,0 +1,77 @@
+#include <vector>
+
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// the packed gemm behind Matrix2D * Matrix2D against the triple loop, at shapes that leave partial
+// micro-tiles and cache blocks on every side
+
+
+template<class _T>
+vector<double> naive_product(const Matrix2D<_T> &a, const Matrix2D<_T> &b, bool __ta) {
+    size_t __m = __ta ? a.Col() : a.Row(), __k = __ta ? a.Row() : a.Col(), __n = b.Col();
+    vector<double> c(__m * __n, 0.);
+    for (size_t i = 0; i < __m; i++) {
+        for (size_t p = 0; p < __k; p++) {
+            double __a = __ta ? a(p, i) : a(i, p);
+            for (size_t j = 0; j < __n; j++) {
+                c[i * __n + j] += __a * b(p, j);
+            }
+        }
+    }
+    return c;
+}
+
+
+template<class _T>
+void check_products(double __tol) {
+    size_t shapes[][3] = {{1, 1, 1}, {17, 9, 33}, {64, 64, 64}, {130, 301, 70}, {257, 129, 300}};
+    for (auto &s : shapes) {
+        size_t __m = s[0], __k = s[1], __n = s[2];
+        auto a = Matrix2D<_T>::RandomInit(__m, __k, 11), b = Matrix2D<_T>::RandomInit(__k, __n, 12);
+        auto at = Matrix2D<_T>::RandomInit(__k, __m, 13);
+
+        Matrix2D<_T> c = a * b;
+        auto ref = naive_product(a, b, false);
+        CHECK(c.Row() == __m && c.Col() == __n);
+        for (size_t i = 0; i < __m * __n; i++) {
+            CHECK_NEAR(c(i / __n, i % __n), ref[i], __tol);
+        }
+
+        // the transposed view is read through its strides
+        Matrix2D<_T> d = at.T() * b;
+        ref = naive_product(at, b, true);
+        for (size_t i = 0; i < __m * __n; i++) {
+            CHECK_NEAR(d(i / __n, i % __n), ref[i], __tol);
+        }
+
+        // C = alpha A B + beta C
+        auto e = Matrix2D<_T>::RandomInit(__m, __n, 14);
+        Matrix2D<_T> e0 = e;
+        gemm(__m, __n, __k, _T(2), a.Begin(), a.Stride(), size_t(1), b.Begin(), b.Stride(), size_t(1), _T(0.5), e.Begin(), e.Stride());
+        ref = naive_product(a, b, false);
+        for (size_t i = 0; i < __m * __n; i++) {
+            CHECK_NEAR(e(i / __n, i % __n), 2 * ref[i] + 0.5 * e0(i / __n, i % __n), __tol);
+        }
+    }
+}
+
+
+// the same bits whatever the thread count
+void check_deterministic() {
+    auto a = Matrix2D<float>::RandomInit(300, 200, 21), b = Matrix2D<float>::RandomInit(200, 250, 22);
+    vector<Matrix2D<float>> runs;
+    check_threads([&] { runs.push_back(a * b); });
+    CHECK(memcmp(runs[0].Begin(), runs[1].Begin(), 300 * 250 * sizeof(float)) == 0);
+}
+
+
+int main() {
+    check_threads([] {
+        check_products<float>(1e-4);
+        check_products<double>(1e-12);
+    });
+    check_deterministic();
+    return check_result();
+}
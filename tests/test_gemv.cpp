@@ -0,0 +1,107 @@
+#include <cstring>
+#include <vector>
+
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// Dot, MatVec and MatVecT against loops accumulated in double, on shapes around the four row groups,
+// the GEMV_COLS column blocks and the row panels of gemv_t; views through their strides, queries of
+// the wrong size, and the same bits for every thread count
+
+
+template<class _T>
+void check_dot(double __tol) {
+    for (size_t __n : {1, 3, 16, 17, 1000, 4097}) {
+        auto x = Vector<_T>::RandomInit(__n, 101);
+        auto y = Vector<_T>::RandomInit(__n, 102);
+        double __d = 0, __e = 0;
+        for (size_t i = 0; i < __n; i++) {
+            __d += double(x[i]) * y[i];
+            __e += double(x[i]) * (y[i] * _T(2));
+        }
+        CHECK_NEAR(x.Dot(y), __d, __tol);
+        CHECK_NEAR(x.Dot(y * _T(2)), __e, __tol);
+    }
+    auto x = Vector<_T>::RandomInit(10, 103);
+    CHECK(x.Dot(Vector<_T>::RandomInit(11, 104)) == 0);
+}
+
+
+template<class _T>
+void check_mat_vec(double __tol) {
+    size_t shapes[][2] = {{1, 1}, {3, 5}, {4, 4}, {7, 2049}, {1000, 3}, {17000, 33}, {5, 5000}};
+    for (auto &s : shapes) {
+        size_t __m = s[0], __n = s[1];
+        auto a = Matrix2D<_T>::RandomInit(__m, __n, 105);
+        auto x = Vector<_T>::RandomInit(__n, 106);
+        auto z = Vector<_T>::RandomInit(__m, 107);
+
+        auto y = a.MatVec(x);
+        auto t = a.MatVecT(z);
+        CHECK(y.Size() == __m && t.Size() == __n);
+        vector<double> ty(__n, 0.0);
+        for (size_t i = 0; i < __m; i++) {
+            double __d = 0;
+            for (size_t j = 0; j < __n; j++) {
+                __d += double(a(i, j)) * x[j];
+                ty[j] += double(a(i, j)) * z[i];
+            }
+            CHECK_NEAR(y[i], __d, __tol);
+        }
+        for (size_t j = 0; j < __n; j++) {
+            CHECK_NEAR(t[j], ty[j], __tol);
+        }
+
+        // a transposed view runs the other kernel, same result
+        auto vt = a.T().MatVec(z);
+        auto vy = a.T().MatVecT(x);
+        CHECK(vt.Size() == __n && memcmp(vt.Begin(), t.Begin(), __n * sizeof(_T)) == 0);
+        CHECK(vy.Size() == __m && memcmp(vy.Begin(), y.Begin(), __m * sizeof(_T)) == 0);
+
+        // the query of the wrong size
+        CHECK(a.MatVec(z).Size() == (__m == __n ? __m : 0) && a.MatVecT(x).Size() == (__m == __n ? __n : 0));
+    }
+
+    // a block view keeps the row stride of its parent
+    auto a = Matrix2D<_T>::RandomInit(300, 200, 108);
+    auto x = Vector<_T>::RandomInit(50, 109);
+    auto y = a.Block(10, 20, 100, 50).MatVec(x);
+    for (size_t i = 0; i < 100; i++) {
+        double __d = 0;
+        for (size_t j = 0; j < 50; j++) {
+            __d += double(a(10 + i, 20 + j)) * x[j];
+        }
+        CHECK_NEAR(y[i], __d, __tol);
+    }
+}
+
+
+// the panels only depend on the shape
+void check_threads_agree() {
+    auto a = Matrix2D<float>::RandomInit(20000, 70, 110);
+    auto x = Vector<float>::RandomInit(70, 111);
+    auto z = Vector<float>::RandomInit(20000, 112);
+    Vector<float> y[2], t[2];
+    size_t __threads[2] = {1, 4};
+    for (size_t k = 0; k < 2; k++) {
+        ThreadPool::SetThreadCount(__threads[k]);
+        ThreadPool::Global().SetSerialThreshold(1 << 10);
+        y[k] = a.MatVec(x);
+        t[k] = a.MatVecT(z);
+    }
+    CHECK(memcmp(y[0].Begin(), y[1].Begin(), 20000 * sizeof(float)) == 0);
+    CHECK(memcmp(t[0].Begin(), t[1].Begin(), 70 * sizeof(float)) == 0);
+}
+
+
+int main() {
+    check_threads([] {
+        check_dot<float>(1e-5);
+        check_dot<double>(1e-12);
+        check_mat_vec<float>(1e-4);
+        check_mat_vec<double>(1e-12);
+    });
+    check_threads_agree();
+    return check_result();
+}
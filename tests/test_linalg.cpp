@@ -0,0 +1,231 @@
+#include <cstring>
+#include <vector>
+
+#include "Linalg.hpp"
+#include "Check.hpp"
+
+// LU, Cholesky and QR by their defining identities (P A = L U, A = L L^T, A = Q R with Q^T Q = I)
+// rebuilt with plain loops, solutions by their residuals, across the recursion and panel sizes; the
+// matrices that must give Ok() false, and the same bits for every thread count
+
+
+// max |a(i, j) - b(i, j)|
+template<class _A, class _B>
+double max_diff(const _A &a, const _B &b) {
+    double __d = 0;
+    for (size_t i = 0; i < a.Row(); i++) {
+        for (size_t j = 0; j < a.Col(); j++) {
+            __d = max(__d, fabs(double(a(i, j)) - double(b(i, j))));
+        }
+    }
+    return __d;
+}
+
+
+Matrix2D<double> naive_product(const Matrix2D<double> &a, const Matrix2D<double> &b, bool __ta = false) {
+    size_t __m = __ta ? a.Col() : a.Row(), __k = __ta ? a.Row() : a.Col();
+    auto c = Matrix2D<double>::ZeroInit(__m, b.Col());
+    for (size_t i = 0; i < __m; i++) {
+        for (size_t j = 0; j < b.Col(); j++) {
+            double __s = 0;
+            for (size_t k = 0; k < __k; k++) {
+                __s += (__ta ? a(k, i) : a(i, k)) * b(k, j);
+            }
+            c(i, j) = __s;
+        }
+    }
+    return c;
+}
+
+
+void check_lu() {
+    for (size_t __n : {1, 2, 7, 64, 129, 300}) {
+        auto a = Matrix2D<double>::RandomInit(__n, __n, 151);
+        LU<double> lu(a);
+        CHECK(lu.Ok() && lu.Pivots().size() == __n);
+
+        // P A = L U, with the row swaps applied in order
+        auto pa = a;
+        for (size_t i = 0; i < __n; i++) {
+            CHECK(lu.Pivots()[i] >= i && lu.Pivots()[i] < __n);
+            for (size_t j = 0; j < __n; j++) {
+                swap(pa(i, j), pa(lu.Pivots()[i], j));
+            }
+        }
+        const auto &f = lu.Factors();
+        auto l = Matrix2D<double>::ZeroInit(__n, __n), u = Matrix2D<double>::ZeroInit(__n, __n);
+        for (size_t i = 0; i < __n; i++) {
+            for (size_t j = 0; j < __n; j++) {
+                (j < i ? l(i, j) : u(i, j)) = f(i, j);
+                CHECK(j >= i || fabs(f(i, j)) <= 1.0);
+            }
+            l(i, i) = 1;
+        }
+        CHECK(max_diff(naive_product(l, u), pa) < 1e-12 * __n);
+
+        // the determinant is the signed product of the pivots
+        double __logdet = 0;
+        int __sign = 1;
+        for (size_t i = 0; i < __n; i++) {
+            __logdet += log(fabs(u(i, i)));
+            __sign *= (u(i, i) < 0) != (lu.Pivots()[i] != i) ? -1 : 1;
+        }
+        double __det = lu.Determinant();
+        CHECK((__det < 0 ? -1 : 1) == __sign);
+        CHECK_NEAR(log(fabs(__det)), __logdet, 1e-10);
+
+        auto b = Vector<double>::RandomInit(__n, 152);
+        auto x = lu.Solve(b);
+        auto bm = Matrix2D<double>::RandomInit(__n, 5, 153);
+        auto xm = lu.Solve(bm);
+        Matrix2D<double> xcol(x.Begin(), __n, 1), bcol(b.Begin(), __n, 1);
+        CHECK(max_diff(naive_product(a, xcol), bcol) < 1e-10);
+        CHECK(max_diff(naive_product(a, xm), bm) < 1e-10);
+        CHECK(max_diff(naive_product(a, lu.Inverse()), linalg_identity<double>(__n)) < 1e-10);
+    }
+
+    // 2 x 2 by hand, and the free functions
+    Matrix2D<double> a2(vector<double>{0, 2, 3, 4}.data(), 2, 2);
+    CHECK_NEAR(determinant(a2), -6, 1e-15);
+    auto x2 = solve(a2, Vector<double>{2, 7});
+    CHECK(x2.Size() == 2 && fabs(x2[0] - 1) < 1e-15 && fabs(x2[1] - 1) < 1e-15);
+    auto i2 = inverse(a2);
+    CHECK(fabs(i2(0, 0) + 2. / 3) < 1e-15 && fabs(i2(0, 1) - 1. / 3) < 1e-15 && fabs(i2(1, 0) - 0.5) < 1e-15 && i2(1, 1) == 0);
+
+    // singular and non-square; a zero column stays exactly zero through the elimination, where a
+    // duplicated row only cancels up to rounding
+    auto s = Matrix2D<double>::RandomInit(50, 50, 154);
+    for (size_t i = 0; i < 50; i++) {
+        s(i, 7) = 0;
+    }
+    LU<double> bad(s);
+    CHECK(!bad.Ok() && bad.Solve(Vector<double>::RandomInit(50, 155)).Size() == 0 && bad.Inverse().Row() == 0);
+    CHECK(!LU<double>(Matrix2D<double>::RandomInit(5, 4, 156)).Ok());
+    CHECK(LU<double>(a2).Solve(Vector<double>{1, 2, 3}).Size() == 0);
+}
+
+
+void check_cholesky() {
+    for (size_t __n : {1, 3, 100, 128, 129, 300}) {
+        auto g = Matrix2D<double>::RandomInit(__n, __n, 157);
+        auto a = naive_product(g, g, true);
+        for (size_t i = 0; i < __n; i++) {
+            a(i, i) += 1;
+        }
+        Cholesky<double> ch(a);
+        CHECK(ch.Ok());
+        const auto &l = ch.L();
+        for (size_t i = 0; i < __n; i++) {
+            CHECK(l(i, i) > 0);
+            for (size_t j = i + 1; j < __n; j++) {
+                CHECK(l(i, j) == 0);
+            }
+        }
+        CHECK(max_diff(naive_product(l, Matrix2D<double>(l.T())), a) < 1e-12 * __n * __n);
+
+        auto b = Matrix2D<double>::RandomInit(__n, 3, 158);
+        auto x = ch.Solve(b);
+        CHECK(max_diff(naive_product(a, x), b) < 1e-9);
+        double __det = LU<double>(a).Determinant();
+        if (std::isfinite(__det)) {
+            CHECK_NEAR(ch.Determinant(), __det, 1e-9);
+        } else {
+            CHECK(ch.Determinant() == __det);
+        }
+        CHECK(max_diff(ch.Inverse(), LU<double>(a).Inverse()) < 1e-9);
+    }
+
+    // indefinite, and not square
+    auto d = linalg_identity<double>(4);
+    d(2, 2) = -1;
+    CHECK(!Cholesky<double>(d).Ok() && Cholesky<double>(d).Solve(Vector<double>::OneInit(4)).Size() == 0);
+    CHECK(!Cholesky<double>(Matrix2D<double>::OneInit(3, 4)).Ok());
+}
+
+
+void check_qr() {
+    size_t shapes[][2] = {{1, 1}, {5, 3}, {100, 100}, {300, 129}, {400, 260}};
+    for (auto &s : shapes) {
+        size_t __m = s[0], __n = s[1];
+        auto a = Matrix2D<double>::RandomInit(__m, __n, 159);
+        QR<double> qr(a);
+        CHECK(qr.Ok());
+        auto q = qr.Q(), r = qr.R();
+        CHECK(q.Row() == __m && q.Col() == __n && r.Row() == __n && r.Col() == __n);
+        CHECK(max_diff(naive_product(q, q, true), linalg_identity<double>(__n)) < 1e-12 * __m);
+        CHECK(max_diff(naive_product(q, r), a) < 1e-12 * __m);
+        for (size_t i = 0; i < __n; i++) {
+            for (size_t j = 0; j < i; j++) {
+                CHECK(r(i, j) == 0);
+            }
+        }
+
+        // least squares: the residual is orthogonal to the columns of A
+        auto b = Vector<double>::RandomInit(__m, 160);
+        auto x = least_squares(a, b);
+        CHECK(x.Size() == __n);
+        Matrix2D<double> xcol(x.Begin(), __n, 1), bcol(b.Begin(), __m, 1);
+        auto res = naive_product(a, xcol);
+        for (size_t i = 0; i < __m; i++) {
+            res(i, 0) -= bcol(i, 0);
+        }
+        auto g = naive_product(a, res, true);
+        double __g = 0;
+        for (size_t j = 0; j < __n; j++) {
+            __g = max(__g, fabs(g(j, 0)));
+        }
+        CHECK(__g < 1e-9);
+    }
+
+    // rank deficient and wide
+    auto a = Matrix2D<double>::RandomInit(20, 5, 161);
+    for (size_t i = 0; i < 20; i++) {
+        a(i, 4) = a(i, 1) - a(i, 2);
+    }
+    CHECK(!QR<double>(a).Ok() && least_squares(a, Vector<double>::OneInit(20)).Size() == 0);
+    CHECK(!QR<double>(Matrix2D<double>::RandomInit(3, 5, 162)).Ok());
+}
+
+
+// float runs the same code through the float kernels
+void check_float() {
+    auto a = Matrix2D<float>::RandomInit(200, 200, 163);
+    auto b = Vector<float>::RandomInit(200, 164);
+    auto x = solve(a, b);
+    Vector<float> ax = a.MatVec(x);
+    for (size_t i = 0; i < 200; i++) {
+        // backward stable: the residual is small relative to |A| |x|, not to b
+        double __scale = 0;
+        for (size_t j = 0; j < 200; j++) {
+            __scale += fabs(double(a(i, j)) * x[j]);
+        }
+        CHECK(fabs(ax[i] - b[i]) < 1e-4 * __scale);
+    }
+}
+
+
+void check_threads_agree() {
+    auto a = Matrix2D<double>::RandomInit(400, 400, 165);
+    Matrix2D<double> lu[2], qr[2];
+    size_t __threads[2] = {1, 4};
+    for (size_t k = 0; k < 2; k++) {
+        ThreadPool::SetThreadCount(__threads[k]);
+        ThreadPool::Global().SetSerialThreshold(1 << 10);
+        lu[k] = LU<double>(a).Factors();
+        qr[k] = QR<double>(a).R();
+    }
+    CHECK(memcmp(lu[0].Begin(), lu[1].Begin(), 400 * 400 * sizeof(double)) == 0);
+    CHECK(memcmp(qr[0].Begin(), qr[1].Begin(), 400 * 400 * sizeof(double)) == 0);
+}
+
+
+int main() {
+    check_threads([] {
+        check_lu();
+        check_cholesky();
+        check_qr();
+        check_float();
+    });
+    check_threads_agree();
+    return check_result();
+}
@@ -0,0 +1,203 @@
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <sstream>
+
+#include "Profile.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// built with CVM_PROFILE: the calls, FLOPs and bytes a few operations record, the live and peak bytes
+// of their buffers, the summary table, and a trace that parses as JSON with one complete event per
+// call. test_profile_off checks the macros without CVM_PROFILE
+
+#ifndef CVM_PROFILE
+#error "test_profile needs CVM_PROFILE"
+#endif
+
+
+// a strict reader for the JSON WriteTrace produces: objects, arrays, strings with escapes, numbers
+struct JsonReader {
+    const char *p;
+
+    void space() {
+        while (*this->p && isspace((unsigned char)*this->p)) {
+            this->p++;
+        }
+    }
+
+    bool string() {
+        if (*this->p++ != '"') {
+            return false;
+        }
+        for (; *this->p != '"'; this->p++) {
+            if (*this->p == '\0' || (unsigned char)*this->p < 0x20) {
+                return false;
+            }
+            if (*this->p == '\\' && !strchr("\"\\/bfnrt", *++this->p)) {
+                return false;
+            }
+        }
+        this->p++;
+        return true;
+    }
+
+    bool number() {
+        char *end;
+        strtod(this->p, &end);
+        bool __ok = end != this->p;
+        this->p = end;
+        return __ok;
+    }
+
+    template<class _F>
+    bool items(char __close, _F item) {
+        this->space();
+        if (*this->p == __close) {
+            this->p++;
+            return true;
+        }
+        for (;;) {
+            if (!item()) {
+                return false;
+            }
+            this->space();
+            if (*this->p == __close) {
+                this->p++;
+                return true;
+            }
+            if (*this->p++ != ',') {
+                return false;
+            }
+            this->space();
+        }
+    }
+
+    bool value() {
+        this->space();
+        switch (*this->p) {
+            case '{' :
+                this->p++;
+                return this->items('}', [this]() {
+                    if (!this->string()) {
+                        return false;
+                    }
+                    this->space();
+                    return *this->p++ == ':' && this->value();
+                });
+            case '[' :
+                this->p++;
+                return this->items(']', [this]() { return this->value(); });
+            case '"' : return this->string();
+            default : return this->number();
+        }
+    }
+
+    static bool valid(const std::string &__text) {
+        JsonReader r{__text.c_str()};
+        bool __ok = r.value();
+        r.space();
+        return __ok && *r.p == '\0';
+    }
+};
+
+
+size_t occurrences(const string &__text, const string &__what) {
+    size_t __n = 0;
+    for (size_t k = __text.find(__what); k != string::npos; k = __text.find(__what, k + 1)) {
+        __n++;
+    }
+    return __n;
+}
+
+
+void check_counters() {
+    Profiler &prof = Profiler::Global();
+    prof.Reset();
+    int64_t __live = prof.Live();
+    size_t __bytes = 0;
+    {
+        auto a = Matrix2D<float>::RandomInit(64, 32, 191);
+        auto b = Matrix2D<float>::RandomInit(32, 48, 192);
+        auto c = a * b;
+        Matrix2D<float> t = a.T();
+        auto u = Matrix2D<float>(b).T();
+        __bytes = (a.Row() * a.Stride() + b.Row() * b.Stride() + c.Row() * c.Stride() + t.Row() * t.Stride()) * sizeof(float);
+        CHECK((c.Row() == 64 && c.Col() == 48 && t.Row() == 32 && u.Row() == 48));
+        CHECK(prof.Live() - __live >= int64_t(__bytes));
+    }
+    CHECK(prof.Live() == __live);
+    CHECK(prof.Peak() - __live >= int64_t(__bytes));
+    CHECK(prof.Allocated() >= __bytes);
+
+    auto s = prof.Stats();
+    CHECK(s["Matrix2D::RandomInit"].calls == 2);
+    CHECK(s["Matrix2D::RandomInit"].bytes >= (64 * 32 + 32 * 48) * sizeof(float));
+    CHECK(s["Matrix2D::operator*"].calls == 1);
+    CHECK(s["Matrix2D::operator*"].flops == 2.0 * 64 * 32 * 48);
+    CHECK(s["Matrix2D::operator*"].bytes >= 64 * 48 * sizeof(float));
+    CHECK(s["Matrix2D::Matrix2D(expression)"].calls >= 1);
+    CHECK(s["Matrix2D::Transpose"].calls == 1);
+    CHECK(s["Matrix2D::RandomInit"].min_nanoseconds <= s["Matrix2D::RandomInit"].max_nanoseconds);
+    CHECK(s.count("Matrix2D::Sort") == 0);
+
+    // the summary lists every operation and the memory figures
+    ostringstream out;
+    prof.WriteSummary(out);
+    string __table = out.str();
+    CHECK(__table.find("operation") == 0);
+    CHECK(__table.find("Matrix2D::operator*") != string::npos && __table.find("Matrix2D::Transpose") != string::npos);
+    CHECK(__table.find("peak live") != string::npos);
+
+    // Reset drops the counters, the peak restarts from what is live
+    prof.Reset();
+    CHECK(prof.Stats().empty() && prof.Allocated() == 0 && prof.Peak() == prof.Live());
+}
+
+
+void check_trace() {
+    Profiler &prof = Profiler::Global();
+    prof.Reset();
+    prof.SetTrace(true);
+    {
+        auto a = Matrix2D<double>::RandomInit(40, 40, 193);
+        auto c = a * a;
+        _PROFILE_SCOPE("a \"quoted\" \\ name", 7);
+    }
+    prof.SetTrace(false);
+    {
+        auto b = Matrix2D<double>::RandomInit(4, 4, 194);
+    }
+
+    size_t __calls = 0;
+    for (auto &[name, s] : prof.Stats()) {
+        __calls += s.calls;
+    }
+    ostringstream out;
+    CHECK(prof.WriteTrace(out));
+    string __json = out.str();
+    CHECK(JsonReader::valid(__json));
+    CHECK(__json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+    // one complete event and one live-bytes counter per traced call, the call after SetTrace(false)
+    // is only counted
+    CHECK(occurrences(__json, "\"ph\":\"X\"") == __calls - 1);
+    CHECK(occurrences(__json, "\"ph\":\"C\"") == __calls - 1);
+    CHECK(occurrences(__json, "\"name\":\"Matrix2D::RandomInit\"") == 1);
+    CHECK(occurrences(__json, "\"name\":\"Matrix2D::operator*\"") == 1);
+    CHECK(__json.find("\"name\":\"a \\\"quoted\\\" \\\\ name\"") != string::npos);
+    CHECK(__json.find("\"flops\":128000") != string::npos);
+
+    // nothing traced is still a valid file
+    prof.Reset();
+    ostringstream empty;
+    CHECK(prof.WriteTrace(empty) && JsonReader::valid(empty.str()) && occurrences(empty.str(), "\"ph\"") == 0);
+}
+
+
+int main() {
+    check_threads([] {
+        check_counters();
+        check_trace();
+    });
+    return check_result();
+}
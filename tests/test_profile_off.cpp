@@ -0,0 +1,42 @@
+// the CVM_PROFILE option defines it for every target, this test is about the build without it
+#undef CVM_PROFILE
+
+#include <string>
+
+#include "Profile.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// without CVM_PROFILE the macros expand to a no-op that does not evaluate its arguments, and nothing
+// of the profiler is declared
+
+#ifdef _PROFILE_CONCAT
+#error "the profiler is compiled in without CVM_PROFILE"
+#endif
+
+#define _STRING_(x) #x
+#define _STRING(x) _STRING_(x)
+
+
+void check_disabled() {
+    CHECK(string(_STRING(_PROFILE_SCOPE("name", 1))) == "((void)0)");
+    CHECK(string(_STRING(_PROFILE_ALLOCATE(8, true))) == "((void)0)");
+    CHECK(string(_STRING(_PROFILE_RELEASE(8))) == "((void)0)");
+
+    int __evaluated = 0;
+    _PROFILE_SCOPE("name", __evaluated++);
+    _PROFILE_ALLOCATE(size_t(__evaluated++), true);
+    _PROFILE_RELEASE(size_t(__evaluated++));
+    CHECK(__evaluated == 0);
+
+    // the instrumented operations still build and run
+    auto a = Matrix2D<float>::RandomInit(20, 30, 195);
+    auto c = a * a.T();
+    CHECK((c.Row() == 20 && c.Col() == 20));
+}
+
+
+int main() {
+    check_threads([] { check_disabled(); });
+    return check_result();
+}
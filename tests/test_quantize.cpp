@@ -0,0 +1,170 @@
+#include <cstring>
+#include <vector>
+
+#include "Quantize.hpp"
+#include "Check.hpp"
+
+// Half and BFloat16 conversions bit for bit (every half, the compiler's _Float16 when there is one,
+// and the selected kernels against the scalar ones), the error bounds of the quantized matrices, and
+// the int8 product against the float product of the dequantized operands
+
+
+float bits_float(uint32_t __x) {
+    float f;
+    memcpy(&f, &__x, sizeof(f));
+    return f;
+}
+
+
+// random bit patterns and the edges: zeros, subnormals of both formats, the half overflow threshold,
+// infinities and NaNs
+vector<float> conversion_inputs() {
+    vector<float> v = {0.f, -0.f, 1.f, -1.f, 65504.f, 65519.99f, 65520.f, 1e-8f, 6.1e-5f, 5.96e-8f, 2.98e-8f,
+                       bits_float(0x7f800000), bits_float(0xff800000), bits_float(0x7fc00000), bits_float(0x7f800001),
+                       bits_float(0x00000001), bits_float(0x007fffff), bits_float(0x3f808000), bits_float(0x3f818000)};
+    uint64_t __s = 0x9e3779b97f4a7c15;
+    for (size_t i = 0; i < 200000; i++) {
+        __s ^= __s << 13;
+        __s ^= __s >> 7;
+        __s ^= __s << 17;
+        v.push_back(bits_float(uint32_t(__s)));
+    }
+    return v;
+}
+
+
+void check_conversions() {
+    // every half goes to a float and back unchanged, NaNs come back quiet with their sign
+    for (uint32_t h = 0; h < 0x10000; h++) {
+        bool __nan = (h & 0x7c00) == 0x7c00 && (h & 0x3ff) != 0;
+        uint16_t __back = half_from_float(float_from_half(uint16_t(h)));
+        CHECK(__nan ? (__back & 0xfe00) == ((h & 0x8000) | 0x7e00) : __back == h);
+    }
+
+    vector<float> in = conversion_inputs();
+    size_t __n = in.size();
+    vector<uint16_t> h(__n), hs(__n), b(__n), bs(__n);
+    vector<float> back(__n), backs(__n);
+    const QuantKernels &k = quant_kernels();
+
+    // the selected kernels against the scalar ones; NaN payloads may differ between the instructions
+    // and the bit manipulation
+    k.to_half(in.data(), h.data(), __n);
+    quant_to_half_scalar(in.data(), hs.data(), __n);
+    k.to_bfloat16(in.data(), b.data(), __n);
+    quant_to_bfloat16_base(in.data(), bs.data(), __n);
+    k.from_half(hs.data(), back.data(), __n);
+    quant_from_half_scalar(hs.data(), backs.data(), __n);
+    for (size_t i = 0; i < __n; i++) {
+        if (std::isnan(in[i])) {
+            CHECK(std::isnan(float_from_half(h[i])) && std::isnan(float_from_bfloat16(b[i])));
+        } else {
+            CHECK(h[i] == hs[i] && b[i] == bs[i]);
+            CHECK(memcmp(&back[i], &backs[i], sizeof(float)) == 0);
+        }
+    }
+
+    for (size_t i = 0; i < __n; i++) {
+        float __x = in[i];
+        if (std::isnan(__x)) {
+            CHECK(std::isnan(float_from_half(hs[i])) && std::isnan(float_from_bfloat16(bs[i])));
+            continue;
+        }
+#ifdef __FLT16_MAX__
+        _Float16 __ref = _Float16(__x);
+        uint16_t __rb;
+        memcpy(&__rb, &__ref, sizeof(__rb));
+        CHECK(hs[i] == __rb);
+#endif
+        // subnormals flush to a signed zero, the rest rounds to nearest: neither neighbour is closer
+        float __r = float_from_bfloat16(bs[i]);
+        if (fabs(__x) < 0x1p-126f) {
+            CHECK(__r == 0.f && std::signbit(__r) == std::signbit(__x));
+        } else if (!std::isinf(__r) && (bs[i] & 0x7fff) != 0) {
+            float __up = float_from_bfloat16(uint16_t(bs[i] + 1)), __down = float_from_bfloat16(uint16_t(bs[i] - 1));
+            CHECK(fabs(double(__r) - __x) <= fabs(double(__up) - __x) && fabs(double(__r) - __x) <= fabs(double(__down) - __x));
+        }
+    }
+}
+
+
+void check_matrices() {
+    auto a = Matrix2D<float>::NormalInit(131, 77, 0.f, 3.f, 131);
+    a(0, 0) = 0.f;
+    a(5, 9) = 0.f;
+
+    auto h = QuantizedMatrix<Half>(a).Dequantize();
+    auto b = QuantizedMatrix<BFloat16>(a).Dequantize();
+    for (size_t i = 0; i < a.Row(); i++) {
+        for (size_t j = 0; j < a.Col(); j++) {
+            CHECK(fabs(h(i, j) - a(i, j)) <= fabs(a(i, j)) * 0x1p-11f + 0x1p-25f);
+            CHECK(fabs(b(i, j) - a(i, j)) <= fabs(a(i, j)) * 0x1p-8f);
+        }
+    }
+
+    for (Axis2D axis : {Axis2D::ALL, Axis2D::ROW, Axis2D::COL}) {
+        QuantizedMatrix<int8_t> q(a, axis);
+        auto d = q.Dequantize();
+        auto d64 = q.Dequantize<double>();
+        CHECK(q.Axis() == axis && d.Row() == a.Row() && d.Col() == a.Col());
+        CHECK(q.Bytes() < a.Row() * a.Col() * sizeof(float) / 3);
+        for (size_t i = 0; i < a.Row(); i++) {
+            auto row = q.Row(i);
+            for (size_t j = 0; j < a.Col(); j++) {
+                float __s = q.Scales()[axis == Axis2D::ALL ? 0 : axis == Axis2D::ROW ? i : j];
+                CHECK(fabs(d(i, j) - a(i, j)) <= __s * 0.5001f);
+                CHECK(row[j] == d(i, j) && float(d64(i, j)) == d(i, j));
+            }
+        }
+        CHECK(d(0, 0) == 0.f && d(5, 9) == 0.f);
+
+        auto x = Vector<float>::RandomInit(77, 132);
+        auto y = q.MatVec(x), dy = d.MatVec(x);
+        CHECK(y.Size() == 131);
+        for (size_t i = 0; i < y.Size(); i++) {
+            CHECK_NEAR(y[i], dy[i], 1e-4);
+        }
+    }
+}
+
+
+void check_products() {
+    auto a = Matrix2D<float>::RandomInit(70, 300, 133);
+    auto b = Matrix2D<float>::RandomInit(300, 45, 134);
+    Matrix2D<float> exact = a * b;
+
+    Axis2D pairs[][2] = {{Axis2D::ROW, Axis2D::COL}, {Axis2D::ALL, Axis2D::ALL}, {Axis2D::ALL, Axis2D::COL},
+                         {Axis2D::ROW, Axis2D::ALL}, {Axis2D::COL, Axis2D::ROW}};
+    for (auto &p : pairs) {
+        QuantizedMatrix<int8_t> qa(a, p[0]), qb(b, p[1]);
+        auto c = qa * qb;
+        Matrix2D<float> ref = qa.Dequantize() * qb.Dequantize();
+        CHECK(c.Row() == 70 && c.Col() == 45);
+        for (size_t i = 0; i < c.Row(); i++) {
+            for (size_t j = 0; j < c.Col(); j++) {
+                CHECK_NEAR(c(i, j), ref(i, j), 1e-4);
+                // 300 terms, each off by at most half a step of a (2 / 255) and of b
+                CHECK(fabs(c(i, j) - exact(i, j)) <= 300 * (2 * 0.5f * 2.f / 255.f + 0.25f / 255.f / 255.f * 4));
+            }
+        }
+    }
+
+    auto h = QuantizedMatrix<Half>(a) * QuantizedMatrix<Half>(b);
+    for (size_t i = 0; i < h.Row(); i++) {
+        for (size_t j = 0; j < h.Col(); j++) {
+            CHECK_NEAR(h(i, j), exact(i, j), 1e-2);
+        }
+    }
+
+    CHECK((QuantizedMatrix<int8_t>(a) * QuantizedMatrix<int8_t>(a)).Row() == 0);
+}
+
+
+int main() {
+    check_conversions();
+    check_threads([] {
+        check_matrices();
+        check_products();
+    });
+    return check_result();
+}
@@ -0,0 +1,93 @@
+#include <cstring>
+
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Random.hpp"
+#include "Check.hpp"
+
+// the batched Philox4x32-10 against a one block reference that reproduces the known answers of the
+// Random123 distribution, and the fills: element k only depends on (seed, k), so the output is the
+// same bits for every thread count and a shorter buffer is a prefix of a longer one
+
+
+void philox_reference(uint32_t c[4], uint32_t k0, uint32_t k1) {
+    for (size_t r = 0; r < PHILOX_ROUNDS; r++) {
+        uint64_t p0 = uint64_t(PHILOX_M0) * c[0];
+        uint64_t p1 = uint64_t(PHILOX_M1) * c[2];
+        uint32_t n[4] = {uint32_t(p1 >> 32) ^ c[1] ^ k0, uint32_t(p1), uint32_t(p0 >> 32) ^ c[3] ^ k1, uint32_t(p0)};
+        memcpy(c, n, sizeof(n));
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+
+void check_philox() {
+    struct { uint32_t ctr[4], key[2], out[4]; } kat[] = {
+        {{0, 0, 0, 0}, {0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+        {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}, {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+        {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}, {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+    };
+    for (auto &t : kat) {
+        uint32_t c[4];
+        memcpy(c, t.ctr, sizeof(c));
+        philox_reference(c, t.key[0], t.key[1]);
+        CHECK(memcmp(c, t.out, sizeof(c)) == 0);
+    }
+
+    // the batch puts the 64-bit counter in words 0 and 1 and the 64-bit seed in the key
+    for (uint64_t __seed : {uint64_t(0), uint64_t(0x299f31d0a4093822), uint64_t(42)}) {
+        for (uint64_t __first : {uint64_t(0), uint64_t(0xfffffffffffffff0)}) {
+            uint32_t w[4][RANDOM_BATCH];
+            philox_batch(__first, __seed, w);
+            for (size_t l = 0; l < RANDOM_BATCH; l++) {
+                uint64_t __c = __first + l;
+                uint32_t c[4] = {uint32_t(__c), uint32_t(__c >> 32), 0, 0};
+                philox_reference(c, uint32_t(__seed), uint32_t(__seed >> 32));
+                CHECK(w[0][l] == c[0] && w[1][l] == c[1] && w[2][l] == c[2] && w[3][l] == c[3]);
+            }
+        }
+    }
+}
+
+
+template<class _T>
+void check_fills() {
+    size_t __n = 100003;
+    Vector<_T> u[2], g[2];
+    Matrix2D<_T> m[2];
+    size_t __threads[2] = {1, 4};
+    for (size_t t = 0; t < 2; t++) {
+        ThreadPool::SetThreadCount(__threads[t]);
+        ThreadPool::Global().SetSerialThreshold(1 << 10);
+        u[t] = Vector<_T>::RandomInit(__n, 61);
+        g[t] = Vector<_T>::NormalInit(__n, _T(2), _T(3), 62);
+        m[t] = Matrix2D<_T>::RandomInit(301, 333, 61);
+    }
+    CHECK(memcmp(u[0].Begin(), u[1].Begin(), __n * sizeof(_T)) == 0);
+    CHECK(memcmp(g[0].Begin(), g[1].Begin(), __n * sizeof(_T)) == 0);
+    CHECK(memcmp(m[0].Begin(), m[1].Begin(), 301 * 333 * sizeof(_T)) == 0);
+
+    // a prefix, whatever the length, and a different stream for another seed
+    for (size_t __l : {1, 255, 257, 5000}) {
+        auto p = Vector<_T>::RandomInit(__l, 61);
+        auto q = Vector<_T>::NormalInit(__l, _T(2), _T(3), 62);
+        CHECK(memcmp(p.Begin(), u[0].Begin(), __l * sizeof(_T)) == 0);
+        CHECK(memcmp(q.Begin(), g[0].Begin(), __l * sizeof(_T)) == 0);
+    }
+    auto other = Vector<_T>::RandomInit(__n, 63);
+    CHECK(memcmp(other.Begin(), u[0].Begin(), __n * sizeof(_T)) != 0);
+
+    // the ranges and the first two moments
+    CHECK(u[0].Min() >= _T(-1) && u[0].Max() < _T(1));
+    CHECK(fabs(u[0].Mean()) < 0.01 && fabs(u[0].STD() - 1 / sqrt(3.)) < 0.01);
+    CHECK(fabs(g[0].Mean() - 2) < 0.03 && fabs(g[0].STD() - 3) < 0.03);
+}
+
+
+int main() {
+    check_philox();
+    check_fills<float>();
+    check_fills<double>();
+    return check_result();
+}
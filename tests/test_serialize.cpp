@@ -0,0 +1,169 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <fstream>
+
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// Save / Load / Map round trips, and the files that must give an empty container instead of a crash
+// or a huge allocation: another element type or rank, a flipped data byte, a truncated file, and
+// headers crafted with sizes that overflow or an offset past the end of the file
+
+
+template<class _C>
+bool same(const _C &a, const _C &b) {
+    if constexpr (is_same_v<_C, Vector<typename _C::value_type>>) {
+        return a.Size() == b.Size() && (a.Size() == 0 || memcmp(a.Begin(), b.Begin(), a.Size() * sizeof(a[0])) == 0);
+    } else {
+        if (a.Row() != b.Row() || a.Col() != b.Col()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.Row(); i++) {
+            for (size_t j = 0; j < a.Col(); j++) {
+                if (a(i, j) != b(i, j)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+
+string file_bytes(const string &__path) {
+    ifstream in(__path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+
+void write_bytes(const string &__path, const string &__bytes) {
+    ofstream out(__path, ios::binary | ios::trunc);
+    out.write(__bytes.data(), streamsize(__bytes.size()));
+}
+
+
+template<class _T>
+Vector<_T> counted(size_t __n) {
+    auto v = Vector<_T>::ZeroInit(__n);
+    for (size_t i = 0; i < __n; i++) {
+        v[i] = _T(i % 101);
+    }
+    return v;
+}
+
+
+template<class _T>
+void check_round_trip() {
+    string __path = "test_serialize.bin";
+    for (size_t __n : {0, 1, 17, 300000}) {
+        auto v = counted<_T>(__n);
+        stringstream s;
+        CHECK(v.Save(s));
+        CHECK(same(Vector<_T>::Load(s), v));
+        CHECK(v.Save(__path));
+        CHECK(same(Vector<_T>::Load(__path), v));
+        CHECK(same(Vector<_T>::Map(__path), v) && same(Vector<_T>::Map(__path, true), v));
+    }
+
+    auto m = Matrix2D<_T>::ZeroInit(123, 45);
+    m += counted<_T>(45);
+    stringstream s;
+    CHECK(m.Save(s) && same(Matrix2D<_T>::Load(s), m));
+    CHECK(m.Save(__path));
+    CHECK(same(Matrix2D<_T>::Load(__path), m) && same(Matrix2D<_T>::Map(__path, true), m));
+
+    // a mapping is private, writing to it leaves the file as it was
+    {
+        auto mapped = Matrix2D<_T>::Map(__path);
+        if (CHECK(mapped.Row() > 3 && mapped.Col() > 4)) {
+            mapped(3, 4) = _T(99);
+        }
+    }
+    CHECK(same(Matrix2D<_T>::Load(__path), m));
+
+    // rows stored with padding come back packed
+    ostringstream padded;
+    _T rows[3][8] = {};
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 5; j++) {
+            rows[i][j] = _T(i * 5 + j);
+        }
+    }
+    CHECK(serial_save(padded, 2, 3, 5, 8, &rows[0][0]));
+    istringstream in(padded.str());
+    auto p = Matrix2D<_T>::Load(in);
+    CHECK(p.Row() == 3 && p.Col() == 5 && p.Stride() == 5);
+    for (size_t i = 0; i < p.Row(); i++) {
+        for (size_t j = 0; j < p.Col(); j++) {
+            CHECK(p(i, j) == rows[i][j]);
+        }
+    }
+    remove(__path.c_str());
+}
+
+
+void check_rejected() {
+    string __path = "test_serialize_bad.bin";
+    auto m = Matrix2D<float>::RandomInit(64, 32, 71);
+    CHECK(m.Save(__path));
+    string good = file_bytes(__path);
+
+    // another element type, another rank
+    CHECK(Matrix2D<double>::Load(__path).Row() == 0 && Matrix2D<int32_t>::Map(__path).Row() == 0);
+    CHECK(Vector<float>::Load(__path).Size() == 0 && Vector<float>::Map(__path).Size() == 0);
+
+    // a flipped data byte fails the checksum of Load and of a verified Map
+    string bad = good;
+    bad[SERIAL_DATA_OFFSET + 1000] ^= 1;
+    write_bytes(__path, bad);
+    CHECK(Matrix2D<float>::Load(__path).Row() == 0 && Matrix2D<float>::Map(__path, true).Row() == 0);
+    CHECK(Matrix2D<float>::Map(__path).Row() == 64);
+
+    // truncated in the header, in the padding and in the data
+    for (size_t __len : {size_t(0), size_t(100), SERIAL_DATA_OFFSET - 8, good.size() - 1}) {
+        write_bytes(__path, good.substr(0, __len));
+        CHECK(Matrix2D<float>::Load(__path).Row() == 0 && Matrix2D<float>::Map(__path).Row() == 0);
+        istringstream in(good.substr(0, __len));
+        CHECK(Matrix2D<float>::Load(in).Row() == 0);
+    }
+
+    // a header claiming terabytes: too large for size_t, or larger than the file
+    SerialHeader h;
+    memcpy(&h, good.data(), sizeof(h));
+    for (uint64_t __rows : {uint64_t(1) << 62, uint64_t(1) << 40, uint64_t(1) << 20}) {
+        SerialHeader c = h;
+        c.row = __rows;
+        c.col = c.stride = uint64_t(1) << 20;
+        string crafted = string(reinterpret_cast<const char*>(&c), sizeof(c)) + good.substr(sizeof(c));
+        write_bytes(__path, crafted);
+        CHECK(Matrix2D<float>::Load(__path).Row() == 0 && Matrix2D<float>::Map(__path).Row() == 0);
+        istringstream in(crafted);
+        CHECK(Matrix2D<float>::Load(in).Row() == 0);
+    }
+
+    // the data offset past the end of the file
+    SerialHeader c = h;
+    c.offset = uint64_t(1) << 40;
+    string crafted = string(reinterpret_cast<const char*>(&c), sizeof(c)) + good.substr(sizeof(c));
+    write_bytes(__path, crafted);
+    CHECK(Matrix2D<float>::Load(__path).Row() == 0 && Matrix2D<float>::Map(__path).Row() == 0);
+
+    // a missing file
+    remove(__path.c_str());
+    CHECK(Matrix2D<float>::Load(__path).Row() == 0 && Matrix2D<float>::Map(__path).Row() == 0);
+}
+
+
+int main() {
+    check_threads([] {
+        check_round_trip<float>();
+        check_round_trip<double>();
+        check_round_trip<int16_t>();
+        check_round_trip<uint8_t>();
+        check_rejected();
+    });
+    return check_result();
+}
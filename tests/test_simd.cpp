@@ -0,0 +1,116 @@
+#include <vector>
+
+#include "Vector.hpp"
+#include "Simd.hpp"
+#include "Check.hpp"
+
+// every kernel set the machine can run (scalar, 128-bit, AVX2, AVX-512) against plain loops, on sizes
+// around the vector width, the accumulator step and SIMD_BLOCK, and at unaligned starts; argmax must
+// give the first index of the maximum whatever lane it was found in
+
+
+template<class _T>
+vector<SimdKernels<_T>> kernel_sets() {
+    vector<SimdKernels<_T>> sets = {{ simd_sum_scalar<_T>, simd_min_scalar<_T>, simd_max_scalar<_T>, simd_argmax_scalar<_T>,
+                                      simd_dot_scalar<_T>, simd_dot4_scalar<_T> }};
+#ifdef _SIMD_VECTOR_EXT
+    sets.push_back({ simd_sum_base<_T>, simd_min_base<_T>, simd_max_base<_T>, simd_argmax_base<_T>,
+                     simd_dot_base<_T>, simd_dot4_base<_T> });
+#endif
+#ifdef _SIMD_X86_DISPATCH
+    if (simd_level() >= SimdLevel::AVX2) {
+        sets.push_back({ simd_sum_avx2<_T>, simd_min_avx2<_T>, simd_max_avx2<_T>, simd_argmax_avx2<_T>,
+                         simd_dot_avx2<_T>, simd_dot4_avx2<_T> });
+    }
+    if (simd_level() >= SimdLevel::AVX512) {
+        sets.push_back({ simd_sum_avx512<_T>, simd_min_avx512<_T>, simd_max_avx512<_T>, simd_argmax_avx512<_T>,
+                         simd_dot_avx512<_T>, simd_dot4_avx512<_T> });
+    }
+#endif
+    return sets;
+}
+
+
+template<class _T>
+void check_kernels(double __tol) {
+    vector<size_t> sizes;
+    for (size_t __n = 1; __n <= 80; __n++) {
+        sizes.push_back(__n);
+    }
+    for (size_t __n : {255, 256, 257, 4095, 4096, 4097, 3 * 4096 + 5}) {
+        sizes.push_back(__n);
+    }
+    // room for the four rows of dot4 behind x, then y
+    size_t __len = 3 * 4096 + 8;
+    auto data = Vector<_T>::RandomInit(5 * __len + 20, 51);
+    const _T *x = data.Begin();
+    const _T *y = data.Begin() + 4 * __len + 20;
+
+    for (auto &k : kernel_sets<_T>()) {
+        for (size_t __n : sizes) {
+            for (size_t __off : {0, 1, 3}) {
+                const _T *p = x + __off, *q = y + __off;
+                double __sum = 0, __dot = 0;
+                _T __min = p[0], __max = p[0];
+                size_t __arg = 0;
+                for (size_t i = 0; i < __n; i++) {
+                    __sum += p[i];
+                    __dot += double(p[i]) * q[i];
+                    __min = min(__min, p[i]);
+                    if (p[i] > __max) {
+                        __max = p[i];
+                        __arg = i;
+                    }
+                }
+                CHECK_NEAR(k.sum(p, __n), __sum, __tol);
+                CHECK_NEAR(k.dot(p, q, __n), __dot, __tol);
+                CHECK(k.min(p, __n) == __min && k.max(p, __n) == __max);
+                CHECK(k.argmax(p, __n) == __arg);
+
+                // four rows __n + 5 apart against q
+                double out[4];
+                k.dot4(p, __n + 5, q, __n, out);
+                for (size_t r = 0; r < 4; r++) {
+                    double __d = 0;
+                    for (size_t i = 0; i < __n; i++) {
+                        __d += double(p[r * (__n + 5) + i]) * q[i];
+                    }
+                    CHECK_NEAR(out[r], __d, __tol);
+                }
+            }
+        }
+
+        // the maximum repeated in every lane and both halves: the first one wins
+        vector<_T> ties(1000, _T(0));
+        for (size_t i : {997, 613, 64, 37, 9}) {
+            ties[i] = _T(1);
+            CHECK(k.argmax(ties.data(), ties.size()) == i);
+        }
+    }
+}
+
+
+// the Vector reductions that run on them, integers included
+void check_vector() {
+    auto v = Vector<float>::RandomInit(10007, 52);
+    double __sum = 0;
+    for (size_t i = 0; i < v.Size(); i++) {
+        __sum += v[i];
+    }
+    CHECK_NEAR(v.Mean(), __sum / v.Size(), 1e-6);
+    CHECK_NEAR(v.Dot(v * 0.f + 1.f), __sum, 1e-6);
+
+    Vector<int> n = {5, -3, 9, 9, 2, -7, 9, 0};
+    CHECK(n.Max() == 9 && n.Min() == -7 && n.Argmax() == 2);
+    CHECK(n.Mean() == 3);
+}
+
+
+int main() {
+    check_threads([] {
+        check_kernels<float>(1e-5);
+        check_kernels<double>(1e-12);
+        check_vector();
+    });
+    return check_result();
+}
@@ -0,0 +1,269 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// Sort, Argsort, TopK and Quantile against std::stable_sort with the library's order written out:
+// NaN last in both directions, -0 equal to 0, equal values in index order. The inputs are full of
+// ties and, for floats, of NaN, signed zeros and infinities; the lengths cross the insertion sort,
+// the panel split and the small-bucket cut of the radix select. The Matrix2D axis variants are
+// checked against the Vector ones on every column, row and the whole matrix
+
+
+template<class _T>
+bool before(_T a, _T b, bool __descending) {
+    if (a != a) {
+        return false;
+    }
+    if (b != b) {
+        return true;
+    }
+    return __descending ? b < a : a < b;
+}
+
+
+template<class _T>
+bool same_value(_T a, _T b) {
+    return (a != a && b != b) || a == b;
+}
+
+
+template<class _T>
+vector<size_t> naive_argsort(const Vector<_T> &x, bool __descending) {
+    vector<size_t> idx(x.Size());
+    for (size_t i = 0; i < idx.size(); i++) {
+        idx[i] = i;
+    }
+    stable_sort(idx.begin(), idx.end(), [&](size_t i, size_t j) { return before(x[i], x[j], __descending); });
+    return idx;
+}
+
+
+// NumPy's linear interpolation, the same arithmetic as sort_quantile
+template<class _T>
+_T naive_quantile(const Vector<_T> &x, const vector<size_t> &idx, double __q) {
+    if (x.Size() == 0) {
+        return _T(0);
+    }
+    __q = min(1.0, max(0.0, __q));
+    double __pos = __q * double(x.Size() - 1);
+    size_t __lo = size_t(__pos);
+    double __frac = __pos - double(__lo);
+    _T __a = x[idx[__lo]];
+    if (__frac == 0 || __lo + 1 >= x.Size()) {
+        return __a;
+    }
+    _T __b = x[idx[__lo + 1]];
+    return __a == __b ? __a : _T(double(__a) + __frac * (double(__b) - double(__a)));
+}
+
+
+template<class _T>
+_T naive_quantile(const Vector<_T> &x, double __q) {
+    return naive_quantile(x, naive_argsort(x, false), __q);
+}
+
+
+// half of the values from a handful, so there are long runs of ties
+template<class _T>
+Vector<_T> sample(size_t __n, size_t __seed) {
+    auto u = Vector<double>::RandomInit(__n, __seed);
+    auto x = Vector<_T>::ZeroInit(__n);
+    for (size_t i = 0; i < __n; i++) {
+        double __few = floor(u[i] * 8), __many = u[i];
+        if constexpr (is_floating_point_v<_T>) {
+            x[i] = i % 2 ? _T(__few / 4) : _T(__many * 1000);
+            x[i] = i % 37 == 5 ? numeric_limits<_T>::quiet_NaN() : x[i];
+            x[i] = i % 41 == 7 ? -_T(0) : x[i];
+            x[i] = i % 53 == 11 ? _T(i % 2 ? 1 : -1) * numeric_limits<_T>::infinity() : x[i];
+        } else if constexpr (is_signed_v<_T>) {
+            x[i] = i % 2 ? _T(__few) : _T(__many * double(numeric_limits<_T>::max()));
+            x[i] = i % 61 == 3 ? numeric_limits<_T>::min() : x[i];
+        } else {
+            x[i] = i % 2 ? _T(__few + 8) : _T((__many + 1) * 127.5);
+        }
+    }
+    return x;
+}
+
+
+template<class _T>
+void check_vector(const Vector<_T> &x) {
+    size_t __n = x.Size();
+    for (bool __descending : {false, true}) {
+        auto idx = naive_argsort(x, __descending);
+        auto s = x.Sort(__descending);
+        auto a = x.Argsort(__descending);
+        CHECK((s.Size() == __n && a.Size() == __n));
+        bool __sorted = true, __args = true;
+        for (size_t i = 0; i < __n && s.Size() == __n && a.Size() == __n; i++) {
+            __sorted = __sorted && same_value(s[i], x[idx[i]]);
+            __args = __args && a[i] == idx[i];
+        }
+        CHECK(__sorted);
+        CHECK(__args);
+
+        // TopK(k, largest) is the head of the stable descending order, TopK(k, false) of the ascending
+        for (size_t __k : {size_t(0), size_t(1), size_t(10), __n / 2, __n, __n + 5}) {
+            auto t = x.TopK(__k, __descending);
+            size_t __m = min(__k, __n);
+            CHECK(t.Size() == __m);
+            bool __top = true;
+            for (size_t i = 0; i < __m && t.Size() == __m; i++) {
+                __top = __top && t[i] == idx[i];
+            }
+            CHECK(__top);
+        }
+    }
+    auto up = naive_argsort(x, false);
+    for (double __q : {-0.5, 0.0, 0.1, 0.25, 0.5, 0.9, 0.99, 1.0, 1.5}) {
+        CHECK(same_value(x.Quantile(__q), naive_quantile(x, up, __q)));
+    }
+    CHECK(same_value(x.Median(), naive_quantile(x, up, 0.5)));
+}
+
+
+template<class _T>
+void check_vectors() {
+    for (size_t __n : {0, 1, 2, 5, 64, 65, 1000, 20000, 300000}) {
+        check_vector(sample<_T>(__n, 181 + __n));
+    }
+    // a constant input skips every radix pass, a view goes through a copy
+    check_vector(Vector<_T>::OneInit(5000));
+    auto x = sample<_T>(3000, 182);
+    check_vector(Vector<_T>(x.Slice(7, 2900)));
+    auto s = x.Slice(7, 2900);
+    auto a = s.Argsort(), b = Vector<_T>(s).Argsort();
+    CHECK((a.Size() == b.Size() && equal(a.Begin(), a.Begin() + a.Size(), b.Begin())));
+}
+
+
+// floats whose order only the sign bit, the exponent or the last mantissa bit decides
+void check_float_keys() {
+    float __tiny = numeric_limits<float>::denorm_min(), __max = numeric_limits<float>::max();
+    Vector<float> x{1.f, -1.f, 0.f, -0.f, __tiny, -__tiny, __max, -__max, nextafterf(1.f, 2.f), nextafterf(-1.f, -2.f),
+                    numeric_limits<float>::infinity(), -numeric_limits<float>::infinity(), -numeric_limits<float>::quiet_NaN(), 0.f};
+    check_vector(x);
+    auto s = x.Sort();
+    CHECK((s[0] == -numeric_limits<float>::infinity() && s[1] == -__max && s[5] == 0 && s[8] == __tiny && std::isnan(s[13])));
+    auto a = x.Argsort();
+    CHECK((a[5] == 2 && a[6] == 3 && a[7] == 13));
+    CHECK((x.Quantile(0.5) == 0 && Vector<float>{-__max, __max}.Quantile(0.5) == 0 && Vector<float>{-numeric_limits<float>::infinity(), -numeric_limits<float>::infinity()}.Median() < 0));
+    CHECK((Vector<int32_t>{numeric_limits<int32_t>::min(), numeric_limits<int32_t>::max()}.Quantile(0.75) == 1073741823));
+    auto d = x.Argsort(true);
+    CHECK((d[0] == 10 && d[5] == 2 && d[6] == 3 && d[7] == 13 && d[13] == 12));
+}
+
+
+template<class _T>
+void check_matrix() {
+    size_t shapes[][2] = {{1, 1}, {7, 3}, {100, 37}, {3, 1000}, {2000, 20}};
+    for (auto &__shape : shapes) {
+        size_t __r = __shape[0], __c = __shape[1];
+        auto flat = sample<_T>(__r * __c, 183 + __r);
+        auto m = Matrix2D<_T>::ZeroInit(__r, __c);
+        for (size_t i = 0; i < __r; i++) {
+            for (size_t j = 0; j < __c; j++) {
+                m(i, j) = flat[i * __c + j];
+            }
+        }
+
+        for (bool __descending : {false, true}) {
+            auto sc = m.Sort(Axis2D::COL, __descending), ac = m.Argsort(Axis2D::COL, __descending);
+            auto sr = m.Sort(Axis2D::ROW, __descending), ar = m.Argsort(Axis2D::ROW, __descending);
+            auto tc = m.TopK(5, Axis2D::COL, __descending), tr = m.TopK(5, Axis2D::ROW, __descending);
+            CHECK((sc.Row() == __r && sc.Col() == __c && ac.Row() == __r && ac.Col() == __c));
+            CHECK((sr.Row() == __r && sr.Col() == __c && ar.Row() == __r && ar.Col() == __c));
+            CHECK((tc.Row() == min<size_t>(5, __r) && tc.Col() == __c && tr.Row() == __r && tr.Col() == min<size_t>(5, __c)));
+            bool __ok = true;
+            for (size_t j = 0; j < __c; j++) {
+                auto col = Vector<_T>::ZeroInit(__r);
+                for (size_t i = 0; i < __r; i++) {
+                    col[i] = m(i, j);
+                }
+                auto s = col.Sort(__descending);
+                auto a = col.Argsort(__descending);
+                auto t = col.TopK(5, __descending);
+                for (size_t i = 0; i < __r; i++) {
+                    __ok = __ok && same_value(sc(i, j), s[i]) && ac(i, j) == a[i];
+                }
+                for (size_t i = 0; i < t.Size(); i++) {
+                    __ok = __ok && tc(i, j) == t[i];
+                }
+            }
+            for (size_t i = 0; i < __r; i++) {
+                auto row = Vector<_T>(m.Row(i));
+                auto s = row.Sort(__descending);
+                auto a = row.Argsort(__descending);
+                auto t = row.TopK(5, __descending);
+                for (size_t j = 0; j < __c; j++) {
+                    __ok = __ok && same_value(sr(i, j), s[j]) && ar(i, j) == a[j];
+                }
+                for (size_t j = 0; j < t.Size(); j++) {
+                    __ok = __ok && tr(i, j) == t[j];
+                }
+            }
+            CHECK(__ok);
+
+            // the whole matrix in row-major order, and a transposed view swaps the axes
+            auto sa = m.Sort(Axis2D::ALL, __descending), aa = m.Argsort(Axis2D::ALL, __descending);
+            auto ta = m.TopK(10, Axis2D::ALL, __descending);
+            auto s = flat.Sort(__descending);
+            auto a = flat.Argsort(__descending);
+            auto t = flat.TopK(10, __descending);
+            CHECK((sa.Row() == __r && sa.Col() == __c && ta.Row() == 1 && ta.Col() == t.Size()));
+            __ok = true;
+            for (size_t k = 0; k < __r * __c; k++) {
+                __ok = __ok && same_value(sa(k / __c, k % __c), s[k]) && aa(k / __c, k % __c) == a[k];
+            }
+            for (size_t k = 0; k < t.Size(); k++) {
+                __ok = __ok && ta(0, k) == t[k];
+            }
+            auto vc = m.T().Argsort(Axis2D::COL, __descending);
+            for (size_t i = 0; i < __r; i++) {
+                for (size_t j = 0; j < __c; j++) {
+                    __ok = __ok && vc(j, i) == ar(i, j);
+                }
+            }
+            CHECK(__ok);
+        }
+
+        for (double __q : {0.0, 0.3, 0.5, 1.0}) {
+            auto qc = m.Quantile(__q, Axis2D::COL), qr = m.Quantile(__q, Axis2D::ROW), qa = m.Quantile(__q, Axis2D::ALL);
+            CHECK((qc.Size() == __c && qr.Size() == __r && qa.Size() == 1));
+            for (size_t j = 0; j < __c; j++) {
+                auto col = Vector<_T>::ZeroInit(__r);
+                for (size_t i = 0; i < __r; i++) {
+                    col[i] = m(i, j);
+                }
+                CHECK(same_value(qc[j], naive_quantile(col, __q)));
+            }
+            for (size_t i = 0; i < __r; i++) {
+                CHECK(same_value(qr[i], naive_quantile(Vector<_T>(m.Row(i)), __q)));
+            }
+            CHECK(same_value(qa[0], naive_quantile(flat, __q)));
+        }
+        CHECK(same_value(m.Median(Axis2D::COL)[0], m.Quantile(0.5, Axis2D::COL)[0]));
+    }
+}
+
+
+int main() {
+    check_threads([] {
+        check_vectors<float>();
+        check_vectors<double>();
+        check_vectors<int32_t>();
+        check_vectors<int16_t>();
+        check_vectors<uint8_t>();
+        check_float_keys();
+        check_matrix<float>();
+        check_matrix<double>();
+        check_matrix<int32_t>();
+    });
+    return check_result();
+}
@@ -0,0 +1,135 @@
+#include <cstring>
+#include <vector>
+
+#include "Sparse.hpp"
+#include "Check.hpp"
+
+// CSR and CSC against the dense matrix they were built from: conversions and transposes, the
+// products, the statistics along every axis (zeros included), triplets with duplicates and out of
+// range indices, and the same bits for every thread count
+
+
+// about 5% nonzeros, with an empty row and an empty column
+Matrix2D<double> sparse_dense(size_t __r, size_t __c, uint64_t __seed) {
+    auto m = Matrix2D<double>::RandomInit(__r, __c, __seed);
+    for (size_t i = 0; i < __r; i++) {
+        for (size_t j = 0; j < __c; j++) {
+            double __v = m(i, j);
+            m(i, j) = fabs(__v) > 0.95 && i != 3 && j != 5 ? __v : 0.0;
+        }
+    }
+    return m;
+}
+
+
+template<class _M>
+bool same_dense(const Matrix2D<double> &a, const _M &b) {
+    if (a.Row() != b.Row() || a.Col() != b.Col()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.Row(); i++) {
+        for (size_t j = 0; j < a.Col(); j++) {
+            if (a(i, j) != b(i, j)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+template<SparseLayout _L>
+void check_layout() {
+    size_t __r = 700, __c = 300;
+    auto d = sparse_dense(__r, __c, 121);
+    SparseMatrix<double, _L> s(d);
+
+    size_t __nnz = 0;
+    for (size_t i = 0; i < __r; i++) {
+        for (size_t j = 0; j < __c; j++) {
+            __nnz += d(i, j) != 0;
+        }
+    }
+    CHECK(s.Row() == __r && s.Col() == __c && s.NonZeros() == __nnz);
+    CHECK_NEAR(s.Density(), double(__nnz) / (__r * __c), 1e-12);
+    CHECK(same_dense(d, s.Dense()) && same_dense(d, s.ToCSR().Dense()) && same_dense(d, s.ToCSC().Dense()));
+    CHECK(same_dense(d, s.T().Dense().T()) && s.T().Row() == __c);
+
+    auto x = Vector<double>::RandomInit(__c, 122);
+    auto z = Vector<double>::RandomInit(__r, 123);
+    auto y = s.MatVec(x), t = s.MatVecT(z);
+    auto dy = d.MatVec(x), dt = d.MatVecT(z);
+    CHECK(y.Size() == __r && t.Size() == __c);
+    for (size_t i = 0; i < __r; i++) {
+        CHECK_NEAR(y[i], dy[i], 1e-12);
+    }
+    for (size_t j = 0; j < __c; j++) {
+        CHECK_NEAR(t[j], dt[j], 1e-12);
+    }
+    CHECK(s.MatVec(z).Size() == 0);
+
+    auto w = Matrix2D<double>::RandomInit(__c, 37, 124);
+    auto p = s * w;
+    Matrix2D<double> dp = d * w;
+    CHECK(p.Row() == __r && p.Col() == 37);
+    for (size_t i = 0; i < __r; i++) {
+        for (size_t j = 0; j < 37; j++) {
+            CHECK_NEAR(p(i, j), dp(i, j), 1e-12);
+        }
+    }
+
+    for (Axis2D axis : {Axis2D::ALL, Axis2D::COL, Axis2D::ROW}) {
+        auto mean = s.Mean(axis), sd = s.STD(axis), mn = s.Min(axis), mx = s.Max(axis);
+        auto dmean = d.Mean(axis), dsd = d.STD(axis), dmn = d.Min(axis), dmx = d.Max(axis);
+        CHECK(mean.Size() == dmean.Size() && sd.Size() == dsd.Size() && mn.Size() == dmn.Size());
+        for (size_t k = 0; k < mean.Size() && k < dmean.Size(); k++) {
+            CHECK_NEAR(mean[k], dmean[k], 1e-12);
+            CHECK_NEAR(sd[k], dsd[k], 1e-12);
+            CHECK(mn[k] == dmn[k] && mx[k] == dmx[k]);
+        }
+    }
+}
+
+
+void check_triplets() {
+    vector<uint32_t> r = {0, 2, 1, 2, 0}, c = {1, 0, 3, 0, 1};
+    vector<float> v = {1.f, 2.f, 3.f, 4.f, 5.f};
+    auto a = CSRMatrix<float>::FromTriplets(3, 4, r.data(), c.data(), v.data(), v.size());
+    auto b = CSCMatrix<float>::FromTriplets(3, 4, r.data(), c.data(), v.data(), v.size());
+    CHECK(a.NonZeros() == 3 && b.NonZeros() == 3);
+    auto da = a.Dense(), db = b.Dense();
+    CHECK(da(0, 1) == 6.f && da(2, 0) == 6.f && da(1, 3) == 3.f && da(1, 1) == 0.f);
+    CHECK(memcmp(da.Begin(), db.Begin(), 12 * sizeof(float)) == 0);
+
+    c[2] = 4;
+    auto bad = CSRMatrix<float>::FromTriplets(3, 4, r.data(), c.data(), v.data(), v.size());
+    CHECK(bad.Row() == 0 && bad.NonZeros() == 0);
+}
+
+
+void check_threads_agree() {
+    auto d = sparse_dense(30000, 200, 125);
+    CSRMatrix<double> s(d);
+    auto x = Vector<double>::RandomInit(30000, 126);
+    Vector<double> t[2], m[2];
+    size_t __threads[2] = {1, 4};
+    for (size_t k = 0; k < 2; k++) {
+        ThreadPool::SetThreadCount(__threads[k]);
+        ThreadPool::Global().SetSerialThreshold(1 << 10);
+        t[k] = s.MatVecT(x);
+        m[k] = s.STD(Axis2D::COL);
+    }
+    CHECK(memcmp(t[0].Begin(), t[1].Begin(), 200 * sizeof(double)) == 0);
+    CHECK(memcmp(m[0].Begin(), m[1].Begin(), 200 * sizeof(double)) == 0);
+}
+
+
+int main() {
+    check_threads([] {
+        check_layout<SparseLayout::CSR>();
+        check_layout<SparseLayout::CSC>();
+        check_triplets();
+    });
+    check_threads_agree();
+    return check_result();
+}
@@ -0,0 +1,97 @@
+#include <vector>
+
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// the single-pass Describe against a two-pass mean / population variance and a scan for the extrema
+
+
+struct Naive {
+    double mean = 0, std = 0, min = 0, max = 0;
+    size_t argmin = 0, argmax = 0;
+};
+
+
+template<class _F>
+Naive naive_describe(size_t __n, _F get) {
+    Naive d;
+    if (__n == 0) {
+        return d;
+    }
+    d.min = d.max = get(0);
+    for (size_t i = 0; i < __n; i++) {
+        double v = get(i);
+        d.mean += v;
+        if (v < d.min) {
+            d.min = v;
+            d.argmin = i;
+        }
+        if (v > d.max) {
+            d.max = v;
+            d.argmax = i;
+        }
+    }
+    d.mean /= __n;
+    for (size_t i = 0; i < __n; i++) {
+        d.std += (get(i) - d.mean) * (get(i) - d.mean);
+    }
+    d.std = sqrt(d.std / __n);
+    return d;
+}
+
+
+template<class _D>
+void check_description(const _D &d, const Naive &ref, size_t __n, double __tol) {
+    CHECK(d.Count() == __n);
+    CHECK_NEAR(d.Mean(), ref.mean, __tol);
+    CHECK_NEAR(d.STD(), ref.std, __tol);
+    CHECK(d.Min() == ref.min && d.Max() == ref.max);
+    CHECK(d.Argmin() == ref.argmin && d.Argmax() == ref.argmax);
+}
+
+
+void check_vector() {
+    for (size_t __n : {1, 2, 255, 256, 257, 10007}) {
+        auto x = Vector<double>::NormalInit(__n, 3., 2., __n);
+        check_description(x.Describe(), naive_describe(__n, [&x](size_t i) { return x[i]; }), __n, 1e-12);
+    }
+
+    // a large offset is where a one-pass sum of squares loses every digit
+    auto y = Vector<float>::RandomInit(5000, 7);
+    y += 1e4f;
+    check_description(y.Describe(), naive_describe(5000, [&y](size_t i) { return y[i]; }), 5000, 1e-4);
+
+    // ties keep the first index
+    Vector<int> t = {3, 1, 4, 1, 5, 9, 2, 6, 5, 9};
+    auto d = t.Describe();
+    CHECK(d.Argmin() == 1 && d.Argmax() == 5);
+}
+
+
+void check_matrix() {
+    size_t __r = 301, __c = 13;
+    auto m = Matrix2D<double>::RandomInit(__r, __c, 8);
+
+    auto cols = m.Describe(Axis2D::COL);
+    CHECK(cols.size() == __c);
+    for (size_t j = 0; j < __c; j++) {
+        check_description(cols[j], naive_describe(__r, [&](size_t i) { return m(i, j); }), __r, 1e-12);
+    }
+    auto rows = m.Describe(Axis2D::ROW);
+    CHECK(rows.size() == __r);
+    for (size_t i = 0; i < __r; i++) {
+        check_description(rows[i], naive_describe(__c, [&](size_t j) { return m(i, j); }), __c, 1e-12);
+    }
+    auto all = m.Describe(Axis2D::ALL);
+    check_description(all[0], naive_describe(__r * __c, [&](size_t k) { return m(k / __c, k % __c); }), __r * __c, 1e-12);
+}
+
+
+int main() {
+    check_threads([] {
+        check_vector();
+        check_matrix();
+    });
+    return check_result();
+}
@@ -0,0 +1,216 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fstream>
+
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Stream.hpp"
+#include "Check.hpp"
+
+// stream_column_stats against the in-memory column statistics of the whole matrix, which it must
+// match bit for bit whatever the block size, and against a naive two-pass reference; stream_transform
+// against the same expression on the whole matrix; and the sources that must fail: a flipped byte, a
+// truncated file, a missing file
+
+
+template<class _T>
+bool same_bits(const Vector<_T> &a, const Vector<_T> &b) {
+    return a.Size() == b.Size() && (a.Size() == 0 || memcmp(a.Begin(), b.Begin(), a.Size() * sizeof(_T)) == 0);
+}
+
+
+template<class _T>
+bool same_bits(const Matrix2D<_T> &a, const Matrix2D<_T> &b) {
+    if (a.Row() != b.Row() || a.Col() != b.Col()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.Row(); i++) {
+        if (memcmp(a.Begin() + i * a.Stride(), b.Begin() + i * b.Stride(), a.Col() * sizeof(_T)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+string file_bytes(const string &__path) {
+    ifstream in(__path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+
+void write_bytes(const string &__path, const string &__bytes) {
+    ofstream out(__path, ios::binary | ios::trunc);
+    out.write(__bytes.data(), streamsize(__bytes.size()));
+}
+
+
+template<class _T>
+void check_stats_equal(const StreamStats<_T> &s, const Matrix2D<_T> &m) {
+    CHECK(s.Rows() == m.Row());
+    CHECK(same_bits(s.Mean(), Vector<_T>(m.Mean(Axis2D::COL))));
+    CHECK(same_bits(s.STD(), Vector<_T>(m.STD(Axis2D::COL))));
+    CHECK(same_bits(s.Min(), Vector<_T>(m.Min(Axis2D::COL))));
+    CHECK(same_bits(s.Max(), Vector<_T>(m.Max(Axis2D::COL))));
+
+    auto d = m.Describe(Axis2D::COL);
+    CHECK(s.Describe().size() == d.size());
+    for (size_t j = 0; j < d.size() && j < s.Describe().size(); j++) {
+        const auto &a = s.Describe()[j];
+        CHECK((a.Count() == d[j].Count() && a.Mean() == d[j].Mean() && a.Variance() == d[j].Variance()));
+        CHECK((a.Min() == d[j].Min() && a.Max() == d[j].Max() && a.Argmin() == d[j].Argmin() && a.Argmax() == d[j].Argmax()));
+    }
+
+    // two passes in double, first index of the extrema
+    for (size_t j = 0; j < m.Col() && s.Rows() == m.Row(); j++) {
+        double __mean = 0, __var = 0;
+        size_t __argmin = 0, __argmax = 0;
+        for (size_t i = 0; i < m.Row(); i++) {
+            __mean += m(i, j);
+            __argmin = m(i, j) < m(__argmin, j) ? i : __argmin;
+            __argmax = m(i, j) > m(__argmax, j) ? i : __argmax;
+        }
+        __mean /= m.Row();
+        for (size_t i = 0; i < m.Row(); i++) {
+            __var += (m(i, j) - __mean) * (m(i, j) - __mean);
+        }
+        double __tol = is_same_v<_T, float> ? 1e-4 : 1e-12;
+        CHECK_NEAR(s.Mean()[j], __mean, __tol);
+        CHECK_NEAR(s.STD()[j], sqrt(__var / m.Row()), __tol);
+        CHECK((s.Min()[j] == m(__argmin, j) && s.Describe()[j].Argmin() == __argmin));
+        CHECK((s.Max()[j] == m(__argmax, j) && s.Describe()[j].Argmax() == __argmax));
+    }
+}
+
+
+// file sources of a few shapes, with blocks of one grain up to the whole matrix
+template<class _T>
+void check_file_stats() {
+    string __path = "test_stream.bin";
+    size_t shapes[][2] = {{1, 1}, {3, 5}, {1000, 7}, {4097, 33}, {20000, 3}};
+    for (auto &__shape : shapes) {
+        auto m = Matrix2D<_T>::RandomInit(__shape[0], __shape[1], 171);
+        for (size_t i = 0; i < m.Row(); i += 17) {
+            m(i, 0) += _T(100);
+        }
+        CHECK(m.Save(__path));
+        for (size_t __bytes : {size_t(1), size_t(1) << 12, size_t(1) << 16, STREAM_CHUNK_BYTES}) {
+            RowSource<_T> source(__path);
+            CHECK(source.Ok() && source.Col() == m.Col());
+            auto s = stream_column_stats(source, __bytes);
+            CHECK(source.Ok() && source.Rows() == m.Row());
+            check_stats_equal(s, m);
+        }
+    }
+    remove(__path.c_str());
+}
+
+
+// a generator source handing out a few rows per call gives the statistics of the same rows in memory
+void check_generator_stats() {
+    auto m = Matrix2D<double>::RandomInit(5003, 9, 172);
+    size_t __next = 0;
+    RowSource<double> source(m.Col(), [&](double *dst, size_t __n) {
+        size_t __k = min({__n, size_t(13), m.Row() - __next});
+        for (size_t i = 0; i < __k; i++, __next++) {
+            memcpy(dst + i * m.Col(), &m(__next, 0), m.Col() * sizeof(double));
+        }
+        return __k;
+    });
+    check_stats_equal(stream_column_stats(source, 1 << 14), m);
+
+    // no rows: empty statistics
+    RowSource<double> none(4, [](double*, size_t) { return size_t(0); });
+    auto s = stream_column_stats(none);
+    CHECK((s.Rows() == 0 && s.Mean().Size() == 0 && s.STD().Size() == 0 && s.Min().Size() == 0 && s.Max().Size() == 0));
+}
+
+
+template<class _T>
+void check_transform() {
+    string __in = "test_stream_in.bin", __out = "test_stream_out.bin";
+    auto m = Matrix2D<_T>::RandomInit(3001, 19, 173);
+    CHECK(m.Save(__in));
+
+    for (size_t __bytes : {size_t(1) << 12, STREAM_CHUNK_BYTES}) {
+        RowSource<_T> first(__in);
+        auto s = stream_column_stats(first, __bytes);
+        auto mu = s.Mean(), sd = s.STD();
+
+        RowSource<_T> again(__in);
+        RowSink<_T> sink(__out, again.Col());
+        CHECK(stream_transform(again, sink, [&](const Matrix2DView<_T> &x) { return (x - mu) / sd; }, __bytes));
+        CHECK(sink.Close() && sink.Rows() == m.Row());
+        Matrix2D<_T> want = (m - mu) / sd;
+        CHECK(same_bits(Matrix2D<_T>::Load(__out), want));
+        CHECK(same_bits(Matrix2D<_T>::Map(__out, true), want));
+    }
+
+    // another width fails the sink, and so the transform
+    RowSource<_T> source(__in);
+    RowSink<_T> narrow(__out, 3);
+    CHECK(!stream_transform(source, narrow, [](const Matrix2DView<_T> &x) { return x * _T(2); }, 1 << 12));
+    CHECK(!narrow.Ok());
+
+    // rows written by hand, from a padded stride, in pieces that straddle the checksum chunks
+    RowSink<_T> sink(__out, m.Col());
+    for (size_t i = 0; i < m.Row(); i += 250) {
+        CHECK(sink.Write(&m(i, 0), min<size_t>(250, m.Row() - i), m.Stride()));
+    }
+    CHECK(sink.Close() && !sink.Write(&m(0, 0), 1, m.Stride()));
+    CHECK(same_bits(Matrix2D<_T>::Load(__out), m));
+    remove(__in.c_str());
+    remove(__out.c_str());
+}
+
+
+void check_rejected() {
+    string __path = "test_stream_bad.bin";
+    auto m = Matrix2D<float>::RandomInit(3000, 40, 174);
+    CHECK(m.Save(__path));
+    string good = file_bytes(__path);
+
+    // a flipped byte is only seen once the last row is read: the statistics are empty and the
+    // transform fails
+    for (size_t __at : {size_t(SERIAL_DATA_OFFSET + 10), good.size() - 1}) {
+        string bad = good;
+        bad[__at] ^= 1;
+        write_bytes(__path, bad);
+        for (size_t __bytes : {size_t(1) << 12, STREAM_CHUNK_BYTES}) {
+            RowSource<float> source(__path);
+            CHECK(source.Ok());
+            auto s = stream_column_stats(source, __bytes);
+            CHECK((!source.Ok() && s.Rows() == 0 && s.Mean().Size() == 0 && s.Describe().empty()));
+
+            RowSource<float> again(__path);
+            RowSink<float> sink("test_stream_bad_out.bin", 40);
+            CHECK(!stream_transform(again, sink, [](const Matrix2DView<float> &x) { return x + 1.f; }, __bytes));
+        }
+    }
+
+    // truncated data, another element type, a missing file
+    write_bytes(__path, good.substr(0, good.size() - 100));
+    RowSource<float> truncated(__path);
+    CHECK(stream_column_stats(truncated).Mean().Size() == 0 && !truncated.Ok());
+    write_bytes(__path, good);
+    CHECK(!RowSource<double>(__path).Ok() && RowSource<float>(__path).Ok());
+    RowSource<float> missing("test_stream_missing.bin");
+    CHECK(!missing.Ok() && stream_column_stats(missing).Rows() == 0);
+
+    remove(__path.c_str());
+    remove("test_stream_bad_out.bin");
+}
+
+
+int main() {
+    check_threads([] {
+        check_file_stats<float>();
+        check_file_stats<double>();
+        check_generator_stats();
+        check_transform<float>();
+        check_transform<double>();
+        check_rejected();
+    });
+    return check_result();
+}
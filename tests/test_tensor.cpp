@@ -0,0 +1,253 @@
+#include <cstring>
+#include <vector>
+
+#include "Tensor.hpp"
+#include "Check.hpp"
+
+// views, broadcasting and reductions against loops over multi-indices read through the strides, the
+// compound operators with a right-hand side that reads the same buffer, the copy of an empty tensor,
+// and reductions that give the same bits for every thread count
+
+
+// f(index) for every multi-index of shape, the last axis fastest
+template<class _F>
+void for_each_index(const TensorShape &__shape, _F f) {
+    size_t __n = 1;
+    for (size_t s : __shape) {
+        __n *= s;
+    }
+    TensorShape idx(__shape.size(), 0);
+    for (size_t k = 0; k < __n; k++) {
+        f(idx);
+        for (size_t d = __shape.size(); d-- > 0;) {
+            if (++idx[d] < __shape[d]) {
+                break;
+            }
+            idx[d] = 0;
+        }
+    }
+}
+
+
+template<class _T>
+_T at(const TensorView<_T> &v, const TensorShape &idx) {
+    const _T *p = v.Begin();
+    for (size_t d = 0; d < idx.size(); d++) {
+        p += idx[d] * v.Stride(d);
+    }
+    return *p;
+}
+
+
+// the element of a tensor of shape s broadcast to idx, axes aligned on the right
+template<class _T>
+_T at_broadcast(const TensorView<_T> &v, const TensorShape &idx) {
+    TensorShape own(v.Rank());
+    for (size_t d = 0; d < v.Rank(); d++) {
+        size_t i = idx[idx.size() - v.Rank() + d];
+        own[d] = v.Shape(d) == 1 ? 0 : i;
+    }
+    return at(v, own);
+}
+
+
+void check_views() {
+    auto x = Tensor<double>::RandomInit({4, 3, 5, 6}, 141);
+
+    auto p = x.Permute({2, 0, 3, 1});
+    CHECK((p.Shape() == TensorShape{5, 4, 6, 3}) && !p.Contiguous());
+    for_each_index(p.Shape(), [&](const TensorShape &i) {
+        CHECK(at(p, i) == at(x.View(), {i[1], i[3], i[0], i[2]}));
+    });
+
+    auto s = x.Slice(3, 1, 6, 2).Index(1, 2);
+    CHECK((s.Shape() == TensorShape{4, 5, 3}));
+    for_each_index(s.Shape(), [&](const TensorShape &i) {
+        CHECK(at(s, i) == at(x.View(), {i[0], 2, i[1], 1 + 2 * i[2]}));
+    });
+
+    auto r = x.Reshape({12, 30});
+    auto e = x.Index(0, 1).ExpandDims(0).BroadcastTo({7, 3, 5, 6});
+    CHECK((r.Shape() == TensorShape{12, 30}) && (e.Shape() == TensorShape{7, 3, 5, 6}));
+    CHECK(at(r, {7, 29}) == at(x.View(), {2, 1, 4, 5}) && at(e, {6, 2, 4, 5}) == at(x.View(), {1, 2, 4, 5}));
+    CHECK(p.Reshape({120, 3}).Size() == 0 && x.Permute({0, 0, 1, 2}).Size() == 0 && x.Index(1, 3).Size() == 0);
+
+    // a copy of a permuted view is contiguous, and T reverses the axes
+    Tensor<double> c(p);
+    CHECK(c.Contiguous() && c.Shape() == p.Shape());
+    for_each_index(c.Shape(), [&](const TensorShape &i) { CHECK(at(c.View(), i) == at(p, i)); });
+    CHECK((x.T().Shape() == TensorShape{6, 5, 3, 4}) && at(x.T(), {5, 4, 2, 3}) == at(x.View(), {3, 2, 4, 5}));
+}
+
+
+void check_broadcast() {
+    auto x = Tensor<double>::RandomInit({4, 3, 5, 6}, 142);
+    auto y = Tensor<double>::RandomInit({3, 1, 6}, 143);
+    auto z = Tensor<double>::RandomInit({4, 1, 5, 1}, 144);
+
+    auto a = (x - y) * z + 2.0;
+    auto b = y / (z + 3.0);
+    CHECK(a.Shape() == x.Shape() && (b.Shape() == TensorShape{4, 3, 5, 6}));
+    for_each_index(x.Shape(), [&](const TensorShape &i) {
+        double __y = at_broadcast(y.View(), i), __z = at_broadcast(z.View(), i);
+        CHECK_NEAR(at(a.View(), i), (at(x.View(), i) - __y) * __z + 2.0, 1e-12);
+        CHECK_NEAR(at(b.View(), i), __y / (__z + 3.0), 1e-12);
+    });
+
+    // operands that are themselves views
+    auto v = x.Permute({0, 1, 3, 2}) + y.Permute({0, 2, 1});
+    CHECK((v.Shape() == TensorShape{4, 3, 6, 5}));
+    for_each_index(v.Shape(), [&](const TensorShape &i) {
+        CHECK_NEAR(at(v.View(), i), at(x.View(), {i[0], i[1], i[3], i[2]}) + at(y.View(), {i[1], 0, i[2]}), 1e-12);
+    });
+
+    auto bad = x + Tensor<double>::RandomInit({2, 6}, 145);
+    CHECK(bad.Size() == 0);
+}
+
+
+void check_reductions() {
+    TensorShape __shape = {4, 3, 5, 6};
+    auto x = Tensor<double>::NormalInit(__shape, 1.0, 2.0, 146);
+
+    for (TensorShape __axes : {TensorShape{}, TensorShape{0}, TensorShape{1, 3}, TensorShape{0, 2, 3}, TensorShape{3}}) {
+        uint32_t __mask = 0;
+        for (size_t d : __axes) {
+            __mask |= 1u << d;
+        }
+        if (__axes.empty()) {
+            __mask = 0xf;
+        }
+        // the shape with the reduced axes kept as 1
+        TensorShape __kept = __shape;
+        for (size_t d = 0; d < 4; d++) {
+            __kept[d] = __mask >> d & 1 ? 1 : __shape[d];
+        }
+        size_t __count = x.Size() / (__kept[0] * __kept[1] * __kept[2] * __kept[3]);
+
+        auto sum = x.Sum(__axes, true), mean = x.Mean(__axes, true), sd = x.STD(__axes, true);
+        auto mn = x.Min(__axes, true), mx = x.Max(__axes, true);
+        CHECK(sum.Shape() == __kept && mean.Shape() == __kept && sd.Shape() == __kept);
+
+        vector<double> rs(sum.Size(), 0.0), rm(sum.Size(), 0.0), rmin(sum.Size(), 1e300), rmax(sum.Size(), -1e300);
+        auto flat = [&](const TensorShape &i) {
+            size_t __k = 0;
+            for (size_t d = 0; d < 4; d++) {
+                __k = __k * __kept[d] + (__mask >> d & 1 ? 0 : i[d]);
+            }
+            return __k;
+        };
+        for_each_index(__shape, [&](const TensorShape &i) {
+            double __v = at(x.View(), i);
+            rs[flat(i)] += __v;
+            rmin[flat(i)] = min(rmin[flat(i)], __v);
+            rmax[flat(i)] = max(rmax[flat(i)], __v);
+        });
+        for_each_index(__shape, [&](const TensorShape &i) {
+            double __d = at(x.View(), i) - rs[flat(i)] / __count;
+            rm[flat(i)] += __d * __d;
+        });
+        for (size_t k = 0; k < rs.size(); k++) {
+            CHECK_NEAR(sum.Begin()[k], rs[k], 1e-12);
+            CHECK_NEAR(mean.Begin()[k], rs[k] / __count, 1e-12);
+            CHECK_NEAR(sd.Begin()[k], sqrt(rm[k] / __count), 1e-12);
+            CHECK(mn.Begin()[k] == rmin[k] && mx.Begin()[k] == rmax[k]);
+        }
+
+        // without keep the reduced axes are dropped
+        auto dropped = x.Sum(__axes);
+        CHECK(dropped.Size() == sum.Size() && dropped.Rank() == 4 - size_t(__builtin_popcount(__mask)));
+    }
+    CHECK(x.Sum({4}).Size() == 0);
+
+    // a reduction over a view, and the Axis2D case
+    auto m = Matrix2D<double>::RandomInit(40, 30, 147);
+    TensorView<double> tv(m);
+    auto cols = tv.Sum(tensor_axes(Axis2D::COL));
+    auto mean = m.Mean(Axis2D::COL);
+    CHECK(cols.Size() == 30);
+    for (size_t j = 0; j < 30; j++) {
+        CHECK_NEAR(cols.Begin()[j] / 40, mean[j], 1e-12);
+    }
+}
+
+
+void check_updates() {
+    auto x = Tensor<double>::RandomInit({6, 6}, 148);
+    auto y = Tensor<double>::RandomInit({6}, 149);
+    Tensor<double> t = x;
+    t += y;
+    t *= 2.0;
+    for_each_index({6, 6}, [&](const TensorShape &i) {
+        CHECK_NEAR(at(t.View(), i), (at(x.View(), i) + at(y.View(), {i[1]})) * 2.0, 1e-12);
+    });
+
+    // the right-hand side reads the same buffer in another order: the old values are used
+    Tensor<double> s = x;
+    s += s.T();
+    s -= s.Slice(0, 0, 1).BroadcastTo({6, 6});
+    for_each_index({6, 6}, [&](const TensorShape &i) {
+        double __sym = at(x.View(), i) + at(x.View(), {i[1], i[0]});
+        double __row0 = at(x.View(), {0, i[1]}) + at(x.View(), {i[1], 0});
+        CHECK_NEAR(at(s.View(), i), __sym - __row0, 1e-12);
+    });
+
+    // the same view on the right is read in place
+    Tensor<double> u = x;
+    u *= u.View();
+    for_each_index({6, 6}, [&](const TensorShape &i) { CHECK(at(u.View(), i) == at(x.View(), i) * at(x.View(), i)); });
+}
+
+
+void check_empty() {
+    Tensor<float> e;
+    Tensor<float> c(e);
+    Tensor<float> d = e;
+    CHECK(e.Size() == 0 && c.Size() == 0 && d.Size() == 0 && c.Begin() == nullptr);
+    auto z = Tensor<float>::ZeroInit({3, 0, 2});
+    Tensor<float> zc(z);
+    CHECK(z.Size() == 0 && zc.Size() == 0 && (zc.Shape() == TensorShape{3, 0, 2}));
+
+    // the empty result of a failed operation as an operand: empty results, nothing updated
+    auto a = Tensor<float>::OneInit({2, 3});
+    auto bad = Tensor<float>::OneInit({2, 3}) + Tensor<float>::OneInit({4, 5});
+    CHECK(bad.Size() == 0 && bad.Begin() == nullptr);
+    auto l = bad + a, r = a * bad, b = bad - bad;
+    CHECK(l.Begin() == nullptr && r.Begin() == nullptr && b.Begin() == nullptr && l.Size() == 0);
+    a += Tensor<float>();
+    a /= bad;
+    CHECK((a.Shape() == TensorShape{2, 3} && a(0, 0) == 1 && a(1, 2) == 1));
+    Tensor<float> v{TensorView<float>()};
+    CHECK(v.Size() == 0 && v.Rank() == 0 && v.Begin() == nullptr);
+    CHECK(bad.Apply([](float x) { return x + 1; }).Begin() == nullptr);
+    auto zz = z + z;
+    CHECK((zz.Size() == 0 && zz.Shape() == TensorShape{3, 0, 2}));
+}
+
+
+void check_threads_agree() {
+    auto x = Tensor<float>::RandomInit({64, 3, 128, 128}, 150);
+    Tensor<float> s[2], m[2];
+    size_t __threads[2] = {1, 4};
+    for (size_t k = 0; k < 2; k++) {
+        ThreadPool::SetThreadCount(__threads[k]);
+        ThreadPool::Global().SetSerialThreshold(1 << 10);
+        s[k] = x.Sum();
+        m[k] = x.STD({0, 2, 3});
+    }
+    CHECK(memcmp(s[0].Begin(), s[1].Begin(), sizeof(float)) == 0);
+    CHECK(memcmp(m[0].Begin(), m[1].Begin(), 3 * sizeof(float)) == 0);
+}
+
+
+int main() {
+    check_threads([] {
+        check_views();
+        check_broadcast();
+        check_reductions();
+        check_updates();
+        check_empty();
+    });
+    check_threads_agree();
+    return check_result();
+}
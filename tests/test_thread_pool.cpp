@@ -0,0 +1,64 @@
+#include <vector>
+#include <string>
+#include <atomic>
+
+#include "ThreadPool.hpp"
+#include "Check.hpp"
+
+// ParallelFor covers every index once, ParallelReduce folds its chunks in order, nested calls finish
+
+
+void check_parallel_for() {
+    auto &pool = ThreadPool::Global();
+    for (size_t __n : {0, 1, 7, 1000, 100003}) {
+        vector<int> hits(__n, 0);
+        pool.ParallelFor(0, __n, 1, [&hits](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                hits[i]++;
+            }
+        });
+        CHECK(count(hits.begin(), hits.end(), 1) == long(__n));
+    }
+}
+
+
+// string concatenation is not commutative, so any reordering of the chunks shows
+void check_parallel_reduce() {
+    auto &pool = ThreadPool::Global();
+    size_t __n = 5000;
+    string s = pool.ParallelReduce(0, __n, 1, string(), [](size_t lo, size_t hi) {
+        string part;
+        for (size_t i = lo; i < hi; i++) {
+            part += char('a' + i % 26);
+        }
+        return part;
+    }, [](string acc, const string &part) { return acc + part; });
+
+    string ref;
+    for (size_t i = 0; i < __n; i++) {
+        ref += char('a' + i % 26);
+    }
+    CHECK(s == ref);
+}
+
+
+void check_nested() {
+    auto &pool = ThreadPool::Global();
+    atomic<size_t> __total{0};
+    pool.ParallelFor(0, 64, 1 << 10, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            pool.ParallelFor(0, 2000, 1, [&](size_t a, size_t b) { __total += b - a; });
+        }
+    });
+    CHECK(__total == 64 * 2000);
+}
+
+
+int main() {
+    check_threads([] {
+        check_parallel_for();
+        check_parallel_reduce();
+        check_nested();
+    });
+    return check_result();
+}
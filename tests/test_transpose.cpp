@@ -0,0 +1,77 @@
+#include <cstdint>
+
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// every transpose path against element-wise reads: the tiled out-of-place copy, the in-place swap of
+// square matrices, the copy of a T() view and of a transposed block, on sizes around the register
+// block and the 32 x 32 tile, with the element sizes that have a shuffle kernel and one that has not
+
+
+template<class _T>
+Matrix2D<_T> numbered(size_t __r, size_t __c) {
+    auto m = Matrix2D<_T>::ZeroInit(__r, __c);
+    for (size_t i = 0; i < __r; i++) {
+        for (size_t j = 0; j < __c; j++) {
+            m(i, j) = _T(i * __c + j);
+        }
+    }
+    return m;
+}
+
+
+template<class _M, class _T>
+bool is_transpose(const _M &t, const Matrix2D<_T> &m, size_t __r0 = 0, size_t __c0 = 0) {
+    for (size_t i = 0; i < t.Row(); i++) {
+        for (size_t j = 0; j < t.Col(); j++) {
+            if (t(i, j) != m(__r0 + j, __c0 + i)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+template<class _T>
+void check_type() {
+    for (size_t __r : {1, 3, 4, 31, 32, 33, 70}) {
+        for (size_t __c : {1, 2, 5, 32, 65}) {
+            auto m = numbered<_T>(__r, __c);
+
+            Matrix2D<_T> copy(m.T());
+            CHECK(copy.Row() == __c && copy.Col() == __r && is_transpose(copy, m));
+
+            auto t = m;
+            t.Transpose();
+            CHECK(t.Row() == __c && t.Col() == __r && is_transpose(t, m));
+
+            auto moved = Matrix2D<_T>(m).T();
+            CHECK(moved.Row() == __c && is_transpose(moved, m));
+        }
+    }
+
+    for (size_t __n : {1, 2, 3, 4, 17, 32, 33, 100}) {
+        auto m = numbered<_T>(__n, __n);
+        auto t = m;
+        t.Transpose();
+        CHECK(is_transpose(t, m));
+        t.Transpose();
+        CHECK(is_transpose(t.T(), m));
+    }
+
+    auto m = numbered<_T>(90, 70);
+    Matrix2D<_T> block(m.Block(5, 3, 40, 33).T());
+    CHECK(block.Row() == 33 && block.Col() == 40 && is_transpose(block, m, 5, 3));
+}
+
+
+int main() {
+    check_threads([] {
+        check_type<float>();
+        check_type<double>();
+        check_type<int32_t>();
+        check_type<int16_t>();
+    });
+    return check_result();
+}
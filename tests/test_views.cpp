@@ -0,0 +1,133 @@
+#include "Vector.hpp"
+#include "Matrix2D.hpp"
+#include "Check.hpp"
+
+// slices, batches, rows, columns and blocks read the buffer they come from, nested views compose
+// their strides, and reductions, expressions and the matrix product take them as they are
+
+
+void check_vector_views() {
+    auto x = Vector<double>::RandomInit(1000, 21);
+
+    for (size_t __step : {1, 2, 3, 7}) {
+        auto s = x.Slice(5, 998, __step);
+        CHECK(s.Size() == (998 - 5 + __step - 1) / __step && s.Step() == __step);
+        double __sum = 0, __max = x[5];
+        for (size_t i = 0; i < s.Size(); i++) {
+            CHECK(s[i] == x[5 + i * __step]);
+            __sum += x[5 + i * __step];
+            __max = max(__max, x[5 + i * __step]);
+        }
+        CHECK_NEAR(s.Mean(), __sum / s.Size(), 1e-12);
+        CHECK(s.Max() == __max);
+
+        // a slice of a slice multiplies the steps
+        auto ss = s.Slice(2, 50, 3);
+        for (size_t i = 0; i < ss.Size(); i++) {
+            CHECK(ss[i] == x[5 + (2 + i * 3) * __step]);
+        }
+    }
+    CHECK(x.Slice(10, 10).Size() == 0 && x.Slice(20, 10).Size() == 0);
+
+    // an expression over a view is evaluated like one over a Vector
+    Vector<double> y = x.Slice(0, 1000, 2) * 2.0 + x.Slice(1, 1000, 2);
+    CHECK(y.Size() == 500);
+    for (size_t i = 0; i < 500; i++) {
+        CHECK_NEAR(y[i], x[2 * i] * 2.0 + x[2 * i + 1], 1e-12);
+    }
+
+    auto b = x.Batch(64);
+    CHECK(b.Row() == 1000 / 64 && b.Col() == 64);
+    for (size_t i = 0; i < b.Row(); i++) {
+        for (size_t j = 0; j < 64; j++) {
+            CHECK(b(i, j) == x[i * 64 + j]);
+        }
+    }
+}
+
+
+void check_matrix_views() {
+    auto m = Matrix2D<double>::RandomInit(120, 90, 22);
+
+    auto r = m.Row(7);
+    auto c = m.Column(11);
+    CHECK(r.Size() == 90 && c.Size() == 120);
+    for (size_t j = 0; j < 90; j++) {
+        CHECK(r[j] == m(7, j));
+    }
+    for (size_t i = 0; i < 120; i++) {
+        CHECK(c[i] == m(i, 11));
+    }
+
+    auto blk = m.Block(10, 20, 50, 40);
+    auto inner = blk.Block(5, 6, 10, 12);
+    auto t = blk.T();
+    CHECK(inner.Row() == 10 && inner.Col() == 12 && t.Row() == 40 && t.Col() == 50);
+    for (size_t i = 0; i < 10; i++) {
+        for (size_t j = 0; j < 12; j++) {
+            CHECK(inner(i, j) == m(15 + i, 26 + j));
+        }
+    }
+    for (size_t i = 0; i < 40; i++) {
+        CHECK(t.Row(i)[3] == m(13, 20 + i) && t.Column(3)[i] == m(13, 20 + i));
+    }
+
+    // the product of a block and a transposed block against the triple loop
+    auto p = m.Block(0, 0, 30, 45) * m.Block(40, 10, 25, 45).T();
+    CHECK(p.Row() == 30 && p.Col() == 25);
+    for (size_t i = 0; i < 30; i++) {
+        for (size_t j = 0; j < 25; j++) {
+            double __s = 0;
+            for (size_t k = 0; k < 45; k++) {
+                __s += m(i, k) * m(40 + j, 10 + k);
+            }
+            CHECK_NEAR(p(i, j), __s, 1e-12);
+        }
+    }
+
+    // an element-wise expression of views and a copy of a view
+    Matrix2D<double> e = blk + blk.T().T() * 0.5;
+    Matrix2D<double> copy(blk);
+    for (size_t i = 0; i < 50; i++) {
+        for (size_t j = 0; j < 40; j++) {
+            CHECK_NEAR(e(i, j), m(10 + i, 20 + j) * 1.5, 1e-12);
+            CHECK(copy(i, j) == m(10 + i, 20 + j));
+        }
+    }
+}
+
+
+// bounds past the end are clamped, as TensorView::Slice does, and a zero step or batch size gives an
+// empty view instead of dividing by zero
+void check_out_of_range() {
+    auto x = Vector<double>::RandomInit(10, 23);
+    auto s = x.Slice(2, 100);
+    CHECK(s.Size() == 8 && s[7] == x[9]);
+    CHECK(x.Slice(3, 100, 4).Size() == 2 && x.Slice(3, 100, 4)[1] == x[7]);
+    CHECK(x.Slice(50, 100).Size() == 0 && x.Slice(0, 10, 0).Size() == 0);
+    auto v = x.Slice(1, 10, 2);
+    CHECK(v.Slice(1, 100).Size() == 4 && v.Slice(1, 100)[3] == x[9]);
+    CHECK(v.Slice(7, 100).Size() == 0 && v.Slice(0, 5, 0).Size() == 0);
+    auto b = x.Batch(0);
+    CHECK(b.Row() == 0 && b.Col() == 0);
+    CHECK(x.Batch(20).Row() == 0);
+
+    auto m = Matrix2D<double>::RandomInit(6, 5, 24);
+    auto blk = m.Block(4, 3, 10, 10);
+    CHECK(blk.Row() == 2 && blk.Col() == 2 && blk(1, 1) == m(5, 4));
+    auto none = m.Block(7, 9, 3, 3);
+    CHECK(none.Row() == 0 && none.Col() == 0);
+    auto inner = m.Block(1, 1, 4, 4).Block(2, 1, 5, 5);
+    CHECK(inner.Row() == 2 && inner.Col() == 3 && inner(1, 2) == m(4, 4));
+    CHECK(m.Block(1, 1, 4, 4).Block(9, 0, 1, 1).Row() == 0);
+}
+
+
+int main() {
+    check_threads([] {
+        check_vector_views();
+        check_matrix_views();
+        check_out_of_range();
+    });
+    return check_result();
+}